@@ -307,6 +307,16 @@ The following variables are for advanced uses of CPack:
   are: Build directory, Project Name, Project Component, Directory.  If
   omitted, CPack will build an installer that installs everything.
 
+.. variable:: CPACK_INSTALL_PARALLEL_LEVEL
+
+  Maximum number of components of a project to install at the same time.
+  The default is ``1``.  When component installation is used, each
+  component installed concurrently runs its ``cmake_install.cmake`` script
+  in a separate ``cmake`` process.  Components staged into the same
+  directory are still installed one after the other.  CPack also sets the
+  :envvar:`CMAKE_INSTALL_PARALLEL_LEVEL` environment variable to this value
+  so that each :command:`file(INSTALL)` copies that many files at once.
+
 .. variable:: CPACK_SYSTEM_NAME
 
   System name, defaults to the value of :variable:`CMAKE_SYSTEM_NAME`,
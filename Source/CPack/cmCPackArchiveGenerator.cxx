@@ -9,6 +9,7 @@
 #include "cmSystemTools.h"
 #include "cmWorkingDirectory.h"
 
+#include <algorithm>
 #include <cstring>
 #include <map>
 #include <ostream>
@@ -20,6 +21,9 @@ cmCPackArchiveGenerator::cmCPackArchiveGenerator(cmArchiveWrite::Compress t,
 {
   this->Compress = t;
   this->ArchiveFormat = format;
+  this->CompressionLevel = 0;
+  this->NumThreads = 1;
+  this->Reproducible = false;
 }
 
 cmCPackArchiveGenerator::~cmCPackArchiveGenerator() = default;
@@ -49,6 +53,30 @@ std::string cmCPackArchiveGenerator::GetArchiveComponentFileName(
 int cmCPackArchiveGenerator::InitializeInternal()
 {
   this->SetOptionIfNotSet("CPACK_INCLUDE_TOPLEVEL_DIRECTORY", "1");
+
+  unsigned long value;
+  this->CompressionLevel = 0;
+  if (const char* level = this->GetOption("CPACK_ARCHIVE_COMPRESSION_LEVEL")) {
+    if (!cmSystemTools::StringToULong(level, &value) || value < 1 ||
+        value > 9) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR,
+                    "Invalid CPACK_ARCHIVE_COMPRESSION_LEVEL: "
+                      << level << ", it must be from 1 to 9." << std::endl);
+      return 0;
+    }
+    this->CompressionLevel = static_cast<int>(value);
+  }
+  this->NumThreads = 1;
+  if (const char* threads = this->GetOption("CPACK_ARCHIVE_THREADS")) {
+    if (!cmSystemTools::StringToULong(threads, &value) || value > 1024) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR,
+                    "Invalid CPACK_ARCHIVE_THREADS: " << threads << std::endl);
+      return 0;
+    }
+    this->NumThreads = static_cast<int>(value);
+  }
+  this->Reproducible = this->IsOn("CPACK_ARCHIVE_REPRODUCIBLE");
+
   return this->Superclass::InitializeInternal();
 }
 
@@ -109,7 +137,9 @@ int cmCPackArchiveGenerator::addOneComponentToArchive(
                     << (filename) << ">." << std::endl);                      \
     return 0;                                                                 \
   }                                                                           \
-  cmArchiveWrite archive(gf, this->Compress, this->ArchiveFormat);            \
+  cmArchiveWrite archive(gf, this->Compress, this->ArchiveFormat,             \
+                         this->CompressionLevel, this->NumThreads,            \
+                         this->Reproducible);                                 \
   do {                                                                        \
     if (!(archive)) {                                                         \
       cmCPackLogger(cmCPackLog::LOG_ERROR,                                    \
@@ -257,6 +287,10 @@ int cmCPackArchiveGenerator::PackageFiles()
                     << std::strerror(workdir.GetLastResult()) << std::endl);
     return 0;
   }
+  if (this->Reproducible) {
+    // The files are listed in the order the file system returns them.
+    std::sort(files.begin(), files.end());
+  }
   for (std::string const& file : files) {
     // Get the relative path to the file
     std::string rp = cmSystemTools::RelativePath(toplevel, file);
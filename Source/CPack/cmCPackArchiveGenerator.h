@@ -71,6 +71,9 @@ protected:
   const char* GetOutputExtension() override = 0;
   cmArchiveWrite::Compress Compress;
   std::string ArchiveFormat;
+  int CompressionLevel;
+  int NumThreads;
+  bool Reproducible;
 };
 
 #endif
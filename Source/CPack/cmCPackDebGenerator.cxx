@@ -249,21 +249,29 @@ std::string DebGenerator::generateMD5File() const
 
   std::string topLevelWithTrailingSlash = TemporaryDir;
   topLevelWithTrailingSlash += '/';
+  // hash only regular files
+  std::vector<std::string> files;
   for (std::string const& file : PackageFiles) {
-    // hash only regular files
-    if (cmSystemTools::FileIsDirectory(file) ||
-        cmSystemTools::FileIsSymlink(file)) {
-      continue;
+    if (!cmSystemTools::FileIsDirectory(file) &&
+        !cmSystemTools::FileIsSymlink(file)) {
+      files.push_back(file);
     }
+  }
 
-    std::string output =
-      cmSystemTools::ComputeFileHash(file, cmCryptoHash::AlgoMD5);
+  // Packages may have many files, so hash them at the same time.  The
+  // entries are still written in the order of the files.  The staged
+  // files were installed by CPack and may be mapped into memory.
+  cmCryptoHash md5(cmCryptoHash::AlgoMD5);
+  md5.SetMapFiles(true);
+  std::vector<std::string> const hashes = md5.HashFiles(files);
+  for (size_t i = 0; i < files.size(); ++i) {
+    std::string output = hashes[i];
     if (output.empty()) {
       cmCPackLogger(cmCPackLog::LOG_ERROR,
-                    "Problem computing the md5 of " << file << std::endl);
+                    "Problem computing the md5 of " << files[i] << std::endl);
     }
 
-    output += "  " + file + "\n";
+    output += "  " + files[i] + "\n";
     // debian md5sums entries are like this:
     // 014f3604694729f3bf19263bac599765  usr/bin/ccmake
     // thus strip the full path (with the trailing slash)
@@ -146,6 +146,23 @@ int cmCPackExternalGenerator::InstallCMakeProject(
   return 1;
 }
 
+int cmCPackExternalGenerator::InstallCMakeProjectComponents(
+  bool setDestDir, const std::string& installDirectory,
+  const std::string& baseTempInstallDirectory, const mode_t* default_dir_mode,
+  const std::vector<std::string>& components, bool componentInstall,
+  const std::string& installSubDirectory, const std::string& buildConfig,
+  std::string& absoluteDestFiles, unsigned long parallelLevel)
+{
+  if (this->StagingEnabled()) {
+    return cmCPackGenerator::InstallCMakeProjectComponents(
+      setDestDir, installDirectory, baseTempInstallDirectory, default_dir_mode,
+      components, componentInstall, installSubDirectory, buildConfig,
+      absoluteDestFiles, parallelLevel);
+  }
+
+  return 1;
+}
+
 bool cmCPackExternalGenerator::StagingEnabled() const
 {
   return !cmSystemTools::IsOff(
@@ -50,6 +50,13 @@ protected:
                           const std::string& installSubDirectory,
                           const std::string& buildConfig,
                           std::string& absoluteDestFiles) override;
+  int InstallCMakeProjectComponents(
+    bool setDestDir, const std::string& installDirectory,
+    const std::string& baseTempInstallDirectory,
+    const mode_t* default_dir_mode,
+    const std::vector<std::string>& components, bool componentInstall,
+    const std::string& installSubDirectory, const std::string& buildConfig,
+    std::string& absoluteDestFiles, unsigned long parallelLevel) override;
 
 private:
   bool StagingEnabled() const;
@@ -11,6 +11,7 @@
 #include <utility>
 
 #include "cmCPackComponentGroup.h"
+#include "cmCPackInstallRunner.h"
 #include "cmCPackLog.h"
 #include "cmCryptoHash.h"
 #include "cmDuration.h"
@@ -516,6 +517,24 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
                       << std::endl);
       return 0;
     }
+    // Install several components and copy several files at once if
+    // asked to.
+    unsigned long parallelLevel = 1;
+    const char* parallel = this->GetOption("CPACK_INSTALL_PARALLEL_LEVEL");
+    if (parallel && *parallel) {
+      if (!cmSystemTools::StringToULong(parallel, &parallelLevel) ||
+          parallelLevel < 1) {
+        cmCPackLogger(cmCPackLog::LOG_ERROR,
+                      "CPACK_INSTALL_PARALLEL_LEVEL must be a positive "
+                      "integer, but it is: "
+                        << parallel << std::endl);
+        return 0;
+      }
+      if (parallelLevel > 1) {
+        cmSystemTools::PutEnv("CMAKE_INSTALL_PARALLEL_LEVEL=" +
+                              std::to_string(parallelLevel));
+      }
+    }
     std::vector<std::string> cmakeProjectsVector;
     cmSystemTools::ExpandListArgument(cmakeProjects, cmakeProjectsVector);
     std::vector<std::string>::iterator it;
@@ -614,13 +633,12 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
                     "- Install project: " << project.ProjectName << std::endl);
 
       // Run the installation for each component
-      for (std::string const& component : componentsVector) {
-        if (!this->InstallCMakeProject(
-              setDestDir, project.Directory, baseTempInstallDirectory,
-              default_dir_mode, component, componentInstall,
-              project.SubDirectory, buildConfig, absoluteDestFiles)) {
-          return 0;
-        }
+      if (!this->InstallCMakeProjectComponents(
+            setDestDir, project.Directory, baseTempInstallDirectory,
+            default_dir_mode, componentsVector, componentInstall,
+            project.SubDirectory, buildConfig, absoluteDestFiles,
+            parallelLevel)) {
+        return 0;
       }
 
       this->CMakeProjects.push_back(project);
@@ -676,12 +694,12 @@ int cmCPackGenerator::InstallCMakeProject(
   const std::string& installSubDirectory, const std::string& buildConfig,
   std::string& absoluteDestFiles)
 {
-  std::string tempInstallDirectory = baseTempInstallDirectory;
-  std::string installFile = installDirectory + "/cmake_install.cmake";
-
-  if (componentInstall) {
-    cmCPackLogger(cmCPackLog::LOG_OUTPUT,
-                  "-   Install component: " << component << std::endl);
+  CMakeProjectInstall install;
+  if (!this->PrepareCMakeProjectInstall(
+        setDestDir, installDirectory, baseTempInstallDirectory,
+        default_dir_mode, component, componentInstall, installSubDirectory,
+        buildConfig, install)) {
+    return 0;
   }
 
   cmake cm(cmake::RoleScript, cmState::CPack);
@@ -696,6 +714,174 @@ int cmCPackGenerator::InstallCMakeProject(
   cm.SetTraceExpand(this->TraceExpand);
   cmGlobalGenerator gg(&cm, nullptr);
   cmMakefile mf(&gg, cm.GetCurrentSnapshot());
+  for (auto const& def : install.Definitions) {
+    mf.AddDefinition(def.first, def.second.c_str());
+  }
+  if (setDestDir) {
+    cmSystemTools::PutEnv("DESTDIR=" + install.TempInstallDirectory);
+  }
+
+  // do installation
+  bool res = mf.ReadListFile(install.InstallFile);
+  // forward definition of CMAKE_ABSOLUTE_DESTINATION_FILES
+  // to CPack (may be used by generators like CPack RPM or DEB)
+  // in order to transparently handle ABSOLUTE PATH
+  if (const char* files =
+        mf.GetDefinition("CMAKE_ABSOLUTE_DESTINATION_FILES")) {
+    install.HasAbsoluteDestFiles = true;
+    install.AbsoluteDestFiles = files;
+  }
+
+  this->FinishCMakeProjectInstall(install, absoluteDestFiles);
+  if (cmSystemTools::GetErrorOccuredFlag() || !res) {
+    return 0;
+  }
+  return 1;
+}
+
+int cmCPackGenerator::InstallCMakeProjectComponents(
+  bool setDestDir, const std::string& installDirectory,
+  const std::string& baseTempInstallDirectory, const mode_t* default_dir_mode,
+  const std::vector<std::string>& components, bool componentInstall,
+  const std::string& installSubDirectory, const std::string& buildConfig,
+  std::string& absoluteDestFiles, unsigned long parallelLevel)
+{
+  if (parallelLevel < 2 || components.size() < 2) {
+    for (std::string const& component : components) {
+      if (!this->InstallCMakeProject(
+            setDestDir, installDirectory, baseTempInstallDirectory,
+            default_dir_mode, component, componentInstall,
+            installSubDirectory, buildConfig, absoluteDestFiles)) {
+        return 0;
+      }
+    }
+    return 1;
+  }
+
+  // Components installed to the same directory are told apart by the
+  // files each adds to it, so they are installed one after the other.
+  std::vector<std::vector<size_t>> chains;
+  std::map<std::string, size_t> chainOfDirectory;
+  for (size_t i = 0; i < components.size(); ++i) {
+    std::string const dir = this->GetCMakeProjectInstallDirectory(
+      setDestDir, baseTempInstallDirectory, components[i], componentInstall,
+      installSubDirectory);
+    auto it = chainOfDirectory.emplace(dir, chains.size()).first;
+    if (it->second == chains.size()) {
+      chains.emplace_back();
+    }
+    chains[it->second].push_back(i);
+  }
+
+  // The install scripts run in separate cmake processes because DESTDIR
+  // and the state of the script engine are global to a process.  A
+  // small script runs the install script and reports the absolute
+  // destination files back.
+  std::string const toplevel = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
+  std::string const wrapper = toplevel + "/CPackInstallComponent.cmake";
+  {
+    cmGeneratedFileStream fout(wrapper);
+    fout << "include(\"${CPACK_INSTALL_SCRIPT}\")\n"
+            "if(DEFINED CMAKE_ABSOLUTE_DESTINATION_FILES)\n"
+            "  file(WRITE \"${CPACK_INSTALL_RESULT}\"\n"
+            "    \"${CMAKE_ABSOLUTE_DESTINATION_FILES}\")\n"
+            "endif()\n";
+  }
+
+  std::vector<CMakeProjectInstall> installs(components.size());
+  std::vector<std::string> absoluteDestFilesOf(components.size());
+  std::vector<std::string> const environment =
+    cmSystemTools::GetEnvironmentVariables();
+
+  auto start = [&](size_t i, cmCPackInstallRunner::Job& job) -> bool {
+    CMakeProjectInstall& install = installs[i];
+    if (!this->PrepareCMakeProjectInstall(
+          setDestDir, installDirectory, baseTempInstallDirectory,
+          default_dir_mode, components[i], componentInstall,
+          installSubDirectory, buildConfig, install)) {
+      return false;
+    }
+    std::string const result =
+      toplevel + "/CPackInstallResult-" + std::to_string(i) + ".txt";
+    cmSystemTools::RemoveFile(result);
+
+    job.Command.push_back(cmSystemTools::GetCMakeCommand());
+    if (this->Trace) {
+      job.Command.emplace_back("--trace");
+    }
+    if (this->TraceExpand) {
+      job.Command.emplace_back("--trace-expand");
+    }
+    for (auto const& def : install.Definitions) {
+      job.Command.push_back("-D" + def.first + "=" + def.second);
+    }
+    job.Command.push_back("-DCPACK_INSTALL_SCRIPT=" + install.InstallFile);
+    job.Command.push_back("-DCPACK_INSTALL_RESULT=" + result);
+    job.Command.emplace_back("-P");
+    job.Command.push_back(wrapper);
+
+    for (std::string const& var : environment) {
+      if (!setDestDir || !cmSystemTools::StringStartsWith(var, "DESTDIR=")) {
+        job.Environment.push_back(var);
+      }
+    }
+    if (setDestDir) {
+      job.Environment.push_back("DESTDIR=" + install.TempInstallDirectory);
+    }
+    return true;
+  };
+
+  auto finish = [&](size_t i, cmCPackInstallRunner::Job& job) -> bool {
+    CMakeProjectInstall& install = installs[i];
+    std::string const result =
+      toplevel + "/CPackInstallResult-" + std::to_string(i) + ".txt";
+    if (cmSystemTools::FileExists(result)) {
+      cmsys::ifstream fin(result.c_str());
+      std::getline(fin, install.AbsoluteDestFiles, '\0');
+      install.HasAbsoluteDestFiles = true;
+      fin.close();
+      cmSystemTools::RemoveFile(result);
+    }
+    this->FinishCMakeProjectInstall(install, absoluteDestFilesOf[i]);
+
+    if (!job.Output.empty()) {
+      cmCPackLogger(cmCPackLog::LOG_VERBOSE, job.Output);
+    }
+    if (!job.Exited || job.ExitValue != 0) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR,
+                    "Problem installing component: "
+                      << components[i] << std::endl
+                      << job.Errors << std::endl);
+      return false;
+    }
+    if (!job.Errors.empty()) {
+      cmCPackLogger(cmCPackLog::LOG_WARNING, job.Errors);
+    }
+    return true;
+  };
+
+  cmCPackInstallRunner runner(std::move(chains), parallelLevel, start,
+                              finish);
+  bool const res = runner.Run();
+
+  // Report the absolute destination files in the order of components.
+  for (std::string const& files : absoluteDestFilesOf) {
+    if (!files.empty()) {
+      if (!absoluteDestFiles.empty()) {
+        absoluteDestFiles += ";";
+      }
+      absoluteDestFiles += files;
+    }
+  }
+  return res ? 1 : 0;
+}
+
+std::string cmCPackGenerator::GetCMakeProjectInstallDirectory(
+  bool setDestDir, const std::string& baseTempInstallDirectory,
+  const std::string& component, bool componentInstall,
+  const std::string& installSubDirectory)
+{
+  std::string tempInstallDirectory = baseTempInstallDirectory;
   if (!installSubDirectory.empty() && installSubDirectory != "/" &&
       installSubDirectory != ".") {
     tempInstallDirectory += installSubDirectory;
@@ -715,15 +901,38 @@ int cmCPackGenerator::InstallCMakeProject(
     }
   }
 
+  if (!setDestDir) {
+    tempInstallDirectory += this->GetPackagingInstallPrefix();
+  }
+  return tempInstallDirectory;
+}
+
+int cmCPackGenerator::PrepareCMakeProjectInstall(
+  bool setDestDir, const std::string& installDirectory,
+  const std::string& baseTempInstallDirectory, const mode_t* default_dir_mode,
+  const std::string& component, bool componentInstall,
+  const std::string& installSubDirectory, const std::string& buildConfig,
+  CMakeProjectInstall& install)
+{
+  std::string tempInstallDirectory = this->GetCMakeProjectInstallDirectory(
+    setDestDir, baseTempInstallDirectory, component, componentInstall,
+    installSubDirectory);
+  install.Component = component;
+  install.ComponentInstall = componentInstall;
+  install.InstallFile = installDirectory + "/cmake_install.cmake";
+  install.TempInstallDirectory = tempInstallDirectory;
+  auto& definitions = install.Definitions;
+
+  if (componentInstall) {
+    cmCPackLogger(cmCPackLog::LOG_OUTPUT,
+                  "-   Install component: " << component << std::endl);
+  }
+
   const char* default_dir_inst_permissions =
     this->GetOption("CPACK_INSTALL_DEFAULT_DIRECTORY_PERMISSIONS");
   if (default_dir_inst_permissions && *default_dir_inst_permissions) {
-    mf.AddDefinition("CMAKE_INSTALL_DEFAULT_DIRECTORY_PERMISSIONS",
-                     default_dir_inst_permissions);
-  }
-
-  if (!setDestDir) {
-    tempInstallDirectory += this->GetPackagingInstallPrefix();
+    definitions.emplace_back("CMAKE_INSTALL_DEFAULT_DIRECTORY_PERMISSIONS",
+                             default_dir_inst_permissions);
   }
 
   if (setDestDir) {
@@ -746,7 +955,7 @@ int cmCPackGenerator::InstallCMakeProject(
     if (this->GetOption("CPACK_INSTALL_PREFIX")) {
       dir += this->GetOption("CPACK_INSTALL_PREFIX");
     }
-    mf.AddDefinition("CMAKE_INSTALL_PREFIX", dir.c_str());
+    definitions.emplace_back("CMAKE_INSTALL_PREFIX", dir);
 
     cmCPackLogger(
       cmCPackLog::LOG_DEBUG,
@@ -775,7 +984,6 @@ int cmCPackGenerator::InstallCMakeProject(
      *     - Because it was already used for component install
      *       in order to put things in subdirs...
      */
-    cmSystemTools::PutEnv(std::string("DESTDIR=") + tempInstallDirectory);
     cmCPackLogger(cmCPackLog::LOG_DEBUG,
                   "- Creating directory: '" << dir << "'" << std::endl);
 
@@ -786,7 +994,7 @@ int cmCPackGenerator::InstallCMakeProject(
       return 0;
     }
   } else {
-    mf.AddDefinition("CMAKE_INSTALL_PREFIX", tempInstallDirectory.c_str());
+    definitions.emplace_back("CMAKE_INSTALL_PREFIX", tempInstallDirectory);
 
     if (!cmsys::SystemTools::MakeDirectory(tempInstallDirectory,
                                            default_dir_mode)) {
@@ -805,37 +1013,34 @@ int cmCPackGenerator::InstallCMakeProject(
   }
 
   if (!buildConfig.empty()) {
-    mf.AddDefinition("BUILD_TYPE", buildConfig.c_str());
+    definitions.emplace_back("BUILD_TYPE", buildConfig);
   }
   std::string installComponentLowerCase = cmSystemTools::LowerCase(component);
   if (installComponentLowerCase != "all") {
-    mf.AddDefinition("CMAKE_INSTALL_COMPONENT", component.c_str());
+    definitions.emplace_back("CMAKE_INSTALL_COMPONENT", component);
   }
 
   // strip on TRUE, ON, 1, one or several file names, but not on
   // FALSE, OFF, 0 and an empty string
   if (!cmSystemTools::IsOff(this->GetOption("CPACK_STRIP_FILES"))) {
-    mf.AddDefinition("CMAKE_INSTALL_DO_STRIP", "1");
+    definitions.emplace_back("CMAKE_INSTALL_DO_STRIP", "1");
   }
   // Remember the list of files before installation
   // of the current component (if we are in component install)
-  std::string const& InstallPrefix = tempInstallDirectory;
-  std::vector<std::string> filesBefore;
-  std::string findExpr = tempInstallDirectory;
   if (componentInstall) {
     cmsys::Glob glB;
-    findExpr += "/*";
     glB.RecurseOn();
     glB.SetRecurseListDirs(true);
-    glB.FindFiles(findExpr);
-    filesBefore = glB.GetFiles();
-    std::sort(filesBefore.begin(), filesBefore.end());
+    glB.FindFiles(tempInstallDirectory + "/*");
+    install.FilesBefore = glB.GetFiles();
+    std::sort(install.FilesBefore.begin(), install.FilesBefore.end());
   }
 
   // If CPack was asked to warn on ABSOLUTE INSTALL DESTINATION
   // then forward request to cmake_install.cmake script
   if (this->IsOn("CPACK_WARN_ON_ABSOLUTE_INSTALL_DESTINATION")) {
-    mf.AddDefinition("CMAKE_WARN_ON_ABSOLUTE_INSTALL_DESTINATION", "1");
+    definitions.emplace_back("CMAKE_WARN_ON_ABSOLUTE_INSTALL_DESTINATION",
+                             "1");
   }
   // If current CPack generator does support
   // ABSOLUTE INSTALL DESTINATION or CPack has been asked for
@@ -843,33 +1048,33 @@ int cmCPackGenerator::InstallCMakeProject(
   // as soon as it occurs (before installing file)
   if (!SupportsAbsoluteDestination() ||
       this->IsOn("CPACK_ERROR_ON_ABSOLUTE_INSTALL_DESTINATION")) {
-    mf.AddDefinition("CMAKE_ERROR_ON_ABSOLUTE_INSTALL_DESTINATION", "1");
-  }
-  // do installation
-  bool res = mf.ReadListFile(installFile);
-  // forward definition of CMAKE_ABSOLUTE_DESTINATION_FILES
-  // to CPack (may be used by generators like CPack RPM or DEB)
-  // in order to transparently handle ABSOLUTE PATH
-  if (mf.GetDefinition("CMAKE_ABSOLUTE_DESTINATION_FILES")) {
-    mf.AddDefinition("CPACK_ABSOLUTE_DESTINATION_FILES",
-                     mf.GetDefinition("CMAKE_ABSOLUTE_DESTINATION_FILES"));
+    definitions.emplace_back("CMAKE_ERROR_ON_ABSOLUTE_INSTALL_DESTINATION",
+                             "1");
   }
+  return 1;
+}
+
+void cmCPackGenerator::FinishCMakeProjectInstall(
+  CMakeProjectInstall const& install, std::string& absoluteDestFiles)
+{
+  std::string const& component = install.Component;
 
   // Now rebuild the list of files after installation
   // of the current component (if we are in component install)
-  if (componentInstall) {
+  if (install.ComponentInstall) {
+    std::string const& InstallPrefix = install.TempInstallDirectory;
     cmsys::Glob glA;
     glA.RecurseOn();
     glA.SetRecurseListDirs(true);
     glA.SetRecurseThroughSymlinks(false);
-    glA.FindFiles(findExpr);
+    glA.FindFiles(install.TempInstallDirectory + "/*");
     std::vector<std::string> filesAfter = glA.GetFiles();
     std::sort(filesAfter.begin(), filesAfter.end());
     std::vector<std::string>::iterator diff;
     std::vector<std::string> result(filesAfter.size());
     diff = std::set_difference(filesAfter.begin(), filesAfter.end(),
-                               filesBefore.begin(), filesBefore.end(),
-                               result.begin());
+                               install.FilesBefore.begin(),
+                               install.FilesBefore.end(), result.begin());
 
     std::vector<std::string>::iterator fit;
     std::string localFileName;
@@ -885,16 +1090,16 @@ int cmCPackGenerator::InstallCMakeProject(
     }
   }
 
-  if (nullptr != mf.GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES")) {
+  if (install.HasAbsoluteDestFiles) {
     if (!absoluteDestFiles.empty()) {
       absoluteDestFiles += ";";
     }
-    absoluteDestFiles += mf.GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES");
+    absoluteDestFiles += install.AbsoluteDestFiles;
     cmCPackLogger(cmCPackLog::LOG_DEBUG,
                   "Got some ABSOLUTE DESTINATION FILES: " << absoluteDestFiles
                                                           << std::endl);
     // define component specific var
-    if (componentInstall) {
+    if (install.ComponentInstall) {
       std::string absoluteDestFileComponent =
         std::string("CPACK_ABSOLUTE_DESTINATION_FILES") + "_" +
         GetComponentInstallDirNameSuffix(component);
@@ -902,20 +1107,15 @@ int cmCPackGenerator::InstallCMakeProject(
         std::string absoluteDestFilesListComponent =
           this->GetOption(absoluteDestFileComponent);
         absoluteDestFilesListComponent += ";";
-        absoluteDestFilesListComponent +=
-          mf.GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES");
+        absoluteDestFilesListComponent += install.AbsoluteDestFiles;
         this->SetOption(absoluteDestFileComponent,
                         absoluteDestFilesListComponent.c_str());
       } else {
         this->SetOption(absoluteDestFileComponent,
-                        mf.GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES"));
+                        install.AbsoluteDestFiles.c_str());
       }
     }
   }
-  if (cmSystemTools::GetErrorOccuredFlag() || !res) {
-    return 0;
-  }
-  return 1;
 }
 
 bool cmCPackGenerator::ReadListFile(const char* moduleName)
@@ -1050,6 +1250,13 @@ int cmCPackGenerator::DoPackage()
   /* Prepare checksum algorithm*/
   const char* algo = this->GetOption("CPACK_PACKAGE_CHECKSUM");
   std::unique_ptr<cmCryptoHash> crypto = cmCryptoHash::New(algo ? algo : "");
+  // Hash all packages at once.  The copies have the same content.
+  std::vector<std::string> packageHashes;
+  if (crypto) {
+    // CPack just wrote the packages, so nothing truncates them meanwhile.
+    crypto->SetMapFiles(true);
+    packageHashes = crypto->HashFiles(packageFileNames);
+  }
 
   /*
    * Copy the generated packages to final destination
@@ -1061,7 +1268,8 @@ int cmCPackGenerator::DoPackage()
                 "Copying final package(s) [" << packageFileNames.size()
                                              << "]:" << std::endl);
   /* now copy package one by one */
-  for (std::string const& pkgFileName : packageFileNames) {
+  for (size_t i = 0; i < packageFileNames.size(); ++i) {
+    std::string const& pkgFileName = packageFileNames[i];
     std::string tmpPF(this->GetOption("CPACK_OUTPUT_FILE_PREFIX"));
     std::string filename(cmSystemTools::GetFilenameName(pkgFileName));
     tempPackageFileName = pkgFileName.c_str();
@@ -1096,7 +1304,7 @@ int cmCPackGenerator::DoPackage()
                                                       << std::endl);
         return 0;
       }
-      outF << crypto->HashFile(packageFileName) << "  " << filename << "\n";
+      outF << packageHashes[i] << "  " << filename << "\n";
       cmCPackLogger(cmCPackLog::LOG_OUTPUT,
                     "- checksum file: " << hashFile << " generated."
                                         << std::endl);
@@ -8,6 +8,7 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "cmCPackComponentGroup.h"
@@ -196,6 +197,45 @@ protected:
     const mode_t* default_dir_mode, const std::string& component,
     bool componentInstall, const std::string& installSubDirectory,
     const std::string& buildConfig, std::string& absoluteDestFiles);
+  //! Run the installation of the given components of a project
+  virtual int InstallCMakeProjectComponents(
+    bool setDestDir, const std::string& installDirectory,
+    const std::string& baseTempInstallDirectory,
+    const mode_t* default_dir_mode,
+    const std::vector<std::string>& components, bool componentInstall,
+    const std::string& installSubDirectory, const std::string& buildConfig,
+    std::string& absoluteDestFiles, unsigned long parallelLevel);
+
+  /**
+   * The installation of one component of a CMake project.  It is
+   * prepared and finished by CPack and run either by CPack or by a
+   * separate cmake process.
+   */
+  struct CMakeProjectInstall
+  {
+    std::string Component;
+    bool ComponentInstall = false;
+    std::string InstallFile;
+    std::string TempInstallDirectory;
+    // Definitions for the install script
+    std::vector<std::pair<std::string, std::string>> Definitions;
+    std::vector<std::string> FilesBefore;
+    // CMAKE_ABSOLUTE_DESTINATION_FILES after the installation, if set
+    bool HasAbsoluteDestFiles = false;
+    std::string AbsoluteDestFiles;
+  };
+  std::string GetCMakeProjectInstallDirectory(
+    bool setDestDir, const std::string& baseTempInstallDirectory,
+    const std::string& component, bool componentInstall,
+    const std::string& installSubDirectory);
+  int PrepareCMakeProjectInstall(
+    bool setDestDir, const std::string& installDirectory,
+    const std::string& baseTempInstallDirectory,
+    const mode_t* default_dir_mode, const std::string& component,
+    bool componentInstall, const std::string& installSubDirectory,
+    const std::string& buildConfig, CMakeProjectInstall& install);
+  void FinishCMakeProjectInstall(CMakeProjectInstall const& install,
+                                 std::string& absoluteDestFiles);
 
   /**
    * The various level of support of
@@ -0,0 +1,76 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCPackInstallRunner.h"
+
+#include <algorithm>
+#include <utility>
+
+cmCPackInstallRunner::cmCPackInstallRunner(
+  std::vector<std::vector<size_t>> chains, size_t parallelLevel,
+  StartFunction start, FinishFunction finish)
+  : Chains(std::move(chains))
+  , Start(std::move(start))
+  , Finish(std::move(finish))
+  , Pool(std::max<size_t>(parallelLevel, 1),
+         [this](size_t slot) {
+           this->FinishJob(slot);
+           this->StartJobs();
+         })
+  , SlotChain(this->Pool.GetSlotCount(), 0)
+  , SlotIndex(this->Pool.GetSlotCount(), 0)
+  , SlotJob(this->Pool.GetSlotCount())
+  , NextInChain(this->Chains.size(), 0)
+  , ChainBusy(this->Chains.size(), false)
+{
+}
+
+bool cmCPackInstallRunner::Run()
+{
+  this->StartJobs();
+  this->Pool.Run();
+  return !this->Failed;
+}
+
+void cmCPackInstallRunner::StartJobs()
+{
+  size_t chain = 0;
+  for (size_t slot = 0; slot < this->Pool.GetSlotCount(); ++slot) {
+    if (this->Pool.IsBusy(slot)) {
+      continue;
+    }
+    // Take the next job of the first idle chain with work left.
+    for (; !this->Failed && chain < this->Chains.size(); ++chain) {
+      if (!this->ChainBusy[chain] &&
+          this->NextInChain[chain] < this->Chains[chain].size()) {
+        break;
+      }
+    }
+    if (this->Failed || chain == this->Chains.size()) {
+      return;
+    }
+
+    this->SlotChain[slot] = chain;
+    this->SlotIndex[slot] = this->Chains[chain][this->NextInChain[chain]];
+    this->SlotJob[slot] = Job();
+    this->ChainBusy[chain] = true;
+
+    if (!this->Start(this->SlotIndex[slot], this->SlotJob[slot])) {
+      this->Failed = true;
+      return;
+    }
+    if (!this->Pool.Start(slot, this->SlotJob[slot])) {
+      // Let the caller report the error.
+      this->FinishJob(slot);
+    }
+  }
+}
+
+void cmCPackInstallRunner::FinishJob(size_t slot)
+{
+  if (!this->Finish(this->SlotIndex[slot], this->SlotJob[slot])) {
+    this->Failed = true;
+  }
+  size_t const chain = this->SlotChain[slot];
+  ++this->NextInChain[chain];
+  this->ChainBusy[chain] = false;
+}
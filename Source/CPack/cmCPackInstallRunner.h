@@ -0,0 +1,60 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmCPackInstallRunner_h
+#define cmCPackInstallRunner_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include "cmUVProcessPool.h"
+
+#include <functional>
+#include <stddef.h>
+#include <vector>
+
+/** \class cmCPackInstallRunner
+ * \brief Run install scripts in several cmake processes at once
+ *
+ * The jobs are grouped in chains.  The jobs of a chain run one after
+ * the other in order, for example because they install to the same
+ * directory, while jobs of different chains run concurrently.  The
+ * start and finish functions are called on the calling thread, so they
+ * may use the state of the caller.  Once one of them fails no more jobs
+ * are started.
+ */
+class cmCPackInstallRunner
+{
+public:
+  typedef cmUVProcessPool::Job Job;
+
+  //! Set up the job with the given index.  Return false to fail.
+  typedef std::function<bool(size_t, Job&)> StartFunction;
+  //! Handle the result of the job with the given index.
+  typedef std::function<bool(size_t, Job&)> FinishFunction;
+
+  cmCPackInstallRunner(std::vector<std::vector<size_t>> chains,
+                       size_t parallelLevel, StartFunction start,
+                       FinishFunction finish);
+
+  //! Run all jobs.  Returns false if a job could not run or failed.
+  bool Run();
+
+private:
+  void StartJobs();
+  void FinishJob(size_t slot);
+
+  std::vector<std::vector<size_t>> Chains;
+  StartFunction Start;
+  FinishFunction Finish;
+  cmUVProcessPool Pool;
+  // The chain, the index and the job run in each slot
+  std::vector<size_t> SlotChain;
+  std::vector<size_t> SlotIndex;
+  std::vector<Job> SlotJob;
+  // The next job of each chain, or its size once it is done
+  std::vector<size_t> NextInChain;
+  // Whether each chain has a running job
+  std::vector<bool> ChainBusy;
+  bool Failed = false;
+};
+
+#endif
@@ -184,10 +184,10 @@ void cmCTestBuildHandler::Initialize()
   this->ReallyCustomWarningExceptions.clear();
   this->ErrorWarningFileLineRegex.clear();
 
-  this->ErrorMatchRegex.clear();
-  this->ErrorExceptionRegex.clear();
-  this->WarningMatchRegex.clear();
-  this->WarningExceptionRegex.clear();
+  this->ErrorMatchRegex.Clear();
+  this->ErrorExceptionRegex.Clear();
+  this->WarningMatchRegex.Clear();
+  this->WarningExceptionRegex.Clear();
   this->BuildProcessingQueue.clear();
   this->BuildProcessingErrorQueue.clear();
   this->BuildOutputLogSize = 0;
@@ -358,14 +358,14 @@ int cmCTestBuildHandler::ProcessHandler()
 
 #define cmCTestBuildHandlerPopulateRegexVector(strings, regexes)              \
   do {                                                                        \
-    regexes.clear();                                                          \
+    (regexes).Clear();                                                        \
     cmCTestOptionalLog(this->CTest, DEBUG,                                    \
                        this << "Add " #regexes << std::endl, this->Quiet);    \
     for (std::string const& s : (strings)) {                                  \
       cmCTestOptionalLog(this->CTest, DEBUG,                                  \
                          "Add " #strings ": " << s << std::endl,              \
                          this->Quiet);                                        \
-      (regexes).emplace_back(s);                                              \
+      (regexes).Add(s);                                                       \
     }                                                                         \
   } while (false)
 
@@ -1092,66 +1092,51 @@ int cmCTestBuildHandler::ProcessSingleLine(const char* data)
 
   if (!this->ErrorQuotaReached) {
     // Errors
-    int wrxCnt = 0;
-    for (cmsys::RegularExpression& rx : this->ErrorMatchRegex) {
-      if (rx.find(data)) {
-        errorLine = 1;
-        cmCTestOptionalLog(this->CTest, DEBUG,
-                           "  Error Line: " << data << " (matches: "
-                                            << this->CustomErrorMatches[wrxCnt]
-                                            << ")" << std::endl,
-                           this->Quiet);
-        break;
-      }
-      wrxCnt++;
+    size_t idx = this->ErrorMatchRegex.Find(data);
+    if (idx != cmRegularExpressionSet::npos) {
+      errorLine = 1;
+      cmCTestOptionalLog(this->CTest, DEBUG,
+                         "  Error Line: "
+                           << data << " (matches: "
+                           << this->ErrorMatchRegex.GetPattern(idx) << ")"
+                           << std::endl,
+                         this->Quiet);
     }
     // Error exceptions
-    wrxCnt = 0;
-    for (cmsys::RegularExpression& rx : this->ErrorExceptionRegex) {
-      if (rx.find(data)) {
-        errorLine = 0;
-        cmCTestOptionalLog(this->CTest, DEBUG,
-                           "  Not an error Line: "
-                             << data << " (matches: "
-                             << this->CustomErrorExceptions[wrxCnt] << ")"
-                             << std::endl,
-                           this->Quiet);
-        break;
-      }
-      wrxCnt++;
+    idx = this->ErrorExceptionRegex.Find(data);
+    if (idx != cmRegularExpressionSet::npos) {
+      errorLine = 0;
+      cmCTestOptionalLog(this->CTest, DEBUG,
+                         "  Not an error Line: "
+                           << data << " (matches: "
+                           << this->ErrorExceptionRegex.GetPattern(idx) << ")"
+                           << std::endl,
+                         this->Quiet);
     }
   }
   if (!this->WarningQuotaReached) {
     // Warnings
-    int wrxCnt = 0;
-    for (cmsys::RegularExpression& rx : this->WarningMatchRegex) {
-      if (rx.find(data)) {
-        warningLine = 1;
-        cmCTestOptionalLog(this->CTest, DEBUG,
-                           "  Warning Line: "
-                             << data << " (matches: "
-                             << this->CustomWarningMatches[wrxCnt] << ")"
-                             << std::endl,
-                           this->Quiet);
-        break;
-      }
-      wrxCnt++;
+    size_t idx = this->WarningMatchRegex.Find(data);
+    if (idx != cmRegularExpressionSet::npos) {
+      warningLine = 1;
+      cmCTestOptionalLog(this->CTest, DEBUG,
+                         "  Warning Line: "
+                           << data << " (matches: "
+                           << this->WarningMatchRegex.GetPattern(idx) << ")"
+                           << std::endl,
+                         this->Quiet);
     }
 
-    wrxCnt = 0;
     // Warning exceptions
-    for (cmsys::RegularExpression& rx : this->WarningExceptionRegex) {
-      if (rx.find(data)) {
-        warningLine = 0;
-        cmCTestOptionalLog(this->CTest, DEBUG,
-                           "  Not a warning Line: "
-                             << data << " (matches: "
-                             << this->CustomWarningExceptions[wrxCnt] << ")"
-                             << std::endl,
-                           this->Quiet);
-        break;
-      }
-      wrxCnt++;
+    idx = this->WarningExceptionRegex.Find(data);
+    if (idx != cmRegularExpressionSet::npos) {
+      warningLine = 0;
+      cmCTestOptionalLog(this->CTest, DEBUG,
+                         "  Not a warning Line: "
+                           << data << " (matches: "
+                           << this->WarningExceptionRegex.GetPattern(idx)
+                           << ")" << std::endl,
+                         this->Quiet);
     }
   }
   if (errorLine) {
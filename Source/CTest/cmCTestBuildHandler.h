@@ -9,6 +9,7 @@
 
 #include "cmDuration.h"
 #include "cmProcessOutput.h"
+#include "cmRegularExpressionSet.h"
 #include "cmsys/RegularExpression.hxx"
 #include <chrono>
 #include <deque>
@@ -105,10 +106,10 @@ private:
   std::vector<std::string> ReallyCustomWarningExceptions;
   std::vector<cmCTestCompileErrorWarningRex> ErrorWarningFileLineRegex;
 
-  std::vector<cmsys::RegularExpression> ErrorMatchRegex;
-  std::vector<cmsys::RegularExpression> ErrorExceptionRegex;
-  std::vector<cmsys::RegularExpression> WarningMatchRegex;
-  std::vector<cmsys::RegularExpression> WarningExceptionRegex;
+  cmRegularExpressionSet ErrorMatchRegex;
+  cmRegularExpressionSet ErrorExceptionRegex;
+  cmRegularExpressionSet WarningMatchRegex;
+  cmRegularExpressionSet WarningExceptionRegex;
 
   typedef std::deque<char> t_BuildProcessingQueueType;
 
@@ -2,6 +2,7 @@
    file Copyright.txt or https://cmake.org/licensing for details.  */
 #include "cmCTestCoverageHandler.h"
 
+#include "cmAlgorithms.h"
 #include "cmCTest.h"
 #include "cmDuration.h"
 #include "cmGeneratedFileStream.h"
@@ -12,10 +13,14 @@
 #include "cmParseGTMCoverage.h"
 #include "cmParseJacocoCoverage.h"
 #include "cmParsePHPCoverage.h"
+#include "cmProcessOutput.h"
 #include "cmSystemTools.h"
+#include "cmUVProcessPool.h"
 #include "cmWorkingDirectory.h"
 #include "cmXMLWriter.h"
+#include "cm_uv.h"
 
+#include "cmsys/Directory.hxx"
 #include "cmsys/FStream.hxx"
 #include "cmsys/Glob.hxx"
 #include "cmsys/Process.h"
@@ -23,11 +28,15 @@
 #include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <deque>
+#include <functional>
 #include <iomanip>
 #include <iterator>
+#include <memory>
 #include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
+#include <thread>
 #include <utility>
 
 class cmMakefile;
@@ -267,6 +276,122 @@ bool cmCTestCoverageHandler::ShouldIDoCoverage(std::string const& file,
   return true;
 }
 
+namespace {
+// A source file whose lines are written to a coverage log.
+struct cmCTestCoverageLogEntry
+{
+  std::string FullPath;
+  std::string FileName;
+  std::string ShortPath;
+  // Null for files found by the extra coverage globs that have no
+  // coverage data.
+  cmCTestCoverageHandlerContainer::SingleFileCoverageVector* Coverage =
+    nullptr;
+  bool Opened = false;
+  int Tested = 0;
+  int Untested = 0;
+};
+
+// One CoverageLog-<n>.xml file.  The main thread opens and closes it,
+// while its entries may be written by a thread of their own.
+struct cmCTestCoverageLogShard
+{
+  ~cmCTestCoverageLogShard()
+  {
+    if (this->Thread.joinable()) {
+      this->Thread.join();
+    }
+  }
+
+  int Index = 0;
+  cmGeneratedFileStream Stream;
+  cmXMLWriter XML{ this->Stream };
+  std::vector<cmCTestCoverageLogEntry> Entries;
+  std::vector<std::string> Errors;
+  int ErrorCount = 0;
+  std::thread Thread;
+};
+
+// Write the lines of each source file of a shard.  Source files are
+// streamed and the coverage of each file is released once it has been
+// written, so memory use does not grow with the size of the project.
+void cmCTestWriteCoverageLogShard(cmCTestCoverageLogShard& shard)
+{
+  cmXMLWriter& xml = shard.XML;
+  for (cmCTestCoverageLogEntry& entry : shard.Entries) {
+    xml.StartElement("File");
+    xml.Attribute("Name", entry.FileName);
+    xml.Attribute("FullPath", entry.ShortPath);
+    xml.StartElement("Report");
+
+    cmsys::ifstream ifs(entry.FullPath.c_str());
+    if (!ifs) {
+      std::ostringstream ostr;
+      ostr << "Cannot open source file: " << entry.FullPath;
+      shard.Errors.push_back(ostr.str());
+      shard.ErrorCount++;
+      if (!entry.Coverage) {
+        xml.EndElement(); // Report
+        xml.EndElement(); // File
+      }
+      continue;
+    }
+    entry.Opened = true;
+
+    std::string line;
+    if (!entry.Coverage) {
+      while (cmSystemTools::GetLineFromStream(ifs, line)) {
+        xml.StartElement("Line");
+        xml.Attribute("Number", entry.Untested);
+        xml.Attribute("Count", 0);
+        xml.Content(line);
+        xml.EndElement(); // Line
+        entry.Untested++;
+      }
+      xml.EndElement(); // Report
+      xml.EndElement(); // File
+      continue;
+    }
+
+    cmCTestCoverageHandlerContainer::SingleFileCoverageVector& fcov =
+      *entry.Coverage;
+    cmCTestCoverageHandlerContainer::SingleFileCoverageVector::size_type cc;
+    for (cc = 0; cc < fcov.size(); cc++) {
+      if (!cmSystemTools::GetLineFromStream(ifs, line) &&
+          cc != fcov.size() - 1) {
+        std::ostringstream ostr;
+        ostr << "Problem reading source file: " << entry.FullPath
+             << " line:" << cc << "  out total: " << fcov.size() - 1;
+        shard.Errors.push_back(ostr.str());
+        shard.ErrorCount++;
+        break;
+      }
+      xml.StartElement("Line");
+      xml.Attribute("Number", cc);
+      xml.Attribute("Count", fcov[cc]);
+      xml.Content(line);
+      xml.EndElement(); // Line
+      if (fcov[cc] == 0) {
+        entry.Untested++;
+      } else if (fcov[cc] > 0) {
+        entry.Tested++;
+      }
+    }
+    if (cmSystemTools::GetLineFromStream(ifs, line)) {
+      std::ostringstream ostr;
+      ostr << "Looks like there are more lines in the file: "
+           << entry.FullPath;
+      shard.Errors.push_back(ostr.str());
+    }
+    xml.EndElement(); // Report
+    xml.EndElement(); // File
+
+    // Nothing needs the line counts anymore.
+    cmCTestCoverageHandlerContainer::SingleFileCoverageVector().swap(fcov);
+  }
+}
+}
+
 // clearly it would be nice if this were broken up into a few smaller
 // functions and commented...
 int cmCTestCoverageHandler::ProcessHandler()
@@ -399,11 +524,6 @@ int cmCTestCoverageHandler::ProcessHandler()
   covSumXML.StartElement("Coverage");
   covSumXML.Element("StartDateTime", coverage_start_time);
   covSumXML.Element("StartTime", coverage_start_time_time);
-  int logFileCount = 0;
-  if (!this->StartCoverageLogFile(covLogFile, logFileCount)) {
-    return -1;
-  }
-  this->StartCoverageLogXML(covLogXML);
   int cnt = 0;
   long total_tested = 0;
   long total_untested = 0;
@@ -418,8 +538,93 @@ int cmCTestCoverageHandler::ProcessHandler()
 
   std::vector<std::string> errorsWhileAccumulating;
 
+  // The coverage logs are written by up to one thread per parallel
+  // job.  The main thread keeps collecting the files of the next log
+  // and writes the summary of each log in order once it is complete.
+  size_t const maxShards =
+    static_cast<size_t>(std::max(this->CTest->GetParallelLevel(), 1));
+  std::deque<std::unique_ptr<cmCTestCoverageLogShard>> shards;
+  auto finishShard = [&]() {
+    cmCTestCoverageLogShard& shard = *shards.front();
+    if (shard.Thread.joinable()) {
+      shard.Thread.join();
+    }
+    this->EndCoverageLogXML(shard.XML);
+    this->EndCoverageLogFile(shard.Stream, shard.Index);
+    errorsWhileAccumulating.insert(errorsWhileAccumulating.end(),
+                                   shard.Errors.begin(), shard.Errors.end());
+    error += shard.ErrorCount;
+
+    for (cmCTestCoverageLogEntry const& entry : shard.Entries) {
+      if (!entry.Opened) {
+        continue;
+      }
+      int const tested = entry.Tested;
+      int const untested = entry.Untested;
+      total_tested += tested;
+      total_untested += untested;
+      covSumXML.StartElement("File");
+      covSumXML.Attribute("Name", entry.FileName);
+      covSumXML.Attribute("FullPath", entry.ShortPath);
+      if (!entry.Coverage) {
+        covSumXML.Attribute("Covered", "true");
+        covSumXML.Element("LOCTested", 0);
+        covSumXML.Element("LOCUnTested", untested);
+        covSumXML.Element("PercentCoverage", 0);
+        covSumXML.Element("CoverageMetric", 0);
+      } else {
+        float cper = 0;
+        float cmet = 0;
+        if (tested + untested > 0) {
+          cper = (100 *
+                  SAFEDIV(static_cast<float>(tested),
+                          static_cast<float>(tested + untested)));
+          cmet = (SAFEDIV(static_cast<float>(tested + 10),
+                          static_cast<float>(tested + untested + 10)));
+        }
+        covSumXML.Attribute("Covered",
+                            tested + untested > 0 ? "true" : "false");
+        covSumXML.Element("LOCTested", tested);
+        covSumXML.Element("LOCUnTested", untested);
+        covSumXML.Element("PercentCoverage", cper);
+        covSumXML.Element("CoverageMetric", cmet);
+      }
+      this->WriteXMLLabels(covSumXML, entry.ShortPath);
+      covSumXML.EndElement(); // File
+    }
+    shards.pop_front();
+  };
+  auto startShard = [&](int index) -> bool {
+    std::unique_ptr<cmCTestCoverageLogShard> shard =
+      cm::make_unique<cmCTestCoverageLogShard>();
+    shard->Index = index;
+    if (!this->StartCoverageLogFile(shard->Stream, index)) {
+      return false;
+    }
+    this->StartCoverageLogXML(shard->XML);
+    shards.push_back(std::move(shard));
+    return true;
+  };
+  auto writeShard = [&]() {
+    cmCTestCoverageLogShard& shard = *shards.back();
+    if (maxShards > 1) {
+      shard.Thread =
+        std::thread(cmCTestWriteCoverageLogShard, std::ref(shard));
+    } else {
+      cmCTestWriteCoverageLogShard(shard);
+    }
+    while (shards.size() > maxShards) {
+      finishShard();
+    }
+  };
+
+  int logFileCount = 0;
+  if (!startShard(logFileCount)) {
+    return -1;
+  }
+
   file_count = 0;
-  for (auto const& file : cont.TotalCoverage) {
+  for (auto& file : cont.TotalCoverage) {
     cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, "." << std::flush,
                        this->Quiet);
     file_count++;
@@ -454,146 +659,41 @@ int cmCTestCoverageHandler::ProcessHandler()
     }
 
     if (++cnt % 100 == 0) {
-      this->EndCoverageLogXML(covLogXML);
-      this->EndCoverageLogFile(covLogFile, logFileCount);
+      writeShard();
       logFileCount++;
-      if (!this->StartCoverageLogFile(covLogFile, logFileCount)) {
+      if (!startShard(logFileCount)) {
         return -1;
       }
-      this->StartCoverageLogXML(covLogXML);
-    }
-
-    const std::string fileName = cmSystemTools::GetFilenameName(fullFileName);
-    std::string shortFileName =
-      this->CTest->GetShortPathToFile(fullFileName.c_str());
-    const cmCTestCoverageHandlerContainer::SingleFileCoverageVector& fcov =
-      file.second;
-    covLogXML.StartElement("File");
-    covLogXML.Attribute("Name", fileName);
-    covLogXML.Attribute("FullPath", shortFileName);
-    covLogXML.StartElement("Report");
-
-    cmsys::ifstream ifs(fullFileName.c_str());
-    if (!ifs) {
-      std::ostringstream ostr;
-      ostr << "Cannot open source file: " << fullFileName;
-      errorsWhileAccumulating.push_back(ostr.str());
-      error++;
-      continue;
     }
 
-    int tested = 0;
-    int untested = 0;
-
-    cmCTestCoverageHandlerContainer::SingleFileCoverageVector::size_type cc;
-    std::string line;
     cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
                        "Actually performing coverage for: " << fullFileName
                                                             << std::endl,
                        this->Quiet);
-    for (cc = 0; cc < fcov.size(); cc++) {
-      if (!cmSystemTools::GetLineFromStream(ifs, line) &&
-          cc != fcov.size() - 1) {
-        std::ostringstream ostr;
-        ostr << "Problem reading source file: " << fullFileName
-             << " line:" << cc << "  out total: " << fcov.size() - 1;
-        errorsWhileAccumulating.push_back(ostr.str());
-        error++;
-        break;
-      }
-      covLogXML.StartElement("Line");
-      covLogXML.Attribute("Number", cc);
-      covLogXML.Attribute("Count", fcov[cc]);
-      covLogXML.Content(line);
-      covLogXML.EndElement(); // Line
-      if (fcov[cc] == 0) {
-        untested++;
-      } else if (fcov[cc] > 0) {
-        tested++;
-      }
-    }
-    if (cmSystemTools::GetLineFromStream(ifs, line)) {
-      std::ostringstream ostr;
-      ostr << "Looks like there are more lines in the file: " << fullFileName;
-      errorsWhileAccumulating.push_back(ostr.str());
-    }
-    float cper = 0;
-    float cmet = 0;
-    if (tested + untested > 0) {
-      cper = (100 *
-              SAFEDIV(static_cast<float>(tested),
-                      static_cast<float>(tested + untested)));
-      cmet = (SAFEDIV(static_cast<float>(tested + 10),
-                      static_cast<float>(tested + untested + 10)));
-    }
-    total_tested += tested;
-    total_untested += untested;
-    covLogXML.EndElement(); // Report
-    covLogXML.EndElement(); // File
-    covSumXML.StartElement("File");
-    covSumXML.Attribute("Name", fileName);
-    covSumXML.Attribute("FullPath",
-                        this->CTest->GetShortPathToFile(fullFileName.c_str()));
-    covSumXML.Attribute("Covered", tested + untested > 0 ? "true" : "false");
-    covSumXML.Element("LOCTested", tested);
-    covSumXML.Element("LOCUnTested", untested);
-    covSumXML.Element("PercentCoverage", cper);
-    covSumXML.Element("CoverageMetric", cmet);
-    this->WriteXMLLabels(covSumXML, shortFileName);
-    covSumXML.EndElement(); // File
+    cmCTestCoverageLogEntry entry;
+    entry.FullPath = fullFileName;
+    entry.FileName = cmSystemTools::GetFilenameName(fullFileName);
+    entry.ShortPath = this->CTest->GetShortPathToFile(fullFileName.c_str());
+    entry.Coverage = &file.second;
+    shards.back()->Entries.push_back(std::move(entry));
   }
 
   // Handle all the files in the extra coverage globs that have no cov data
   for (std::string const& u : uncovered) {
-    std::string fileName = cmSystemTools::GetFilenameName(u);
-    std::string fullPath = cont.SourceDir + "/" + u;
-
-    covLogXML.StartElement("File");
-    covLogXML.Attribute("Name", fileName);
-    covLogXML.Attribute("FullPath", u);
-    covLogXML.StartElement("Report");
-
-    cmsys::ifstream ifs(fullPath.c_str());
-    if (!ifs) {
-      std::ostringstream ostr;
-      ostr << "Cannot open source file: " << fullPath;
-      errorsWhileAccumulating.push_back(ostr.str());
-      error++;
-      covLogXML.EndElement(); // Report
-      covLogXML.EndElement(); // File
-      continue;
-    }
-    int untested = 0;
-    std::string line;
     cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
                        "Actually performing coverage for: " << u << std::endl,
                        this->Quiet);
-    while (cmSystemTools::GetLineFromStream(ifs, line)) {
-      covLogXML.StartElement("Line");
-      covLogXML.Attribute("Number", untested);
-      covLogXML.Attribute("Count", 0);
-      covLogXML.Content(line);
-      covLogXML.EndElement(); // Line
-      untested++;
-    }
-    covLogXML.EndElement(); // Report
-    covLogXML.EndElement(); // File
-
-    total_untested += untested;
-    covSumXML.StartElement("File");
-    covSumXML.Attribute("Name", fileName);
-    covSumXML.Attribute("FullPath", u);
-    covSumXML.Attribute("Covered", "true");
-    covSumXML.Element("LOCTested", 0);
-    covSumXML.Element("LOCUnTested", untested);
-    covSumXML.Element("PercentCoverage", 0);
-    covSumXML.Element("CoverageMetric", 0);
-    this->WriteXMLLabels(covSumXML, u);
-    covSumXML.EndElement(); // File
+    cmCTestCoverageLogEntry entry;
+    entry.FullPath = cont.SourceDir + "/" + u;
+    entry.FileName = cmSystemTools::GetFilenameName(u);
+    entry.ShortPath = u;
+    shards.back()->Entries.push_back(std::move(entry));
   }
 
-  this->EndCoverageLogXML(covLogXML);
-  this->EndCoverageLogFile(covLogFile, logFileCount);
+  writeShard();
+  while (!shards.empty()) {
+    finishShard();
+  }
 
   if (!errorsWhileAccumulating.empty()) {
     cmCTestLog(this->CTest, ERROR_MESSAGE, std::endl);
@@ -919,6 +1019,277 @@ int cmCTestCoverageHandler::HandleBlanketJSCoverage(
   }
   return static_cast<int>(cont->TotalCoverage.size());
 }
+// Style 1 gcov output
+static const char* const st1gcovOutputRex1 =
+  "[0-9]+\\.[0-9]+% of [0-9]+ (source |)lines executed in file (.*)$";
+static const char* const st1gcovOutputRex2 = "^Creating (.*\\.gcov)\\.";
+
+// Style 2 gcov output
+static const char* const st2gcovOutputRex1 = "^File *[`'](.*)'$";
+static const char* const st2gcovOutputRex2 =
+  "Lines executed: *[0-9]+\\.[0-9]+% of [0-9]+$";
+static const char* const st2gcovOutputRex3 = "^(.*)reating [`'](.*\\.gcov)'";
+static const char* const st2gcovOutputRex4 = "^(.*):unexpected EOF *$";
+static const char* const st2gcovOutputRex5 =
+  "^(.*):cannot open source file*$";
+static const char* const st2gcovOutputRex6 =
+  "^(.*):source file is newer than graph file `(.*)'$";
+
+namespace {
+typedef cmCTestCoverageHandlerContainer::SingleFileCoverageVector
+  cmCTestGCovLines;
+
+// Read the line counts of a .gcov file.  Lines without coverage
+// information are -1.
+void cmCTestReadGCovFile(std::istream& ifile, cmCTestGCovLines& vec)
+{
+  long cnt = -1;
+  std::string nl;
+  while (cmSystemTools::GetLineFromStream(ifile, nl)) {
+    cnt++;
+
+    // TODO: Handle gcov 3.0 non-coverage lines
+
+    // Skip empty lines
+    if (nl.empty()) {
+      continue;
+    }
+
+    // Skip unused lines
+    if (nl.size() < 12) {
+      continue;
+    }
+
+    // Read the coverage count from the beginning of the gcov output
+    // line
+    std::string prefix = nl.substr(0, 12);
+    int cov = atoi(prefix.c_str());
+
+    // Read the line number starting at the 10th character of the gcov
+    // output line
+    std::string lineNumber = nl.substr(10, 5);
+
+    int lineIdx = atoi(lineNumber.c_str()) - 1;
+    if (lineIdx >= 0) {
+      while (vec.size() <= static_cast<size_t>(lineIdx)) {
+        vec.push_back(-1);
+      }
+
+      // Initially all entries are -1 (not used). If we get coverage
+      // information, increment it to 0 first.
+      if (vec[lineIdx] < 0) {
+        if (cov > 0 || prefix.find('#') != std::string::npos) {
+          vec[lineIdx] = 0;
+        }
+      }
+
+      vec[lineIdx] += cov;
+    }
+  }
+}
+
+// Add the line counts read from one .gcov file to those of its source.
+void cmCTestMergeGCovLines(cmCTestGCovLines const& lines,
+                           cmCTestGCovLines& vec)
+{
+  if (vec.size() < lines.size()) {
+    vec.resize(lines.size(), -1);
+  }
+  for (size_t i = 0; i < lines.size(); ++i) {
+    if (lines[i] >= 0) {
+      if (vec[i] < 0) {
+        vec[i] = 0;
+      }
+      vec[i] += lines[i];
+    }
+  }
+}
+
+// The result of running gcov on one coverage data file.
+struct cmCTestGCovJob : public cmUVProcessPool::Job
+{
+  // Line counts of the .gcov files that may be needed for the report,
+  // by the name gcov printed for them.
+  std::map<std::string, cmCTestGCovLines> GCovFiles;
+};
+
+// Run gcov on several coverage data files at once.  gcov writes .gcov
+// files to its working directory, so each concurrent invocation gets
+// its own.  The .gcov files are read on the libuv thread pool.  The
+// jobs are handed to the merge function in order on the calling thread.
+// A job waiting for an earlier one to be merged keeps its line counts,
+// so at most two jobs per working directory are started ahead of the
+// next job to merge.
+class cmCTestGCovRunner
+{
+public:
+  typedef std::function<void(cmCTestGCovJob&)> MergeFunction;
+
+  cmCTestGCovRunner(std::vector<cmCTestGCovJob>& jobs,
+                    std::vector<std::string> const& workingDirectories,
+                    std::string const& sourceDir, std::string const& binaryDir,
+                    MergeFunction merge);
+
+  void Run();
+
+private:
+  struct Slot
+  {
+    cmCTestGCovRunner* Runner = nullptr;
+    size_t Index = 0;
+    size_t Job = 0;
+    // Whether gcov runs or its output is parsed
+    bool Busy = false;
+    uv_work_t Work;
+  };
+
+  void StartJobs();
+  void ParseJob(cmCTestGCovJob& job) const;
+  void MergeJobs();
+
+  static void OnParse(uv_work_t* req);
+  static void OnParsed(uv_work_t* req, int status);
+
+  std::vector<cmCTestGCovJob>& Jobs;
+  std::vector<std::string> WorkingDirectories;
+  std::string SourceDir;
+  std::string BinaryDir;
+  MergeFunction Merge;
+  std::vector<Slot> Slots;
+  cmUVProcessPool Pool;
+  std::vector<bool> Done;
+  size_t NextJob = 0;
+  size_t NextMerge = 0;
+};
+
+cmCTestGCovRunner::cmCTestGCovRunner(
+  std::vector<cmCTestGCovJob>& jobs,
+  std::vector<std::string> const& workingDirectories,
+  std::string const& sourceDir, std::string const& binaryDir,
+  MergeFunction merge)
+  : Jobs(jobs)
+  , WorkingDirectories(workingDirectories)
+  , SourceDir(sourceDir)
+  , BinaryDir(binaryDir)
+  , Merge(std::move(merge))
+  , Slots(workingDirectories.size())
+  , Pool(workingDirectories.size(),
+         [this](size_t slot) {
+           uv_queue_work(&this->Pool.GetLoop(), &this->Slots[slot].Work,
+                         &cmCTestGCovRunner::OnParse,
+                         &cmCTestGCovRunner::OnParsed);
+         })
+  , Done(jobs.size(), false)
+{
+  for (size_t i = 0; i < this->Slots.size(); ++i) {
+    Slot& slot = this->Slots[i];
+    slot.Runner = this;
+    slot.Index = i;
+    slot.Work.data = &slot;
+  }
+}
+
+void cmCTestGCovRunner::Run()
+{
+  this->StartJobs();
+  this->Pool.Run();
+}
+
+void cmCTestGCovRunner::StartJobs()
+{
+  this->MergeJobs();
+  size_t const maxAhead = 2 * this->Slots.size();
+  for (Slot& slot : this->Slots) {
+    while (!slot.Busy && this->NextJob < this->Jobs.size() &&
+           this->NextJob - this->NextMerge < maxAhead) {
+      slot.Job = this->NextJob++;
+      cmCTestGCovJob& job = this->Jobs[slot.Job];
+      job.WorkingDirectory = this->WorkingDirectories[slot.Index];
+      if (this->Pool.Start(slot.Index, job)) {
+        slot.Busy = true;
+      } else {
+        this->Done[slot.Job] = true;
+        this->MergeJobs();
+      }
+    }
+  }
+}
+
+void cmCTestGCovRunner::OnParse(uv_work_t* req)
+{
+  Slot& slot = *static_cast<Slot*>(req->data);
+  slot.Runner->ParseJob(slot.Runner->Jobs[slot.Job]);
+}
+
+void cmCTestGCovRunner::OnParsed(uv_work_t* req, int /*status*/)
+{
+  Slot& slot = *static_cast<Slot*>(req->data);
+  cmCTestGCovRunner& runner = *slot.Runner;
+  runner.Done[slot.Job] = true;
+  slot.Busy = false;
+  runner.StartJobs();
+}
+
+void cmCTestGCovRunner::ParseJob(cmCTestGCovJob& job) const
+{
+  cmProcessOutput processOutput;
+  processOutput.DecodeText(job.Output, job.Output);
+  processOutput.DecodeText(job.Errors, job.Errors);
+  if (!job.Exited) {
+    return;
+  }
+
+  // Classify the output lines like HandleGCovCoverage does to find the
+  // .gcov files it will read.  These are the ones for sources in the
+  // source or binary tree.  A .gcov file may also belong to a source
+  // named in the output for the previous data file.
+  cmsys::RegularExpression st1re1(st1gcovOutputRex1);
+  cmsys::RegularExpression st1re2(st1gcovOutputRex2);
+  cmsys::RegularExpression st2re1(st2gcovOutputRex1);
+  cmsys::RegularExpression st2re2(st2gcovOutputRex2);
+  cmsys::RegularExpression st2re3(st2gcovOutputRex3);
+  bool inTree = true;
+  std::vector<std::string> lines;
+  cmSystemTools::Split(job.Output.c_str(), lines);
+  for (std::string const& line : lines) {
+    std::string gcovFile;
+    if (st1re1.find(line)) {
+      inTree = IsFileInDir(st1re1.match(2), this->SourceDir) ||
+        IsFileInDir(st1re1.match(2), this->BinaryDir);
+    } else if (st1re2.find(line)) {
+      gcovFile = st1re2.match(1);
+    } else if (st2re1.find(line)) {
+      inTree = IsFileInDir(st2re1.match(1), this->SourceDir) ||
+        IsFileInDir(st2re1.match(1), this->BinaryDir);
+    } else if (st2re2.find(line)) {
+      // Nothing to read.
+    } else if (st2re3.find(line)) {
+      gcovFile = st2re3.match(2);
+    }
+    if (!gcovFile.empty() && inTree &&
+        job.GCovFiles.find(gcovFile) == job.GCovFiles.end()) {
+      std::string const path =
+        cmSystemTools::CollapseFullPath(gcovFile, job.WorkingDirectory);
+      cmsys::ifstream ifile(path.c_str());
+      if (ifile) {
+        cmCTestReadGCovFile(ifile, job.GCovFiles[gcovFile]);
+      }
+    }
+  }
+}
+
+void cmCTestGCovRunner::MergeJobs()
+{
+  while (this->NextMerge < this->Jobs.size() &&
+         this->Done[this->NextMerge]) {
+    cmCTestGCovJob& job = this->Jobs[this->NextMerge++];
+    this->Merge(job);
+    // Release the output and line counts of the job.
+    job = cmCTestGCovJob();
+  }
+}
+}
+
 int cmCTestCoverageHandler::HandleGCovCoverage(
   cmCTestCoverageHandlerContainer* cont)
 {
@@ -939,27 +1310,16 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
   }
 
   // Style 1
-  std::string st1gcovOutputRex1 =
-    "[0-9]+\\.[0-9]+% of [0-9]+ (source |)lines executed in file (.*)$";
-  std::string st1gcovOutputRex2 = "^Creating (.*\\.gcov)\\.";
-  cmsys::RegularExpression st1re1(st1gcovOutputRex1.c_str());
-  cmsys::RegularExpression st1re2(st1gcovOutputRex2.c_str());
+  cmsys::RegularExpression st1re1(st1gcovOutputRex1);
+  cmsys::RegularExpression st1re2(st1gcovOutputRex2);
 
   // Style 2
-  std::string st2gcovOutputRex1 = "^File *[`'](.*)'$";
-  std::string st2gcovOutputRex2 =
-    "Lines executed: *[0-9]+\\.[0-9]+% of [0-9]+$";
-  std::string st2gcovOutputRex3 = "^(.*)reating [`'](.*\\.gcov)'";
-  std::string st2gcovOutputRex4 = "^(.*):unexpected EOF *$";
-  std::string st2gcovOutputRex5 = "^(.*):cannot open source file*$";
-  std::string st2gcovOutputRex6 =
-    "^(.*):source file is newer than graph file `(.*)'$";
-  cmsys::RegularExpression st2re1(st2gcovOutputRex1.c_str());
-  cmsys::RegularExpression st2re2(st2gcovOutputRex2.c_str());
-  cmsys::RegularExpression st2re3(st2gcovOutputRex3.c_str());
-  cmsys::RegularExpression st2re4(st2gcovOutputRex4.c_str());
-  cmsys::RegularExpression st2re5(st2gcovOutputRex5.c_str());
-  cmsys::RegularExpression st2re6(st2gcovOutputRex6.c_str());
+  cmsys::RegularExpression st2re1(st2gcovOutputRex1);
+  cmsys::RegularExpression st2re2(st2gcovOutputRex2);
+  cmsys::RegularExpression st2re3(st2gcovOutputRex3);
+  cmsys::RegularExpression st2re4(st2gcovOutputRex4);
+  cmsys::RegularExpression st2re5(st2gcovOutputRex5);
+  cmsys::RegularExpression st2re6(st2gcovOutputRex6);
 
   std::vector<std::string> files;
   this->FindGCovFiles(files);
@@ -1007,29 +1367,46 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
   // These are binary files that you give as input to gcov so that it will
   // give us text output we can analyze to summarize coverage.
   //
-  for (std::string const& f : files) {
+  std::vector<cmCTestGCovJob> jobs(files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    // Call gcov to get coverage data for this *.gcda file:
+    //
+    jobs[i].Command = basecovargs;
+    jobs[i].Command.push_back(cmSystemTools::GetFilenamePath(files[i]));
+    jobs[i].Command.push_back(files[i]);
+  }
+
+  // Run gcov for several files at once, each in its own directory.
+  std::vector<std::string> workingDirectories(1, tempDir);
+  int const parallelLevel = this->CTest->GetParallelLevel();
+  for (int i = 1; i < parallelLevel && static_cast<size_t>(i) < files.size();
+       ++i) {
+    std::string dir = tempDir + "/gcov-" + std::to_string(i);
+    if (!cmSystemTools::MakeDirectory(dir)) {
+      break;
+    }
+    workingDirectories.push_back(std::move(dir));
+  }
+
+  // Process the results in the order of the files.
+  size_t fileIndex = 0;
+  auto processJob = [&](cmCTestGCovJob& job) {
+    std::string const& f = files[fileIndex++];
     cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, "." << std::flush,
                        this->Quiet);
 
-    // Call gcov to get coverage data for this *.gcda file:
-    //
     std::string fileDir = cmSystemTools::GetFilenamePath(f);
-    std::vector<std::string> covargs = basecovargs;
-    covargs.push_back(fileDir);
-    covargs.push_back(f);
-    const std::string command = joinCommandLine(covargs);
+    const std::string command = joinCommandLine(job.Command);
 
     cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
                        command << std::endl, this->Quiet);
 
-    std::string output;
-    std::string errors;
-    int retVal = 0;
+    std::string const& output = job.Output;
+    std::string const& errors = job.Errors;
+    int retVal = job.ExitValue;
     *cont->OFS << "* Run coverage for: " << fileDir << std::endl;
     *cont->OFS << "  Command: " << command << std::endl;
-    int res = this->CTest->RunCommand(covargs, &output, &errors, &retVal,
-                                      tempDir.c_str(),
-                                      cmDuration::zero() /*this->TimeOut*/);
+    bool res = job.Exited;
 
     *cont->OFS << "  Output: " << output << std::endl;
     *cont->OFS << "  Errors: " << errors << std::endl;
@@ -1039,7 +1416,7 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
       cmCTestLog(this->CTest, ERROR_MESSAGE,
                  "Command produced error: " << errors << std::endl);
       cont->Error++;
-      continue;
+      return;
     }
     if (retVal != 0) {
       cmCTestLog(this->CTest, ERROR_MESSAGE,
@@ -1201,54 +1578,13 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
                            "   in gcovFile: " << gcovFile << std::endl,
                            this->Quiet);
 
-        cmsys::ifstream ifile(gcovFile.c_str());
-        if (!ifile) {
+        // The .gcov file was read when gcov finished.
+        auto gcovLines = job.GCovFiles.find(gcovFile);
+        if (gcovLines == job.GCovFiles.end()) {
           cmCTestLog(this->CTest, ERROR_MESSAGE,
                      "Cannot open file: " << gcovFile << std::endl);
         } else {
-          long cnt = -1;
-          std::string nl;
-          while (cmSystemTools::GetLineFromStream(ifile, nl)) {
-            cnt++;
-
-            // TODO: Handle gcov 3.0 non-coverage lines
-
-            // Skip empty lines
-            if (nl.empty()) {
-              continue;
-            }
-
-            // Skip unused lines
-            if (nl.size() < 12) {
-              continue;
-            }
-
-            // Read the coverage count from the beginning of the gcov output
-            // line
-            std::string prefix = nl.substr(0, 12);
-            int cov = atoi(prefix.c_str());
-
-            // Read the line number starting at the 10th character of the gcov
-            // output line
-            std::string lineNumber = nl.substr(10, 5);
-
-            int lineIdx = atoi(lineNumber.c_str()) - 1;
-            if (lineIdx >= 0) {
-              while (vec.size() <= static_cast<size_t>(lineIdx)) {
-                vec.push_back(-1);
-              }
-
-              // Initially all entries are -1 (not used). If we get coverage
-              // information, increment it to 0 first.
-              if (vec[lineIdx] < 0) {
-                if (cov > 0 || prefix.find('#') != std::string::npos) {
-                  vec[lineIdx] = 0;
-                }
-              }
-
-              vec[lineIdx] += cov;
-            }
-          }
+          cmCTestMergeGCovLines(gcovLines->second, vec);
         }
 
         actualSourceFile.clear();
@@ -1311,6 +1647,29 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
                          this->Quiet);
       cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, "    ", this->Quiet);
     }
+  };
+
+  cmCTestGCovRunner runner(jobs, workingDirectories, cont->SourceDir,
+                           cont->BinaryDir, processJob);
+  runner.Run();
+
+  // Move the .gcov files written in the extra working directories next
+  // to the others and remove the directories.  The line counts were
+  // already merged from the parsed files.  Of several .gcov files for
+  // the same source, e.g. a header, the one kept is not necessarily
+  // the one of the last data file.
+  for (size_t i = 1; i < workingDirectories.size(); ++i) {
+    std::string const& dir = workingDirectories[i];
+    cmsys::Directory d;
+    if (d.Load(dir)) {
+      for (unsigned long j = 0; j < d.GetNumberOfFiles(); ++j) {
+        std::string const name = d.GetFile(j);
+        if (cmSystemTools::StringEndsWith(name, ".gcov")) {
+          cmSystemTools::RenameFile(dir + "/" + name, tempDir + "/" + name);
+        }
+      }
+    }
+    cmSystemTools::RemoveADirectory(dir);
   }
 
   return file_count;
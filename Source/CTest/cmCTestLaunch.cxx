@@ -4,7 +4,6 @@
 
 #include "cmsys/FStream.hxx"
 #include "cmsys/Process.h"
-#include "cmsys/RegularExpression.hxx"
 #include <iostream>
 #include <memory> // IWYU pragma: keep
 #include <stdlib.h>
@@ -534,17 +533,17 @@ void cmCTestLaunch::LoadScrapeRules()
   // Common compiler warning formats.  These are much simpler than the
   // full log-scraping expressions because we do not need to extract
   // file and line information.
-  this->RegexWarning.emplace_back("(^|[ :])[Ww][Aa][Rr][Nn][Ii][Nn][Gg]");
-  this->RegexWarning.emplace_back("(^|[ :])[Rr][Ee][Mm][Aa][Rr][Kk]");
-  this->RegexWarning.emplace_back("(^|[ :])[Nn][Oo][Tt][Ee]");
+  this->RegexWarning.Add("(^|[ :])[Ww][Aa][Rr][Nn][Ii][Nn][Gg]");
+  this->RegexWarning.Add("(^|[ :])[Rr][Ee][Mm][Aa][Rr][Kk]");
+  this->RegexWarning.Add("(^|[ :])[Nn][Oo][Tt][Ee]");
 
   // Load custom match rules given to us by CTest.
   this->LoadScrapeRules("Warning", this->RegexWarning);
   this->LoadScrapeRules("WarningSuppress", this->RegexWarningSuppress);
 }
 
-void cmCTestLaunch::LoadScrapeRules(
-  const char* purpose, std::vector<cmsys::RegularExpression>& regexps)
+void cmCTestLaunch::LoadScrapeRules(const char* purpose,
+                                    cmRegularExpressionSet& regexps)
 {
   std::string fname = this->LogDir;
   fname += "Custom";
@@ -552,11 +551,8 @@ void cmCTestLaunch::LoadScrapeRules(
   fname += ".txt";
   cmsys::ifstream fin(fname.c_str(), std::ios::in | std::ios::binary);
   std::string line;
-  cmsys::RegularExpression rex;
   while (cmSystemTools::GetLineFromStream(fin, line)) {
-    if (rex.compile(line)) {
-      regexps.push_back(rex);
-    }
+    regexps.Add(line);
   }
 }
 
@@ -582,14 +578,9 @@ bool cmCTestLaunch::ScrapeLog(std::string const& fname)
 }
 
 bool cmCTestLaunch::Match(std::string const& line,
-                          std::vector<cmsys::RegularExpression>& regexps)
+                          cmRegularExpressionSet& regexps)
 {
-  for (cmsys::RegularExpression& r : regexps) {
-    if (r.find(line)) {
-      return true;
-    }
-  }
-  return false;
+  return regexps.Find(line) != cmRegularExpressionSet::npos;
 }
 
 bool cmCTestLaunch::MatchesFilterPrefix(std::string const& line) const
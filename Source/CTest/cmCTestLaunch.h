@@ -5,7 +5,7 @@
 
 #include "cmConfigure.h" // IWYU pragma: keep
 
-#include "cmsys/RegularExpression.hxx"
+#include "cmRegularExpressionSet.h"
 #include <set>
 #include <string>
 #include <vector>
@@ -77,14 +77,12 @@ private:
 
   // Regular expressions to match warnings and their exceptions.
   bool ScrapeRulesLoaded;
-  std::vector<cmsys::RegularExpression> RegexWarning;
-  std::vector<cmsys::RegularExpression> RegexWarningSuppress;
+  cmRegularExpressionSet RegexWarning;
+  cmRegularExpressionSet RegexWarningSuppress;
   void LoadScrapeRules();
-  void LoadScrapeRules(const char* purpose,
-                       std::vector<cmsys::RegularExpression>& regexps);
+  void LoadScrapeRules(const char* purpose, cmRegularExpressionSet& regexps);
   bool ScrapeLog(std::string const& fname);
-  bool Match(std::string const& line,
-             std::vector<cmsys::RegularExpression>& regexps);
+  bool Match(std::string const& line, cmRegularExpressionSet& regexps);
   bool MatchesFilterPrefix(std::string const& line) const;
 
   // Methods to generate the xml fragment.
@@ -3,9 +3,12 @@
 #include "cmCTestMultiProcessHandler.h"
 
 #include "cmAffinity.h"
+#include "cmAlgorithms.h"
 #include "cmCTest.h"
+#include "cmCTestResourceMonitor.h"
 #include "cmCTestRunTest.h"
 #include "cmCTestTestHandler.h"
+#include "cmCTestWorkerPool.h"
 #include "cmDuration.h"
 #include "cmListFileCache.h"
 #include "cmSystemTools.h"
@@ -82,9 +85,17 @@ void cmCTestMultiProcessHandler::SetTests(TestMap& tests,
   for (auto const& t : this->Tests) {
     this->TestRunningMap[t.first] = false;
     this->TestFinishMap[t.first] = false;
+    this->Dependents[t.first];
+    for (int d : t.second) {
+      this->Dependents[d].insert(t.first);
+    }
   }
+  this->ReadResourceUsageData();
   if (!this->CTest->GetShowOnly()) {
     this->ReadCostData();
+    if (this->CacheResults) {
+      this->ResultCache.Load(this->GetResultCacheFile());
+    }
     this->HasCycles = !this->CheckCycles();
     if (this->HasCycles) {
       return;
@@ -114,6 +125,21 @@ void cmCTestMultiProcessHandler::SetTestLoad(unsigned long load)
   }
 }
 
+void cmCTestMultiProcessHandler::SetTestPressure(unsigned long pressure)
+{
+  this->TestPressure = pressure;
+
+  std::string fake_pressure_value;
+  if (cmSystemTools::GetEnv("__CTEST_FAKE_PRESSURE_FOR_TESTING",
+                            fake_pressure_value)) {
+    if (!cmSystemTools::StringToULong(fake_pressure_value.c_str(),
+                                      &this->FakePressureForTesting)) {
+      cmSystemTools::Error("Failed to parse fake pressure value: ",
+                           fake_pressure_value.c_str());
+    }
+  }
+}
+
 void cmCTestMultiProcessHandler::RunTests()
 {
   this->CheckResume();
@@ -125,13 +151,37 @@ void cmCTestMultiProcessHandler::RunTests()
 #endif
   this->TestHandler->SetMaxIndex(this->FindMaxIndex());
 
+  auto const clock_start = std::chrono::steady_clock::now();
   uv_loop_init(&this->Loop);
+  if (this->Workers > 0) {
+    this->WorkerPool = cm::make_unique<cmCTestWorkerPool>(this->CTest);
+    if (!this->WorkerPool->Start(this->Loop, this->Workers)) {
+      this->WorkerPool.reset();
+    }
+  }
   this->StartNextTests();
   uv_run(&this->Loop, UV_RUN_DEFAULT);
+  if (this->WorkerPool) {
+    // Wait for the workers to exit.
+    this->WorkerPool->Stop();
+    uv_run(&this->Loop, UV_RUN_DEFAULT);
+    this->WorkerPool.reset();
+  }
   uv_loop_close(&this->Loop);
 
+  if (this->ParallelLevel > 1) {
+    this->PrintMakespanReport(std::chrono::steady_clock::now() -
+                              clock_start);
+  }
   this->MarkFinished();
   this->UpdateCostData();
+  this->UpdateResourceUsageData();
+  if (this->CacheResults &&
+      !this->ResultCache.Save(this->GetResultCacheFile())) {
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "Cannot write test result cache: " << this->GetResultCacheFile()
+                                                  << std::endl);
+  }
 }
 
 bool cmCTestMultiProcessHandler::StartTestProcess(int test)
@@ -157,6 +207,7 @@ bool cmCTestMultiProcessHandler::StartTestProcess(int test)
   // now remove the test itself
   this->EraseTest(test);
   this->RunningCount += GetProcessorsUsed(test);
+  this->TestStartTimes[test] = std::chrono::steady_clock::now();
 
   cmCTestRunTest* testRun = new cmCTestRunTest(*this);
   if (this->CTest->GetRepeatUntilFail()) {
@@ -186,6 +237,7 @@ bool cmCTestMultiProcessHandler::StartTestProcess(int test)
                           std::strerror(workdir.GetLastResult()));
   } else {
     if (testRun->StartTest(this->Completed, this->Total)) {
+      this->RunningTests[test] = testRun;
       return true;
     }
   }
@@ -249,6 +301,12 @@ void cmCTestMultiProcessHandler::EraseTest(int test)
 inline size_t cmCTestMultiProcessHandler::GetProcessorsUsed(int test)
 {
   size_t processors = static_cast<int>(this->Properties[test]->Processors);
+  // With admission control, reserve as many processors as the test
+  // kept busy before.
+  int const expected = this->Properties[test]->ExpectedProcessors;
+  if (this->TestPressure > 0 && static_cast<size_t>(expected) > processors) {
+    processors = static_cast<size_t>(expected);
+  }
   // If processors setting is set higher than the -j
   // setting, we default to using all of the process slots.
   if (processors > this->ParallelLevel) {
@@ -350,6 +408,59 @@ void cmCTestMultiProcessHandler::StartNextTests()
     }
   }
 
+  // Memory the tests are expected to need in KiB, if the
+  // available memory is known.
+  bool checkMemory = false;
+  uint64_t spareMemory = 0;
+  if (this->TestPressure > 0) {
+    // Pressure stall information reacts within seconds, unlike the load
+    // average, so wait briefly while tasks are stalling.
+    double cpuPressure = 0;
+    double memoryPressure = 0;
+    bool const fakePressure = this->FakePressureForTesting > 0;
+    if (fakePressure) {
+      cpuPressure = static_cast<double>(this->FakePressureForTesting);
+      // Drop the fake pressure for the next iteration to a value low
+      // enough that the next iteration will start tests.
+      this->FakePressureForTesting = 1;
+    } else {
+      cmCTestResourceMonitor::GetPressure(
+        cmCTestResourceMonitor::Resource::CPU, cpuPressure);
+      cmCTestResourceMonitor::GetPressure(
+        cmCTestResourceMonitor::Resource::Memory, memoryPressure);
+    }
+    double const maxPressure = static_cast<double>(this->TestPressure);
+    if (cpuPressure > maxPressure || memoryPressure > maxPressure) {
+      /* clang-format off */
+      cmCTestLog(this->CTest, HANDLER_OUTPUT,
+                 "***** WAITING, "
+                 "CPU Pressure: " << cpuPressure << "%, "
+                 "Memory Pressure: " << memoryPressure << "%, "
+                 "Max Allowed Pressure: " << this->TestPressure << "% "
+                 "*****" << std::endl);
+      /* clang-format on */
+      if (this->TestLoadRetryTimer.get() == nullptr) {
+        this->TestLoadRetryTimer.init(this->Loop, this);
+      }
+      // The kernel updates the averages every 2 seconds.
+      this->TestLoadRetryTimer.start(
+        &cmCTestMultiProcessHandler::OnTestLoadRetryCB,
+        fakePressure ? 10 : 1000, 0);
+      return;
+    }
+
+    // Keep the memory that the running tests are expected to need
+    // beyond what they use already.
+    checkMemory = cmCTestResourceMonitor::GetAvailableMemory(spareMemory);
+    for (auto const& r : this->RunningTests) {
+      uint64_t const expected = this->Properties[r.first]->ExpectedMemory;
+      uint64_t const used = r.second->GetResidentSetSize();
+      uint64_t const reserved = expected > used ? expected - used : 0;
+      spareMemory = spareMemory > reserved ? spareMemory - reserved : 0;
+    }
+  }
+
+  size_t const completedBefore = this->Completed;
   TestList copy = this->SortedTests;
   for (auto const& test : copy) {
     // Take a nap if we're currently performing a RUN_SERIAL test.
@@ -380,8 +491,22 @@ void cmCTestMultiProcessHandler::StartNextTests()
       testWithMinProcessors = GetName(test);
     }
 
-    if (testLoadOk && processors <= numToStart && this->StartTest(test)) {
+    // A test always fits if no others are running.
+    uint64_t const memory = this->Properties[test]->ExpectedMemory;
+    bool memoryOk = true;
+    if (checkMemory && memory > spareMemory && this->RunningCount > 0) {
+      cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                 "Waiting for memory to run "
+                   << GetName(test) << ", it is expected to use " << memory
+                   << " KiB & " << spareMemory << " KiB are available"
+                   << std::endl);
+      memoryOk = false;
+    }
+
+    if (testLoadOk && memoryOk && processors <= numToStart &&
+        this->StartTest(test)) {
       numToStart -= processors;
+      spareMemory -= std::min(memory, spareMemory);
     } else if (numToStart == 0) {
       break;
     }
@@ -425,6 +550,16 @@ void cmCTestMultiProcessHandler::StartNextTests()
     }
     this->TestLoadRetryTimer.start(
       &cmCTestMultiProcessHandler::OnTestLoadRetryCB, milliseconds, 0);
+  } else if (this->Completed != completedBefore && numToStart > 0 &&
+             !this->Tests.empty()) {
+    // Tests that finished without running, e.g. because their results
+    // were cached, may have been the last dependencies of tests passed
+    // over above.  Look at the remaining tests again.
+    if (this->TestLoadRetryTimer.get() == nullptr) {
+      this->TestLoadRetryTimer.init(this->Loop, this);
+    }
+    this->TestLoadRetryTimer.start(
+      &cmCTestMultiProcessHandler::OnTestLoadRetryCB, 0, 0);
   }
 }
 
@@ -453,6 +588,13 @@ void cmCTestMultiProcessHandler::FinishTestProcess(cmCTestRunTest* runner,
     }
   }
 
+  this->TestDurations[test] =
+    std::chrono::steady_clock::now() - this->TestStartTimes[test];
+
+  if (this->CacheResults) {
+    this->UpdateResultCache(runner, started);
+  }
+
   if (testResult) {
     this->Passed->push_back(properties->Name);
   } else if (!properties->Disabled) {
@@ -474,6 +616,7 @@ void cmCTestMultiProcessHandler::FinishTestProcess(cmCTestRunTest* runner,
   }
   properties->Affinity.clear();
 
+  this->RunningTests.erase(test);
   delete runner;
   if (started) {
     this->StartNextTests();
@@ -538,6 +681,140 @@ void cmCTestMultiProcessHandler::UpdateCostData()
   cmSystemTools::RenameFile(tmpout, fname);
 }
 
+std::string cmCTestMultiProcessHandler::GetResourceUsageDataFile()
+{
+  return cmSystemTools::GetFilenamePath(this->CTest->GetCostDataFile()) +
+    "/CTestResourceUsage.txt";
+}
+
+void cmCTestMultiProcessHandler::UpdateResourceUsageData()
+{
+  std::string fname = this->GetResourceUsageDataFile();
+  std::string tmpout = fname + ".tmp";
+  cmsys::ofstream fout(tmpout.c_str());
+
+  auto write = [&fout](cmCTestTestHandler::cmCTestTestProperties const& p) {
+    cmCTestTestHandler::cmCTestResourceUsage const& usage =
+      p.AverageResourceUsage;
+    fout << p.Name << " " << p.ResourceUsageRuns << " "
+         << p.AverageExecutionTime << " " << usage.UserTime << " "
+         << usage.SystemTime << " " << usage.MaxResidentSetSize << " "
+         << usage.BlockInput << " " << usage.BlockOutput << " "
+         << p.ExpectedMemory << "\n";
+  };
+
+  PropertiesMap temp = this->Properties;
+
+  cmsys::ifstream fin(fname.c_str());
+  std::string line;
+  while (std::getline(fin, line)) {
+    std::vector<std::string> parts = cmSystemTools::SplitString(line, ' ');
+    if (parts.size() < 8) {
+      continue;
+    }
+    int index = this->SearchByName(parts[0]);
+    if (index == -1) {
+      // This test is not in memory. We just rewrite the entry
+      fout << line << "\n";
+    } else {
+      write(*this->Properties[index]);
+      temp.erase(index);
+    }
+  }
+  fin.close();
+
+  // Add the tests that used resources for the first time
+  for (auto const& i : temp) {
+    if (i.second->ResourceUsageRuns > 0) {
+      write(*i.second);
+    }
+  }
+  fout.close();
+  cmSystemTools::RenameFile(tmpout, fname);
+}
+
+void cmCTestMultiProcessHandler::ReadResourceUsageData()
+{
+  cmsys::ifstream fin(this->GetResourceUsageDataFile().c_str());
+  std::string line;
+  while (std::getline(fin, line)) {
+    // Format: <name> <runs> <execution_time> <user_time> <system_time>
+    //         <max_rss> <block_input> <block_output> <expected_memory>
+    std::vector<std::string> parts = cmSystemTools::SplitString(line, ' ');
+    if (parts.size() < 8) {
+      continue;
+    }
+    int index = this->SearchByName(parts[0]);
+    if (index == -1) {
+      continue;
+    }
+
+    cmCTestTestHandler::cmCTestTestProperties& p = *this->Properties[index];
+    cmCTestTestHandler::cmCTestResourceUsage& usage = p.AverageResourceUsage;
+    p.ResourceUsageRuns = atoi(parts[1].c_str());
+    p.AverageExecutionTime = atof(parts[2].c_str());
+    usage.UserTime = atof(parts[3].c_str());
+    usage.SystemTime = atof(parts[4].c_str());
+    usage.MaxResidentSetSize = strtoull(parts[5].c_str(), nullptr, 10);
+    usage.BlockInput = strtoull(parts[6].c_str(), nullptr, 10);
+    usage.BlockOutput = strtoull(parts[7].c_str(), nullptr, 10);
+    // The memory to keep free for the test with --test-pressure.
+    p.ExpectedMemory = parts.size() > 8
+      ? strtoull(parts[8].c_str(), nullptr, 10)
+      : usage.MaxResidentSetSize;
+
+    // Tests whose threads or child processes kept several processors
+    // busy at once.
+    if (p.ResourceUsageRuns > 0 && p.AverageExecutionTime > 0) {
+      p.ExpectedProcessors = static_cast<int>(
+        floor((usage.UserTime + usage.SystemTime) / p.AverageExecutionTime +
+              0.5));
+    }
+  }
+}
+
+std::string cmCTestMultiProcessHandler::GetResultCacheFile()
+{
+  return this->CTest->GetBinaryDir() +
+    "/Testing/Temporary/CTestResultCache.txt";
+}
+
+cmCTestResultCache* cmCTestMultiProcessHandler::GetResultCache()
+{
+  return this->CacheResults ? &this->ResultCache : nullptr;
+}
+
+bool cmCTestMultiProcessHandler::IsResultCached(int test,
+                                                std::string const& fingerprint)
+{
+  if (!this->CacheResults || this->ResultCacheInvalidated.count(test) != 0) {
+    return false;
+  }
+  return this->ResultCache.IsPassed(this->Properties[test]->Name, fingerprint);
+}
+
+void cmCTestMultiProcessHandler::UpdateResultCache(cmCTestRunTest* runner,
+                                                   bool started)
+{
+  if (runner->IsResultCached()) {
+    return;
+  }
+  int test = runner->GetIndex();
+  std::string const& name = this->Properties[test]->Name;
+  if (started &&
+      runner->GetTestResultStatus() == cmCTestTestHandler::COMPLETED) {
+    this->ResultCache.SetPassed(name, runner->GetFingerprint());
+  } else {
+    this->ResultCache.Remove(name);
+  }
+
+  // A test that ran may have changed what the tests depending on it see.
+  if (started) {
+    TestSet const& dependents = this->Dependents[test];
+    this->ResultCacheInvalidated.insert(dependents.begin(), dependents.end());
+  }
+}
+
 void cmCTestMultiProcessHandler::ReadCostData()
 {
   std::string fname = this->CTest->GetCostDataFile();
@@ -599,7 +876,10 @@ int cmCTestMultiProcessHandler::SearchByName(std::string const& name)
 
 void cmCTestMultiProcessHandler::CreateTestCostList()
 {
-  if (this->ParallelLevel > 1) {
+  if (this->ParallelLevel > 1 &&
+      this->CTest->GetScheduleType() == "CriticalPath") {
+    CreateCriticalPathTestCostList();
+  } else if (this->ParallelLevel > 1) {
     CreateParallelTestCostList();
   } else {
     CreateSerialTestCostList();
@@ -671,6 +951,102 @@ void cmCTestMultiProcessHandler::CreateParallelTestCostList()
   }
 }
 
+void cmCTestMultiProcessHandler::CreateCriticalPathTestCostList()
+{
+  // Tests without cost data are assumed to take as long as the average
+  // test with cost data.
+  double knownCost = 0;
+  size_t knownCount = 0;
+  for (auto const& t : this->Tests) {
+    if (this->Properties[t.first]->Cost > 0) {
+      knownCost += this->Properties[t.first]->Cost;
+      ++knownCount;
+    }
+  }
+  double const unknownCost = knownCount > 0 ? knownCost / knownCount : 1;
+
+  std::map<int, double> lengths;
+  for (auto const& t : this->Tests) {
+    float const cost = this->Properties[t.first]->Cost;
+    lengths[t.first] = cost > 0 ? cost : unknownCost;
+  }
+
+  // Start the tests with the longest chain of dependent tests first.
+  // Among those with equally long chains prefer the tests needing more
+  // processors, which are harder to fit in once the others are running.
+  std::map<int, double> remaining;
+  for (auto const& t : this->Tests) {
+    this->GetRemainingPathLength(t.first, lengths, remaining);
+    this->SortedTests.push_back(t.first);
+  }
+  std::stable_sort(this->SortedTests.begin(), this->SortedTests.end(),
+                   [this, &remaining](int a, int b) {
+                     if (remaining[a] != remaining[b]) {
+                       return remaining[a] > remaining[b];
+                     }
+                     return this->GetProcessorsUsed(a) >
+                       this->GetProcessorsUsed(b);
+                   });
+}
+
+double cmCTestMultiProcessHandler::GetRemainingPathLength(
+  int test, std::map<int, double> const& lengths,
+  std::map<int, double>& remaining)
+{
+  auto r = remaining.find(test);
+  if (r != remaining.end()) {
+    return r->second;
+  }
+
+  double longest = 0;
+  for (int d : this->Dependents[test]) {
+    longest =
+      std::max(longest, this->GetRemainingPathLength(d, lengths, remaining));
+  }
+  auto l = lengths.find(test);
+  if (l != lengths.end()) {
+    longest += l->second;
+  }
+  remaining[test] = longest;
+  return longest;
+}
+
+void cmCTestMultiProcessHandler::PrintMakespanReport(cmDuration achieved)
+{
+  // No schedule can finish before the longest chain of dependent tests
+  // or before all processors have done the work of all tests.
+  std::map<int, double> lengths;
+  double work = 0;
+  for (auto const& d : this->TestDurations) {
+    lengths[d.first] = d.second.count();
+    size_t processors = this->Properties[d.first]->RunSerial
+      ? this->ParallelLevel
+      : this->GetProcessorsUsed(d.first);
+    work += d.second.count() * processors;
+  }
+  std::map<int, double> remaining;
+  double criticalPath = 0;
+  for (auto const& d : this->TestDurations) {
+    criticalPath = std::max(
+      criticalPath, this->GetRemainingPathLength(d.first, lengths, remaining));
+  }
+  double const ideal = std::max(criticalPath, work / this->ParallelLevel);
+
+  std::ostringstream report;
+  report << std::fixed << std::setprecision(2)
+         << "\nTest makespan (real) = " << std::setw(6) << achieved.count()
+         << " sec\nIdeal makespan       = " << std::setw(6) << ideal
+         << " sec (critical path " << criticalPath << " sec, work " << work
+         << " sec on " << this->ParallelLevel << " processors)\n";
+  if (this->CTest->GetScheduleType() == "CriticalPath") {
+    cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, report.str(),
+                       this->Quiet);
+  } else {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT, report.str(),
+                       this->Quiet);
+  }
+}
+
 void cmCTestMultiProcessHandler::GetAllTestDependencies(int test,
                                                         TestList& dependencies)
 {
@@ -865,6 +1241,11 @@ static Json::Value DumpCTestProperties(
     properties.append(DumpCTestProperty(
       "RESOURCE_LOCK", DumpToJsonArray(testProperties.LockedResources)));
   }
+  if (!testProperties.ResultCacheInputs.empty()) {
+    properties.append(DumpCTestProperty(
+      "RESULT_CACHE_INPUTS",
+      DumpToJsonArray(testProperties.ResultCacheInputs)));
+  }
   if (testProperties.RunSerial) {
     properties.append(
       DumpCTestProperty("RUN_SERIAL", testProperties.RunSerial));
@@ -974,6 +1355,23 @@ static void AddBacktrace(BacktraceData& backtraceGraph, Json::Value& object,
   }
 }
 
+static Json::Value DumpResourceUsage(
+  cmCTestTestHandler::cmCTestTestProperties& testProperties)
+{
+  cmCTestTestHandler::cmCTestResourceUsage const& usage =
+    testProperties.AverageResourceUsage;
+  Json::Value resourceUsage = Json::objectValue;
+  resourceUsage["runs"] = testProperties.ResourceUsageRuns;
+  resourceUsage["executionTime"] = testProperties.AverageExecutionTime;
+  resourceUsage["userTime"] = usage.UserTime;
+  resourceUsage["systemTime"] = usage.SystemTime;
+  resourceUsage["maxResidentSetSize"] =
+    static_cast<Json::UInt64>(usage.MaxResidentSetSize);
+  resourceUsage["blockInput"] = static_cast<Json::UInt64>(usage.BlockInput);
+  resourceUsage["blockOutput"] = static_cast<Json::UInt64>(usage.BlockOutput);
+  return resourceUsage;
+}
+
 static Json::Value DumpCTestInfo(
   cmCTestRunTest& testRun,
   cmCTestTestHandler::cmCTestTestProperties& testProperties,
@@ -1004,6 +1402,9 @@ static Json::Value DumpCTestInfo(
   if (!testProperties.Backtrace.Empty()) {
     AddBacktrace(backtraceGraph, testInfo, testProperties.Backtrace);
   }
+  if (testProperties.ResourceUsageRuns > 0) {
+    testInfo["resourceUsage"] = DumpResourceUsage(testProperties);
+  }
   return testInfo;
 }
 
@@ -1021,7 +1422,7 @@ void cmCTestMultiProcessHandler::PrintOutputAsJson()
 
   Json::Value result = Json::objectValue;
   result["kind"] = "ctestInfo";
-  result["version"] = DumpVersion(1, 0);
+  result["version"] = DumpVersion(1, 1);
 
   BacktraceData backtraceGraph;
   Json::Value tests = Json::arrayValue;
@@ -5,8 +5,12 @@
 
 #include "cmConfigure.h" // IWYU pragma: keep
 
+#include "cmCTestResultCache.h"
 #include "cmCTestTestHandler.h"
+#include "cmDuration.h"
+#include <chrono>
 #include <map>
+#include <memory>
 #include <set>
 #include <stddef.h>
 #include <string>
@@ -17,6 +21,7 @@
 
 class cmCTest;
 class cmCTestRunTest;
+class cmCTestWorkerPool;
 
 /** \class cmCTestMultiProcessHandler
  * \brief run parallel ctest
@@ -50,6 +55,13 @@ public:
   // Set the max number of tests that can be run at the same time.
   void SetParallelLevel(size_t);
   void SetTestLoad(unsigned long load);
+  // Don't start tests while the CPU or memory pressure in percent is
+  // higher or while their expected memory use does not fit.
+  void SetTestPressure(unsigned long pressure);
+  // Skip tests whose inputs did not change since they last passed.
+  void SetCacheResults(bool cache) { this->CacheResults = cache; }
+  // Run the tests in this many worker processes, or here if zero.
+  void SetWorkers(size_t workers) { this->Workers = workers; }
   virtual void RunTests();
   void PrintOutputAsJson();
   void PrintTestList();
@@ -88,6 +100,19 @@ protected:
 
   void UpdateCostData();
   void ReadCostData();
+  // Record the resources used by the tests next to the cost data.
+  void UpdateResourceUsageData();
+  void ReadResourceUsageData();
+  std::string GetResourceUsageDataFile();
+  // Return the result cache, or null if results are not cached.
+  cmCTestResultCache* GetResultCache();
+  // Return whether a test with the given fingerprint passed last time
+  // and none of the tests it depends on ran since.
+  bool IsResultCached(int test, std::string const& fingerprint);
+  void UpdateResultCache(cmCTestRunTest* runner, bool started);
+  std::string GetResultCacheFile();
+  // Return the worker processes, or null if tests run here.
+  cmCTestWorkerPool* GetWorkerPool() { return this->WorkerPool.get(); }
   // Return index of a test based on its name
   int SearchByName(std::string const& name);
 
@@ -98,6 +123,15 @@ protected:
 
   void CreateParallelTestCostList();
 
+  // Order tests by the longest path of test costs from each test through
+  // the tests that depend on it.
+  void CreateCriticalPathTestCostList();
+  double GetRemainingPathLength(int test,
+                                std::map<int, double> const& lengths,
+                                std::map<int, double>& remaining);
+  // Compare the time taken by the tests to the shortest possible time
+  void PrintMakespanReport(cmDuration achieved);
+
   // Removes the checkpoint file
   void MarkFinished();
   void EraseTest(int index);
@@ -121,6 +155,8 @@ protected:
   void UnlockResources(int index);
   // map from test number to set of depend tests
   TestMap Tests;
+  // map from test number to set of tests depending on it
+  TestMap Dependents;
   TestList SortedTests;
   // Total number of tests we'll be running
   size_t Total;
@@ -134,7 +170,10 @@ protected:
   PropertiesMap Properties;
   std::map<int, bool> TestRunningMap;
   std::map<int, bool> TestFinishMap;
+  std::map<int, cmCTestRunTest*> RunningTests;
   std::map<int, std::string> TestOutput;
+  std::map<int, std::chrono::steady_clock::time_point> TestStartTimes;
+  std::map<int, cmDuration> TestDurations;
   std::vector<std::string>* Passed;
   std::vector<std::string>* Failed;
   std::vector<std::string> LastTestsFailed;
@@ -143,6 +182,8 @@ protected:
   size_t ParallelLevel; // max number of process that can be run at once
   unsigned long TestLoad;
   unsigned long FakeLoadForTesting;
+  unsigned long TestPressure = 0;
+  unsigned long FakePressureForTesting = 0;
   uv_loop_t Loop;
   cm::uv_timer_ptr TestLoadRetryTimer;
   cmCTestTestHandler* TestHandler;
@@ -150,6 +191,12 @@ protected:
   bool HasCycles;
   bool Quiet;
   bool SerialTestRunning;
+  bool CacheResults = false;
+  cmCTestResultCache ResultCache;
+  // Tests depending on tests that ran and so cannot use cached results.
+  TestSet ResultCacheInvalidated;
+  size_t Workers = 0;
+  std::unique_ptr<cmCTestWorkerPool> WorkerPool;
 };
 
 #endif
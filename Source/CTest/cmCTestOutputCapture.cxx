@@ -0,0 +1,229 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestOutputCapture.h"
+
+#include "cmAlgorithms.h"
+#include "cmSystemTools.h"
+
+#include "cm_zlib.h"
+#include "cmsys/Base64.h"
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+struct cmCTestOutputCapture::Deflater
+{
+  z_stream Stream;
+};
+
+cmCTestOutputCapture::cmCTestOutputCapture() = default;
+
+cmCTestOutputCapture::~cmCTestOutputCapture()
+{
+  this->Clear();
+}
+
+void cmCTestOutputCapture::Clear()
+{
+  this->TotalSize = 0;
+  this->DroppedSize = 0;
+  this->Head.clear();
+  this->Tail.clear();
+  this->TailSize = 0;
+  this->Kept.clear();
+
+  if (this->SpillStream) {
+    this->SpillStream.reset();
+    cmSystemTools::RemoveFile(this->SpillPath);
+  }
+  this->Spilled = false;
+
+  this->EndDeflate();
+  this->DeflateFailed = false;
+  this->Deflated.clear();
+}
+
+void cmCTestOutputCapture::AppendLine(std::string const& line)
+{
+  this->TotalSize += line.size() + 1;
+
+  if (this->Compress && !this->DeflateFailed) {
+    this->Deflate(line.c_str(), line.size(), false);
+    this->Deflate("\n", 1, false);
+  }
+  if (this->SpillStream) {
+    *this->SpillStream << line << '\n';
+  }
+
+  if (this->Limit == 0 ||
+      (this->Tail.empty() &&
+       this->Head.size() + line.size() + 1 <= this->Limit / 2)) {
+    this->Head += line;
+    this->Head += '\n';
+    return;
+  }
+
+  this->TailSize += line.size() + 1;
+  this->Tail.push_back(line);
+  if (this->TailSize > this->Limit - this->Limit / 2) {
+    this->Drop();
+  }
+}
+
+void cmCTestOutputCapture::Drop()
+{
+  // Save the complete output before the first line is lost.
+  if (!this->Spilled) {
+    this->StartSpill();
+  }
+
+  size_t const tailLimit = this->Limit - this->Limit / 2;
+  while (this->TailSize > tailLimit) {
+    std::string const& line = this->Tail.front();
+    if (this->DropCallback && this->DropCallback(line)) {
+      this->Kept += line;
+      this->Kept += '\n';
+    } else {
+      this->DroppedSize += line.size() + 1;
+    }
+    this->TailSize -= line.size() + 1;
+    this->Tail.pop_front();
+  }
+}
+
+void cmCTestOutputCapture::StartSpill()
+{
+  this->Spilled = true;
+  if (this->SpillPath.empty()) {
+    return;
+  }
+
+  this->SpillStream = cm::make_unique<cmsys::ofstream>(
+    this->SpillPath.c_str(), std::ios::out | std::ios::binary);
+  if (!*this->SpillStream) {
+    this->SpillStream.reset();
+    return;
+  }
+  *this->SpillStream << this->Head;
+  for (std::string const& line : this->Tail) {
+    *this->SpillStream << line << '\n';
+  }
+}
+
+std::string cmCTestOutputCapture::GetOutput() const
+{
+  std::string output = this->Head;
+  if (this->DroppedSize > 0) {
+    std::ostringstream msg;
+    msg << "...\n"
+        << this->DroppedSize
+        << " bytes of the test output were removed here since it exceeds "
+           "the capture limit of "
+        << this->Limit << " bytes.\n"
+        << "...\n";
+    output += msg.str();
+  }
+  output += this->Kept;
+  for (std::string const& line : this->Tail) {
+    output += line;
+    output += '\n';
+  }
+  return output;
+}
+
+bool cmCTestOutputCapture::WriteFullOutput(std::ostream& os)
+{
+  if (this->DroppedSize == 0) {
+    os << this->GetOutput();
+    return true;
+  }
+  if (this->SpillStream) {
+    this->SpillStream->flush();
+    cmsys::ifstream fin(this->SpillPath.c_str(),
+                        std::ios::in | std::ios::binary);
+    if (fin) {
+      os << fin.rdbuf();
+      return true;
+    }
+  }
+  os << this->GetOutput();
+  return false;
+}
+
+std::string cmCTestOutputCapture::ReleaseSpillFile()
+{
+  if (!this->SpillStream) {
+    return std::string();
+  }
+  this->SpillStream.reset();
+  return this->SpillPath;
+}
+
+bool cmCTestOutputCapture::GetCompressedOutput(std::string& compressed)
+{
+  if (!this->Compress || this->DeflateFailed || this->TotalSize == 0) {
+    return false;
+  }
+  this->Deflate(nullptr, 0, true);
+  this->EndDeflate();
+  if (this->DeflateFailed || this->Deflated.size() >= this->TotalSize) {
+    return false;
+  }
+
+  std::vector<unsigned char> encoded(this->Deflated.size() * 3 / 2 + 16);
+  size_t rlen = cmsysBase64_Encode(
+    reinterpret_cast<unsigned char const*>(this->Deflated.data()),
+    this->Deflated.size(), encoded.data(), 1);
+  compressed.assign(encoded.begin(), encoded.begin() + rlen);
+  return true;
+}
+
+void cmCTestOutputCapture::Deflate(char const* data, size_t size,
+                                   bool finish)
+{
+  if (!this->Deflating) {
+    this->Deflating = cm::make_unique<Deflater>();
+    z_stream& strm = this->Deflating->Stream;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    if (deflateInit(&strm, -1) != Z_OK) { // default compression level
+      this->Deflating.reset();
+      this->DeflateFailed = true;
+      return;
+    }
+  }
+
+  z_stream& strm = this->Deflating->Stream;
+  strm.next_in =
+    reinterpret_cast<unsigned char*>(const_cast<char*>(data ? data : ""));
+  strm.avail_in = static_cast<uInt>(size);
+  unsigned char out[16384];
+  int ret;
+  do {
+    strm.next_out = out;
+    strm.avail_out = sizeof(out);
+    ret = deflate(&strm, finish ? Z_FINISH : Z_NO_FLUSH);
+    if (ret == Z_STREAM_ERROR) {
+      break;
+    }
+    this->Deflated.append(reinterpret_cast<char*>(out),
+                          sizeof(out) - strm.avail_out);
+  } while (strm.avail_out == 0);
+
+  // Compressed output that does not fit in the limit is not kept.
+  if (ret == Z_STREAM_ERROR || (finish && ret != Z_STREAM_END) ||
+      (this->Limit > 0 && this->Deflated.size() > this->Limit)) {
+    this->EndDeflate();
+    this->DeflateFailed = true;
+    this->Deflated.clear();
+  }
+}
+
+void cmCTestOutputCapture::EndDeflate()
+{
+  if (this->Deflating) {
+    (void)deflateEnd(&this->Deflating->Stream);
+    this->Deflating.reset();
+  }
+}
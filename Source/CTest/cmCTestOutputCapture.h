@@ -0,0 +1,117 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmCTestOutputCapture_h
+#define cmCTestOutputCapture_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include "cmsys/FStream.hxx"
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <stddef.h>
+#include <string>
+#include <utility>
+
+/** \class cmCTestOutputCapture
+ * \brief Collect the output of a test in bounded memory
+ *
+ * Output is added line by line.  Once it exceeds the limit only the
+ * start and the end of the output are kept in memory and the lines in
+ * between are dropped as newer lines arrive.  The complete output is
+ * then written to a spill file so that it can still be copied to the
+ * test log.  The output may also be compressed as it arrives instead
+ * of all at once after the test finished.
+ */
+class cmCTestOutputCapture
+{
+public:
+  cmCTestOutputCapture();
+  ~cmCTestOutputCapture();
+
+  cmCTestOutputCapture(cmCTestOutputCapture const&) = delete;
+  cmCTestOutputCapture& operator=(cmCTestOutputCapture const&) = delete;
+
+  /** Keep at most about this many bytes of output in memory, half of
+      them from the start of the output and half from its end.  Zero
+      keeps all output.  */
+  void SetLimit(size_t limit) { this->Limit = limit; }
+
+  /** Write the complete output to this file once it exceeds the limit.
+      The file is removed when the output is cleared.  */
+  void SetSpillFile(std::string const& path) { this->SpillPath = path; }
+
+  //! Compress the output as it arrives.
+  void SetCompress(bool compress) { this->Compress = compress; }
+
+  /** Call the given function with each line that is about to be
+      dropped.  The line is kept anyway if the function returns true.  */
+  void SetDropCallback(std::function<bool(std::string const&)> cb)
+  {
+    this->DropCallback = std::move(cb);
+  }
+
+  //! Discard all output collected so far.
+  void Clear();
+
+  //! Add a line of output.  A newline is appended to it.
+  void AppendLine(std::string const& line);
+
+  //! Return the size of the complete output.
+  size_t GetTotalSize() const { return this->TotalSize; }
+
+  //! Return whether lines were dropped from the output kept in memory.
+  bool IsTruncated() const { return this->DroppedSize > 0; }
+
+  /** Return the output kept in memory.  A note replaces the lines that
+      were dropped.  */
+  std::string GetOutput() const;
+
+  /** Write the complete output to the given stream.  Returns false if
+      it is no longer available, in which case the output kept in
+      memory is written.  */
+  bool WriteFullOutput(std::ostream& os);
+
+  /** Stop writing the spill file and return its path, or an empty
+      string if there is none.  The file is then no longer removed when
+      the output is cleared.  */
+  std::string ReleaseSpillFile();
+
+  /** Finish compressing the output and store it base64 encoded.
+      Returns false if the output was not compressed, did not fit in
+      the limit, or did not get smaller.  */
+  bool GetCompressedOutput(std::string& compressed);
+
+private:
+  struct Deflater;
+
+  void Drop();
+  void StartSpill();
+  void Deflate(char const* data, size_t size, bool finish);
+  void EndDeflate();
+
+  size_t Limit = 0;
+  bool Compress = false;
+  std::string SpillPath;
+  std::function<bool(std::string const&)> DropCallback;
+
+  size_t TotalSize = 0;
+  size_t DroppedSize = 0;
+  // Output from the start, with newlines.
+  std::string Head;
+  // Lines from the end, without newlines.
+  std::deque<std::string> Tail;
+  size_t TailSize = 0;
+  // Lines kept at the request of the drop callback, with newlines.
+  std::string Kept;
+
+  bool Spilled = false;
+  std::unique_ptr<cmsys::ofstream> SpillStream;
+
+  std::unique_ptr<Deflater> Deflating;
+  bool DeflateFailed = false;
+  std::string Deflated;
+};
+
+#endif
@@ -0,0 +1,107 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestOutputMatcher.h"
+
+#include <algorithm>
+#include <sstream>
+
+void cmCTestOutputMatcher::Reset(Settings const& settings)
+{
+  this->Capture.Clear();
+  this->Capture.SetLimit(settings.Limit);
+  this->Capture.SetCompress(settings.Compress);
+  this->Capture.SetSpillFile(settings.SpillFile);
+  this->Capture.SetDropCallback([this](std::string const& line) {
+    return this->CheckDroppedOutput(line);
+  });
+
+  // Match all expressions of a kind in one pass over the output.
+  this->RequiredRegex.Clear();
+  for (std::string const& pass : settings.RequiredRegex) {
+    this->RequiredRegex.Add(pass);
+  }
+  this->ErrorRegex.Clear();
+  for (std::string const& fail : settings.ErrorRegex) {
+    this->ErrorRegex.Add(fail);
+  }
+  this->TimeoutRegex.Clear();
+  for (std::string const& timeout : settings.TimeoutRegex) {
+    this->TimeoutRegex.Add(timeout);
+  }
+
+  this->RequiredMatchedDropped.assign(this->RequiredRegex.Size(), false);
+  this->ErrorMatchedDropped.assign(this->ErrorRegex.Size(), false);
+  this->FullOutputDropped = false;
+}
+
+bool cmCTestOutputMatcher::AddLine(std::string const& line)
+{
+  this->Capture.AppendLine(line);
+
+  // The timeout changes only once.
+  if (!this->TimeoutRegex.Empty() &&
+      this->TimeoutRegex.Find(line) != cmRegularExpressionSet::npos) {
+    this->TimeoutRegex.Clear();
+    return true;
+  }
+  return false;
+}
+
+bool cmCTestOutputMatcher::CheckDroppedOutput(std::string const& line)
+{
+  // The pass and fail regular expressions are matched against the
+  // captured output once the test has finished.  Match the lines that
+  // will no longer be part of it now.
+  if (!this->RequiredRegex.Empty() || !this->ErrorRegex.Empty()) {
+    std::string const text = line + "\n";
+    this->RequiredRegex.FindAll(text, this->RequiredMatchedDropped);
+    this->ErrorRegex.FindAll(text, this->ErrorMatchedDropped);
+  }
+  if (line.find("CTEST_FULL_OUTPUT") != std::string::npos) {
+    this->FullOutputDropped = true;
+  }
+
+  // Keep measurements so that DartProcessing still finds them.
+  return line.find("<DartMeasurement") != std::string::npos;
+}
+
+cmCTestOutputMatcher::Result cmCTestOutputMatcher::Finish()
+{
+  Result result;
+  result.Output = this->Capture.GetOutput();
+  // Tests asking for their full output get it back from the spill file.
+  if (this->Capture.IsTruncated() &&
+      (this->FullOutputDropped ||
+       result.Output.find("CTEST_FULL_OUTPUT") != std::string::npos)) {
+    std::ostringstream fullOutput;
+    if (this->Capture.WriteFullOutput(fullOutput)) {
+      result.Output = fullOutput.str();
+    }
+  }
+
+  if (!this->RequiredRegex.Empty()) {
+    result.RequiredFound =
+      std::find(this->RequiredMatchedDropped.begin(),
+                this->RequiredMatchedDropped.end(),
+                true) != this->RequiredMatchedDropped.end() ||
+      this->RequiredRegex.Find(result.Output) != cmRegularExpressionSet::npos;
+  }
+  if (!this->ErrorRegex.Empty()) {
+    // Report the first expression that matched anywhere in the output.
+    std::vector<bool> matched = this->ErrorMatchedDropped;
+    this->ErrorRegex.FindAll(result.Output, matched);
+    auto const first = std::find(matched.begin(), matched.end(), true);
+    if (first != matched.end()) {
+      result.ErrorFound = true;
+      result.ErrorRegex = this->ErrorRegex.GetPattern(
+        static_cast<size_t>(first - matched.begin()));
+    }
+  }
+
+  result.Compressed =
+    this->Capture.GetCompressedOutput(result.CompressedOutput);
+  if (this->Capture.IsTruncated()) {
+    result.FullOutputFile = this->Capture.ReleaseSpillFile();
+  }
+  return result;
+}
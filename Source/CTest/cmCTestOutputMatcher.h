@@ -0,0 +1,83 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmCTestOutputMatcher_h
+#define cmCTestOutputMatcher_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include "cmCTestOutputCapture.h"
+#include "cmRegularExpressionSet.h"
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/** \class cmCTestOutputMatcher
+ * \brief Capture the output of a test run and match it
+ *
+ * The output is kept in a cmCTestOutputCapture.  The pass and fail
+ * regular expressions are matched against the complete output once the
+ * run finished, including the lines dropped from the capture, and the
+ * TIMEOUT_AFTER_MATCH expressions against each line as it arrives.
+ */
+class cmCTestOutputMatcher
+{
+public:
+  struct Settings
+  {
+    // Capture limit in bytes, or zero to keep all output
+    size_t Limit = 0;
+    bool Compress = false;
+    // File to write the complete output to once it exceeds the limit
+    std::string SpillFile;
+    // The PASS, FAIL and TIMEOUT_AFTER_MATCH regular expressions
+    std::vector<std::string> RequiredRegex;
+    std::vector<std::string> ErrorRegex;
+    std::vector<std::string> TimeoutRegex;
+  };
+
+  struct Result
+  {
+    // The captured output, or the complete output if the test asked for
+    // it with CTEST_FULL_OUTPUT
+    std::string Output;
+    // The output compressed and base64 encoded, if that made it smaller
+    bool Compressed = false;
+    std::string CompressedOutput;
+    // File holding the complete output if lines were dropped, else empty
+    std::string FullOutputFile;
+    bool RequiredFound = false;
+    // The first FAIL expression found, if any
+    bool ErrorFound = false;
+    std::string ErrorRegex;
+  };
+
+  //! Prepare to capture the output of a new run.
+  void Reset(Settings const& settings);
+
+  /** Add a line of output.  Returns true if it is the first to match a
+      TIMEOUT_AFTER_MATCH expression.  */
+  bool AddLine(std::string const& line);
+
+  /** Finish the run.  The file named by the result is no longer removed
+      when the output is cleared.  */
+  Result Finish();
+
+  //! Discard the output.
+  void Clear() { this->Capture.Clear(); }
+
+private:
+  // Check a line dropped from the captured output
+  bool CheckDroppedOutput(std::string const& line);
+
+  cmCTestOutputCapture Capture;
+  cmRegularExpressionSet RequiredRegex;
+  cmRegularExpressionSet ErrorRegex;
+  cmRegularExpressionSet TimeoutRegex;
+  // Regular expressions matched by output dropped from the capture
+  std::vector<bool> RequiredMatchedDropped;
+  std::vector<bool> ErrorMatchedDropped;
+  bool FullOutputDropped = false;
+};
+
+#endif
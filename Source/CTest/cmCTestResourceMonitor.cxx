@@ -0,0 +1,173 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestResourceMonitor.h"
+
+#if defined(__linux__)
+#  include "cmsys/FStream.hxx"
+
+#  include <algorithm>
+#  include <stdio.h>
+#  include <string>
+#  include <unistd.h>
+
+namespace {
+
+bool cmCTestReadFirstLine(std::string const& fname, std::string& line)
+{
+  cmsys::ifstream fin(fname.c_str());
+  return fin && std::getline(fin, line);
+}
+
+// Return the directory of the cgroup v2 hierarchy ctest runs in, or an
+// empty string.
+std::string cmCTestGetCgroupDirectory()
+{
+  cmsys::ifstream fin("/proc/self/cgroup");
+  std::string line;
+  while (std::getline(fin, line)) {
+    // Format: 0::<path>
+    if (line.compare(0, 3, "0::") == 0) {
+      return "/sys/fs/cgroup" + line.substr(3);
+    }
+  }
+  return std::string();
+}
+
+bool cmCTestReadPressure(std::string const& fname, double& percent)
+{
+  // Format: some avg10=<percent> avg60=<percent> avg300=<percent> ...
+  std::string line;
+  return cmCTestReadFirstLine(fname, line) &&
+    sscanf(line.c_str(), "some avg10=%lf", &percent) == 1;
+}
+
+bool cmCTestReadBytes(std::string const& fname, uint64_t& bytes)
+{
+  std::string line;
+  unsigned long long value;
+  if (!cmCTestReadFirstLine(fname, line) ||
+      sscanf(line.c_str(), "%llu", &value) != 1) {
+    return false;
+  }
+  bytes = static_cast<uint64_t>(value);
+  return true;
+}
+}
+
+bool cmCTestResourceMonitor::GetPressure(Resource resource, double& percent)
+{
+  char const* name = resource == Resource::CPU ? "cpu" : "memory";
+
+  // Take the larger of the pressure on the system and on our cgroup.
+  bool known = false;
+  double value;
+  percent = 0;
+  if (cmCTestReadPressure(std::string("/proc/pressure/") + name, value)) {
+    percent = value;
+    known = true;
+  }
+  std::string const cgroup = cmCTestGetCgroupDirectory();
+  if (!cgroup.empty() &&
+      cmCTestReadPressure(cgroup + "/" + name + ".pressure", value)) {
+    percent = std::max(percent, value);
+    known = true;
+  }
+  return known;
+}
+
+bool cmCTestResourceMonitor::GetAvailableMemory(uint64_t& kib)
+{
+  bool known = false;
+  {
+    cmsys::ifstream fin("/proc/meminfo");
+    std::string line;
+    unsigned long long value;
+    while (std::getline(fin, line)) {
+      if (sscanf(line.c_str(), "MemAvailable: %llu kB", &value) == 1) {
+        kib = static_cast<uint64_t>(value);
+        known = true;
+        break;
+      }
+    }
+  }
+
+  // A cgroup memory limit may leave less than that.
+  std::string const cgroup = cmCTestGetCgroupDirectory();
+  uint64_t limit;
+  uint64_t current;
+  if (!cgroup.empty() && cmCTestReadBytes(cgroup + "/memory.max", limit) &&
+      cmCTestReadBytes(cgroup + "/memory.current", current)) {
+    uint64_t const spare = limit > current ? (limit - current) / 1024 : 0;
+    if (!known || spare < kib) {
+      kib = spare;
+    }
+    known = true;
+  }
+  return known;
+}
+
+bool cmCTestResourceMonitor::GetResidentSetSize(int pid, uint64_t& kib)
+{
+  // Format: <size> <resident> ... in pages
+  std::string line;
+  unsigned long long size;
+  unsigned long long resident;
+  if (pid <= 0 ||
+      !cmCTestReadFirstLine("/proc/" + std::to_string(pid) + "/statm",
+                            line) ||
+      sscanf(line.c_str(), "%llu %llu", &size, &resident) != 2) {
+    return false;
+  }
+  long const pageSize = sysconf(_SC_PAGESIZE);
+  if (pageSize <= 0) {
+    return false;
+  }
+  kib = static_cast<uint64_t>(resident) *
+    static_cast<uint64_t>(pageSize) / 1024;
+  return true;
+}
+
+bool cmCTestResourceMonitor::GetPeakResidentSetSize(int pid, uint64_t& kib)
+{
+  if (pid <= 0) {
+    return false;
+  }
+  // Format: VmHWM:\t<size> kB
+  cmsys::ifstream fin(("/proc/" + std::to_string(pid) + "/status").c_str());
+  std::string line;
+  unsigned long long peak;
+  while (std::getline(fin, line)) {
+    if (sscanf(line.c_str(), "VmHWM: %llu", &peak) == 1) {
+      kib = static_cast<uint64_t>(peak);
+      return true;
+    }
+  }
+  return false;
+}
+
+#else
+
+bool cmCTestResourceMonitor::GetPressure(Resource /*unused*/,
+                                         double& /*unused*/)
+{
+  return false;
+}
+
+bool cmCTestResourceMonitor::GetAvailableMemory(uint64_t& /*unused*/)
+{
+  return false;
+}
+
+bool cmCTestResourceMonitor::GetResidentSetSize(int /*unused*/,
+                                                uint64_t& /*unused*/)
+{
+  return false;
+}
+
+bool cmCTestResourceMonitor::GetPeakResidentSetSize(int /*unused*/,
+                                                    uint64_t& /*unused*/)
+{
+  return false;
+}
+
+#endif
@@ -0,0 +1,44 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmCTestResourceMonitor_h
+#define cmCTestResourceMonitor_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <stdint.h>
+
+/** \class cmCTestResourceMonitor
+ * \brief Read how busy the machine is
+ *
+ * The values come from the Linux pressure stall information and memory
+ * accounting, both of the whole system and of the cgroup ctest runs in.
+ * On other platforms nothing is known.
+ */
+class cmCTestResourceMonitor
+{
+public:
+  enum class Resource
+  {
+    CPU,
+    Memory
+  };
+
+  /** Get the percentage of the last 10 seconds in which some tasks
+      stalled waiting for the resource.  Returns false if unknown.  */
+  static bool GetPressure(Resource resource, double& percent);
+
+  /** Get the memory in KiB that new processes may use without making
+      the system or the cgroup swap or reclaim.  Returns false if
+      unknown.  */
+  static bool GetAvailableMemory(uint64_t& kib);
+
+  /** Get the resident set size in KiB of a running process.  Returns
+      false if unknown.  */
+  static bool GetResidentSetSize(int pid, uint64_t& kib);
+
+  /** Get the peak resident set size in KiB that a running process
+      reached so far.  Returns false if unknown.  */
+  static bool GetPeakResidentSetSize(int pid, uint64_t& kib);
+};
+
+#endif
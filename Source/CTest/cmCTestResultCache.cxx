@@ -0,0 +1,145 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestResultCache.h"
+
+#include "cmCryptoHash.h"
+#include "cmSystemTools.h"
+
+#include "cmsys/FStream.hxx"
+
+void cmCTestResultCache::Load(std::string const& fname)
+{
+  this->Fingerprints.clear();
+  cmsys::ifstream fin(fname.c_str());
+  std::string line;
+  while (std::getline(fin, line)) {
+    // Format: <fingerprint> <name>
+    std::string::size_type pos = line.find(' ');
+    if (pos == std::string::npos || pos == 0) {
+      continue;
+    }
+    this->Fingerprints[line.substr(pos + 1)] = line.substr(0, pos);
+  }
+}
+
+bool cmCTestResultCache::Save(std::string const& fname) const
+{
+  std::string tmpout = fname + ".tmp";
+  {
+    cmsys::ofstream fout(tmpout.c_str());
+    if (!fout) {
+      return false;
+    }
+    for (auto const& f : this->Fingerprints) {
+      fout << f.second << " " << f.first << "\n";
+    }
+    if (!fout) {
+      return false;
+    }
+  }
+  return cmSystemTools::RenameFile(tmpout, fname);
+}
+
+std::string cmCTestResultCache::ComputeFingerprint(
+  cmCTestTestHandler::cmCTestTestProperties const& properties,
+  std::string const& command, std::vector<std::string> const& arguments,
+  std::string const& config)
+{
+  cmCryptoHash hash(cmCryptoHash::AlgoSHA256);
+  hash.Initialize();
+  // Terminate each field so that different lists cannot hash the same.
+  auto add = [&hash](std::string const& field) {
+    hash.Append(field);
+    hash.Append("", 1);
+  };
+  auto addFile = [this, &add, &properties](std::string const& path) {
+    std::string const full =
+      cmSystemTools::CollapseFullPath(path, properties.Directory);
+    add(full);
+    add(this->HashFile(full));
+  };
+
+  add("cmCTestResultCache 1");
+  add(properties.Name);
+  add(config);
+  add(properties.Directory);
+
+  addFile(command);
+  add(std::to_string(arguments.size()));
+  for (std::string const& arg : arguments) {
+    add(arg);
+    // Scripts and data files given to the test are likely inputs.
+    if (cmSystemTools::FileIsFullPath(arg) &&
+        cmSystemTools::FileExists(arg, true)) {
+      add(this->HashFile(arg));
+    }
+  }
+
+  add(std::to_string(properties.Environment.size()));
+  for (std::string const& env : properties.Environment) {
+    add(env);
+  }
+
+  add(properties.WillFail ? "WILL_FAIL" : "");
+  add(std::to_string(properties.SkipReturnCode));
+  add(std::to_string(properties.Timeout.count()));
+  add(std::to_string(properties.RequiredRegularExpressions.size()));
+  for (auto const& re : properties.RequiredRegularExpressions) {
+    add(re.second);
+  }
+  add(std::to_string(properties.ErrorRegularExpressions.size()));
+  for (auto const& re : properties.ErrorRegularExpressions) {
+    add(re.second);
+  }
+
+  add(std::to_string(properties.RequiredFiles.size()));
+  for (std::string const& file : properties.RequiredFiles) {
+    addFile(file);
+  }
+  add(std::to_string(properties.ResultCacheInputs.size()));
+  for (std::string const& file : properties.ResultCacheInputs) {
+    addFile(file);
+  }
+
+  return hash.FinalizeHex();
+}
+
+bool cmCTestResultCache::IsPassed(std::string const& name,
+                                  std::string const& fingerprint) const
+{
+  auto i = this->Fingerprints.find(name);
+  return i != this->Fingerprints.end() && i->second == fingerprint;
+}
+
+void cmCTestResultCache::SetPassed(std::string const& name,
+                                   std::string const& fingerprint)
+{
+  this->Fingerprints[name] = fingerprint;
+}
+
+void cmCTestResultCache::Remove(std::string const& name)
+{
+  this->Fingerprints.erase(name);
+}
+
+std::string const& cmCTestResultCache::HashFile(std::string const& path)
+{
+  // A missing file hashes as an empty string.
+  FileHash& entry = this->FileHashes[path];
+  if (!cmSystemTools::FileExists(path, true)) {
+    entry = FileHash();
+    return entry.Hash;
+  }
+
+  // Hash the file again if an earlier test may have changed it.
+  long const mtime = cmSystemTools::ModifiedTime(path);
+  unsigned long const size = cmSystemTools::FileLength(path);
+  if (entry.Hash.empty() || entry.ModifiedTime != mtime ||
+      entry.Size != size) {
+    cmCryptoHash fileHash(cmCryptoHash::AlgoSHA256);
+    entry.Hash = fileHash.HashFile(path);
+    entry.ModifiedTime = mtime;
+    entry.Size = size;
+  }
+  return entry.Hash;
+}
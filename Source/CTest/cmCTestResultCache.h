@@ -0,0 +1,66 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmCTestResultCache_h
+#define cmCTestResultCache_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include "cmCTestTestHandler.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+/** \class cmCTestResultCache
+ * \brief Remember the inputs of tests that passed
+ *
+ * The fingerprint of a test covers its command line, working directory,
+ * environment and the properties that decide whether it passes, along
+ * with the contents of the test executable, of the existing files named
+ * by absolute paths on its command line, and of its REQUIRED_FILES and
+ * RESULT_CACHE_INPUTS.  A test whose fingerprint matches the one
+ * recorded when it last passed does not need to run again.
+ */
+class cmCTestResultCache
+{
+public:
+  //! Read the fingerprints recorded by a previous run.
+  void Load(std::string const& fname);
+
+  //! Write the recorded fingerprints.
+  bool Save(std::string const& fname) const;
+
+  /** Compute the fingerprint of a test that runs the given command.
+      The configuration is the one given to ctest with -C.  */
+  std::string ComputeFingerprint(
+    cmCTestTestHandler::cmCTestTestProperties const& properties,
+    std::string const& command, std::vector<std::string> const& arguments,
+    std::string const& config);
+
+  //! Return whether the test passed last with the given fingerprint.
+  bool IsPassed(std::string const& name, std::string const& fingerprint) const;
+
+  //! Record that the test passed with the given fingerprint.
+  void SetPassed(std::string const& name, std::string const& fingerprint);
+
+  //! Forget the test, e.g. because it did not pass.
+  void Remove(std::string const& name);
+
+private:
+  struct FileHash
+  {
+    std::string Hash;
+    long ModifiedTime = 0;
+    unsigned long Size = 0;
+  };
+
+  std::string const& HashFile(std::string const& path);
+
+  // Fingerprint of the last passing run by test name.
+  std::map<std::string, std::string> Fingerprints;
+  // Content hashes of the files seen in this run.  Many tests run the
+  // same executable.
+  std::map<std::string, FileHash> FileHashes;
+};
+
+#endif
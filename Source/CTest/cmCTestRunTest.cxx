@@ -5,13 +5,16 @@
 #include "cmCTest.h"
 #include "cmCTestMemCheckHandler.h"
 #include "cmCTestMultiProcessHandler.h"
+#include "cmCTestResourceMonitor.h"
+#include "cmCTestResultCache.h"
+#include "cmCTestWorkerPool.h"
 #include "cmProcess.h"
 #include "cmSystemTools.h"
 #include "cmWorkingDirectory.h"
 
-#include "cm_zlib.h"
-#include "cmsys/Base64.h"
-#include "cmsys/RegularExpression.hxx"
+#include "cmsys/FStream.hxx"
+
+#include <algorithm>
 #include <chrono>
 #include <cmAlgorithms.h>
 #include <cstring>
@@ -32,8 +35,6 @@ cmCTestRunTest::cmCTestRunTest(cmCTestMultiProcessHandler& multiHandler)
   this->TestResult.TestCount = 0;
   this->TestResult.Properties = nullptr;
   this->ProcessOutput.clear();
-  this->CompressedOutput.clear();
-  this->CompressionRatio = 2;
   this->NumberOfRunsLeft = 1; // default to 1 run of the test
   this->RunUntilFail = false; // default to run the test once
   this->RunAgain = false;     // default to not having to run again
@@ -43,97 +44,67 @@ void cmCTestRunTest::CheckOutput(std::string const& line)
 {
   cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
              this->GetIndex() << ": " << line << std::endl);
-  this->ProcessOutput += line;
-  this->ProcessOutput += "\n";
 
   // Check for TIMEOUT_AFTER_MATCH property.
-  if (!this->TestProperties->TimeoutRegularExpressions.empty()) {
-    for (auto& reg : this->TestProperties->TimeoutRegularExpressions) {
-      if (reg.first.find(this->ProcessOutput)) {
-        cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
-                   this->GetIndex()
-                     << ": "
-                     << "Test timeout changed to "
-                     << std::chrono::duration_cast<std::chrono::seconds>(
-                          this->TestProperties->AlternateTimeout)
-                          .count()
-                     << std::endl);
-        this->TestProcess->ResetStartTime();
-        this->TestProcess->ChangeTimeout(
-          this->TestProperties->AlternateTimeout);
-        this->TestProperties->TimeoutRegularExpressions.clear();
-        break;
-      }
-    }
+  if (this->OutputMatcher.AddLine(line)) {
+    cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+               this->GetIndex()
+                 << ": "
+                 << "Test timeout changed to "
+                 << std::chrono::duration_cast<std::chrono::seconds>(
+                      this->TestProperties->AlternateTimeout)
+                      .count()
+                 << std::endl);
+    this->TestProcess->ResetStartTime();
+    this->TestProcess->ChangeTimeout(this->TestProperties->AlternateTimeout);
+    this->TestProperties->TimeoutRegularExpressions.clear();
   }
 }
 
-// Streamed compression of test output.  The compressed data
-// is appended to this->CompressedOutput
-void cmCTestRunTest::CompressOutput()
+void cmCTestRunTest::ResetOutput()
 {
-  int ret;
-  z_stream strm;
-
-  unsigned char* in = reinterpret_cast<unsigned char*>(
-    const_cast<char*>(this->ProcessOutput.c_str()));
-  // zlib makes the guarantee that this is the maximum output size
-  int outSize = static_cast<int>(
-    static_cast<double>(this->ProcessOutput.size()) * 1.001 + 13.0);
-  unsigned char* out = new unsigned char[outSize];
-
-  strm.zalloc = Z_NULL;
-  strm.zfree = Z_NULL;
-  strm.opaque = Z_NULL;
-  ret = deflateInit(&strm, -1); // default compression level
-  if (ret != Z_OK) {
-    delete[] out;
-    return;
+  this->ProcessOutput.clear();
+  this->OutputResult = cmCTestOutputMatcher::Result();
+
+  cmCTestOutputMatcher::Settings& settings = this->OutputSettings;
+  // MemCheck parses all of the output so it must be kept.
+  settings.Limit = 0;
+  if (!this->TestHandler->MemCheck &&
+      this->TestHandler->CustomTestOutputCaptureSize > 0) {
+    // Keep at least as much output as may be recorded for the test.
+    settings.Limit = static_cast<size_t>(std::max(
+      { this->TestHandler->CustomTestOutputCaptureSize,
+        2 * this->TestHandler->CustomMaximumPassedTestOutputSize,
+        2 * this->TestHandler->CustomMaximumFailedTestOutputSize }));
+  }
+  settings.Compress =
+    !this->TestHandler->MemCheck && this->CTest->ShouldCompressTestOutput();
+  settings.SpillFile.clear();
+  if (this->TestHandler->LogFile) {
+    std::ostringstream path;
+    path << this->CTest->GetBinaryDir() << "/Testing/Temporary/TestOutput-"
+         << this->Index << ".log";
+    settings.SpillFile = path.str();
   }
 
-  strm.avail_in = static_cast<uInt>(this->ProcessOutput.size());
-  strm.next_in = in;
-  strm.avail_out = outSize;
-  strm.next_out = out;
-  ret = deflate(&strm, Z_FINISH);
-
-  if (ret != Z_STREAM_END) {
-    cmCTestLog(this->CTest, ERROR_MESSAGE,
-               "Error during output compression. Sending uncompressed output."
-                 << std::endl);
-    delete[] out;
-    return;
+  settings.RequiredRegex.clear();
+  for (auto& pass : this->TestProperties->RequiredRegularExpressions) {
+    settings.RequiredRegex.push_back(pass.second);
   }
-
-  (void)deflateEnd(&strm);
-
-  unsigned char* encoded_buffer =
-    new unsigned char[static_cast<int>(outSize * 1.5)];
-
-  size_t rlen = cmsysBase64_Encode(out, strm.total_out, encoded_buffer, 1);
-
-  this->CompressedOutput.clear();
-  for (size_t i = 0; i < rlen; i++) {
-    this->CompressedOutput += encoded_buffer[i];
+  settings.ErrorRegex.clear();
+  for (auto& fail : this->TestProperties->ErrorRegularExpressions) {
+    settings.ErrorRegex.push_back(fail.second);
   }
-
-  if (strm.total_in) {
-    this->CompressionRatio =
-      static_cast<double>(strm.total_out) / static_cast<double>(strm.total_in);
+  settings.TimeoutRegex.clear();
+  for (auto& timeout : this->TestProperties->TimeoutRegularExpressions) {
+    settings.TimeoutRegex.push_back(timeout.second);
   }
-
-  delete[] encoded_buffer;
-  delete[] out;
+  this->OutputMatcher.Reset(settings);
 }
 
 bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
 {
-  if ((!this->TestHandler->MemCheck &&
-       this->CTest->ShouldCompressTestOutput()) ||
-      (this->TestHandler->MemCheck &&
-       this->CTest->ShouldCompressTestOutput())) {
-    this->CompressOutput();
-  }
+  this->ProcessOutput = this->OutputResult.Output;
 
   this->WriteLogOutputTop(completed, total);
   std::string reason;
@@ -148,16 +119,10 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
   bool skipped = false;
   bool outputTestErrorsToConsole = false;
   if (!this->TestProperties->RequiredRegularExpressions.empty() &&
-      this->FailedDependencies.empty()) {
-    bool found = false;
-    for (auto& pass : this->TestProperties->RequiredRegularExpressions) {
-      if (pass.first.find(this->ProcessOutput)) {
-        found = true;
-        reason = "Required regular expression found.";
-        break;
-      }
-    }
-    if (!found) {
+      this->FailedDependencies.empty() && !this->ResultCached) {
+    if (this->OutputResult.RequiredFound) {
+      reason = "Required regular expression found.";
+    } else {
       reason = "Required regular expression not found.";
       forceFail = true;
     }
@@ -169,16 +134,14 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
     reason += "]";
   }
   if (!this->TestProperties->ErrorRegularExpressions.empty() &&
-      this->FailedDependencies.empty()) {
-    for (auto& pass : this->TestProperties->ErrorRegularExpressions) {
-      if (pass.first.find(this->ProcessOutput)) {
-        reason = "Error regular expression found in output.";
-        reason += " Regex=[";
-        reason += pass.second;
-        reason += "]";
-        forceFail = true;
-        break;
-      }
+      this->FailedDependencies.empty() && !this->ResultCached) {
+    // Report the first expression that matched anywhere in the output.
+    if (this->OutputResult.ErrorFound) {
+      reason = "Error regular expression found in output.";
+      reason += " Regex=[";
+      reason += this->OutputResult.ErrorRegex;
+      reason += "]";
+      forceFail = true;
     }
   }
   std::ostringstream outputStream;
@@ -234,6 +197,8 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
                    this->TestResult.ExceptionStatus);
         this->TestResult.Status = cmCTestTestHandler::OTHER_FAULT;
     }
+  } else if (this->ResultCached) {
+    outputStream << "   Passed (cached) ";
   } else if ("Disabled" == this->TestResult.CompletionStatus) {
     outputStream << "***Not Run (Disabled) ";
   } else // cmProcess::State::Error
@@ -335,16 +300,17 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
   // if the test actually started and ran
   // record the results in TestResult
   if (started) {
-    bool compress = !this->TestHandler->MemCheck &&
-      this->CompressionRatio < 1 && this->CTest->ShouldCompressTestOutput();
+    bool compress = this->OutputResult.Compressed;
     this->TestResult.Output =
-      compress ? this->CompressedOutput : this->ProcessOutput;
+      compress ? this->OutputResult.CompressedOutput : this->ProcessOutput;
     this->TestResult.CompressOutput = compress;
     this->TestResult.ReturnValue = this->TestProcess->GetExitValue();
     if (!skipped) {
       this->TestResult.CompletionStatus = "Completed";
     }
     this->TestResult.ExecutionTime = this->TestProcess->GetTotalTime();
+    this->TestResult.HaveResourceUsage =
+      this->TestProcess->GetResourceUsage(this->TestResult.ResourceUsage);
     this->MemCheckPostProcess();
     this->ComputeWeightedCost();
   }
@@ -354,6 +320,11 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
     this->TestHandler->TestResults.push_back(this->TestResult);
   }
   this->TestProcess.reset();
+  this->OutputMatcher.Clear();
+  if (!this->OutputResult.FullOutputFile.empty()) {
+    cmSystemTools::RemoveFile(this->OutputResult.FullOutputFile);
+  }
+  this->OutputResult = cmCTestOutputMatcher::Result();
   return passed || skipped;
 }
 
@@ -402,9 +373,60 @@ void cmCTestRunTest::ComputeWeightedCost()
     this->TestProperties->Cost =
       static_cast<float>(((prev * avgcost) + current) / (prev + 1.0));
     this->TestProperties->PreviousRuns++;
+
+    if (this->TestResult.HaveResourceUsage) {
+      this->ComputeAverageResourceUsage();
+    }
   }
 }
 
+void cmCTestRunTest::ComputeAverageResourceUsage()
+{
+  cmCTestTestHandler::cmCTestResourceUsage const& usage =
+    this->TestResult.ResourceUsage;
+  cmCTestTestHandler::cmCTestTestProperties& properties =
+    *this->TestProperties;
+
+  // Expect more memory as soon as a run needs it, but less only
+  // gradually so that a lucky run does not cause an overcommit.
+  uint64_t const memory = usage.MaxResidentSetSize;
+  uint64_t& expected = properties.ExpectedMemory;
+  if (memory > 0) {
+    expected = std::max(memory, (expected + memory) / 2);
+  }
+
+  double const prev = static_cast<double>(properties.ResourceUsageRuns);
+  auto average = [prev](double avg, double current) -> double {
+    return ((prev * avg) + current) / (prev + 1.0);
+  };
+  cmCTestTestHandler::cmCTestResourceUsage& avg =
+    properties.AverageResourceUsage;
+  properties.AverageExecutionTime = average(
+    properties.AverageExecutionTime, this->TestResult.ExecutionTime.count());
+  avg.UserTime = average(avg.UserTime, usage.UserTime);
+  avg.SystemTime = average(avg.SystemTime, usage.SystemTime);
+  avg.MaxResidentSetSize = static_cast<uint64_t>(
+    average(static_cast<double>(avg.MaxResidentSetSize),
+            static_cast<double>(usage.MaxResidentSetSize)));
+  avg.BlockInput = static_cast<uint64_t>(
+    average(static_cast<double>(avg.BlockInput),
+            static_cast<double>(usage.BlockInput)));
+  avg.BlockOutput = static_cast<uint64_t>(
+    average(static_cast<double>(avg.BlockOutput),
+            static_cast<double>(usage.BlockOutput)));
+  properties.ResourceUsageRuns++;
+}
+
+uint64_t cmCTestRunTest::GetResidentSetSize()
+{
+  uint64_t kib = 0;
+  if (this->TestProcess) {
+    cmCTestResourceMonitor::GetResidentSetSize(this->TestProcess->GetPid(),
+                                               kib);
+  }
+  return kib;
+}
+
 void cmCTestRunTest::MemCheckPostProcess()
 {
   if (!this->TestHandler->MemCheck) {
@@ -433,7 +455,7 @@ void cmCTestRunTest::StartFailure(std::string const& output)
                  << this->TestProperties->Name << std::endl);
   }
 
-  this->ProcessOutput.clear();
+  this->ResetOutput();
   if (!output.empty()) {
     *this->TestHandler->LogFile << output << std::endl;
     cmCTestLog(this->CTest, ERROR_MESSAGE, output << std::endl);
@@ -491,7 +513,8 @@ bool cmCTestRunTest::StartTest(size_t completed, size_t total)
     cmCTestLog(this->CTest, HANDLER_TEST_PROGRESS_OUTPUT, testName);
   }
 
-  this->ProcessOutput.clear();
+  this->ResetOutput();
+  this->ResultCached = false;
 
   // Return immediately if test is disabled
   if (this->TestProperties->Disabled) {
@@ -592,6 +615,26 @@ bool cmCTestRunTest::StartTest(size_t completed, size_t total)
     this->TestResult.Status = cmCTestTestHandler::NOT_RUN;
     return false;
   }
+
+  // Report the last passing run if the inputs of the test did not change
+  if (cmCTestResultCache* cache = this->MultiTestHandler.GetResultCache()) {
+    this->Fingerprint = cache->ComputeFingerprint(
+      *this->TestProperties, this->ActualCommand, this->Arguments,
+      this->CTest->GetConfigType());
+    if (this->MultiTestHandler.IsResultCached(this->Index,
+                                              this->Fingerprint)) {
+      this->TestProcess = cm::make_unique<cmProcess>(*this);
+      *this->TestHandler->LogFile
+        << "Test passed before with the same inputs." << std::endl;
+      this->ResultCached = true;
+      this->TestResult.Output = "Test passed before with the same inputs.";
+      this->TestResult.ReturnValue = 0;
+      this->TestResult.CompletionStatus = "Cached";
+      this->TestResult.Status = cmCTestTestHandler::COMPLETED;
+      return false;
+    }
+  }
+
   this->StartTime = this->CTest->CurrentTime();
 
   auto timeout = this->TestProperties->Timeout;
@@ -730,6 +773,25 @@ bool cmCTestRunTest::ForkProcess(cmDuration testTimeOut, bool explicitTimeout,
                      this->TestHandler->GetQuiet());
 
   this->TestProcess->SetTimeout(timeout);
+  this->TestProcess->SetExplicitTimeout(explicitTimeout);
+
+  if (cmCTestWorkerPool* workers = this->MultiTestHandler.GetWorkerPool()) {
+    cmCTestWorker::Request request;
+    request.Command = this->ActualCommand;
+    request.Arguments = this->Arguments;
+    request.Directory = this->TestProperties->Directory;
+    if (environment) {
+      request.Environment = *environment;
+    }
+    if (affinity) {
+      request.Affinity = *affinity;
+    }
+    request.Timeout = timeout;
+    request.ExplicitTimeout = explicitTimeout;
+    request.AlternateTimeout = this->TestProperties->AlternateTimeout;
+    request.Output = this->OutputSettings;
+    return workers->Run(this, request);
+  }
 
 #ifdef CMAKE_BUILD_WITH_CMAKE
   cmSystemTools::SaveRestoreEnvironment sre;
@@ -804,8 +866,18 @@ void cmCTestRunTest::WriteLogOutputTop(size_t completed, size_t total)
     << "Output:" << std::endl
     << "----------------------------------------------------------"
     << std::endl;
-  *this->TestHandler->LogFile << this->ProcessOutput << "<end of output>"
-                              << std::endl;
+  // Copy the complete output if it did not fit in the capture.
+  cmsys::ifstream fullOutput;
+  if (!this->OutputResult.FullOutputFile.empty()) {
+    fullOutput.open(this->OutputResult.FullOutputFile.c_str(),
+                    std::ios::in | std::ios::binary);
+  }
+  if (fullOutput.is_open() && fullOutput) {
+    *this->TestHandler->LogFile << fullOutput.rdbuf();
+  } else {
+    *this->TestHandler->LogFile << this->ProcessOutput;
+  }
+  *this->TestHandler->LogFile << "<end of output>" << std::endl;
 
   if (!this->CTest->GetTestProgressOutput()) {
     cmCTestLog(this->CTest, HANDLER_OUTPUT, outputStream.str());
@@ -817,5 +889,35 @@ void cmCTestRunTest::WriteLogOutputTop(size_t completed, size_t total)
 
 void cmCTestRunTest::FinalizeTest()
 {
+  this->OutputResult = this->OutputMatcher.Finish();
+  this->MultiTestHandler.FinishTestProcess(this, true);
+}
+
+void cmCTestRunTest::FinishOnWorker(cmCTestWorker::Result const& result)
+{
+  this->OutputResult = result.Output;
+  if (result.TimeoutChanged) {
+    this->TestProperties->TimeoutRegularExpressions.clear();
+  }
+  if (!result.Started) {
+    // The worker has reported the error.
+    cmCTestMultiProcessHandler& multiHandler = this->MultiTestHandler;
+    multiHandler.FinishTestProcess(this, false);
+    multiHandler.StartNextTests();
+    return;
+  }
+
+  this->TestProcess->SetResult(
+    result.State, result.ExitValue, result.Signal, result.TotalTime,
+    result.HaveResourceUsage ? &result.ResourceUsage : nullptr);
+  // The output was not shown while the test ran.
+  if (this->CTest->GetExtraVerbose()) {
+    std::istringstream output(result.Output.Output);
+    std::string line;
+    while (std::getline(output, line)) {
+      cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                 this->GetIndex() << ": " << line << std::endl);
+    }
+  }
   this->MultiTestHandler.FinishTestProcess(this, true);
 }
@@ -7,10 +7,13 @@
 
 #include <set>
 #include <stddef.h>
+#include <stdint.h>
 #include <string>
 #include <vector>
 
+#include "cmCTestOutputMatcher.h"
 #include "cmCTestTestHandler.h"
+#include "cmCTestWorker.h"
 #include "cmDuration.h"
 #include "cmProcess.h" // IWYU pragma: keep (for unique_ptr)
 
@@ -22,7 +25,7 @@ class cmCTestMultiProcessHandler;
  *
  * cmRunTest contains the information related to running a single test
  */
-class cmCTestRunTest
+class cmCTestRunTest : public cmProcess::Client
 {
 public:
   explicit cmCTestRunTest(cmCTestMultiProcessHandler& multiHandler);
@@ -56,10 +59,7 @@ public:
   }
 
   // Read and store output.  Returns true if it must be called again.
-  void CheckOutput(std::string const& line);
-
-  // Compresses the output, writing to CompressedOutput
-  void CompressOutput();
+  void CheckOutput(std::string const& line) override;
 
   // launch the test process, return whether it started correctly
   bool StartTest(size_t completed, size_t total);
@@ -74,26 +74,44 @@ public:
 
   void StartFailure(std::string const& output);
 
-  cmCTest* GetCTest() const { return this->CTest; }
+  cmCTest* GetCTest() const override { return this->CTest; }
 
   std::string& GetActualCommand() { return this->ActualCommand; }
 
   const std::vector<std::string>& GetArguments() { return this->Arguments; }
 
-  void FinalizeTest();
+  void FinalizeTest() override;
+
+  // Finish the test with the result of running it in a worker process
+  void FinishOnWorker(cmCTestWorker::Result const& result);
 
   bool TimedOutForStopTime() const { return this->TimeoutIsForStopTime; }
 
+  int GetTestResultStatus() const { return this->TestResult.Status; }
+
+  // The fingerprint of the test inputs when results are cached
+  std::string const& GetFingerprint() const { return this->Fingerprint; }
+
+  // Whether the result of the last passing run was reused
+  bool IsResultCached() const { return this->ResultCached; }
+
+  // Resident set size in KiB of the running test process, or 0
+  uint64_t GetResidentSetSize();
+
 private:
   bool NeedsToRerun();
   void DartProcessing();
   void ExeNotFound(std::string exe);
+  // Prepare to capture the output of a new run of the test
+  void ResetOutput();
   bool ForkProcess(cmDuration testTimeOut, bool explicitTimeout,
                    std::vector<std::string>* environment,
                    std::vector<size_t>* affinity);
   void WriteLogOutputTop(size_t completed, size_t total);
   // Run post processing of the process output for MemCheck
   void MemCheckPostProcess();
+  // Fold the resource usage of this run into the test properties
+  void ComputeAverageResourceUsage();
 
   // Returns "completed/total Test #Index: "
   std::string GetTestPrefix(size_t completed, size_t total) const;
@@ -105,8 +123,10 @@ private:
   cmCTest* CTest;
   std::unique_ptr<cmProcess> TestProcess;
   std::string ProcessOutput;
-  std::string CompressedOutput;
-  double CompressionRatio;
+  cmCTestOutputMatcher::Settings OutputSettings;
+  cmCTestOutputMatcher OutputMatcher;
+  // The output of the finished run
+  cmCTestOutputMatcher::Result OutputResult;
   // The test results
   cmCTestTestHandler::cmCTestTestResult TestResult;
   cmCTestMultiProcessHandler& MultiTestHandler;
@@ -115,6 +135,8 @@ private:
   std::string StartTime;
   std::string ActualCommand;
   std::vector<std::string> Arguments;
+  std::string Fingerprint;
+  bool ResultCached = false;
   bool RunUntilFail;
   int NumberOfRunsLeft;
   bool RunAgain;
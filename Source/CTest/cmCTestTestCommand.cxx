@@ -27,8 +27,15 @@ cmCTestTestCommand::cmCTestTestCommand()
   this->Arguments[ctt_EXCLUDE_FIXTURE_CLEANUP] = "EXCLUDE_FIXTURE_CLEANUP";
   this->Arguments[ctt_PARALLEL_LEVEL] = "PARALLEL_LEVEL";
   this->Arguments[ctt_SCHEDULE_RANDOM] = "SCHEDULE_RANDOM";
+  this->Arguments[ctt_SCHEDULE_CRITICAL_PATH] = "SCHEDULE_CRITICAL_PATH";
+  this->Arguments[ctt_CACHE_RESULTS] = "CACHE_RESULTS";
   this->Arguments[ctt_STOP_TIME] = "STOP_TIME";
   this->Arguments[ctt_TEST_LOAD] = "TEST_LOAD";
+  this->Arguments[ctt_TEST_PRESSURE] = "TEST_PRESSURE";
+  this->Arguments[ctt_WORKERS] = "WORKERS";
+  this->Arguments[ctt_SHARD_INDEX] = "SHARD_INDEX";
+  this->Arguments[ctt_SHARD_COUNT] = "SHARD_COUNT";
+  this->Arguments[ctt_SHARD_COST_FILE] = "SHARD_COST_FILE";
   this->Arguments[ctt_LAST] = nullptr;
   this->Last = ctt_LAST;
 }
@@ -99,9 +106,31 @@ cmCTestGenericHandler* cmCTestTestCommand::InitializeHandler()
   if (this->Values[ctt_SCHEDULE_RANDOM]) {
     handler->SetOption("ScheduleRandom", this->Values[ctt_SCHEDULE_RANDOM]);
   }
+  if (this->Values[ctt_SCHEDULE_CRITICAL_PATH]) {
+    handler->SetOption("ScheduleCriticalPath",
+                       this->Values[ctt_SCHEDULE_CRITICAL_PATH]);
+  }
+  if (this->Values[ctt_CACHE_RESULTS]) {
+    handler->SetOption("CacheResults", this->Values[ctt_CACHE_RESULTS]);
+  }
   if (this->Values[ctt_STOP_TIME]) {
     this->CTest->SetStopTime(this->Values[ctt_STOP_TIME]);
   }
+  if (this->Values[ctt_TEST_PRESSURE]) {
+    handler->SetOption("TestPressure", this->Values[ctt_TEST_PRESSURE]);
+  }
+  if (this->Values[ctt_WORKERS]) {
+    handler->SetOption("Workers", this->Values[ctt_WORKERS]);
+  }
+  if (this->Values[ctt_SHARD_INDEX]) {
+    handler->SetOption("ShardIndex", this->Values[ctt_SHARD_INDEX]);
+  }
+  if (this->Values[ctt_SHARD_COUNT]) {
+    handler->SetOption("ShardCount", this->Values[ctt_SHARD_COUNT]);
+  }
+  if (this->Values[ctt_SHARD_COST_FILE]) {
+    handler->SetOption("ShardCostFile", this->Values[ctt_SHARD_COST_FILE]);
+  }
 
   // Test load is determined by: TEST_LOAD argument,
   // or CTEST_TEST_LOAD script variable, or ctest --test-load
@@ -58,8 +58,15 @@ protected:
     ctt_EXCLUDE_FIXTURE_CLEANUP,
     ctt_PARALLEL_LEVEL,
     ctt_SCHEDULE_RANDOM,
+    ctt_SCHEDULE_CRITICAL_PATH,
+    ctt_CACHE_RESULTS,
     ctt_STOP_TIME,
     ctt_TEST_LOAD,
+    ctt_TEST_PRESSURE,
+    ctt_WORKERS,
+    ctt_SHARD_INDEX,
+    ctt_SHARD_COUNT,
+    ctt_SHARD_COST_FILE,
     ctt_LAST
   };
 };
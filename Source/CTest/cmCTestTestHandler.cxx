@@ -22,6 +22,7 @@
 #include "cmCTest.h"
 #include "cmCTestMultiProcessHandler.h"
 #include "cmCommand.h"
+#include "cmCryptoHash.h"
 #include "cmDuration.h"
 #include "cmGeneratedFileStream.h"
 #include "cmGlobalGenerator.h"
@@ -337,8 +338,11 @@ cmCTestTestHandler::cmCTestTestHandler()
 
   this->CustomMaximumPassedTestOutputSize = 1 * 1024;
   this->CustomMaximumFailedTestOutputSize = 300 * 1024;
+  this->CustomTestOutputCaptureSize = 1024 * 1024;
 
   this->MemCheck = false;
+  this->ShardIndex = 0;
+  this->ShardCount = 0;
 
   this->LogFile = nullptr;
 
@@ -365,6 +369,7 @@ void cmCTestTestHandler::Initialize()
   this->CustomPostTest.clear();
   this->CustomMaximumPassedTestOutputSize = 1 * 1024;
   this->CustomMaximumFailedTestOutputSize = 300 * 1024;
+  this->CustomTestOutputCaptureSize = 1024 * 1024;
 
   this->TestsToRun.clear();
 
@@ -400,6 +405,9 @@ void cmCTestTestHandler::PopulateCustomVectors(cmMakefile* mf)
   this->CTest->PopulateCustomInteger(
     mf, "CTEST_CUSTOM_MAXIMUM_FAILED_TEST_OUTPUT_SIZE",
     this->CustomMaximumFailedTestOutputSize);
+  this->CTest->PopulateCustomInteger(
+    mf, "CTEST_CUSTOM_TEST_OUTPUT_CAPTURE_SIZE",
+    this->CustomTestOutputCaptureSize);
 }
 
 int cmCTestTestHandler::PreProcessHandler()
@@ -432,6 +440,9 @@ int cmCTestTestHandler::ProcessHandler()
   if (cmSystemTools::IsOn(this->GetOption("ScheduleRandom"))) {
     this->CTest->SetScheduleType("Random");
   }
+  if (cmSystemTools::IsOn(this->GetOption("ScheduleCriticalPath"))) {
+    this->CTest->SetScheduleType("CriticalPath");
+  }
   if (this->GetOption("ParallelLevel")) {
     this->CTest->SetParallelLevel(atoi(this->GetOption("ParallelLevel")));
   }
@@ -470,6 +481,54 @@ int cmCTestTestHandler::ProcessHandler()
     this->ExcludeFixtureCleanupRegExp = val;
   }
   this->SetRerunFailed(cmSystemTools::IsOn(this->GetOption("RerunFailed")));
+  this->CacheResults = cmSystemTools::IsOn(this->GetOption("CacheResults"));
+  this->TestPressure = 0;
+  val = this->GetOption("TestPressure");
+  if (val &&
+      (!cmSystemTools::StringToULong(val, &this->TestPressure) ||
+       this->TestPressure > 100)) {
+    this->TestPressure = 0;
+    cmCTestLog(this->CTest, WARNING,
+               "Invalid value for 'Test Pressure' : " << val << std::endl);
+  }
+  this->Workers = 0;
+  val = this->GetOption("Workers");
+  if (val && !cmSystemTools::StringToULong(val, &this->Workers)) {
+    this->Workers = 0;
+    cmCTestLog(this->CTest, WARNING,
+               "Invalid value for 'Workers' : " << val << std::endl);
+  }
+  this->ShardCount = 0;
+  val = this->GetOption("ShardCount");
+  if (val && !cmSystemTools::StringToULong(val, &this->ShardCount)) {
+    this->ShardCount = 0;
+    cmCTestLog(this->CTest, WARNING,
+               "Invalid value for 'Shard Count' : " << val << std::endl);
+  }
+  this->ShardIndex = 0;
+  val = this->GetOption("ShardIndex");
+  if ((val || this->ShardCount > 0) &&
+      (!val || !cmSystemTools::StringToULong(val, &this->ShardIndex) ||
+       this->ShardIndex >= this->ShardCount)) {
+    // Running all tests on every shard would hide the mistake.
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "Invalid value for 'Shard Index' : "
+                 << (val ? val : "") << ", it must be less than the shard "
+                 << "count " << this->ShardCount << std::endl);
+    return -1;
+  }
+  this->ShardCostFile.clear();
+  val = this->GetOption("ShardCostFile");
+  if (val && this->ShardCount > 0) {
+    this->ShardCostFile = cmSystemTools::CollapseFullPath(val);
+    if (!cmSystemTools::FileExists(this->ShardCostFile, true)) {
+      // A shard falling back to another plan would not match the others.
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+                 "Cannot read the shard cost file " << this->ShardCostFile
+                                                    << std::endl);
+      return -1;
+    }
+  }
 
   this->TestResults.clear();
 
@@ -844,6 +903,7 @@ void cmCTestTestHandler::ComputeTestList()
     finalList.push_back(tp);
   }
 
+  this->SelectShard(finalList);
   UpdateForFixtures(finalList);
 
   // Save the total number of tests before exclusions
@@ -874,6 +934,7 @@ void cmCTestTestHandler::ComputeTestListForRerunFailed()
     finalList.push_back(tp);
   }
 
+  this->SelectShard(finalList);
   UpdateForFixtures(finalList);
 
   // Save the total number of tests before exclusions
@@ -1139,6 +1200,152 @@ void cmCTestTestHandler::UpdateMaxTestNameWidth()
   }
 }
 
+void cmCTestTestHandler::SelectShard(ListOfTests& tests) const
+{
+  if (this->ShardCount == 0) {
+    return;
+  }
+
+  // Tests that depend on each other or share a fixture form a group
+  // that stays in one shard.
+  std::vector<size_t> group(tests.size());
+  for (size_t i = 0; i < group.size(); ++i) {
+    group[i] = i;
+  }
+  auto find = [&group](size_t i) {
+    while (group[i] != i) {
+      i = group[i] = group[group[i]];
+    }
+    return i;
+  };
+  auto unite = [&group, &find](size_t a, size_t b) {
+    a = find(a);
+    b = find(b);
+    // The group is named after its first test.
+    group[std::max(a, b)] = std::min(a, b);
+  };
+  std::map<std::string, size_t> byName;
+  for (size_t i = 0; i < tests.size(); ++i) {
+    byName.insert(std::make_pair(tests[i].Name, i));
+  }
+  std::map<std::string, size_t> byFixture;
+  for (size_t i = 0; i < tests.size(); ++i) {
+    cmCTestTestProperties const& p = tests[i];
+    for (std::string const& dep : p.Depends) {
+      auto const it = byName.find(dep);
+      if (it != byName.end()) {
+        unite(i, it->second);
+      }
+    }
+    for (std::set<std::string> const* fixtures :
+         { &p.FixturesSetup, &p.FixturesCleanup, &p.FixturesRequired }) {
+      for (std::string const& fixture : *fixtures) {
+        auto const it = byFixture.insert(std::make_pair(fixture, i)).first;
+        unite(i, it->second);
+      }
+    }
+  }
+
+  // Every shard must compute the same plan, so it may only depend on
+  // data given to all of them.  With a cost file, balance the cost of
+  // the shards.  Tests missing from the file count as the average test.
+  // Otherwise, assign the groups by a hash of the name of their first
+  // test, and count each test the same.
+  bool const balance = !this->ShardCostFile.empty();
+  std::map<std::string, float> costs;
+  if (balance) {
+    cmsys::ifstream fin(this->ShardCostFile.c_str());
+    std::string line;
+    while (std::getline(fin, line) && line != "---") {
+      std::vector<std::string> parts = cmSystemTools::SplitString(line, ' ');
+      if (parts.size() < 3) {
+        break;
+      }
+      costs[parts[0]] = static_cast<float>(atof(parts[2].c_str()));
+    }
+  }
+  float defaultCost = 1;
+  if (!costs.empty()) {
+    float total = 0;
+    for (auto const& c : costs) {
+      total += c.second;
+    }
+    defaultCost = std::max(total / static_cast<float>(costs.size()), 0.001f);
+  }
+
+  std::vector<float> testCost(tests.size(), 0);
+  std::map<size_t, float> groupCost;
+  for (size_t i = 0; i < tests.size(); ++i) {
+    if (!tests[i].Disabled) {
+      auto const it = costs.find(tests[i].Name);
+      testCost[i] = it != costs.end() ? it->second : defaultCost;
+    }
+    groupCost[find(i)] += testCost[i];
+  }
+
+  std::vector<float> shardCost(this->ShardCount, 0);
+  std::map<size_t, size_t> groupShard;
+  if (balance) {
+    // Hand out the most expensive groups first, each to the shard with
+    // the lowest cost so far.  Ties go to the earlier group and the
+    // lower shard.
+    std::vector<std::pair<float, size_t>> order;
+    for (auto const& g : groupCost) {
+      order.emplace_back(g.second, g.first);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](std::pair<float, size_t> const& a,
+                        std::pair<float, size_t> const& b) {
+                       return a.first > b.first;
+                     });
+    for (auto const& g : order) {
+      size_t const shard = static_cast<size_t>(
+        std::min_element(shardCost.begin(), shardCost.end()) -
+        shardCost.begin());
+      shardCost[shard] += g.first;
+      groupShard[g.second] = shard;
+    }
+  } else {
+    cmCryptoHash md5(cmCryptoHash::AlgoMD5);
+    for (auto const& g : groupCost) {
+      std::string const hash = md5.HashString(tests[g.first].Name);
+      size_t const shard = static_cast<size_t>(
+        strtoul(hash.substr(0, 8).c_str(), nullptr, 16) % this->ShardCount);
+      shardCost[shard] += g.second;
+      groupShard[g.first] = shard;
+    }
+  }
+
+  // Write the plan of all shards to compare them between machines.
+  std::string const planFile =
+    cmSystemTools::GetFilenamePath(this->CTest->GetCostDataFile()) +
+    "/CTestShardPlan.txt";
+  cmGeneratedFileStream plan(planFile.c_str());
+  plan << "# <shard> <cost> <test>\n";
+  for (size_t shard = 0; shard < this->ShardCount; ++shard) {
+    for (size_t i = 0; i < tests.size(); ++i) {
+      if (groupShard[find(i)] == shard) {
+        plan << shard << " " << testCost[i] << " " << tests[i].Name << "\n";
+      }
+    }
+  }
+
+  ListOfTests selected;
+  for (size_t i = 0; i < tests.size(); ++i) {
+    if (groupShard[find(i)] == this->ShardIndex) {
+      selected.push_back(tests[i]);
+    }
+  }
+  cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                     "Shard " << this->ShardIndex << " of "
+                              << this->ShardCount << ": " << selected.size()
+                              << " of " << tests.size()
+                              << " tests, expected cost "
+                              << shardCost[this->ShardIndex] << std::endl,
+                     this->Quiet);
+  tests.swap(selected);
+}
+
 bool cmCTestTestHandler::GetValue(const char* tag, int& value,
                                   std::istream& fin)
 {
@@ -1250,11 +1457,19 @@ void cmCTestTestHandler::ProcessDirectory(std::vector<std::string>& passed,
   parallel->SetParallelLevel(this->CTest->GetParallelLevel());
   parallel->SetTestHandler(this);
   parallel->SetQuiet(this->Quiet);
+  // Memory checks and repeated runs must run every test.
+  parallel->SetCacheResults(this->CacheResults && !this->MemCheck &&
+                            !this->CTest->GetRepeatUntilFail());
   if (this->TestLoad > 0) {
     parallel->SetTestLoad(this->TestLoad);
   } else {
     parallel->SetTestLoad(this->CTest->GetTestLoad());
   }
+  parallel->SetTestPressure(this->TestPressure);
+  // Memory checks parse all of the output here.
+  if (!this->MemCheck) {
+    parallel->SetWorkers(this->Workers);
+  }
 
   *this->LogFile
     << "Start testing: " << this->CTest->CurrentTime() << std::endl
@@ -1361,6 +1576,9 @@ void cmCTestTestHandler::GenerateDartOutput(cmXMLWriter& xml)
       xml.Attribute("name", "Execution Time");
       xml.Element("Value", result.ExecutionTime.count());
       xml.EndElement(); // NamedMeasurement
+      if (result.HaveResourceUsage) {
+        this->WriteResourceUsage(xml, result.ResourceUsage);
+      }
       if (!result.Reason.empty()) {
         const char* reasonType = "Pass Reason";
         if (result.Status != cmCTestTestHandler::COMPLETED) {
@@ -1423,6 +1641,24 @@ void cmCTestTestHandler::GenerateDartOutput(cmXMLWriter& xml)
   this->CTest->EndXML(xml);
 }
 
+void cmCTestTestHandler::WriteResourceUsage(
+  cmXMLWriter& xml, cmCTestResourceUsage const& usage)
+{
+  auto measure = [&xml](const char* name, double value) {
+    xml.StartElement("NamedMeasurement");
+    xml.Attribute("type", "numeric/double");
+    xml.Attribute("name", name);
+    xml.Element("Value", value);
+    xml.EndElement(); // NamedMeasurement
+  };
+  measure("User Time", usage.UserTime);
+  measure("System Time", usage.SystemTime);
+  measure("Max Resident Set Size",
+          static_cast<double>(usage.MaxResidentSetSize));
+  measure("Block Input Operations", static_cast<double>(usage.BlockInput));
+  measure("Block Output Operations", static_cast<double>(usage.BlockOutput));
+}
+
 void cmCTestTestHandler::WriteTestResultHeader(cmXMLWriter& xml,
                                                cmCTestTestResult const& result)
 {
@@ -2219,6 +2455,9 @@ bool cmCTestTestHandler::SetTestsProperties(
           if (key == "REQUIRED_FILES") {
             cmSystemTools::ExpandListArgument(val, rt.RequiredFiles);
           }
+          if (key == "RESULT_CACHE_INPUTS") {
+            cmSystemTools::ExpandListArgument(val, rt.ResultCacheInputs);
+          }
           if (key == "RUN_SERIAL") {
             rt.RunSerial = cmSystemTools::IsOn(val);
           }
@@ -2412,6 +2651,10 @@ bool cmCTestTestHandler::AddTest(const std::vector<std::string>& args)
   test.WantAffinity = false;
   test.SkipReturnCode = -1;
   test.PreviousRuns = 0;
+  test.ExpectedMemory = 0;
+  test.ExpectedProcessors = 0;
+  test.ResourceUsageRuns = 0;
+  test.AverageExecutionTime = 0;
   if (this->UseIncludeRegExpFlag &&
       !this->IncludeTestsRegularExpression.find(testname)) {
     test.IsInBasedOnREOptions = false;
@@ -15,6 +15,7 @@
 #include <map>
 #include <set>
 #include <stddef.h>
+#include <stdint.h>
 #include <string>
 #include <utility>
 #include <vector>
@@ -99,6 +100,19 @@ public:
 
   void Initialize() override;
 
+  // Resources used by a test process
+  struct cmCTestResourceUsage
+  {
+    // Processor time in seconds
+    double UserTime = 0;
+    double SystemTime = 0;
+    // Peak resident set size in KiB
+    uint64_t MaxResidentSetSize = 0;
+    // Number of block input and output operations
+    uint64_t BlockInput = 0;
+    uint64_t BlockOutput = 0;
+  };
+
   // NOTE: This struct is Saved/Restored
   // in cmCTestTestHandler, if you add to this class
   // then you must add the new members to that code or
@@ -109,6 +123,7 @@ public:
     std::string Directory;
     std::vector<std::string> Args;
     std::vector<std::string> RequiredFiles;
+    std::vector<std::string> ResultCacheInputs;
     std::vector<std::string> Depends;
     std::vector<std::string> AttachedFiles;
     std::vector<std::string> AttachOnFail;
@@ -124,6 +139,14 @@ public:
     bool Disabled;
     float Cost;
     int PreviousRuns;
+    // Peak resident set size in KiB expected from previous runs, or 0
+    uint64_t ExpectedMemory;
+    // Number of processors the previous runs kept busy on average, or 0
+    int ExpectedProcessors;
+    // Resources used by the previous runs on average
+    int ResourceUsageRuns;
+    double AverageExecutionTime;
+    cmCTestResourceUsage AverageResourceUsage;
     bool RunSerial;
     cmDuration Timeout;
     bool ExplicitTimeout;
@@ -156,6 +179,8 @@ public:
     int ReturnValue;
     int Status;
     std::string ExceptionStatus;
+    bool HaveResourceUsage = false;
+    cmCTestResourceUsage ResourceUsage;
     bool CompressOutput;
     std::string CompletionStatus;
     std::string Output;
@@ -194,6 +219,8 @@ protected:
   virtual void GenerateTestCommand(std::vector<std::string>& args, int test);
   int ExecuteCommands(std::vector<std::string>& vec);
 
+  void WriteResourceUsage(cmXMLWriter& xml,
+                          cmCTestResourceUsage const& usage);
   void WriteTestResultHeader(cmXMLWriter& xml,
                              cmCTestTestResult const& result);
   void WriteTestResultFooter(cmXMLWriter& xml,
@@ -217,6 +244,7 @@ protected:
   bool MemCheck;
   int CustomMaximumPassedTestOutputSize;
   int CustomMaximumFailedTestOutputSize;
+  int CustomTestOutputCaptureSize;
   int MaxIndex;
 
 public:
@@ -267,6 +295,10 @@ private:
 
   void UpdateMaxTestNameWidth();
 
+  // keep only the tests of the shard selected by --shard-index and
+  // write the plan of all shards
+  void SelectShard(ListOfTests& tests) const;
+
   bool GetValue(const char* tag, std::string& value, std::istream& fin);
   bool GetValue(const char* tag, int& value, std::istream& fin);
   bool GetValue(const char* tag, size_t& value, std::istream& fin);
@@ -318,6 +350,12 @@ private:
   std::ostream* LogFile;
 
   bool RerunFailed;
+  bool CacheResults;
+  unsigned long TestPressure;
+  unsigned long Workers;
+  unsigned long ShardIndex;
+  unsigned long ShardCount;
+  std::string ShardCostFile;
 };
 
 #endif
@@ -0,0 +1,380 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestWorker.h"
+
+#include "cmAlgorithms.h"
+#include "cmCTest.h"
+#include "cmSystemTools.h"
+#include "cmWorkingDirectory.h"
+
+#include "cm_jsoncpp_reader.h"
+#include "cm_jsoncpp_value.h"
+#include "cm_jsoncpp_writer.h"
+
+#include "cmUVSignalHackRAII.h" // IWYU pragma: keep
+
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+Json::Value cmCTestWorkerWriteStrings(std::vector<std::string> const& list)
+{
+  Json::Value value(Json::arrayValue);
+  for (std::string const& s : list) {
+    value.append(s);
+  }
+  return value;
+}
+
+std::vector<std::string> cmCTestWorkerReadStrings(Json::Value const& value)
+{
+  std::vector<std::string> list;
+  if (value.isArray()) {
+    for (Json::Value const& s : value) {
+      list.push_back(s.asString());
+    }
+  }
+  return list;
+}
+
+bool cmCTestWorkerReadObject(std::string const& line, Json::Value& value)
+{
+  Json::Reader reader;
+  return reader.parse(line, value, false) && value.isObject() &&
+    value["id"].isInt();
+}
+}
+
+class cmCTestWorker::Job : public cmProcess::Client
+{
+public:
+  Job(cmCTestWorker& worker, int id, Request request)
+    : Worker(worker)
+    , Id(id)
+    , Req(std::move(request))
+  {
+  }
+
+  bool Start();
+
+  cmCTest* GetCTest() const override { return this->Worker.CTest; }
+  void CheckOutput(std::string const& line) override;
+  void FinalizeTest() override;
+
+private:
+  cmCTestWorker& Worker;
+  int Id;
+  Request Req;
+  std::unique_ptr<cmProcess> Process;
+  cmCTestOutputMatcher Matcher;
+  bool TimeoutChanged = false;
+};
+
+bool cmCTestWorker::Job::Start()
+{
+  this->Matcher.Reset(this->Req.Output);
+  this->Process = cm::make_unique<cmProcess>(*this);
+  this->Process->SetId(this->Id);
+  this->Process->SetWorkingDirectory(this->Req.Directory.c_str());
+  this->Process->SetCommand(this->Req.Command.c_str());
+  this->Process->SetCommandArguments(this->Req.Arguments);
+  this->Process->SetTimeout(this->Req.Timeout);
+  this->Process->SetExplicitTimeout(this->Req.ExplicitTimeout);
+
+  cmWorkingDirectory workdir(this->Req.Directory);
+  if (workdir.Failed()) {
+    cmCTestLog(this->Worker.CTest, ERROR_MESSAGE,
+               "Failed to change working directory to "
+                 << this->Req.Directory << " : "
+                 << std::strerror(workdir.GetLastResult()) << std::endl);
+    return false;
+  }
+
+#ifdef CMAKE_BUILD_WITH_CMAKE
+  cmSystemTools::SaveRestoreEnvironment sre;
+#endif
+
+  if (!this->Req.Environment.empty()) {
+    cmSystemTools::AppendEnv(this->Req.Environment);
+  }
+
+  return this->Process->StartProcess(this->Worker.Loop, &this->Req.Affinity);
+}
+
+void cmCTestWorker::Job::CheckOutput(std::string const& line)
+{
+  if (this->Matcher.AddLine(line)) {
+    this->TimeoutChanged = true;
+    this->Process->ResetStartTime();
+    this->Process->ChangeTimeout(this->Req.AlternateTimeout);
+  }
+}
+
+void cmCTestWorker::Job::FinalizeTest()
+{
+  Result result;
+  result.Started = true;
+  result.State = this->Process->GetProcessStatus();
+  result.ExitValue = this->Process->GetExitValue();
+  result.Signal = this->Process->GetSignal();
+  result.TotalTime = this->Process->GetTotalTime();
+  result.HaveResourceUsage =
+    this->Process->GetResourceUsage(result.ResourceUsage);
+  result.TimeoutChanged = this->TimeoutChanged;
+  result.Output = this->Matcher.Finish();
+  // This deletes the job.
+  this->Worker.FinishJob(this->Id, result);
+}
+
+cmCTestWorker::cmCTestWorker(cmCTest* ctest)
+  : CTest(ctest)
+{
+}
+
+cmCTestWorker::~cmCTestWorker() = default;
+
+int cmCTestWorker::Main(int argc, const char* const argv[])
+{
+  if (argc != 2) {
+    std::cerr << "ctest --worker takes no arguments" << std::endl;
+    return 1;
+  }
+  static_cast<void>(argv);
+
+  cmCTest ctest;
+  cmCTestWorker self(&ctest);
+  return self.Run();
+}
+
+int cmCTestWorker::Run()
+{
+#ifdef CMAKE_UV_SIGNAL_HACK
+  cmUVSignalHackRAII hackRAII;
+#endif
+  uv_loop_init(&this->Loop);
+
+  int status = this->Input.init(this->Loop, 0, this);
+  if (status == 0) {
+    status = uv_pipe_open(this->Input, 0);
+  }
+  if (status == 0) {
+    status = uv_read_start(this->Input, &cmCTestWorker::OnAllocateCB,
+                           &cmCTestWorker::OnReadCB);
+  }
+  if (status != 0) {
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "Error reading requests: " << uv_strerror(status)
+                                          << std::endl);
+    this->Input.reset();
+  }
+
+  uv_run(&this->Loop, UV_RUN_DEFAULT);
+  uv_loop_close(&this->Loop);
+  return status == 0 ? 0 : 1;
+}
+
+void cmCTestWorker::OnAllocateCB(uv_handle_t* handle,
+                                 size_t /*suggested_size*/, uv_buf_t* buf)
+{
+  auto self = static_cast<cmCTestWorker*>(handle->data);
+  if (self->Buf.empty()) {
+    self->Buf.resize(65536);
+  }
+  *buf =
+    uv_buf_init(self->Buf.data(), static_cast<unsigned int>(self->Buf.size()));
+}
+
+void cmCTestWorker::OnReadCB(uv_stream_t* stream, ssize_t nread,
+                             const uv_buf_t* buf)
+{
+  auto self = static_cast<cmCTestWorker*>(stream->data);
+  self->OnRead(nread, buf);
+}
+
+void cmCTestWorker::OnRead(ssize_t nread, const uv_buf_t* buf)
+{
+  if (nread > 0) {
+    char const* first = buf->base;
+    char const* last = buf->base + nread;
+    for (char const* c = first; c != last; ++c) {
+      if (*c == '\n') {
+        this->Line.append(first, c);
+        this->StartJob(this->Line);
+        this->Line.clear();
+        first = c + 1;
+      }
+    }
+    this->Line.append(first, last);
+    return;
+  }
+
+  if (nread == 0) {
+    return;
+  }
+
+  // The coordinating ctest closed our input.  Exit once the tests
+  // running now have finished.
+  if (nread != UV_EOF) {
+    auto error = static_cast<int>(nread);
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "Error reading requests: " << uv_strerror(error)
+                                          << std::endl);
+  }
+  this->Input.reset();
+}
+
+void cmCTestWorker::StartJob(std::string const& line)
+{
+  int id;
+  Request request;
+  if (!ReadRequest(line, id, request)) {
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "Invalid request: " << line << std::endl);
+    return;
+  }
+
+  Job* job = new Job(*this, id, std::move(request));
+  this->Jobs[id] = std::unique_ptr<Job>(job);
+  if (!job->Start()) {
+    this->FinishJob(id, Result());
+  }
+}
+
+void cmCTestWorker::FinishJob(int id, Result const& result)
+{
+  std::cout << WriteResult(id, result) << std::flush;
+  this->Jobs.erase(id);
+}
+
+std::string cmCTestWorker::WriteRequest(int id, Request const& request)
+{
+  Json::Value value(Json::objectValue);
+  value["id"] = id;
+  value["command"] = request.Command;
+  value["arguments"] = cmCTestWorkerWriteStrings(request.Arguments);
+  value["directory"] = request.Directory;
+  value["environment"] = cmCTestWorkerWriteStrings(request.Environment);
+  Json::Value& affinity = value["affinity"] = Json::arrayValue;
+  for (size_t p : request.Affinity) {
+    affinity.append(static_cast<Json::UInt64>(p));
+  }
+  value["timeout"] = request.Timeout.count();
+  value["explicitTimeout"] = request.ExplicitTimeout;
+  value["alternateTimeout"] = request.AlternateTimeout.count();
+
+  cmCTestOutputMatcher::Settings const& output = request.Output;
+  value["limit"] = static_cast<Json::UInt64>(output.Limit);
+  value["compress"] = output.Compress;
+  value["spillFile"] = output.SpillFile;
+  value["requiredRegex"] = cmCTestWorkerWriteStrings(output.RequiredRegex);
+  value["errorRegex"] = cmCTestWorkerWriteStrings(output.ErrorRegex);
+  value["timeoutRegex"] = cmCTestWorkerWriteStrings(output.TimeoutRegex);
+
+  Json::FastWriter writer;
+  return writer.write(value);
+}
+
+bool cmCTestWorker::ReadRequest(std::string const& line, int& id,
+                                Request& request)
+{
+  Json::Value value;
+  if (!cmCTestWorkerReadObject(line, value)) {
+    return false;
+  }
+  id = value["id"].asInt();
+  request.Command = value["command"].asString();
+  request.Arguments = cmCTestWorkerReadStrings(value["arguments"]);
+  request.Directory = value["directory"].asString();
+  request.Environment = cmCTestWorkerReadStrings(value["environment"]);
+  request.Affinity.clear();
+  for (Json::Value const& p : value["affinity"]) {
+    request.Affinity.push_back(static_cast<size_t>(p.asUInt64()));
+  }
+  request.Timeout = cmDuration(value["timeout"].asDouble());
+  request.ExplicitTimeout = value["explicitTimeout"].asBool();
+  request.AlternateTimeout = cmDuration(value["alternateTimeout"].asDouble());
+
+  cmCTestOutputMatcher::Settings& output = request.Output;
+  output.Limit = static_cast<size_t>(value["limit"].asUInt64());
+  output.Compress = value["compress"].asBool();
+  output.SpillFile = value["spillFile"].asString();
+  output.RequiredRegex = cmCTestWorkerReadStrings(value["requiredRegex"]);
+  output.ErrorRegex = cmCTestWorkerReadStrings(value["errorRegex"]);
+  output.TimeoutRegex = cmCTestWorkerReadStrings(value["timeoutRegex"]);
+  return true;
+}
+
+std::string cmCTestWorker::WriteResult(int id, Result const& result)
+{
+  Json::Value value(Json::objectValue);
+  value["id"] = id;
+  value["started"] = result.Started;
+  value["state"] = static_cast<int>(result.State);
+  value["exitValue"] = result.ExitValue;
+  value["signal"] = result.Signal;
+  value["totalTime"] = result.TotalTime.count();
+  if (result.HaveResourceUsage) {
+    cmCTestTestHandler::cmCTestResourceUsage const& usage =
+      result.ResourceUsage;
+    Json::Value& resources = value["resourceUsage"] = Json::objectValue;
+    resources["userTime"] = usage.UserTime;
+    resources["systemTime"] = usage.SystemTime;
+    resources["maxResidentSetSize"] =
+      static_cast<Json::UInt64>(usage.MaxResidentSetSize);
+    resources["blockInput"] = static_cast<Json::UInt64>(usage.BlockInput);
+    resources["blockOutput"] = static_cast<Json::UInt64>(usage.BlockOutput);
+  }
+  value["timeoutChanged"] = result.TimeoutChanged;
+
+  cmCTestOutputMatcher::Result const& output = result.Output;
+  value["output"] = output.Output;
+  if (output.Compressed) {
+    value["compressedOutput"] = output.CompressedOutput;
+  }
+  value["fullOutputFile"] = output.FullOutputFile;
+  value["requiredFound"] = output.RequiredFound;
+  if (output.ErrorFound) {
+    value["errorFound"] = output.ErrorRegex;
+  }
+
+  Json::FastWriter writer;
+  return writer.write(value);
+}
+
+bool cmCTestWorker::ReadResult(std::string const& line, int& id,
+                               Result& result)
+{
+  Json::Value value;
+  if (!cmCTestWorkerReadObject(line, value)) {
+    return false;
+  }
+  id = value["id"].asInt();
+  result.Started = value["started"].asBool();
+  result.State = static_cast<cmProcess::State>(value["state"].asInt());
+  result.ExitValue = value["exitValue"].asInt();
+  result.Signal = value["signal"].asInt();
+  result.TotalTime = cmDuration(value["totalTime"].asDouble());
+  Json::Value const& resources = value["resourceUsage"];
+  result.HaveResourceUsage = resources.isObject();
+  if (result.HaveResourceUsage) {
+    cmCTestTestHandler::cmCTestResourceUsage& usage = result.ResourceUsage;
+    usage.UserTime = resources["userTime"].asDouble();
+    usage.SystemTime = resources["systemTime"].asDouble();
+    usage.MaxResidentSetSize = resources["maxResidentSetSize"].asUInt64();
+    usage.BlockInput = resources["blockInput"].asUInt64();
+    usage.BlockOutput = resources["blockOutput"].asUInt64();
+  }
+  result.TimeoutChanged = value["timeoutChanged"].asBool();
+
+  cmCTestOutputMatcher::Result& output = result.Output;
+  output.Output = value["output"].asString();
+  output.Compressed = value.isMember("compressedOutput");
+  output.CompressedOutput = value["compressedOutput"].asString();
+  output.FullOutputFile = value["fullOutputFile"].asString();
+  output.RequiredFound = value["requiredFound"].asBool();
+  output.ErrorFound = value.isMember("errorFound");
+  output.ErrorRegex = value["errorFound"].asString();
+  return true;
+}
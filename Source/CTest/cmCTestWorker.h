@@ -0,0 +1,100 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmCTestWorker_h
+#define cmCTestWorker_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include "cmCTestOutputMatcher.h"
+#include "cmCTestTestHandler.h"
+#include "cmDuration.h"
+#include "cmProcess.h"
+#include "cmUVHandlePtr.h"
+#include "cm_uv.h"
+
+#include <map>
+#include <memory>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+class cmCTest;
+
+/** \class cmCTestWorker
+ * \brief Run test processes for another ctest process
+ *
+ * This implements 'ctest --worker', which ctest starts when asked to
+ * use worker processes.  The worker reads requests to run a test from
+ * its standard input and writes the result of each run to its standard
+ * output, one JSON object per line.  It captures the output of the test
+ * and matches the regular expressions of the test against it.  The
+ * ctest process that started it keeps scheduling the tests and reports
+ * their results.
+ */
+class cmCTestWorker
+{
+public:
+  struct Request
+  {
+    std::string Command;
+    std::vector<std::string> Arguments;
+    std::string Directory;
+    std::vector<std::string> Environment;
+    std::vector<size_t> Affinity;
+    cmDuration Timeout = cmDuration::zero();
+    bool ExplicitTimeout = false;
+    cmDuration AlternateTimeout = cmDuration::zero();
+    cmCTestOutputMatcher::Settings Output;
+  };
+
+  struct Result
+  {
+    // Whether the process could be started
+    bool Started = false;
+    cmProcess::State State = cmProcess::State::Error;
+    int ExitValue = 0;
+    int Signal = 0;
+    cmDuration TotalTime = cmDuration::zero();
+    bool HaveResourceUsage = false;
+    cmCTestTestHandler::cmCTestResourceUsage ResourceUsage;
+    // Whether the output matched a TIMEOUT_AFTER_MATCH expression
+    bool TimeoutChanged = false;
+    cmCTestOutputMatcher::Result Output;
+  };
+
+  /** Entry point from ctest executable main().  */
+  static int Main(int argc, const char* const argv[]);
+
+  // Encode a request or a result as a line of JSON and decode it.
+  static std::string WriteRequest(int id, Request const& request);
+  static bool ReadRequest(std::string const& line, int& id,
+                          Request& request);
+  static std::string WriteResult(int id, Result const& result);
+  static bool ReadResult(std::string const& line, int& id, Result& result);
+
+private:
+  class Job;
+
+  explicit cmCTestWorker(cmCTest* ctest);
+  ~cmCTestWorker();
+
+  int Run();
+  void StartJob(std::string const& line);
+  void FinishJob(int id, Result const& result);
+
+  static void OnAllocateCB(uv_handle_t* handle, size_t suggested_size,
+                           uv_buf_t* buf);
+  static void OnReadCB(uv_stream_t* stream, ssize_t nread,
+                       const uv_buf_t* buf);
+  void OnRead(ssize_t nread, const uv_buf_t* buf);
+
+  cmCTest* CTest;
+  uv_loop_t Loop;
+  cm::uv_pipe_ptr Input;
+  std::vector<char> Buf;
+  // Partial line of input
+  std::string Line;
+  std::map<int, std::unique_ptr<Job>> Jobs;
+};
+
+#endif
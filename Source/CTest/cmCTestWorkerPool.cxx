@@ -0,0 +1,241 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestWorkerPool.h"
+
+#include "cmAlgorithms.h"
+#include "cmCTest.h"
+#include "cmCTestRunTest.h"
+#include "cmSystemTools.h"
+#include "cmUVHandlePtr.h"
+
+#include <set>
+#include <utility>
+
+struct cmCTestWorkerPool::Worker
+{
+  cmCTestWorkerPool* Pool = nullptr;
+  cm::uv_process_ptr Process;
+  // The standard input and output of the worker
+  cm::uv_pipe_ptr Input;
+  cm::uv_pipe_ptr Output;
+  // Partial line of output
+  std::string Line;
+  // The tests running in the worker, by test index
+  std::set<int> Tests;
+};
+
+struct cmCTestWorkerPool::Write
+{
+  uv_write_t Request;
+  std::string Data;
+};
+
+cmCTestWorkerPool::cmCTestWorkerPool(cmCTest* ctest)
+  : CTest(ctest)
+{
+}
+
+cmCTestWorkerPool::~cmCTestWorkerPool() = default;
+
+bool cmCTestWorkerPool::Start(uv_loop_t& loop, size_t count)
+{
+  std::string const ctest = cmSystemTools::GetCTestCommand();
+  char const* args[] = { ctest.c_str(), "--worker", nullptr };
+
+  for (size_t i = 0; i < count; ++i) {
+    auto worker = cm::make_unique<Worker>();
+    worker->Pool = this;
+    worker->Input.init(loop, 0, worker.get());
+    worker->Output.init(loop, 0, worker.get());
+
+    uv_stdio_container_t stdio[3];
+    stdio[0].flags =
+      static_cast<uv_stdio_flags>(UV_CREATE_PIPE | UV_READABLE_PIPE);
+    stdio[0].data.stream = worker->Input;
+    stdio[1].flags =
+      static_cast<uv_stdio_flags>(UV_CREATE_PIPE | UV_WRITABLE_PIPE);
+    stdio[1].data.stream = worker->Output;
+    stdio[2].flags = UV_INHERIT_FD;
+    stdio[2].data.fd = 2;
+
+    uv_process_options_t options = uv_process_options_t();
+    options.file = ctest.c_str();
+    options.args = const_cast<char**>(args);
+    options.stdio_count = 3;
+    options.stdio = stdio;
+    options.exit_cb = &cmCTestWorkerPool::OnExitCB;
+
+    int status = worker->Process.spawn(loop, options, worker.get());
+    if (status == 0) {
+      status = uv_read_start(worker->Output, &cmCTestWorkerPool::OnAllocateCB,
+                             &cmCTestWorkerPool::OnReadCB);
+    }
+    if (status != 0) {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+                 "Cannot start ctest worker: " << uv_strerror(status)
+                                               << std::endl);
+      break;
+    }
+
+    // Idle workers do not keep the event loop running.
+    uv_unref(worker->Process);
+    uv_unref(worker->Input);
+    uv_unref(worker->Output);
+    this->Workers.push_back(std::move(worker));
+  }
+  return !this->Workers.empty();
+}
+
+bool cmCTestWorkerPool::Run(cmCTestRunTest* runner,
+                            cmCTestWorker::Request const& request)
+{
+  Worker* worker = nullptr;
+  for (auto const& w : this->Workers) {
+    if (w->Process.get() != nullptr &&
+        (!worker || w->Tests.size() < worker->Tests.size())) {
+      worker = w.get();
+    }
+  }
+  if (!worker) {
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "No ctest worker is left to run tests." << std::endl);
+    return false;
+  }
+
+  int const id = runner->GetIndex();
+  Write* write = new Write;
+  write->Request.data = write;
+  write->Data = cmCTestWorker::WriteRequest(id, request);
+  uv_buf_t buf = uv_buf_init(&write->Data[0],
+                             static_cast<unsigned int>(write->Data.size()));
+  int status = uv_write(&write->Request, worker->Input, &buf, 1,
+                        &cmCTestWorkerPool::OnWriteCB);
+  if (status != 0) {
+    delete write;
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "Error writing to ctest worker: " << uv_strerror(status)
+                                                 << std::endl);
+    return false;
+  }
+
+  // Keep the event loop running until the result arrives.
+  if (worker->Tests.empty()) {
+    uv_ref(worker->Output);
+  }
+  worker->Tests.insert(id);
+  this->Running[id] = runner;
+  return true;
+}
+
+void cmCTestWorkerPool::Stop()
+{
+  for (auto const& worker : this->Workers) {
+    worker->Input.reset();
+    if (worker->Process.get() != nullptr) {
+      uv_ref(worker->Process);
+    }
+  }
+}
+
+void cmCTestWorkerPool::OnWriteCB(uv_write_t* req, int /*status*/)
+{
+  // A worker that cannot read its input has exited.  Its tests fail
+  // when the exit is noticed.
+  delete static_cast<Write*>(req->data);
+}
+
+void cmCTestWorkerPool::OnExitCB(uv_process_t* process,
+                                 int64_t /*exit_status*/, int /*term_signal*/)
+{
+  auto worker = static_cast<Worker*>(process->data);
+  worker->Pool->OnExit(worker);
+}
+
+void cmCTestWorkerPool::OnExit(Worker* worker)
+{
+  worker->Process.reset();
+  worker->Input.reset();
+  worker->Output.reset();
+
+  std::set<int> tests;
+  tests.swap(worker->Tests);
+  if (!tests.empty()) {
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "A ctest worker exited while running tests." << std::endl);
+  }
+  for (int id : tests) {
+    this->FinishTest(worker, id, cmCTestWorker::Result());
+  }
+}
+
+void cmCTestWorkerPool::OnAllocateCB(uv_handle_t* handle,
+                                     size_t /*suggested_size*/, uv_buf_t* buf)
+{
+  cmCTestWorkerPool* self = static_cast<Worker*>(handle->data)->Pool;
+  if (self->Buf.empty()) {
+    self->Buf.resize(65536);
+  }
+  *buf =
+    uv_buf_init(self->Buf.data(), static_cast<unsigned int>(self->Buf.size()));
+}
+
+void cmCTestWorkerPool::OnReadCB(uv_stream_t* stream, ssize_t nread,
+                                 const uv_buf_t* buf)
+{
+  auto worker = static_cast<Worker*>(stream->data);
+  worker->Pool->OnRead(worker, nread, buf);
+}
+
+void cmCTestWorkerPool::OnRead(Worker* worker, ssize_t nread,
+                               const uv_buf_t* buf)
+{
+  if (nread < 0) {
+    // The worker is exiting.
+    worker->Output.reset();
+    return;
+  }
+
+  char const* first = buf->base;
+  char const* last = buf->base + nread;
+  for (char const* c = first; c != last; ++c) {
+    if (*c != '\n') {
+      continue;
+    }
+    worker->Line.append(first, c);
+    first = c + 1;
+    std::string line;
+    line.swap(worker->Line);
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+
+    int id;
+    cmCTestWorker::Result result;
+    if (cmCTestWorker::ReadResult(line, id, result) &&
+        worker->Tests.count(id)) {
+      this->FinishTest(worker, id, result);
+    } else {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+                 "Invalid result from ctest worker: " << line << std::endl);
+    }
+  }
+  worker->Line.append(first, last);
+}
+
+void cmCTestWorkerPool::FinishTest(Worker* worker, int id,
+                                   cmCTestWorker::Result const& result)
+{
+  worker->Tests.erase(id);
+  if (worker->Tests.empty() && worker->Output.get() != nullptr) {
+    uv_unref(worker->Output);
+  }
+
+  auto i = this->Running.find(id);
+  if (i == this->Running.end()) {
+    return;
+  }
+  cmCTestRunTest* runner = i->second;
+  this->Running.erase(i);
+  // This may start more tests.
+  runner->FinishOnWorker(result);
+}
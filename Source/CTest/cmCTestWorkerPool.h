@@ -0,0 +1,70 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmCTestWorkerPool_h
+#define cmCTestWorkerPool_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include "cmCTestWorker.h"
+#include "cm_uv.h"
+
+#include <map>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class cmCTest;
+class cmCTestRunTest;
+
+/** \class cmCTestWorkerPool
+ * \brief Run tests in 'ctest --worker' processes
+ *
+ * The workers are started as children of this ctest process and share
+ * its event loop.  Each test is sent to the worker with the fewest tests
+ * running, so the order and the concurrency of the tests stay with the
+ * caller.
+ */
+class cmCTestWorkerPool
+{
+public:
+  explicit cmCTestWorkerPool(cmCTest* ctest);
+  ~cmCTestWorkerPool();
+
+  //! Start the given number of workers.  Returns false if none started.
+  bool Start(uv_loop_t& loop, size_t count);
+
+  /** Run a test in a worker.  Its result is passed to
+      cmCTestRunTest::FinishOnWorker.  Returns false if no worker can
+      run it.  */
+  bool Run(cmCTestRunTest* runner, cmCTestWorker::Request const& request);
+
+  //! Let the workers exit once they are idle.
+  void Stop();
+
+private:
+  struct Worker;
+  struct Write;
+
+  static void OnExitCB(uv_process_t* process, int64_t exit_status,
+                       int term_signal);
+  static void OnAllocateCB(uv_handle_t* handle, size_t suggested_size,
+                           uv_buf_t* buf);
+  static void OnReadCB(uv_stream_t* stream, ssize_t nread,
+                       const uv_buf_t* buf);
+  static void OnWriteCB(uv_write_t* req, int status);
+
+  void OnExit(Worker* worker);
+  void OnRead(Worker* worker, ssize_t nread, const uv_buf_t* buf);
+  void FinishTest(Worker* worker, int id,
+                  cmCTestWorker::Result const& result);
+
+  cmCTest* CTest;
+  std::vector<std::unique_ptr<Worker>> Workers;
+  std::vector<char> Buf;
+  // The runners of the tests sent to workers, by test index
+  std::map<int, cmCTestRunTest*> Running;
+};
+
+#endif
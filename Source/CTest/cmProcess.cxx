@@ -3,15 +3,23 @@
 #include "cmProcess.h"
 
 #include "cmCTest.h"
-#include "cmCTestRunTest.h"
+#include "cmCTestResourceMonitor.h"
 #include "cmCTestTestHandler.h"
 #include "cmsys/Process.h"
 
+#include <algorithm>
 #include <fcntl.h>
 #include <iostream>
 #include <signal.h>
 #include <string>
-#if !defined(_WIN32)
+#if defined(_WIN32)
+#  include <windows.h>
+
+#  include <psapi.h>
+#else
+#  include <set>
+#  include <sys/resource.h>
+#  include <sys/time.h>
 #  include <unistd.h>
 #endif
 #include <utility>
@@ -58,7 +66,80 @@ static int cmProcessGetPipes(int* fds)
 }
 #endif
 
-cmProcess::cmProcess(cmCTestRunTest& runner)
+// Interval in milliseconds at which the memory of a process is sampled
+#define CM_PROCESS_SAMPLE_INTERVAL 100
+
+#if defined(_WIN32)
+static uint64_t cmProcessFileTimeToMicroseconds(FILETIME const& t)
+{
+  // FILETIME counts 100 nanosecond intervals.
+  ULARGE_INTEGER i;
+  i.LowPart = t.dwLowDateTime;
+  i.HighPart = t.dwHighDateTime;
+  return i.QuadPart / 10;
+}
+
+static bool cmProcessGetUsage(int pid,
+                              cmCTestTestHandler::cmCTestResourceUsage& usage)
+{
+  // The handle libuv holds keeps the exited process around until the
+  // process handle is closed.
+  HANDLE process = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ,
+                               FALSE, static_cast<DWORD>(pid));
+  if (!process) {
+    return false;
+  }
+  FILETIME createTime;
+  FILETIME exitTime;
+  FILETIME kernelTime;
+  FILETIME userTime;
+  PROCESS_MEMORY_COUNTERS memory;
+  IO_COUNTERS io;
+  bool const ok =
+    GetProcessTimes(process, &createTime, &exitTime, &kernelTime,
+                    &userTime) &&
+    GetProcessMemoryInfo(process, &memory, sizeof(memory)) &&
+    GetProcessIoCounters(process, &io);
+  CloseHandle(process);
+  if (!ok) {
+    return false;
+  }
+  usage.UserTime =
+    static_cast<double>(cmProcessFileTimeToMicroseconds(userTime)) / 1e6;
+  usage.SystemTime =
+    static_cast<double>(cmProcessFileTimeToMicroseconds(kernelTime)) / 1e6;
+  usage.MaxResidentSetSize =
+    static_cast<uint64_t>(memory.PeakWorkingSetSize) / 1024;
+  usage.BlockInput = static_cast<uint64_t>(io.ReadOperationCount);
+  usage.BlockOutput = static_cast<uint64_t>(io.WriteOperationCount);
+  return true;
+}
+#else
+// The processes started and not yet exited, used to tell whether the
+// children reaped at once with one process included others.
+static std::set<cmProcess*> cmProcessRunning;
+// The processes reaped along with one that was reported before them.
+static std::set<cmProcess*> cmProcessReapedTogether;
+// The usage of all children reaped so far.
+static struct rusage cmProcessChildrenUsage;
+
+static double cmProcessSeconds(struct timeval const& t)
+{
+  return static_cast<double>(t.tv_sec) + static_cast<double>(t.tv_usec) / 1e6;
+}
+
+static uint64_t cmProcessMaxRSSKiB(struct rusage const& usage)
+{
+#  if defined(__APPLE__)
+  // macOS reports bytes rather than KiB.
+  return static_cast<uint64_t>(usage.ru_maxrss) / 1024;
+#  else
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#  endif
+}
+#endif
+
+cmProcess::cmProcess(Client& runner)
   : Runner(runner)
   , Conv(cmProcessOutput::UTF8, CM_PROCESS_BUF_SIZE)
 {
@@ -69,7 +150,13 @@ cmProcess::cmProcess(cmCTestRunTest& runner)
   this->StartTime = std::chrono::steady_clock::time_point();
 }
 
-cmProcess::~cmProcess() = default;
+cmProcess::~cmProcess()
+{
+#if !defined(_WIN32)
+  cmProcessRunning.erase(this);
+  cmProcessReapedTogether.erase(this);
+#endif
+}
 
 void cmProcess::SetCommand(const char* command)
 {
@@ -164,6 +251,14 @@ bool cmProcess::StartProcess(uv_loop_t& loop, std::vector<size_t>* affinity)
     return false;
   }
 
+#if !defined(_WIN32)
+  // Children reaped while no test ran, e.g. of other commands, must not
+  // count for the next test to exit.
+  if (cmProcessRunning.empty()) {
+    getrusage(RUSAGE_CHILDREN, &cmProcessChildrenUsage);
+  }
+#endif
+
   status = this->Process.spawn(loop, options, this);
   if (status != 0) {
     cmCTestLog(this->Runner.GetCTest(), ERROR_MESSAGE,
@@ -177,17 +272,29 @@ bool cmProcess::StartProcess(uv_loop_t& loop, std::vector<size_t>* affinity)
 
   this->StartTimer();
 
+  // The peak memory of the process is lost once it is reaped.
+  this->PeakResidentSetSize = 0;
+  if (cmCTestResourceMonitor::GetPeakResidentSetSize(
+        this->Process->pid, this->PeakResidentSetSize) &&
+      this->SampleTimer.init(loop, this) == 0) {
+    this->SampleTimer.start(&cmProcess::OnSampleCB,
+                            CM_PROCESS_SAMPLE_INTERVAL,
+                            CM_PROCESS_SAMPLE_INTERVAL);
+  }
+#if !defined(_WIN32)
+  cmProcessRunning.insert(this);
+#endif
+
   this->ProcessState = cmProcess::State::Executing;
   return true;
 }
 
 void cmProcess::StartTimer()
 {
-  auto properties = this->Runner.GetTestProperties();
   auto msec =
     std::chrono::duration_cast<std::chrono::milliseconds>(this->Timeout);
 
-  if (msec != std::chrono::milliseconds(0) || !properties->ExplicitTimeout) {
+  if (msec != std::chrono::milliseconds(0) || !this->ExplicitTimeout) {
     this->Timer.start(&cmProcess::OnTimeoutCB,
                       static_cast<uint64_t>(msec.count()), 0);
   }
@@ -363,6 +470,7 @@ void cmProcess::OnExit(int64_t exit_status, int term_signal)
   if (this->TotalTime <= cmDuration::zero()) {
     this->TotalTime = cmDuration::zero();
   }
+  this->ReadResourceUsage();
 
   this->ProcessHandleClosed = true;
   if (this->ReadHandleClosed) {
@@ -371,6 +479,99 @@ void cmProcess::OnExit(int64_t exit_status, int term_signal)
   }
 }
 
+void cmProcess::ReadResourceUsage()
+{
+  if (this->SampleTimer.get()) {
+    uv_timer_stop(this->SampleTimer);
+  }
+#if defined(_WIN32)
+  this->HaveResourceUsage =
+    cmProcessGetUsage(this->Process->pid, this->ResourceUsage);
+#else
+  cmProcessRunning.erase(this);
+
+  // Attribute the growth of the usage of all reaped children to this
+  // process.  libuv reaps every child that exited before it reports the
+  // first of them, though, and the usage of those cannot be told apart.
+  struct rusage const last = cmProcessChildrenUsage;
+  if (getrusage(RUSAGE_CHILDREN, &cmProcessChildrenUsage) != 0 ||
+      cmProcessReapedTogether.erase(this) > 0) {
+    return;
+  }
+  for (cmProcess* p : cmProcessRunning) {
+    if (kill(p->Process->pid, 0) != 0 && errno == ESRCH) {
+      cmProcessReapedTogether.insert(p);
+    }
+  }
+  if (!cmProcessReapedTogether.empty()) {
+    return;
+  }
+
+  struct rusage const& usage = cmProcessChildrenUsage;
+  this->HaveResourceUsage = true;
+  this->ResourceUsage.UserTime =
+    cmProcessSeconds(usage.ru_utime) - cmProcessSeconds(last.ru_utime);
+  this->ResourceUsage.SystemTime =
+    cmProcessSeconds(usage.ru_stime) - cmProcessSeconds(last.ru_stime);
+  // The children maximum tells the peak of this process only if it is a
+  // new maximum.  Otherwise rely on the samples taken while it ran.
+  uint64_t peak = this->PeakResidentSetSize;
+  if (usage.ru_maxrss > last.ru_maxrss) {
+    peak = std::max(peak, cmProcessMaxRSSKiB(usage));
+  }
+  this->ResourceUsage.MaxResidentSetSize = peak;
+  this->ResourceUsage.BlockInput =
+    static_cast<uint64_t>(usage.ru_inblock - last.ru_inblock);
+  this->ResourceUsage.BlockOutput =
+    static_cast<uint64_t>(usage.ru_oublock - last.ru_oublock);
+#endif
+}
+
+void cmProcess::OnSampleCB(uv_timer_t* timer)
+{
+  auto self = static_cast<cmProcess*>(timer->data);
+  self->OnSample();
+}
+
+void cmProcess::OnSample()
+{
+  uint64_t peak = 0;
+  if (cmCTestResourceMonitor::GetPeakResidentSetSize(this->GetPid(), peak)) {
+    this->PeakResidentSetSize = std::max(this->PeakResidentSetSize, peak);
+  }
+}
+
+bool cmProcess::GetResourceUsage(
+  cmCTestTestHandler::cmCTestResourceUsage& usage)
+{
+  if (this->HaveResourceUsage) {
+    usage = this->ResourceUsage;
+  }
+  return this->HaveResourceUsage;
+}
+
+int cmProcess::GetPid()
+{
+  if (this->Process.get() == nullptr || this->ProcessHandleClosed) {
+    return 0;
+  }
+  return this->Process->pid;
+}
+
+void cmProcess::SetResult(
+  State state, int exitValue, int signal, cmDuration totalTime,
+  cmCTestTestHandler::cmCTestResourceUsage const* usage)
+{
+  this->ProcessState = state;
+  this->ExitValue = exitValue;
+  this->Signal = signal;
+  this->TotalTime = totalTime;
+  this->HaveResourceUsage = usage != nullptr;
+  if (usage) {
+    this->ResourceUsage = *usage;
+  }
+}
+
 cmProcess::State cmProcess::GetProcessStatus()
 {
   return this->ProcessState;
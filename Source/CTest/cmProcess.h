@@ -6,6 +6,7 @@
 #include "cmConfigure.h" // IWYU pragma: keep
 #include "cmDuration.h"
 
+#include "cmCTestTestHandler.h"
 #include "cmProcessOutput.h"
 #include "cmUVHandlePtr.h"
 #include "cm_uv.h"
@@ -16,7 +17,7 @@
 #include <string>
 #include <vector>
 
-class cmCTestRunTest;
+class cmCTest;
 
 /** \class cmProcess
  * \brief run a process with c++
@@ -26,13 +27,28 @@ class cmCTestRunTest;
 class cmProcess
 {
 public:
-  explicit cmProcess(cmCTestRunTest& runner);
+  /** Receives the output of the process and learns when it is done,
+      e.g. the test the process runs.  */
+  class Client
+  {
+  public:
+    virtual ~Client() = default;
+    virtual cmCTest* GetCTest() const = 0;
+    // Called with each line of output
+    virtual void CheckOutput(std::string const& line) = 0;
+    // Called once the process exited and its output was read
+    virtual void FinalizeTest() = 0;
+  };
+
+  explicit cmProcess(Client& runner);
   ~cmProcess();
   const char* GetCommand() { return this->Command.c_str(); }
   void SetCommand(const char* command);
   void SetCommandArguments(std::vector<std::string> const& arg);
   void SetWorkingDirectory(const char* dir) { this->WorkingDirectory = dir; }
   void SetTimeout(cmDuration t) { this->Timeout = t; }
+  // A zero timeout set explicitly means no timeout.
+  void SetExplicitTimeout(bool b) { this->ExplicitTimeout = b; }
   void ChangeTimeout(cmDuration t);
   void ResetStartTime();
   // Return true if the process starts
@@ -54,7 +70,15 @@ public:
   int GetId() { return this->Id; }
   void SetId(int id) { this->Id = id; }
   int GetExitValue() { return this->ExitValue; }
+  int GetSignal() { return this->Signal; }
   cmDuration GetTotalTime() { return this->TotalTime; }
+  // Resources used by the exited process.  Returns false if unknown.
+  bool GetResourceUsage(cmCTestTestHandler::cmCTestResourceUsage& usage);
+  // System process id of the running process, or 0
+  int GetPid();
+  // Take the outcome of a process that ran elsewhere, e.g. in a worker.
+  void SetResult(State state, int exitValue, int signal, cmDuration totalTime,
+                 cmCTestTestHandler::cmCTestResourceUsage const* usage);
 
   enum class Exception
   {
@@ -71,17 +95,23 @@ public:
 
 private:
   cmDuration Timeout;
+  bool ExplicitTimeout = false;
   std::chrono::steady_clock::time_point StartTime;
   cmDuration TotalTime;
+  bool HaveResourceUsage = false;
+  cmCTestTestHandler::cmCTestResourceUsage ResourceUsage;
+  // Peak resident set size in KiB seen while the process ran
+  uint64_t PeakResidentSetSize = 0;
   bool ReadHandleClosed = false;
   bool ProcessHandleClosed = false;
 
   cm::uv_process_ptr Process;
   cm::uv_pipe_ptr PipeReader;
   cm::uv_timer_ptr Timer;
+  cm::uv_timer_ptr SampleTimer;
   std::vector<char> Buf;
 
-  cmCTestRunTest& Runner;
+  Client& Runner;
   cmProcessOutput Conv;
   int Signal = 0;
   cmProcess::State ProcessState = cmProcess::State::Starting;
@@ -89,6 +119,7 @@ private:
   static void OnExitCB(uv_process_t* process, int64_t exit_status,
                        int term_signal);
   static void OnTimeoutCB(uv_timer_t* timer);
+  static void OnSampleCB(uv_timer_t* timer);
   static void OnReadCB(uv_stream_t* stream, ssize_t nread,
                        const uv_buf_t* buf);
   static void OnAllocateCB(uv_handle_t* handle, size_t suggested_size,
@@ -96,6 +127,8 @@ private:
 
   void OnExit(int64_t exit_status, int term_signal);
   void OnTimeout();
+  void OnSample();
+  void ReadResourceUsage();
   void OnRead(ssize_t nread, const uv_buf_t* buf);
   void OnAllocate(size_t suggested_size, uv_buf_t* buf);
 
@@ -2,6 +2,7 @@
    file Copyright.txt or https://cmake.org/licensing for details.  */
 #include "cmArchiveWrite.h"
 
+#include "cmAlgorithms.h"
 #include "cmLocale.h"
 #include "cmSystemTools.h"
 #include "cm_get_date.h"
@@ -9,10 +10,17 @@
 #include "cmsys/Directory.hxx"
 #include "cmsys/Encoding.hxx"
 #include "cmsys/FStream.hxx"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string.h>
+#include <thread>
 #include <time.h>
+#include <utility>
+#include <vector>
 
 #ifndef __LA_SSIZE_T
 #  define __LA_SSIZE_T la_ssize_t
@@ -44,6 +52,10 @@ static void cm_archive_entry_copy_sourcepath(struct archive_entry* e,
 #endif
 }
 
+// The time of all entries in a reproducible archive when no other time
+// is given.  This is the earliest time that the zip format can store.
+static const time_t ReproducibleMTime = 315532800; // 1980-01-01 UTC
+
 class cmArchiveWrite::Entry
 {
   struct archive_entry* Object;
@@ -57,6 +69,243 @@ public:
   operator struct archive_entry*() { return this->Object; }
 };
 
+/** \class cmArchiveWrite::BlockCompressor
+ * \brief Compress a stream in independent blocks on several threads.
+ *
+ * Each block becomes a complete gzip member or xz stream.  Their
+ * concatenation is a valid file that gzip, xz and libarchive read as a
+ * whole.  The blocks are written in order as soon as they are done.
+ * The output depends on the block size only, not on the number of
+ * threads.
+ */
+class cmArchiveWrite::BlockCompressor
+{
+public:
+  BlockCompressor(std::ostream& os, Compress c, int level, int threads);
+  ~BlockCompressor();
+
+  bool Write(const char* data, size_t n);
+  bool Finish();
+  std::string const& GetError() const { return this->Error; }
+
+private:
+  struct Block
+  {
+    std::string Input;
+    std::string Output;
+    std::string Error;
+    bool Done = false;
+  };
+
+  void Submit();
+  bool WriteBlocks(size_t maxPending);
+  void Stop();
+  void Work();
+  void CompressBlock(Block& block) const;
+
+  std::ostream& Stream;
+  Compress Type;
+  int Level;
+  size_t BlockSize;
+  size_t MaxPending;
+  std::string Input;
+  bool Submitted = false;
+  std::string Error;
+
+  std::mutex Mutex;
+  std::condition_variable WorkReady;
+  std::condition_variable BlockDone;
+  // All blocks not written yet, in output order
+  std::deque<std::unique_ptr<Block>> Pending;
+  // Blocks waiting for a thread
+  std::deque<Block*> Queue;
+  bool Stopping = false;
+  std::vector<std::thread> Threads;
+};
+
+cmArchiveWrite::BlockCompressor::BlockCompressor(std::ostream& os,
+                                                 Compress c, int level,
+                                                 int threads)
+  : Stream(os)
+  , Type(c)
+  , Level(level)
+  // A larger block loses less compression at the block boundaries.
+  // This matches the block size of 'xz -T' for the default level.
+  , BlockSize(c == CompressXZ ? 24 << 20 : 1 << 20)
+  // Bound the memory held by blocks waiting to be written.
+  , MaxPending(2 * static_cast<size_t>(threads))
+{
+  for (int i = 0; i < threads; ++i) {
+    this->Threads.emplace_back(&BlockCompressor::Work, this);
+  }
+}
+
+cmArchiveWrite::BlockCompressor::~BlockCompressor()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Queue.clear();
+  }
+  this->Stop();
+}
+
+bool cmArchiveWrite::BlockCompressor::Write(const char* data, size_t n)
+{
+  this->Input.append(data, n);
+  if (this->Input.size() >= this->BlockSize) {
+    this->Submit();
+    return this->WriteBlocks(this->MaxPending);
+  }
+  return this->Error.empty();
+}
+
+bool cmArchiveWrite::BlockCompressor::Finish()
+{
+  // An empty archive still needs one block to be a valid file.
+  if (!this->Input.empty() || !this->Submitted) {
+    this->Submit();
+  }
+  this->WriteBlocks(0);
+  this->Stop();
+  return this->Error.empty();
+}
+
+void cmArchiveWrite::BlockCompressor::Submit()
+{
+  auto block = cm::make_unique<Block>();
+  block->Input.swap(this->Input);
+  this->Input.reserve(this->BlockSize);
+  this->Submitted = true;
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Queue.push_back(block.get());
+    this->Pending.push_back(std::move(block));
+  }
+  this->WorkReady.notify_one();
+}
+
+bool cmArchiveWrite::BlockCompressor::WriteBlocks(size_t maxPending)
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  while (!this->Pending.empty() &&
+         (this->Pending.size() > maxPending || this->Pending.front()->Done)) {
+    this->BlockDone.wait(lock, [this] { return this->Pending.front()->Done; });
+    std::unique_ptr<Block> block = std::move(this->Pending.front());
+    this->Pending.pop_front();
+    lock.unlock();
+    if (this->Error.empty()) {
+      if (!block->Error.empty()) {
+        this->Error = block->Error;
+      } else if (!this->Stream.write(
+                   block->Output.data(),
+                   static_cast<std::streamsize>(block->Output.size()))) {
+        this->Error = "Error writing compressed archive";
+      }
+    }
+    lock.lock();
+  }
+  return this->Error.empty();
+}
+
+void cmArchiveWrite::BlockCompressor::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Stopping = true;
+  }
+  this->WorkReady.notify_all();
+  for (std::thread& thread : this->Threads) {
+    thread.join();
+  }
+  this->Threads.clear();
+}
+
+void cmArchiveWrite::BlockCompressor::Work()
+{
+  for (;;) {
+    Block* block;
+    {
+      std::unique_lock<std::mutex> lock(this->Mutex);
+      this->WorkReady.wait(
+        lock, [this] { return this->Stopping || !this->Queue.empty(); });
+      if (this->Queue.empty()) {
+        return;
+      }
+      block = this->Queue.front();
+      this->Queue.pop_front();
+    }
+    this->CompressBlock(*block);
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      block->Done = true;
+    }
+    this->BlockDone.notify_all();
+  }
+}
+
+namespace {
+// archive_write_callback appending to a std::string
+__LA_SSIZE_T cm_archive_append(struct archive* /*unused*/, void* cd,
+                               const void* b, size_t n)
+{
+  static_cast<std::string*>(cd)->append(static_cast<const char*>(b), n);
+  return static_cast<__LA_SSIZE_T>(n);
+}
+}
+
+void cmArchiveWrite::BlockCompressor::CompressBlock(Block& block) const
+{
+  // Compress the block as the single entry of a raw archive.
+  struct archive* a = archive_write_new();
+  struct archive_entry* e = archive_entry_new();
+  int r = this->Type == CompressXZ ? archive_write_add_filter_xz(a)
+                                   : archive_write_add_filter_gzip(a);
+  if (r == ARCHIVE_OK && this->Type == CompressGZip) {
+    // The members are not files of their own.
+    r = archive_write_set_filter_option(a, "gzip", "timestamp", nullptr);
+  }
+  if (r == ARCHIVE_OK && this->Level > 0) {
+    r = archive_write_set_filter_option(a, nullptr, "compression-level",
+                                        std::to_string(this->Level).c_str());
+  }
+  if (r == ARCHIVE_OK) {
+    r = archive_write_set_format_raw(a);
+  }
+  if (r == ARCHIVE_OK) {
+    r = archive_write_set_bytes_in_last_block(a, 1);
+  }
+  if (r == ARCHIVE_OK) {
+    r = archive_write_open(a, &block.Output, nullptr, &cm_archive_append,
+                           nullptr);
+  }
+  if (r == ARCHIVE_OK) {
+    archive_entry_set_filetype(e, AE_IFREG);
+    r = archive_write_header(a, e);
+  }
+  char const* data = block.Input.data();
+  size_t size = block.Input.size();
+  while (r == ARCHIVE_OK && size > 0) {
+    __LA_SSIZE_T const n = archive_write_data(a, data, size);
+    if (n <= 0) {
+      r = ARCHIVE_FATAL;
+      break;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+  }
+  if (r == ARCHIVE_OK) {
+    r = archive_write_close(a);
+  }
+  if (r != ARCHIVE_OK) {
+    block.Error = "Error compressing archive block: ";
+    block.Error += cm_archive_error_string(a);
+  }
+  archive_entry_free(e);
+  archive_write_free(a);
+  // Release the memory of the input now.
+  std::string().swap(block.Input);
+}
+
 struct cmArchiveWrite::Callback
 {
   // archive_write_callback
@@ -64,22 +313,57 @@ struct cmArchiveWrite::Callback
                             const void* b, size_t n)
   {
     cmArchiveWrite* self = static_cast<cmArchiveWrite*>(cd);
+    if (self->Compressor) {
+      if (self->Compressor->Write(static_cast<const char*>(b), n)) {
+        return static_cast<__LA_SSIZE_T>(n);
+      }
+      return static_cast<__LA_SSIZE_T>(-1);
+    }
     if (self->Stream.write(static_cast<const char*>(b),
                            static_cast<std::streamsize>(n))) {
       return static_cast<__LA_SSIZE_T>(n);
     }
     return static_cast<__LA_SSIZE_T>(-1);
   }
+
+  // archive_close_callback
+  static int Close(struct archive* /*unused*/, void* cd)
+  {
+    cmArchiveWrite* self = static_cast<cmArchiveWrite*>(cd);
+    if (self->Compressor && !self->Compressor->Finish()) {
+      return ARCHIVE_FATAL;
+    }
+    return ARCHIVE_OK;
+  }
 };
 
 cmArchiveWrite::cmArchiveWrite(std::ostream& os, Compress c,
-                               std::string const& format)
+                               std::string const& format, int compressionLevel,
+                               int numThreads, bool reproducible)
   : Stream(os)
   , Archive(archive_write_new())
   , Disk(archive_read_disk_new())
   , Verbose(false)
+  , Reproducible(reproducible)
   , Format(format)
 {
+  if (compressionLevel < 0 || compressionLevel > 9) {
+    this->Error = "Invalid compression level: ";
+    this->Error += std::to_string(compressionLevel);
+    return;
+  }
+  if (numThreads < 1) {
+    numThreads =
+      std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  }
+  if (numThreads > 1 && (c == CompressGZip || c == CompressXZ)) {
+    // libarchive writes the plain archive and the blocks are compressed
+    // on their own.
+    this->Compressor =
+      cm::make_unique<BlockCompressor>(os, c, compressionLevel, numThreads);
+    c = CompressNone;
+  }
+
   switch (c) {
     case CompressNone:
       if (archive_write_add_filter_none(this->Archive) != ARCHIVE_OK) {
@@ -103,7 +387,7 @@ cmArchiveWrite::cmArchiveWrite(std::ostream& os, Compress c,
       }
       std::string source_date_epoch;
       cmSystemTools::GetEnv("SOURCE_DATE_EPOCH", source_date_epoch);
-      if (!source_date_epoch.empty()) {
+      if (!source_date_epoch.empty() || reproducible) {
         // We're not able to specify an arbitrary timestamp for gzip.
         // The next best thing is to omit the timestamp entirely.
         if (archive_write_set_filter_option(this->Archive, "gzip", "timestamp",
@@ -136,6 +420,29 @@ cmArchiveWrite::cmArchiveWrite(std::ostream& os, Compress c,
       }
       break;
   }
+  if (compressionLevel > 0 && c != CompressNone && c != CompressCompress) {
+    if (archive_write_set_filter_option(
+          this->Archive, nullptr, "compression-level",
+          std::to_string(compressionLevel).c_str()) != ARCHIVE_OK) {
+      this->Error = "archive_write_set_filter_option: ";
+      this->Error += cm_archive_error_string(this->Archive);
+      return;
+    }
+  }
+  // ACLs, extended attributes and file flags are cleared from every
+  // entry below, so do not spend system calls on reading them.  Older
+  // versions of libarchive do not know all of these flags.
+#if defined(ARCHIVE_VERSION_NUMBER) && ARCHIVE_VERSION_NUMBER >= 3003000
+  if (archive_read_disk_set_behavior(this->Disk,
+                                     ARCHIVE_READDISK_NO_ACL |
+                                       ARCHIVE_READDISK_NO_XATTR |
+                                       ARCHIVE_READDISK_NO_FFLAGS) !=
+      ARCHIVE_OK) {
+    this->Error = "archive_read_disk_set_behavior: ";
+    this->Error += cm_archive_error_string(this->Disk);
+    return;
+  }
+#endif
 #if !defined(_WIN32) || defined(__CYGWIN__)
   if (archive_read_disk_set_standard_lookup(this->Disk) != ARCHIVE_OK) {
     this->Error = "archive_read_disk_set_standard_lookup: ";
@@ -161,7 +468,8 @@ cmArchiveWrite::cmArchiveWrite(std::ostream& os, Compress c,
   if (archive_write_open(
         this->Archive, this, nullptr,
         reinterpret_cast<archive_write_callback*>(&Callback::Write),
-        nullptr) != ARCHIVE_OK) {
+        reinterpret_cast<archive_close_callback*>(&Callback::Close)) !=
+      ARCHIVE_OK) {
     this->Error = "archive_write_open: ";
     this->Error += cm_archive_error_string(this->Archive);
     return;
@@ -189,38 +497,50 @@ bool cmArchiveWrite::Add(std::string path, size_t skip, const char* prefix,
 bool cmArchiveWrite::AddPath(const char* path, size_t skip, const char* prefix,
                              bool recursive)
 {
-  if (!this->AddFile(path, skip, prefix)) {
+  bool isDirectory = false;
+  if (!this->AddFile(path, skip, prefix, isDirectory)) {
     return false;
   }
-  if ((!cmSystemTools::FileIsDirectory(path) || !recursive) ||
-      cmSystemTools::FileIsSymlink(path)) {
+  if (!isDirectory || !recursive) {
     return true;
   }
   cmsys::Directory d;
   if (d.Load(path)) {
-    std::string next = path;
-    next += "/";
-    std::string::size_type end = next.size();
+    // Add the entries in the same order whatever the file system
+    // returns.
+    std::vector<std::string> files;
     unsigned long n = d.GetNumberOfFiles();
+    files.reserve(n);
     for (unsigned long i = 0; i < n; ++i) {
       const char* file = d.GetFile(i);
       if (strcmp(file, ".") != 0 && strcmp(file, "..") != 0) {
-        next.erase(end);
-        next += file;
-        if (!this->AddPath(next.c_str(), skip, prefix)) {
-          return false;
-        }
+        files.emplace_back(file);
+      }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::string next = path;
+    next += "/";
+    std::string::size_type end = next.size();
+    for (std::string const& file : files) {
+      next.erase(end);
+      next += file;
+      if (!this->AddPath(next.c_str(), skip, prefix)) {
+        return false;
       }
     }
   }
   return true;
 }
 
-bool cmArchiveWrite::AddFile(const char* file, size_t skip, const char* prefix)
+bool cmArchiveWrite::AddFile(const char* file, size_t skip, const char* prefix,
+                             bool& isDirectory)
 {
   // Skip the file if we have no name for it.  This may happen on a
   // top-level directory, which does not need to be included anyway.
   if (skip >= strlen(file)) {
+    isDirectory = cmSystemTools::FileIsDirectory(file) &&
+      !cmSystemTools::FileIsSymlink(file);
     return true;
   }
   const char* out = file + skip;
@@ -245,6 +565,22 @@ bool cmArchiveWrite::AddFile(const char* file, size_t skip, const char* prefix)
     this->Error += cm_archive_error_string(this->Disk);
     return false;
   }
+  // The entry describes the file itself, not a symlink target.
+  isDirectory = archive_entry_filetype(e) == AE_IFDIR;
+
+  if (this->Reproducible) {
+    // Drop what differs between two copies of the same files.  The
+    // owner and time may still be set explicitly below.
+    archive_entry_unset_atime(e);
+    archive_entry_unset_ctime(e);
+    archive_entry_unset_birthtime(e);
+    archive_entry_set_mtime(e, ReproducibleMTime, 0);
+    archive_entry_set_uid(e, 0);
+    archive_entry_set_gid(e, 0);
+    archive_entry_set_uname(e, nullptr);
+    archive_entry_set_gname(e, nullptr);
+  }
+
   if (!this->MTime.empty()) {
     time_t now;
     time(&now);
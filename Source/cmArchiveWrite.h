@@ -6,6 +6,7 @@
 #include "cmConfigure.h" // IWYU pragma: keep
 
 #include <iosfwd>
+#include <memory>
 #include <stddef.h>
 #include <string>
 
@@ -52,15 +53,24 @@ public:
     CompressXZ
   };
 
-  /** Construct with output stream to which to write archive.  */
+  /**
+   * Construct with output stream to which to write archive.  A
+   * "compressionLevel" of 0 selects the default level of the compression
+   * type.  With more than one thread, or with 0 for the number of
+   * processors, gzip and xz compress the archive in independent blocks
+   * on "numThreads" threads.  A "reproducible" archive depends only on
+   * the names, content, types and permissions of the added files.
+   */
   cmArchiveWrite(std::ostream& os, Compress c = CompressNone,
-                 std::string const& format = "paxr");
+                 std::string const& format = "paxr", int compressionLevel = 0,
+                 int numThreads = 1, bool reproducible = false);
 
   ~cmArchiveWrite();
 
   /**
    * Add a path (file or directory) to the archive.  Directories are
-   * added recursively.  The "path" must be readable on disk, either
+   * added recursively, with their entries sorted by name.  The "path"
+   * must be readable on disk, either
    * full path or relative to current working directory.  The "skip"
    * value indicates how many leading bytes from the input path to
    * skip.  The remaining part of the input path is appended to the
@@ -139,18 +149,22 @@ private:
   bool Okay() const { return this->Error.empty(); }
   bool AddPath(const char* path, size_t skip, const char* prefix,
                bool recursive = true);
-  bool AddFile(const char* file, size_t skip, const char* prefix);
+  bool AddFile(const char* file, size_t skip, const char* prefix,
+               bool& isDirectory);
   bool AddData(const char* file, size_t size);
 
   struct Callback;
   friend struct Callback;
 
   class Entry;
+  class BlockCompressor;
 
   std::ostream& Stream;
+  std::unique_ptr<BlockCompressor> Compressor;
   struct archive* Archive;
   struct archive* Disk;
   bool Verbose;
+  bool Reproducible;
   std::string Format;
   std::string Error;
   std::string MTime;
@@ -1837,6 +1837,43 @@ bool cmCTest::HandleCommandLineArguments(size_t& i,
     }
   }
 
+  if (this->CheckArgument(arg, "--test-pressure") && i < args.size() - 1) {
+    i++;
+    this->GetHandler("test")->SetPersistentOption("TestPressure",
+                                                  args[i].c_str());
+    this->GetHandler("memcheck")
+      ->SetPersistentOption("TestPressure", args[i].c_str());
+  }
+
+  if (this->CheckArgument(arg, "--workers") && i < args.size() - 1) {
+    i++;
+    this->GetHandler("test")->SetPersistentOption("Workers", args[i].c_str());
+  }
+
+  if (this->CheckArgument(arg, "--shard-index") && i < args.size() - 1) {
+    i++;
+    this->GetHandler("test")->SetPersistentOption("ShardIndex",
+                                                  args[i].c_str());
+    this->GetHandler("memcheck")
+      ->SetPersistentOption("ShardIndex", args[i].c_str());
+  }
+
+  if (this->CheckArgument(arg, "--shard-count") && i < args.size() - 1) {
+    i++;
+    this->GetHandler("test")->SetPersistentOption("ShardCount",
+                                                  args[i].c_str());
+    this->GetHandler("memcheck")
+      ->SetPersistentOption("ShardCount", args[i].c_str());
+  }
+
+  if (this->CheckArgument(arg, "--shard-cost-file") && i < args.size() - 1) {
+    i++;
+    this->GetHandler("test")->SetPersistentOption("ShardCostFile",
+                                                  args[i].c_str());
+    this->GetHandler("memcheck")
+      ->SetPersistentOption("ShardCostFile", args[i].c_str());
+  }
+
   if (this->CheckArgument(arg, "--no-compress-output")) {
     this->CompressTestOutput = false;
   }
@@ -2066,6 +2103,9 @@ bool cmCTest::HandleCommandLineArguments(size_t& i,
     this->GetHandler("test")->SetPersistentOption("RerunFailed", "true");
     this->GetHandler("memcheck")->SetPersistentOption("RerunFailed", "true");
   }
+  if (this->CheckArgument(arg, "--cache-results")) {
+    this->GetHandler("test")->SetPersistentOption("CacheResults", "true");
+  }
   return true;
 }
 
@@ -2237,6 +2277,11 @@ int cmCTest::Run(std::vector<std::string>& args, std::string* output)
       this->ScheduleType = "Random";
     }
 
+    // --schedule-critical-path
+    if (this->CheckArgument(arg, "--schedule-critical-path")) {
+      this->ScheduleType = "CriticalPath";
+    }
+
     // pass the argument to all the handlers as well, but i may no longer be
     // set to what it was originally so I'm not sure this is working as
     // intended
@@ -3,12 +3,34 @@
 #include "cmCryptoHash.h"
 
 #include "cmAlgorithms.h"
+#include "cmCryptoHashAccel.h"
 #include "cm_kwiml.h"
 #include "cm_rhash.h"
 #include "cmsys/FStream.hxx"
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory> // IWYU pragma: keep
+#include <thread>
+
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#  define CM_CRYPTO_HASH_MMAP
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+
+// Files of at least this size are mapped into memory.  Smaller files
+// are cheaper to read than to map.
+static off_t const cmCryptoHashMapThreshold = 256 * 1024;
+
+// Large files are mapped in windows of this size.
+static size_t const cmCryptoHashMapWindow = 64 * 1024 * 1024;
+#endif
+
+// Buffer size for reading files that are not mapped.
+static size_t const cmCryptoHashReadSize = 64 * 1024;
 
 static unsigned int const cmCryptoHashAlgoToId[] = {
   /* clang-format needs this comment to break after the opening brace */
@@ -35,10 +57,22 @@ static rhash cmCryptoHash_rhash_init(unsigned int id)
   return rhash_init(id);
 }
 
-cmCryptoHash::cmCryptoHash(Algo algo)
-  : Id(cmCryptoHashAlgoToId[algo])
-  , CTX(cmCryptoHash_rhash_init(Id))
+cmCryptoHash::cmCryptoHash(Algo algo, Backend backend)
+  : Algorithm(algo)
+  , Implementation(backend)
+  , Id(cmCryptoHashAlgoToId[algo])
+  , CTX(nullptr)
 {
+  if (backend == BackendDefault) {
+    if (algo == AlgoSHA1) {
+      this->Accel = cmCryptoHashAccel::New(cmCryptoHashAccel::SHA1);
+    } else if (algo == AlgoSHA256) {
+      this->Accel = cmCryptoHashAccel::New(cmCryptoHashAccel::SHA256);
+    }
+  }
+  if (!this->Accel) {
+    this->CTX = cmCryptoHash_rhash_init(this->Id);
+  }
 }
 
 cmCryptoHash::~cmCryptoHash()
@@ -124,24 +158,25 @@ std::vector<unsigned char> cmCryptoHash::ByteHashString(
 
 std::vector<unsigned char> cmCryptoHash::ByteHashFile(const std::string& file)
 {
+  std::vector<unsigned char> hash;
+  if (this->MapFiles && this->ByteHashMappedFile(file, hash)) {
+    return hash;
+  }
+
   cmsys::ifstream fin(file.c_str(), std::ios::in | std::ios::binary);
   if (fin) {
     this->Initialize();
     {
-      // Should be efficient enough on most system:
-      KWIML_INT_uint64_t buffer[512];
-      char* buffer_c = reinterpret_cast<char*>(buffer);
-      unsigned char const* buffer_uc =
-        reinterpret_cast<unsigned char const*>(buffer);
+      std::vector<char> buffer(cmCryptoHashReadSize);
       // This copy loop is very sensitive on certain platforms with
       // slightly broken stream libraries (like HPUX).  Normally, it is
       // incorrect to not check the error condition on the fin.read()
       // before using the data, but the fin.gcount() will be zero if an
       // error occurred.  Therefore, the loop should be safe everywhere.
       while (fin) {
-        fin.read(buffer_c, sizeof(buffer));
-        if (int gcount = static_cast<int>(fin.gcount())) {
-          this->Append(buffer_uc, gcount);
+        fin.read(buffer.data(), buffer.size());
+        if (size_t gcount = static_cast<size_t>(fin.gcount())) {
+          this->Append(buffer.data(), gcount);
         }
       }
     }
@@ -156,6 +191,69 @@ std::vector<unsigned char> cmCryptoHash::ByteHashFile(const std::string& file)
   return std::vector<unsigned char>();
 }
 
+bool cmCryptoHash::ByteHashMappedFile(const std::string& file,
+                                      std::vector<unsigned char>& hash)
+{
+#ifdef CM_CRYPTO_HASH_MMAP
+  int flags = O_RDONLY;
+#  ifdef O_CLOEXEC
+  flags |= O_CLOEXEC;
+#  endif
+  int fd = open(file.c_str(), flags);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_size < cmCryptoHashMapThreshold) {
+    close(fd);
+    return false;
+  }
+
+  // The pages are hashed in place instead of being copied into a
+  // buffer first.
+  bool mapped = true;
+  this->Initialize();
+  for (off_t offset = 0; offset < st.st_size;) {
+    // Read the file instead if it changed size since the last window.
+    // This does not protect against a truncation while a window is
+    // hashed, which is why mapping is used only for files the caller
+    // wrote itself, see SetMapFiles().
+    struct stat now;
+    if (fstat(fd, &now) != 0 || now.st_size != st.st_size) {
+      mapped = false;
+      break;
+    }
+    size_t const length = static_cast<size_t>(std::min<KWIML_INT_uint64_t>(
+      static_cast<KWIML_INT_uint64_t>(st.st_size - offset),
+      cmCryptoHashMapWindow));
+    void* data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, offset);
+    if (data == MAP_FAILED) {
+      mapped = false;
+      break;
+    }
+#  ifdef POSIX_MADV_SEQUENTIAL
+    posix_madvise(data, length, POSIX_MADV_SEQUENTIAL);
+#  endif
+    this->Append(data, length);
+    munmap(data, length);
+    offset += static_cast<off_t>(length);
+  }
+  close(fd);
+
+  // Read the file if it could not be mapped.
+  std::vector<unsigned char> result = this->Finalize();
+  if (mapped) {
+    hash.swap(result);
+  }
+  return mapped;
+#else
+  static_cast<void>(file);
+  static_cast<void>(hash);
+  return false;
+#endif
+}
+
 std::string cmCryptoHash::HashString(const std::string& input)
 {
   return ByteHashToString(this->ByteHashString(input));
@@ -166,13 +264,57 @@ std::string cmCryptoHash::HashFile(const std::string& file)
   return ByteHashToString(this->ByteHashFile(file));
 }
 
+std::vector<std::string> cmCryptoHash::HashFiles(
+  std::vector<std::string> const& files)
+{
+  // The files are independent, so a batch of them is spread over a few
+  // threads, each with its own context.  Each thread waits for its own
+  // reads, which helps most when there are many small files.  The other
+  // contexts are created here because the hash library is initialized
+  // on first use.
+  size_t const threadCount = std::min<size_t>(
+    std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), 8),
+    files.size());
+  std::vector<std::unique_ptr<cmCryptoHash>> hashes;
+  for (size_t t = 1; t < threadCount; ++t) {
+    hashes.push_back(
+      cm::make_unique<cmCryptoHash>(this->Algorithm, this->Implementation));
+    hashes.back()->SetMapFiles(this->MapFiles);
+  }
+
+  std::vector<std::string> results(files.size());
+  std::atomic<size_t> next(0);
+  auto worker = [&files, &results, &next](cmCryptoHash* hash) {
+    for (size_t i = next++; i < files.size(); i = next++) {
+      results[i] = hash->HashFile(files[i]);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (auto const& hash : hashes) {
+    threads.emplace_back(worker, hash.get());
+  }
+  worker(this);
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  return results;
+}
+
 void cmCryptoHash::Initialize()
 {
+  if (this->Accel) {
+    this->Accel->Initialize();
+    return;
+  }
   rhash_reset(this->CTX);
 }
 
 void cmCryptoHash::Append(void const* buf, size_t sz)
 {
+  if (this->Accel) {
+    this->Accel->Append(static_cast<unsigned char const*>(buf), sz);
+    return;
+  }
   rhash_update(this->CTX, buf, sz);
 }
 
@@ -183,6 +325,9 @@ void cmCryptoHash::Append(std::string const& str)
 
 std::vector<unsigned char> cmCryptoHash::Finalize()
 {
+  if (this->Accel) {
+    return this->Accel->Finalize();
+  }
   std::vector<unsigned char> hash(rhash_get_digest_size(this->Id), 0);
   rhash_final(this->CTX, &hash[0]);
   return hash;
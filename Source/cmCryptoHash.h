@@ -10,6 +10,8 @@
 #include <string>
 #include <vector>
 
+class cmCryptoHashAccel;
+
 /**
  * @brief Abstract base class for cryptographic hash generators
  */
@@ -30,7 +32,15 @@ public:
     AlgoSHA3_512
   };
 
-  cmCryptoHash(Algo algo);
+  enum Backend
+  {
+    /// Use the extensions of the processor if it has them
+    BackendDefault,
+    /// Always use the portable implementation
+    BackendPortable
+  };
+
+  cmCryptoHash(Algo algo, Backend backend = BackendDefault);
   ~cmCryptoHash();
 
   cmCryptoHash(cmCryptoHash const&) = delete;
@@ -59,6 +69,7 @@ public:
 
   /// @brief Calculates a binary hash from file content
   /// @see ByteHashString()
+  /// Large files are mapped into memory where the platform supports it.
   /// @return Non empty binary hash vector if the file was read successfully.
   ///         An empty vector otherwise.
   std::vector<unsigned char> ByteHashFile(const std::string& file);
@@ -73,6 +84,21 @@ public:
   ///         An empty string otherwise.
   std::string HashFile(const std::string& file);
 
+  /// @brief Calculates the hash strings of several files at once
+  /// @see HashFile()
+  /// @return The hash strings in the order of the files.  The string of
+  ///         a file that could not be read is empty.
+  std::vector<std::string> HashFiles(std::vector<std::string> const& files);
+
+  /// @brief Map large files into memory instead of reading them
+  /// @details Reading a mapped page of a file that another process
+  ///          truncated raises SIGBUS.  A file that changed size is
+  ///          read instead only if that happens between two mapped
+  ///          windows, so this is only for files that nothing changes
+  ///          while they are hashed, such as files the caller just
+  ///          wrote.  Off by default.
+  void SetMapFiles(bool map) { this->MapFiles = map; }
+
   void Initialize();
   void Append(void const*, size_t);
   void Append(std::string const& str);
@@ -80,8 +106,17 @@ public:
   std::string FinalizeHex();
 
 private:
+  /// Hashes a large file through a memory mapping.  Returns false if
+  /// the file was not mapped, so that the caller reads it instead.
+  bool ByteHashMappedFile(const std::string& file,
+                          std::vector<unsigned char>& hash);
+
+  Algo Algorithm;
+  Backend Implementation;
   unsigned int Id;
   struct rhash_context* CTX;
+  std::unique_ptr<cmCryptoHashAccel> Accel;
+  bool MapFiles = false;
 };
 
 #endif
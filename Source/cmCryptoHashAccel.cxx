@@ -0,0 +1,305 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCryptoHashAccel.h"
+
+#include <algorithm>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                             \
+  ((defined(__clang__) && __clang_major__ >= 4) ||                            \
+   (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 5))
+#  define CM_CRYPTO_HASH_ACCEL
+#  define CM_CRYPTO_HASH_ACCEL_TARGET                                         \
+    __attribute__((target("sha,sse4.1,ssse3")))
+#  include <cpuid.h>
+#  include <immintrin.h>
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER) &&           \
+  _MSC_VER >= 1920 && !defined(__clang__)
+#  define CM_CRYPTO_HASH_ACCEL
+#  define CM_CRYPTO_HASH_ACCEL_TARGET
+#  include <immintrin.h>
+#  include <intrin.h>
+#endif
+
+static uint32_t const cmCryptoHashSHA1Initial[5] = {
+  0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+static uint32_t const cmCryptoHashSHA256Initial[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#ifdef CM_CRYPTO_HASH_ACCEL
+static uint32_t const cmCryptoHashSHA256K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static bool cmCryptoHashAccelDetect()
+{
+  // SSSE3 and SSE4.1 are in leaf 1, the SHA extensions in leaf 7.
+  unsigned int leaf1[4] = { 0, 0, 0, 0 };
+  unsigned int leaf7[4] = { 0, 0, 0, 0 };
+#  if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  memcpy(leaf1, info, sizeof(leaf1));
+  __cpuidex(info, 7, 0);
+  memcpy(leaf7, info, sizeof(leaf7));
+#  else
+  if (__get_cpuid_max(0, nullptr) < 7) {
+    return false;
+  }
+  __cpuid(1, leaf1[0], leaf1[1], leaf1[2], leaf1[3]);
+  __cpuid_count(7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+#  endif
+  bool const ssse3 = (leaf1[2] & (1u << 9)) != 0;
+  bool const sse41 = (leaf1[2] & (1u << 19)) != 0;
+  bool const sha = (leaf7[1] & (1u << 29)) != 0;
+  return ssse3 && sse41 && sha;
+}
+
+CM_CRYPTO_HASH_ACCEL_TARGET
+static void cmCryptoHashSHA256Blocks(uint32_t state[8],
+                                     unsigned char const* data, size_t blocks)
+{
+  __m128i const mask =
+    _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+  // The instructions keep the state as ABEF and CDGH.
+  __m128i tmp = _mm_loadu_si128(reinterpret_cast<__m128i const*>(state));
+  __m128i state1 =
+    _mm_loadu_si128(reinterpret_cast<__m128i const*>(state + 4));
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);
+  state1 = _mm_shuffle_epi32(state1, 0x1B);
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+  for (; blocks > 0; --blocks, data += 64) {
+    __m128i const abefSave = state0;
+    __m128i const cdghSave = state1;
+    __m128i msgs[4];
+
+    // Each step does four rounds and extends the message schedule.
+    for (int i = 0; i < 16; ++i) {
+      __m128i& cur = msgs[i % 4];
+      if (i < 4) {
+        cur = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 16 * i)),
+          mask);
+      }
+      __m128i msg = _mm_add_epi32(
+        cur,
+        _mm_loadu_si128(
+          reinterpret_cast<__m128i const*>(cmCryptoHashSHA256K + 4 * i)));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      if (i >= 3 && i <= 14) {
+        __m128i& next = msgs[(i + 1) % 4];
+        __m128i const prev = msgs[(i + 3) % 4];
+        next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4));
+        next = _mm_sha256msg2_epu32(next, cur);
+      }
+      msg = _mm_shuffle_epi32(msg, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+      if (i >= 1 && i <= 12) {
+        __m128i& prev = msgs[(i + 3) % 4];
+        prev = _mm_sha256msg1_epu32(prev, cur);
+      }
+    }
+
+    state0 = _mm_add_epi32(state0, abefSave);
+    state1 = _mm_add_epi32(state1, cdghSave);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);
+  state1 = _mm_shuffle_epi32(state1, 0xB1);
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+  state1 = _mm_alignr_epi8(state1, tmp, 8);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+// The round function is an immediate operand of the instruction.
+#  define CM_SHA1_RNDS4(abcd, e, i)                                           \
+    ((i) < 20 ? _mm_sha1rnds4_epu32(abcd, e, 0)                               \
+              : (i) < 40 ? _mm_sha1rnds4_epu32(abcd, e, 1)                    \
+                         : (i) < 60 ? _mm_sha1rnds4_epu32(abcd, e, 2)         \
+                                    : _mm_sha1rnds4_epu32(abcd, e, 3))
+
+CM_CRYPTO_HASH_ACCEL_TARGET
+static void cmCryptoHashSHA1Blocks(uint32_t state[5],
+                                   unsigned char const* data, size_t blocks)
+{
+  __m128i const mask =
+    _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+  __m128i abcd = _mm_loadu_si128(reinterpret_cast<__m128i const*>(state));
+  abcd = _mm_shuffle_epi32(abcd, 0x1B);
+  __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+  for (; blocks > 0; --blocks, data += 64) {
+    __m128i const abcdSave = abcd;
+    __m128i const eSave = e0;
+    __m128i e1 = _mm_setzero_si128();
+    __m128i msgs[4];
+
+    // Each step does four rounds and extends the message schedule.  The
+    // value of E alternates between two registers.
+    for (int i = 0; i < 20; ++i) {
+      __m128i& cur = msgs[i % 4];
+      if (i < 4) {
+        cur = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 16 * i)),
+          mask);
+      }
+      __m128i& e = (i % 2 == 0) ? e0 : e1;
+      __m128i& eNext = (i % 2 == 0) ? e1 : e0;
+      if (i == 0) {
+        e = _mm_add_epi32(e, cur);
+      } else {
+        e = _mm_sha1nexte_epu32(e, cur);
+      }
+      eNext = abcd;
+      if (i >= 3 && i <= 18) {
+        __m128i& next = msgs[(i + 1) % 4];
+        next = _mm_sha1msg2_epu32(next, cur);
+      }
+      abcd = CM_SHA1_RNDS4(abcd, e, i * 4);
+      if (i >= 1 && i <= 16) {
+        __m128i& prev = msgs[(i + 3) % 4];
+        prev = _mm_sha1msg1_epu32(prev, cur);
+      }
+      if (i >= 2 && i <= 17) {
+        __m128i& prev2 = msgs[(i + 2) % 4];
+        prev2 = _mm_xor_si128(prev2, cur);
+      }
+    }
+
+    e0 = _mm_sha1nexte_epu32(e0, eSave);
+    abcd = _mm_add_epi32(abcd, abcdSave);
+  }
+
+  abcd = _mm_shuffle_epi32(abcd, 0x1B);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), abcd);
+  state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+#  undef CM_SHA1_RNDS4
+#endif
+
+bool cmCryptoHashAccel::IsSupported()
+{
+#ifdef CM_CRYPTO_HASH_ACCEL
+  static bool const supported = cmCryptoHashAccelDetect();
+  return supported;
+#else
+  return false;
+#endif
+}
+
+std::unique_ptr<cmCryptoHashAccel> cmCryptoHashAccel::New(Kind kind)
+{
+  if (!cmCryptoHashAccel::IsSupported()) {
+    return std::unique_ptr<cmCryptoHashAccel>();
+  }
+  return std::unique_ptr<cmCryptoHashAccel>(new cmCryptoHashAccel(kind));
+}
+
+cmCryptoHashAccel::cmCryptoHashAccel(Kind kind)
+  : Algorithm(kind)
+{
+  this->Initialize();
+}
+
+void cmCryptoHashAccel::Initialize()
+{
+  if (this->Algorithm == SHA1) {
+    memcpy(this->State, cmCryptoHashSHA1Initial,
+           sizeof(cmCryptoHashSHA1Initial));
+  } else {
+    memcpy(this->State, cmCryptoHashSHA256Initial,
+           sizeof(cmCryptoHashSHA256Initial));
+  }
+  this->Length = 0;
+}
+
+void cmCryptoHashAccel::Append(unsigned char const* data, size_t size)
+{
+  size_t buffered = static_cast<size_t>(this->Length % 64);
+  this->Length += size;
+
+  // Complete a partial block first.
+  if (buffered != 0) {
+    size_t const n = std::min<size_t>(64 - buffered, size);
+    memcpy(this->Buffer + buffered, data, n);
+    data += n;
+    size -= n;
+    buffered += n;
+    if (buffered < 64) {
+      return;
+    }
+    this->ProcessBlocks(this->Buffer, 1);
+  }
+
+  // Hash whole blocks in place and keep the rest for later.
+  size_t const blocks = size / 64;
+  if (blocks > 0) {
+    this->ProcessBlocks(data, blocks);
+  }
+  memcpy(this->Buffer, data + blocks * 64, size % 64);
+}
+
+std::vector<unsigned char> cmCryptoHashAccel::Finalize()
+{
+  // Pad with a one bit, zeros, and the message length in bits.
+  uint64_t const bits = this->Length * 8;
+  size_t const buffered = static_cast<size_t>(this->Length % 64);
+  unsigned char padding[128];
+  size_t const padSize = (buffered < 56 ? 64 : 128) - buffered;
+  memset(padding, 0, padSize);
+  padding[0] = 0x80;
+  for (int i = 0; i < 8; ++i) {
+    padding[padSize - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+  }
+  this->Append(padding, padSize);
+
+  size_t const words = this->Algorithm == SHA1 ? 5 : 8;
+  std::vector<unsigned char> hash(words * 4);
+  for (size_t i = 0; i < words; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      hash[i * 4 + j] =
+        static_cast<unsigned char>(this->State[i] >> (24 - 8 * j));
+    }
+  }
+  this->Initialize();
+  return hash;
+}
+
+void cmCryptoHashAccel::ProcessBlocks(unsigned char const* data,
+                                      size_t blocks)
+{
+#ifdef CM_CRYPTO_HASH_ACCEL
+  if (this->Algorithm == SHA1) {
+    cmCryptoHashSHA1Blocks(this->State, data, blocks);
+  } else {
+    cmCryptoHashSHA256Blocks(this->State, data, blocks);
+  }
+#else
+  static_cast<void>(data);
+  static_cast<void>(blocks);
+#endif
+}
@@ -0,0 +1,50 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmCryptoHashAccel_h
+#define cmCryptoHashAccel_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/** \class cmCryptoHashAccel
+ * \brief SHA-1 and SHA-256 using the SHA extensions of x86 processors
+ *
+ * cmCryptoHash uses this instead of the hash library when the processor
+ * it runs on supports the extensions.  The support is checked at run
+ * time, so the same binary works on older processors.
+ */
+class cmCryptoHashAccel
+{
+public:
+  enum Kind
+  {
+    SHA1,
+    SHA256
+  };
+
+  //! Returns null if the processor cannot compute the hash.
+  static std::unique_ptr<cmCryptoHashAccel> New(Kind kind);
+
+  //! Returns true if this build and processor support the extensions.
+  static bool IsSupported();
+
+  void Initialize();
+  void Append(unsigned char const* data, size_t size);
+  std::vector<unsigned char> Finalize();
+
+private:
+  cmCryptoHashAccel(Kind kind);
+
+  void ProcessBlocks(unsigned char const* data, size_t blocks);
+
+  Kind Algorithm;
+  uint32_t State[8];
+  uint64_t Length = 0;
+  unsigned char Buffer[64];
+};
+
+#endif
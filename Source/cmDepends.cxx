@@ -72,6 +72,11 @@ bool cmDepends::Check(const std::string& makeFile,
   // Check whether dependencies must be regenerated.
   bool okay = true;
   cmsys::ifstream fin(internalFile.c_str());
+  if (fin && this->FileComparison) {
+    this->PrefetchFileTimes(fin);
+    fin.clear();
+    fin.seekg(0);
+  }
   if (!(fin && this->CheckDependencies(fin, internalFile, validDeps))) {
     // Clear all dependencies so they will be regenerated.
     this->Clear(makeFile);
@@ -82,6 +87,27 @@ bool cmDepends::Check(const std::string& makeFile,
   return okay;
 }
 
+void cmDepends::PrefetchFileTimes(std::istream& internalDepends)
+{
+  // Lookup the times of all files named in the dependency information
+  // at once instead of one by one while checking them.
+  std::vector<std::string> files;
+  std::set<std::string> seen;
+  std::string line;
+  while (cmSystemTools::GetLineFromStream(internalDepends, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    if (line[0] == ' ') {
+      line.erase(0, 1);
+    }
+    if (seen.insert(line).second) {
+      files.push_back(line);
+    }
+  }
+  this->FileComparison->Prefetch(files);
+}
+
 void cmDepends::Clear(const std::string& file)
 {
   // Print verbose output.
@@ -162,7 +188,8 @@ bool cmDepends::CheckDependencies(
       currentDependencies->push_back(dependee);
     }
 
-    if (!cmSystemTools::FileExists(dependee)) {
+    if (!(this->FileComparison ? this->FileComparison->FileExists(dependee)
+                               : cmSystemTools::FileExists(dependee))) {
       // The dependee does not exist.
       regenerate = true;
 
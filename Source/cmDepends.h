@@ -116,6 +116,9 @@ protected:
   std::vector<std::string> IncludePath;
 
   void SetIncludePathFromLanguage(const std::string& lang);
+
+  // Lookup the times of all files listed in an internal depends stream.
+  void PrefetchFileTimes(std::istream& internalDepends);
 };
 
 #endif
@@ -6,10 +6,13 @@
 #include <utility>
 
 #include "cmAlgorithms.h"
+#include "cmDependsCSharedCache.h"
 #include "cmFileTimeComparison.h"
+#include "cmGlobalGenerator.h"
 #include "cmLocalGenerator.h"
 #include "cmMakefile.h"
 #include "cmSystemTools.h"
+#include "cmake.h"
 
 #define INCLUDE_REGEX_LINE                                                    \
   "^[ \t]*[#%][ \t]*(include|import)[ \t]*[<\"]([^\">]+)([\">])"
@@ -61,11 +64,21 @@ cmDependsC::cmDependsC(
 
   this->SetupTransforms();
 
+  this->SharedCacheSettings = this->IncludeRegexLineString;
+  this->SharedCacheSettings += "\n";
+  this->SharedCacheSettings += this->IncludeRegexScanString;
+  this->SharedCacheSettings += "\n";
+  this->SharedCacheSettings += this->IncludeRegexTransformString;
+
   this->CacheFileName = this->TargetDirectory;
   this->CacheFileName += "/";
   this->CacheFileName += lang;
   this->CacheFileName += ".includecache";
 
+  // Share the file times already looked up by this process.
+  this->FileComparison =
+    lg->GetGlobalGenerator()->GetCMakeInstance()->GetFileComparison();
+
   this->ReadCacheFile();
 }
 
@@ -197,23 +210,63 @@ bool cmDependsC::WriteDependencies(const std::set<std::string>& sources,
             }
           }
         } else {
-
-          // Try to scan the file.  Just leave it out if we cannot find
-          // it.
-          cmsys::ifstream fin(fullName.c_str());
-          if (fin) {
-            cmsys::FStream::BOM bom = cmsys::FStream::ReadBOM(fin);
-            if (bom == cmsys::FStream::BOM_None ||
-                bom == cmsys::FStream::BOM_UTF8) {
-              // Add this file as a dependency.
-              dependencies.insert(fullName);
-
-              // Scan this file for new dependencies.  Pass the directory
-              // containing the file to handle double-quote includes.
-              std::string dir = cmSystemTools::GetFilenamePath(fullName);
-              this->Scan(fin, dir, fullName);
-            } else {
-              // Skip file with encoding we do not implement.
+          // Check whether another target has already scanned this
+          // version of the file.
+          cmDependsCSharedCache::FileStamp stamp;
+          bool haveStamp = this->SharedCache &&
+            cmDependsCSharedCache::GetFileStamp(fullName, stamp);
+          cmDependsCSharedCache::IncludeEntries const* shared = haveStamp
+            ? this->SharedCache->Find(this->SharedCacheSettings, fullName,
+                                      stamp)
+            : nullptr;
+          if (shared) {
+            cmIncludeLines* cacheEntry = new cmIncludeLines;
+            cacheEntry->Used = true;
+            this->FileCache[fullName] = cacheEntry;
+            dependencies.insert(fullName);
+            for (cmDependsCSharedCache::IncludeEntry const& inc : *shared) {
+              UnscannedEntry entry;
+              entry.FileName = inc.FileName;
+              entry.QuotedLocation = inc.QuotedLocation;
+              cacheEntry->UnscannedEntries.push_back(entry);
+              if (this->Encountered.find(entry.FileName) ==
+                  this->Encountered.end()) {
+                this->Encountered.insert(entry.FileName);
+                this->Unscanned.push(entry);
+              }
+            }
+          } else {
+            // Try to scan the file.  Just leave it out if we cannot find
+            // it.
+            cmsys::ifstream fin(fullName.c_str());
+            if (fin) {
+              cmsys::FStream::BOM bom = cmsys::FStream::ReadBOM(fin);
+              if (bom == cmsys::FStream::BOM_None ||
+                  bom == cmsys::FStream::BOM_UTF8) {
+                // Add this file as a dependency.
+                dependencies.insert(fullName);
+
+                // Scan this file for new dependencies.  Pass the directory
+                // containing the file to handle double-quote includes.
+                std::string dir = cmSystemTools::GetFilenamePath(fullName);
+                this->Scan(fin, dir, fullName);
+
+                // Share the result with other targets.
+                if (haveStamp) {
+                  cmDependsCSharedCache::IncludeEntries includes;
+                  for (UnscannedEntry const& inc :
+                       this->FileCache[fullName]->UnscannedEntries) {
+                    cmDependsCSharedCache::IncludeEntry entry;
+                    entry.FileName = inc.FileName;
+                    entry.QuotedLocation = inc.QuotedLocation;
+                    includes.push_back(std::move(entry));
+                  }
+                  this->SharedCache->Store(this->SharedCacheSettings, fullName,
+                                           stamp, std::move(includes));
+                }
+              } else {
+                // Skip file with encoding we do not implement.
+              }
             }
           }
         }
@@ -267,8 +320,8 @@ void cmDependsC::ReadCacheFile()
     if (!haveFileName) {
       haveFileName = true;
       int newer = 0;
-      cmFileTimeComparison comp;
-      bool res = comp.FileTimeCompare(this->CacheFileName, line, &newer);
+      bool res = this->FileComparison->FileTimeCompare(this->CacheFileName,
+                                                       line, &newer);
 
       if (res && newer == 1) // cache is newer than the parsed file
       {
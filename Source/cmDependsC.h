@@ -15,6 +15,7 @@
 #include <string>
 #include <vector>
 
+class cmDependsCSharedCache;
 class cmLocalGenerator;
 
 /** \class cmDependsC
@@ -36,6 +37,13 @@ public:
   cmDependsC(cmDependsC const&) = delete;
   cmDependsC& operator=(cmDependsC const&) = delete;
 
+  /** Set the build-tree-wide cache of scanned include lines consulted
+      before scanning a file not found in the per-target cache.  */
+  void SetSharedCache(cmDependsCSharedCache* cache)
+  {
+    this->SharedCache = cache;
+  }
+
 protected:
   // Implement writing/checking methods required by superclass.
   bool WriteDependencies(const std::set<std::string>& sources,
@@ -90,6 +98,10 @@ protected:
 
   std::string CacheFileName;
 
+  cmDependsCSharedCache* SharedCache = nullptr;
+  // Scanner settings affecting the include lines found in a file.
+  std::string SharedCacheSettings;
+
   void WriteCacheFile() const;
   void ReadCacheFile();
 };
@@ -0,0 +1,302 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmDependsCSharedCache.h"
+
+#include "cmSystemTools.h"
+
+#include "cmsys/FStream.hxx"
+#include <iterator>
+#include <sstream>
+#include <utility>
+
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#  include "cm_sys_stat.h"
+#else
+#  include "cmsys/Encoding.hxx"
+#  include <windows.h>
+#endif
+
+// The file starts with a magic string that encodes the format version.
+// Bump the version whenever the layout below changes.
+//
+//   magic
+//   u32 group count
+//   group:  str settings, u32 entry count, entry...
+//   entry:  str path, i64 mtime, u64 size, u32 include count, include...
+//   include: str file name, str quoted location
+//
+// Integers are stored little-endian and strings as a u32 length
+// followed by the bytes.
+#define CM_DEPENDS_C_SHARED_CACHE_MAGIC "CMakeIncludeScanCache1\n"
+
+namespace {
+
+class BinaryWriter
+{
+public:
+  std::string Data;
+
+  void U32(unsigned int v)
+  {
+    for (int i = 0; i < 4; ++i) {
+      this->Data += static_cast<char>((v >> (8 * i)) & 0xff);
+    }
+  }
+  void U64(unsigned long long v)
+  {
+    for (int i = 0; i < 8; ++i) {
+      this->Data += static_cast<char>((v >> (8 * i)) & 0xff);
+    }
+  }
+  void Str(std::string const& s)
+  {
+    this->U32(static_cast<unsigned int>(s.size()));
+    this->Data += s;
+  }
+};
+
+class BinaryReader
+{
+public:
+  BinaryReader(std::string const& data)
+    : Data(data)
+  {
+  }
+
+  bool U32(unsigned int& v)
+  {
+    if (this->Data.size() - this->Pos < 4) {
+      return false;
+    }
+    v = 0;
+    for (int i = 0; i < 4; ++i) {
+      v |= static_cast<unsigned int>(
+             static_cast<unsigned char>(this->Data[this->Pos++]))
+        << (8 * i);
+    }
+    return true;
+  }
+  bool U64(unsigned long long& v)
+  {
+    if (this->Data.size() - this->Pos < 8) {
+      return false;
+    }
+    v = 0;
+    for (int i = 0; i < 8; ++i) {
+      v |= static_cast<unsigned long long>(
+             static_cast<unsigned char>(this->Data[this->Pos++]))
+        << (8 * i);
+    }
+    return true;
+  }
+  bool Str(std::string& s)
+  {
+    unsigned int len;
+    if (!this->U32(len) || this->Data.size() - this->Pos < len) {
+      return false;
+    }
+    s.assign(this->Data, this->Pos, len);
+    this->Pos += len;
+    return true;
+  }
+  bool Skip(std::string const& prefix)
+  {
+    if (this->Data.compare(this->Pos, prefix.size(), prefix) != 0) {
+      return false;
+    }
+    this->Pos += prefix.size();
+    return true;
+  }
+  bool AtEnd() const { return this->Pos == this->Data.size(); }
+
+private:
+  std::string const& Data;
+  std::string::size_type Pos = 0;
+};
+}
+
+cmDependsCSharedCache::cmDependsCSharedCache(std::string fileName)
+  : FileName(std::move(fileName))
+{
+}
+
+bool cmDependsCSharedCache::Load()
+{
+  this->Groups.clear();
+  this->Modified = false;
+
+  cmsys::ifstream fin(this->FileName.c_str(),
+                      std::ios::in | std::ios::binary);
+  if (!fin) {
+    return false;
+  }
+  std::string data((std::istreambuf_iterator<char>(fin)),
+                   std::istreambuf_iterator<char>());
+  if (!this->Read(data)) {
+    this->Groups.clear();
+    return false;
+  }
+  return true;
+}
+
+bool cmDependsCSharedCache::Read(std::string const& data)
+{
+  BinaryReader r(data);
+  unsigned int groupCount;
+  if (!r.Skip(CM_DEPENDS_C_SHARED_CACHE_MAGIC) || !r.U32(groupCount)) {
+    return false;
+  }
+  for (unsigned int g = 0; g < groupCount; ++g) {
+    std::string settings;
+    unsigned int entryCount;
+    if (!r.Str(settings) || !r.U32(entryCount)) {
+      return false;
+    }
+    EntryMap& entries = this->Groups[settings];
+    for (unsigned int e = 0; e < entryCount; ++e) {
+      std::string path;
+      unsigned long long mtime;
+      Entry entry;
+      unsigned int includeCount;
+      if (!r.Str(path) || !r.U64(mtime) || !r.U64(entry.Stamp.Size) ||
+          !r.U32(includeCount)) {
+        return false;
+      }
+      entry.Stamp.MTime = static_cast<long long>(mtime);
+      for (unsigned int i = 0; i < includeCount; ++i) {
+        IncludeEntry inc;
+        if (!r.Str(inc.FileName) || !r.Str(inc.QuotedLocation)) {
+          return false;
+        }
+        entry.Includes.push_back(std::move(inc));
+      }
+      entries[path] = std::move(entry);
+    }
+  }
+  return r.AtEnd();
+}
+
+bool cmDependsCSharedCache::Save()
+{
+  if (!this->Modified) {
+    return true;
+  }
+
+  // Merge our new entries into the current content of the file so that
+  // entries stored by other processes since we loaded it are kept.
+  cmDependsCSharedCache merged(this->FileName);
+  merged.Load();
+  for (auto const& group : this->Groups) {
+    EntryMap* target = nullptr;
+    for (auto const& entry : group.second) {
+      if (!entry.second.Modified) {
+        continue;
+      }
+      if (!target) {
+        target = &merged.Groups[group.first];
+      }
+      (*target)[entry.first] = entry.second;
+    }
+  }
+
+  // Write to a file private to this process and then atomically
+  // replace the cache file.
+  std::ostringstream tmpName;
+  tmpName << this->FileName << ".tmp" << cmSystemTools::RandomSeed();
+  if (!merged.Write(tmpName.str()) ||
+      !cmSystemTools::RenameFile(tmpName.str(), this->FileName)) {
+    cmSystemTools::RemoveFile(tmpName.str());
+    return false;
+  }
+  this->Modified = false;
+  return true;
+}
+
+bool cmDependsCSharedCache::Write(std::string const& fileName) const
+{
+  BinaryWriter w;
+  w.Data = CM_DEPENDS_C_SHARED_CACHE_MAGIC;
+  w.U32(static_cast<unsigned int>(this->Groups.size()));
+  for (auto const& group : this->Groups) {
+    w.Str(group.first);
+    w.U32(static_cast<unsigned int>(group.second.size()));
+    for (auto const& entry : group.second) {
+      w.Str(entry.first);
+      w.U64(static_cast<unsigned long long>(entry.second.Stamp.MTime));
+      w.U64(entry.second.Stamp.Size);
+      w.U32(static_cast<unsigned int>(entry.second.Includes.size()));
+      for (IncludeEntry const& inc : entry.second.Includes) {
+        w.Str(inc.FileName);
+        w.Str(inc.QuotedLocation);
+      }
+    }
+  }
+
+  cmsys::ofstream fout(fileName.c_str(), std::ios::out | std::ios::binary);
+  if (!fout) {
+    return false;
+  }
+  fout.write(w.Data.data(), static_cast<std::streamsize>(w.Data.size()));
+  fout.close();
+  return !fout.fail();
+}
+
+bool cmDependsCSharedCache::GetFileStamp(std::string const& path,
+                                         FileStamp& stamp)
+{
+#if !defined(_WIN32) || defined(__CYGWIN__)
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0) {
+    return false;
+  }
+  long long bil = 1000000000;
+#  if CMake_STAT_HAS_ST_MTIM
+  stamp.MTime = st.st_mtim.tv_sec * bil + st.st_mtim.tv_nsec;
+#  elif CMake_STAT_HAS_ST_MTIMESPEC
+  stamp.MTime = st.st_mtimespec.tv_sec * bil + st.st_mtimespec.tv_nsec;
+#  else
+  stamp.MTime = st.st_mtime * bil;
+#  endif
+  stamp.Size = static_cast<unsigned long long>(st.st_size);
+#else
+  WIN32_FILE_ATTRIBUTE_DATA fdata;
+  if (!GetFileAttributesExW(cmsys::Encoding::ToWide(path).c_str(),
+                            GetFileExInfoStandard, &fdata)) {
+    return false;
+  }
+  LARGE_INTEGER t;
+  t.LowPart = fdata.ftLastWriteTime.dwLowDateTime;
+  t.HighPart = fdata.ftLastWriteTime.dwHighDateTime;
+  stamp.MTime = t.QuadPart;
+  stamp.Size = (static_cast<unsigned long long>(fdata.nFileSizeHigh) << 32) |
+    fdata.nFileSizeLow;
+#endif
+  return true;
+}
+
+cmDependsCSharedCache::IncludeEntries const* cmDependsCSharedCache::Find(
+  std::string const& settings, std::string const& path,
+  FileStamp const& stamp) const
+{
+  auto gi = this->Groups.find(settings);
+  if (gi == this->Groups.end()) {
+    return nullptr;
+  }
+  auto ei = gi->second.find(path);
+  if (ei == gi->second.end() || !(ei->second.Stamp == stamp)) {
+    return nullptr;
+  }
+  return &ei->second.Includes;
+}
+
+void cmDependsCSharedCache::Store(std::string const& settings,
+                                  std::string const& path,
+                                  FileStamp const& stamp,
+                                  IncludeEntries includes)
+{
+  Entry& entry = this->Groups[settings][path];
+  entry.Stamp = stamp;
+  entry.Includes = std::move(includes);
+  entry.Modified = true;
+  this->Modified = true;
+}
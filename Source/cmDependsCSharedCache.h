@@ -0,0 +1,102 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmDependsCSharedCache_h
+#define cmDependsCSharedCache_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** \class cmDependsCSharedCache
+ * \brief Build-tree-wide cache of include lines scanned by cmDependsC.
+ *
+ * The per-target include cache written by cmDependsC only avoids
+ * rescanning a header within one target.  A header included by many
+ * targets is still read and matched against the include regular
+ * expressions once per target.  This cache is stored once for the
+ * whole build tree in a compact binary file and maps each scanned
+ * file to the include entries found in it, together with the file
+ * size and modification time it had when it was scanned.  Entries
+ * are grouped by the scanner settings (the include, scan and
+ * transform regular expressions) because those affect the result.
+ *
+ * Several "cmake -E cmake_depends" processes may use the same cache
+ * file concurrently.  The file is replaced atomically and entries
+ * written by other processes since it was loaded are merged back in
+ * before saving, so concurrent writers may at worst lose a few
+ * entries that will simply be scanned again later.
+ */
+class cmDependsCSharedCache
+{
+public:
+  /** One include directive found in a scanned file.  */
+  struct IncludeEntry
+  {
+    std::string FileName;
+    std::string QuotedLocation;
+  };
+  typedef std::vector<IncludeEntry> IncludeEntries;
+
+  /** Size and modification time identifying one version of a file.  */
+  struct FileStamp
+  {
+    long long MTime = 0;
+    unsigned long long Size = 0;
+
+    bool operator==(FileStamp const& r) const
+    {
+      return this->MTime == r.MTime && this->Size == r.Size;
+    }
+  };
+
+  cmDependsCSharedCache(std::string fileName);
+
+  cmDependsCSharedCache(cmDependsCSharedCache const&) = delete;
+  cmDependsCSharedCache& operator=(cmDependsCSharedCache const&) = delete;
+
+  /** Load the cache file.  A missing, truncated or incompatible file
+      results in an empty cache.  Returns true if entries were read.  */
+  bool Load();
+
+  /** Write the cache file if any entry has been stored since it was
+      loaded.  Returns false if the file could not be written.  */
+  bool Save();
+
+  /** Get the size and modification time of a file.  */
+  static bool GetFileStamp(std::string const& path, FileStamp& stamp);
+
+  /** Lookup the include entries of the given file as scanned with the
+      given settings.  The stamp must be the current stamp of the file.
+      Returns nullptr if the file has not been scanned or changed.  */
+  IncludeEntries const* Find(std::string const& settings,
+                             std::string const& path,
+                             FileStamp const& stamp) const;
+
+  /** Record the include entries of the given file as scanned with the
+      given settings while the file had the given stamp.  */
+  void Store(std::string const& settings, std::string const& path,
+             FileStamp const& stamp, IncludeEntries includes);
+
+  std::string const& GetFileName() const { return this->FileName; }
+
+private:
+  struct Entry
+  {
+    FileStamp Stamp;
+    IncludeEntries Includes;
+    bool Modified = false;
+  };
+  typedef std::unordered_map<std::string, Entry> EntryMap;
+
+  bool Read(std::string const& data);
+  bool Write(std::string const& fileName) const;
+
+  std::string FileName;
+  std::map<std::string, EntryMap> Groups;
+  bool Modified = false;
+};
+
+#endif
@@ -0,0 +1,125 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmDependsCompiler.h"
+
+#include "cmFileTimeComparison.h"
+#include "cmGccDepfileReader.h"
+#include "cmLocalGenerator.h"
+#include "cmMakefile.h"
+#include "cmSystemTools.h"
+
+#include <sstream>
+#include <utility>
+#include <vector>
+
+cmDependsCompiler::cmDependsCompiler(
+  cmLocalGenerator* lg, const std::string& targetDir,
+  const std::string& internalFile,
+  const std::map<std::string, DependencyVector>* validDeps)
+  : cmDepends(lg, targetDir)
+  , InternalFile(internalFile)
+  , ValidDeps(validDeps)
+{
+}
+
+std::string cmDependsCompiler::GetDepfileName(const std::string& obj)
+{
+  return obj + ".d";
+}
+
+bool cmDependsCompiler::DepfilesChanged(const std::string& lang)
+{
+  std::string const& pairsStr =
+    this->LocalGenerator->GetMakefile()->GetSafeDefinition(
+      "CMAKE_DEPENDS_CHECK_" + lang);
+  std::vector<std::string> pairs;
+  cmSystemTools::ExpandListArgument(pairsStr, pairs);
+  for (std::vector<std::string>::size_type i = 1; i < pairs.size(); i += 2) {
+    std::string const depfile = GetDepfileName(pairs[i]);
+    if (this->DepfileChanged(depfile)) {
+      if (this->Verbose) {
+        std::ostringstream msg;
+        msg << "Dependee \"" << depfile << "\" is newer than depender \""
+            << this->InternalFile << "\"." << std::endl;
+        cmSystemTools::Stdout(msg.str());
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool cmDependsCompiler::DepfileChanged(const std::string& depfile)
+{
+  if (!cmSystemTools::FileExists(depfile)) {
+    return false;
+  }
+  int result;
+  return !this->FileComparison->FileTimeCompare(this->InternalFile, depfile,
+                                                &result) ||
+    result < 0;
+}
+
+bool cmDependsCompiler::WriteDependencies(
+  const std::set<std::string>& sources, const std::string& obj,
+  std::ostream& makeDepends, std::ostream& internalDepends)
+{
+  if (sources.empty() || sources.begin()->empty()) {
+    cmSystemTools::Error("Cannot scan dependencies without a source file.");
+    return false;
+  }
+  if (obj.empty()) {
+    cmSystemTools::Error("Cannot scan dependencies without an object file.");
+    return false;
+  }
+
+  std::string binDir = this->LocalGenerator->GetBinaryDirectory();
+  std::string obj_i =
+    this->LocalGenerator->MaybeConvertToRelativePath(binDir, obj);
+  std::string const depfile = GetDepfileName(obj);
+
+  // Reuse the dependencies consolidated by the last run unless the
+  // compiler has written the dependency file again since then.
+  std::set<std::string> dependencies;
+  bool haveDeps = false;
+  if (this->ValidDeps != nullptr && !this->DepfileChanged(depfile)) {
+    std::map<std::string, DependencyVector>::const_iterator tmpIt =
+      this->ValidDeps->find(obj_i);
+    if (tmpIt != this->ValidDeps->end()) {
+      dependencies.insert(tmpIt->second.begin(), tmpIt->second.end());
+      haveDeps = true;
+    }
+  }
+
+  if (!haveDeps) {
+    // Before the object is compiled for the first time there is no
+    // dependency file yet and the object depends only on its sources.
+    dependencies.insert(sources.begin(), sources.end());
+
+    // Paths in the dependency file are relative to the directory in
+    // which the compiler ran.
+    std::vector<std::string> deps;
+    if (cmReadGccDepfile(depfile, deps)) {
+      std::string const& dir =
+        this->LocalGenerator->GetCurrentBinaryDirectory();
+      for (std::string const& dep : deps) {
+        dependencies.insert(cmSystemTools::CollapseFullPath(dep, dir));
+      }
+    }
+  }
+
+  // Write the dependencies in the same form as cmDependsC.
+  std::string obj_m = cmSystemTools::ConvertToOutputPath(obj_i);
+  internalDepends << obj_i << std::endl;
+  for (std::string const& dep : dependencies) {
+    makeDepends << obj_m << ": "
+                << cmSystemTools::ConvertToOutputPath(
+                     this->LocalGenerator->MaybeConvertToRelativePath(binDir,
+                                                                      dep))
+                << std::endl;
+    internalDepends << " " << dep << std::endl;
+  }
+  makeDepends << std::endl;
+
+  return true;
+}
@@ -0,0 +1,56 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmDependsCompiler_h
+#define cmDependsCompiler_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include "cmDepends.h"
+
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <string>
+
+class cmLocalGenerator;
+
+/** \class cmDependsCompiler
+ * \brief Dependencies reported by the compiler for C-like object files.
+ *
+ * Instead of scanning sources for include directives this reads the
+ * dependency files written by GCC-compatible compilers next to each
+ * object file and consolidates them into the target's depend.make.
+ * The dependency file of an object is only parsed again when it is
+ * newer than the depend.internal file written by the last run.
+ */
+class cmDependsCompiler : public cmDepends
+{
+public:
+  cmDependsCompiler(cmLocalGenerator* lg, const std::string& targetDir,
+                    const std::string& internalFile,
+                    const std::map<std::string, DependencyVector>* validDeps);
+
+  cmDependsCompiler(cmDependsCompiler const&) = delete;
+  cmDependsCompiler& operator=(cmDependsCompiler const&) = delete;
+
+  /** Get the name of the dependency file written by the compiler for
+      the given object file.  */
+  static std::string GetDepfileName(const std::string& obj);
+
+  /** Check whether the compiler wrote any dependency file of the given
+      language since the internal depend file was written.  */
+  bool DepfilesChanged(const std::string& lang);
+
+protected:
+  bool WriteDependencies(const std::set<std::string>& sources,
+                         const std::string& obj, std::ostream& makeDepends,
+                         std::ostream& internalDepends) override;
+
+private:
+  bool DepfileChanged(const std::string& depfile);
+
+  std::string InternalFile;
+  const std::map<std::string, DependencyVector>* ValidDeps = nullptr;
+};
+
+#endif
@@ -10,9 +10,11 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
 #include <cmath>
 #include <ctype.h>
 #include <memory> // IWYU pragma: keep
+#include <set>
 #include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,6 +22,11 @@
 #include <utility>
 #include <vector>
 
+// The bootstrap build does not link to a thread library.
+#ifdef CMAKE_BUILD_WITH_CMAKE
+#  include <thread>
+#endif
+
 #include "cmAlgorithms.h"
 #include "cmCommandArgumentsHelper.h"
 #include "cmCryptoHash.h"
@@ -27,8 +34,11 @@
 #include "cmFileLockPool.h"
 #include "cmFileTimeComparison.h"
 #include "cmGeneratorExpression.h"
+#include "cmGlobDirectories.h"
+#include "cmGlobWalker.h"
 #include "cmGlobalGenerator.h"
 #include "cmHexFileConverter.h"
+#include "cmInstallHashManifest.h"
 #include "cmInstallType.h"
 #include "cmListFileCache.h"
 #include "cmMakefile.h"
@@ -766,7 +776,7 @@ bool cmFileCommand::HandleGlobCommand(std::vector<std::string> const& args,
 
   std::string variable = *i;
   i++;
-  cmsys::Glob g;
+  cmGlobWalker g;
   g.SetRecurse(recurse);
 
   bool explicitFollowSymlinks = false;
@@ -828,7 +838,7 @@ bool cmFileCommand::HandleGlobCommand(std::vector<std::string> const& args,
         this->SetError("GLOB requires a directory after the RELATIVE tag.");
         return false;
       }
-      g.SetRelative(i->c_str());
+      g.SetRelative(*i);
       ++i;
       if (i == args.end()) {
         this->SetError("GLOB requires a glob expression after the directory.");
@@ -867,6 +877,11 @@ bool cmFileCommand::HandleGlobCommand(std::vector<std::string> const& args,
         }
       }
 
+      // Record the directories listed by the glob so that the build
+      // system can check them cheaply.
+      cmGlobDirectories directories;
+      g.SetRecordDirectories(configureDepends ? &directories : nullptr);
+
       cmsys::Glob::GlobMessages globMessages;
       g.FindFiles(expr, &globMessages);
 
@@ -906,7 +921,7 @@ bool cmFileCommand::HandleGlobCommand(std::vector<std::string> const& args,
         this->Makefile->GetCMakeInstance()->AddGlobCacheEntry(
           recurse, (recurse ? g.GetRecurseListDirs() : g.GetListDirs()),
           (recurse ? g.GetRecurseThroughSymlinks() : false),
-          (g.GetRelative() ? g.GetRelative() : ""), expr, foundFiles, variable,
+          g.GetRelative(), expr, foundFiles, directories, variable,
           this->Makefile->GetBacktrace());
       } else {
         warnConfigureLate = true;
@@ -1077,6 +1092,8 @@ struct cmFileCopier
     , UseGivenPermissionsDir(false)
     , UseSourcePermissions(true)
     , Doing(DoingNone)
+    , ParallelLevel(1)
+    , Hashes(nullptr)
   {
   }
   virtual ~cmFileCopier() = default;
@@ -1145,40 +1162,60 @@ protected:
 
   bool SetPermissions(const char* toFile, mode_t permissions)
   {
-    if (permissions) {
+    if (!ApplyPermissions(toFile, permissions, this->StoreModeInStream())) {
+      std::ostringstream e;
+      e << this->Name << " cannot set permissions on \"" << toFile << "\"";
+      this->FileCommand->SetError(e.str());
+      return false;
+    }
+    return true;
+  }
+
+  // Whether the mode of installed files is kept in an NTFS alternate
+  // stream in addition to the file permissions.
+  bool StoreModeInStream() const
+  {
 #ifdef WIN32
-      if (Makefile->IsOn("CMAKE_CROSSCOMPILING")) {
-        // Store the mode in an NTFS alternate stream.
-        std::string mode_t_adt_filename =
-          std::string(toFile) + ":cmake_mode_t";
+    return this->Makefile->IsOn("CMAKE_CROSSCOMPILING");
+#else
+    return false;
+#endif
+  }
 
-        // Writing to an NTFS alternate stream changes the modification
-        // time, so we need to save and restore its original value.
-        cmSystemToolsFileTime* file_time_orig = cmSystemTools::FileTimeNew();
-        cmSystemTools::FileTimeGet(toFile, file_time_orig);
+  // Set the permissions of a file without reporting errors.  This does
+  // not use the makefile, so the threads copying files may call it.
+  static bool ApplyPermissions(const char* toFile, mode_t permissions,
+                               bool storeModeInStream)
+  {
+    if (!permissions) {
+      return true;
+    }
+#ifdef WIN32
+    if (storeModeInStream) {
+      // Store the mode in an NTFS alternate stream.
+      std::string mode_t_adt_filename = std::string(toFile) + ":cmake_mode_t";
 
-        cmsys::ofstream permissionStream(mode_t_adt_filename.c_str());
+      // Writing to an NTFS alternate stream changes the modification
+      // time, so we need to save and restore its original value.
+      cmSystemToolsFileTime* file_time_orig = cmSystemTools::FileTimeNew();
+      cmSystemTools::FileTimeGet(toFile, file_time_orig);
 
-        if (permissionStream) {
-          permissionStream << std::oct << permissions << std::endl;
-        }
+      cmsys::ofstream permissionStream(mode_t_adt_filename.c_str());
 
-        permissionStream.close();
+      if (permissionStream) {
+        permissionStream << std::oct << permissions << std::endl;
+      }
 
-        cmSystemTools::FileTimeSet(toFile, file_time_orig);
+      permissionStream.close();
 
-        cmSystemTools::FileTimeDelete(file_time_orig);
-      }
-#endif
+      cmSystemTools::FileTimeSet(toFile, file_time_orig);
 
-      if (!cmSystemTools::SetPermissions(toFile, permissions)) {
-        std::ostringstream e;
-        e << this->Name << " cannot set permissions on \"" << toFile << "\"";
-        this->FileCommand->SetError(e.str());
-        return false;
-      }
+      cmSystemTools::FileTimeDelete(file_time_orig);
     }
-    return true;
+#else
+    static_cast<void>(storeModeInStream);
+#endif
+    return cmSystemTools::SetPermissions(toFile, permissions);
   }
 
   // Translate an argument to a permissions bit.
@@ -1196,6 +1233,8 @@ protected:
   bool InstallSymlink(const char* fromFile, const char* toFile);
   bool InstallFile(const char* fromFile, const char* toFile,
                    MatchProperties match_properties);
+  mode_t GetFilePermissions(const char* fromFile,
+                            MatchProperties const& match_properties);
   bool InstallDirectory(const char* source, const char* destination,
                         MatchProperties match_properties);
   virtual bool Install(const char* fromFile, const char* toFile);
@@ -1229,6 +1268,65 @@ protected:
   std::vector<std::string> Files;
   int Doing;
 
+  // Number of files copied at the same time.  With more than one the
+  // copies are queued in order and run on a pool of threads before
+  // Run returns, or earlier when a destination is installed again.
+  unsigned int ParallelLevel;
+  struct PendingCopy
+  {
+    std::string FromFile;
+    std::string ToFile;
+    bool CopyTime;
+    mode_t Permissions;
+    std::string Error;
+    bool Hashed = false;
+    cmInstallHashManifest::Entry Hash;
+  };
+  std::vector<PendingCopy> PendingCopies;
+  std::set<std::string> PendingDestinations;
+  // Final permissions of directories whose files are still queued
+  std::vector<std::pair<std::string, mode_t>> PendingDirPermissions;
+  bool FinishCopies(bool report);
+
+  // Content hashes of installed files, to keep copies whose source
+  // changed only its time.  Null if not enabled.
+  cmInstallHashManifest* Hashes;
+  bool HasSameContent(const char* fromFile, const char* toFile)
+  {
+#ifdef CMAKE_BUILD_WITH_CMAKE
+    return this->Hashes && this->Hashes->IsUnchanged(fromFile, toFile);
+#else
+    static_cast<void>(fromFile);
+    static_cast<void>(toFile);
+    return false;
+#endif
+  }
+  void RecordContent(const char* fromFile, const char* toFile, bool copied,
+                     bool sameContent)
+  {
+#ifdef CMAKE_BUILD_WITH_CMAKE
+    if (!this->Hashes) {
+      return;
+    }
+    if (sameContent) {
+      this->Hashes->Refresh(toFile);
+      return;
+    }
+    // Files up-to-date by their time were installed from this content,
+    // so the manifest also learns about files installed before it.
+    cmInstallHashManifest::Entry entry;
+    if ((copied || !this->Hashes->Contains(toFile)) &&
+        cmInstallHashManifest::ComputeEntry(fromFile, toFile, entry)) {
+      this->Hashes->Add(toFile, entry);
+    }
+#else
+    static_cast<void>(fromFile);
+    static_cast<void>(toFile);
+    static_cast<void>(copied);
+    static_cast<void>(sameContent);
+#endif
+  }
+
   virtual bool Parse(std::vector<std::string> const& args);
   enum
   {
@@ -1556,10 +1654,101 @@ bool cmFileCopier::Run(std::vector<std::string> const& args)
     }
 
     if (!this->Install(fromFile.c_str(), toFile.c_str())) {
+      // Finish the files queued before the error but report only it.
+      this->FinishCopies(false);
       return false;
     }
   }
-  return true;
+  return this->FinishCopies(true);
+}
+
+bool cmFileCopier::FinishCopies(bool report)
+{
+  std::vector<PendingCopy>& copies = this->PendingCopies;
+  bool const hashing = this->Hashes != nullptr;
+  std::atomic<size_t> next(0);
+  auto worker = [&copies, &next, hashing]() {
+    for (size_t i = next++; i < copies.size(); i = next++) {
+      PendingCopy& c = copies[i];
+      if (!cmSystemTools::CopyAFile(c.FromFile, c.ToFile, true)) {
+        c.Error = "cannot copy file \"" + c.FromFile + "\" to \"" +
+          c.ToFile + "\".";
+        continue;
+      }
+      if (c.CopyTime) {
+        // Add write permission so we can set the file time.
+        // Permissions are set unconditionally below anyway.
+        mode_t perm = 0;
+        if (cmSystemTools::GetPermissions(c.ToFile, perm)) {
+          cmSystemTools::SetPermissions(c.ToFile, perm | mode_owner_write);
+        }
+        if (!cmSystemTools::CopyFileTime(c.FromFile.c_str(),
+                                         c.ToFile.c_str())) {
+          c.Error = "cannot set modification time on \"" + c.ToFile + "\"";
+          continue;
+        }
+      }
+      // The mode stream is written below, from this thread only.
+      if (!ApplyPermissions(c.ToFile.c_str(), c.Permissions, false)) {
+        c.Error = "cannot set permissions on \"" + c.ToFile + "\"";
+        continue;
+      }
+#ifdef CMAKE_BUILD_WITH_CMAKE
+      if (hashing) {
+        c.Hashed =
+          cmInstallHashManifest::ComputeEntry(c.FromFile, c.ToFile, c.Hash);
+      }
+#else
+      static_cast<void>(hashing);
+#endif
+    }
+  };
+#ifdef CMAKE_BUILD_WITH_CMAKE
+  size_t const threadCount =
+    std::min<size_t>(this->ParallelLevel, copies.size());
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < threadCount; ++t) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& t : threads) {
+    t.join();
+  }
+#else
+  worker();
+#endif
+
+  // Report the first failure in installation order.
+  bool okay = true;
+  bool const storeModeInStream = this->StoreModeInStream();
+  for (PendingCopy const& c : copies) {
+    if (!c.Error.empty()) {
+      if (okay && report) {
+        this->FileCommand->SetError(std::string(this->Name) + " " + c.Error);
+      }
+      okay = false;
+      continue;
+    }
+    if (storeModeInStream) {
+      ApplyPermissions(c.ToFile.c_str(), c.Permissions, true);
+    }
+#ifdef CMAKE_BUILD_WITH_CMAKE
+    if (c.Hashed) {
+      this->Hashes->Add(c.ToFile, c.Hash);
+    }
+#endif
+  }
+  copies.clear();
+  this->PendingDestinations.clear();
+
+  // The directories may now lose the permissions needed to fill them.
+  for (auto const& dir : this->PendingDirPermissions) {
+    if (okay && !this->SetPermissions(dir.first.c_str(), dir.second)) {
+      okay = false;
+    }
+  }
+  this->PendingDirPermissions.clear();
+  return okay;
 }
 
 bool cmFileCopier::Install(const char* fromFile, const char* toFile)
@@ -1622,6 +1811,12 @@ bool cmFileCopier::InstallSymlink(const char* fromFile, const char* toFile)
   this->ReportCopy(toFile, TypeLink, copy);
 
   if (copy) {
+    // Do not race with a queued copy to the same destination.
+    if (this->PendingDestinations.count(toFile) &&
+        !this->FinishCopies(true)) {
+      return false;
+    }
+
     // Remove the destination file so we can always create the symlink.
     cmSystemTools::RemoveFile(toFile);
 
@@ -1644,18 +1839,42 @@ bool cmFileCopier::InstallSymlink(const char* fromFile, const char* toFile)
 bool cmFileCopier::InstallFile(const char* fromFile, const char* toFile,
                                MatchProperties match_properties)
 {
+  // A destination installed twice is copied in order.
+  if (this->PendingDestinations.count(toFile) && !this->FinishCopies(true)) {
+    return false;
+  }
+
   // Determine whether we will copy the file.
   bool copy = true;
+  bool sameContent = false;
   if (!this->Always) {
     // If both files exist with the same time do not copy.
     if (!this->FileTimes.FileTimesDiffer(fromFile, toFile)) {
       copy = false;
+    } else if (this->HasSameContent(fromFile, toFile)) {
+      // The source was rewritten with the content installed before.
+      // Keep the installed file and only update its time.
+      copy = false;
+      sameContent = true;
     }
   }
 
   // Inform the user about this file installation.
   this->ReportCopy(toFile, TypeFile, copy);
 
+  // Queue the copy.
+  if (copy && this->ParallelLevel > 1) {
+    PendingCopy pending;
+    pending.FromFile = fromFile;
+    pending.ToFile = toFile;
+    pending.CopyTime = !this->Always;
+    pending.Permissions =
+      this->GetFilePermissions(fromFile, match_properties);
+    this->PendingCopies.push_back(std::move(pending));
+    this->PendingDestinations.insert(toFile);
+    return true;
+  }
+
   // Copy the file.
   if (copy && !cmSystemTools::CopyAFile(fromFile, toFile, true)) {
     std::ostringstream e;
@@ -1666,7 +1885,7 @@ bool cmFileCopier::InstallFile(const char* fromFile, const char* toFile,
   }
 
   // Set the file modification time of the destination file.
-  if (copy && !this->Always) {
+  if ((copy || sameContent) && !this->Always) {
     // Add write permission so we can set the file time.
     // Permissions are set unconditionally below anyway.
     mode_t perm = 0;
@@ -1683,6 +1902,19 @@ bool cmFileCopier::InstallFile(const char* fromFile, const char* toFile,
   }
 
   // Set permissions of the destination file.
+  if (!this->SetPermissions(
+        toFile, this->GetFilePermissions(fromFile, match_properties))) {
+    return false;
+  }
+
+  // Remember the content of the installed file.
+  this->RecordContent(fromFile, toFile, copy, sameContent);
+  return true;
+}
+
+mode_t cmFileCopier::GetFilePermissions(
+  const char* fromFile, MatchProperties const& match_properties)
+{
   mode_t permissions =
     (match_properties.Permissions ? match_properties.Permissions
                                   : this->FilePermissions);
@@ -1691,7 +1923,7 @@ bool cmFileCopier::InstallFile(const char* fromFile, const char* toFile,
     // that the source file permissions be used.
     cmSystemTools::GetPermissions(fromFile, permissions);
   }
-  return this->SetPermissions(toFile, permissions);
+  return permissions;
 }
 
 bool cmFileCopier::InstallDirectory(const char* source,
@@ -1771,7 +2003,15 @@ bool cmFileCopier::InstallDirectory(const char* source,
     }
   }
 
-  // Set the requested permissions of the destination directory.
+  // Set the requested permissions of the destination directory once
+  // its files are copied.
+  if (!this->PendingCopies.empty()) {
+    if (permissions_after) {
+      this->PendingDirPermissions.emplace_back(destination,
+                                               permissions_after);
+    }
+    return true;
+  }
   return this->SetPermissions(destination, permissions_after);
 }
 
@@ -1799,6 +2039,25 @@ struct cmFileInstaller : public cmFileCopier
     if (cmSystemTools::GetEnv("CMAKE_INSTALL_ALWAYS", install_always)) {
       this->Always = cmSystemTools::IsOn(install_always);
     }
+    // Check how many files to copy at the same time.
+    std::string parallel_level;
+    unsigned long level;
+    if (cmSystemTools::GetEnv("CMAKE_INSTALL_PARALLEL_LEVEL",
+                              parallel_level) &&
+        cmSystemTools::StringToULong(parallel_level.c_str(), &level) &&
+        level > 1) {
+      this->ParallelLevel = static_cast<unsigned int>(std::min(level, 64ul));
+    }
+#ifdef CMAKE_BUILD_WITH_CMAKE
+    // Check whether to keep installed files whose content is unchanged.
+    std::string hash_manifest;
+    if (!this->Always &&
+        cmSystemTools::GetEnv("CMAKE_INSTALL_HASH_MANIFEST", hash_manifest) &&
+        !hash_manifest.empty()) {
+      this->Hashes = &cmInstallHashManifest::Get(
+        cmSystemTools::CollapseFullPath(hash_manifest));
+    }
+#endif
     // Get the current manifest.
     this->Manifest =
       this->Makefile->GetSafeDefinition("CMAKE_INSTALL_MANIFEST_FILES");
@@ -1808,6 +2067,13 @@ struct cmFileInstaller : public cmFileCopier
     // Save the updated install manifest.
     this->Makefile->AddDefinition("CMAKE_INSTALL_MANIFEST_FILES",
                                   this->Manifest.c_str());
+#ifdef CMAKE_BUILD_WITH_CMAKE
+    // The hash manifest is only a cache, so failing to save is not an
+    // error.
+    if (this->Hashes) {
+      this->Hashes->Save();
+    }
+#endif
   }
 
 protected:
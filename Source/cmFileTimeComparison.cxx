@@ -2,10 +2,18 @@
    file Copyright.txt or https://cmake.org/licensing for details.  */
 #include "cmFileTimeComparison.h"
 
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <time.h>
 #include <unordered_map>
 #include <utility>
+#include <vector>
+
+// The bootstrap build does not link to a thread library.
+#ifdef CMAKE_BUILD_WITH_CMAKE
+#  include <thread>
+#endif
 
 // Use a platform-specific API to get file times efficiently.
 #if !defined(_WIN32) || defined(__CYGWIN__)
@@ -26,6 +34,16 @@ public:
 
   bool FileTimesDiffer(const std::string& f1, const std::string& f2);
 
+  bool FileExists(const std::string& f)
+  {
+    cmFileTimeComparison_Type st;
+    return this->Stat(f, &st);
+  }
+
+  void Prefetch(const std::vector<std::string>& files);
+
+  cmFileTimeComparison::Statistics Stats;
+
 private:
   typedef std::unordered_map<std::string, cmFileTimeComparison_Type>
     FileStatsMap;
@@ -33,6 +51,8 @@ private:
 
   // Internal methods to lookup and compare modification times.
   inline bool Stat(const std::string& fname, cmFileTimeComparison_Type* st);
+  static bool StatFile(const std::string& fname,
+                       cmFileTimeComparison_Type* st);
   inline int Compare(cmFileTimeComparison_Type* st1,
                      cmFileTimeComparison_Type* st2);
   inline bool TimesDiffer(cmFileTimeComparison_Type* st1,
@@ -42,6 +62,8 @@ private:
 bool cmFileTimeComparisonInternal::Stat(const std::string& fname,
                                         cmFileTimeComparison_Type* st)
 {
+  ++this->Stats.Lookups;
+
   // Use the stored time if available.
   cmFileTimeComparisonInternal::FileStatsMap::iterator fit =
     this->Files.find(fname);
@@ -50,6 +72,74 @@ bool cmFileTimeComparisonInternal::Stat(const std::string& fname,
     return true;
   }
 
+  ++this->Stats.StatCalls;
+  if (!StatFile(fname, st)) {
+    return false;
+  }
+
+  // Store the time for future use.
+  this->Files[fname] = *st;
+  return true;
+}
+
+void cmFileTimeComparisonInternal::Prefetch(
+  const std::vector<std::string>& files)
+{
+  // Collect the files whose times are not known yet.
+  std::vector<std::string const*> todo;
+  todo.reserve(files.size());
+  for (std::string const& f : files) {
+    if (this->Files.find(f) == this->Files.end()) {
+      todo.push_back(&f);
+    }
+  }
+  if (todo.empty()) {
+    return;
+  }
+
+  // The stat calls are independent, so a large batch is spread over a
+  // few threads.  This mostly helps on network file systems and cold
+  // caches where each call waits for I/O.  Small batches are not worth
+  // starting threads for.
+  std::vector<cmFileTimeComparison_Type> stats(todo.size());
+  std::vector<char> found(todo.size(), 0);
+  std::atomic<size_t> next(0);
+  auto worker = [&todo, &stats, &found, &next]() {
+    for (size_t i = next++; i < todo.size(); i = next++) {
+      found[i] = StatFile(*todo[i], &stats[i]) ? 1 : 0;
+    }
+  };
+#ifdef CMAKE_BUILD_WITH_CMAKE
+  size_t const filesPerThread = 256;
+  size_t threadCount = std::min<size_t>(
+    std::max(std::thread::hardware_concurrency(), 1u), 8);
+  threadCount = std::min(threadCount, todo.size() / filesPerThread);
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < threadCount; ++t) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& t : threads) {
+    t.join();
+  }
+#else
+  worker();
+#endif
+
+  // Store the results.  Missing files are not recorded so that they
+  // are looked up again if they are created later.
+  this->Stats.StatCalls += todo.size();
+  this->Stats.PrefetchedStatCalls += todo.size();
+  for (size_t i = 0; i < todo.size(); ++i) {
+    if (found[i]) {
+      this->Files[*todo[i]] = stats[i];
+    }
+  }
+}
+
+bool cmFileTimeComparisonInternal::StatFile(const std::string& fname,
+                                            cmFileTimeComparison_Type* st)
+{
 #if !defined(_WIN32) || defined(__CYGWIN__)
   // POSIX version.  Use the stat function.
   int res = ::stat(fname.c_str(), st);
@@ -69,8 +159,6 @@ bool cmFileTimeComparisonInternal::Stat(const std::string& fname,
   *st = fdata.ftLastWriteTime;
 #endif
 
-  // Store the time for future use.
-  this->Files[fname] = *st;
   return true;
 }
 
@@ -96,6 +184,22 @@ bool cmFileTimeComparison::FileTimesDiffer(const std::string& f1,
   return this->Internals->FileTimesDiffer(f1, f2);
 }
 
+bool cmFileTimeComparison::FileExists(const std::string& f)
+{
+  return this->Internals->FileExists(f);
+}
+
+void cmFileTimeComparison::Prefetch(const std::vector<std::string>& files)
+{
+  this->Internals->Prefetch(files);
+}
+
+cmFileTimeComparison::Statistics const& cmFileTimeComparison::GetStatistics()
+  const
+{
+  return this->Internals->Stats;
+}
+
 int cmFileTimeComparisonInternal::Compare(cmFileTimeComparison_Type* s1,
                                           cmFileTimeComparison_Type* s2)
 {
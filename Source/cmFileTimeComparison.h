@@ -6,6 +6,7 @@
 #include "cmConfigure.h" // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
 class cmFileTimeComparisonInternal;
 
@@ -35,6 +36,31 @@ public:
    */
   bool FileTimesDiffer(const std::string& f1, const std::string& f2);
 
+  /**
+   *  Test whether a file exists using the stored modification time
+   *  lookup.  A file found once is assumed to keep existing.
+   */
+  bool FileExists(const std::string& f);
+
+  /**
+   *  Lookup the modification times of many files at once.  Large
+   *  batches are distributed over several threads.  Later comparisons
+   *  involving these files use the stored times.
+   */
+  void Prefetch(const std::vector<std::string>& files);
+
+  /** Counters describing how many file system queries were needed.  */
+  struct Statistics
+  {
+    // Number of file time lookups requested.
+    unsigned long long Lookups = 0;
+    // Number of stat calls made, including prefetched files.
+    unsigned long long StatCalls = 0;
+    // Number of stat calls made by Prefetch.
+    unsigned long long PrefetchedStatCalls = 0;
+  };
+  Statistics const& GetStatistics() const;
+
 protected:
   cmFileTimeComparisonInternal* Internals;
 };
@@ -0,0 +1,91 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmGccDepfileReader.h"
+
+#include "cmsys/FStream.hxx"
+#include <iterator>
+
+void cmParseGccDepfile(std::string const& content,
+                       std::vector<std::string>& deps)
+{
+  std::string token;
+  bool inTargets = true;
+  auto flush = [&token, &inTargets, &deps]() {
+    if (!token.empty()) {
+      if (!inTargets) {
+        deps.push_back(token);
+      }
+      token.clear();
+    }
+  };
+
+  std::string::size_type const n = content.size();
+  for (std::string::size_type i = 0; i < n; ++i) {
+    char const c = content[i];
+    char const next = i + 1 < n ? content[i + 1] : '\0';
+    switch (c) {
+      case '\\':
+        if (next == '\n') {
+          // Line continuation.
+          flush();
+          ++i;
+        } else if (next == '\r' && i + 2 < n && content[i + 2] == '\n') {
+          flush();
+          i += 2;
+        } else if (next == ' ' || next == '#') {
+          // Escaped space or comment character.
+          token += next;
+          ++i;
+        } else {
+          // Any other backslash is part of the path, e.g. on Windows.
+          token += c;
+        }
+        break;
+      case '$':
+        token += c;
+        if (next == '$') {
+          ++i;
+        }
+        break;
+      case ' ':
+      case '\t':
+        flush();
+        break;
+      case '\r':
+      case '\n':
+        // The end of a rule.
+        flush();
+        inTargets = true;
+        break;
+      case ':':
+        // A colon not followed by whitespace is part of the path,
+        // e.g. a Windows drive letter.
+        if (inTargets &&
+            (next == '\0' || next == ' ' || next == '\t' || next == '\r' ||
+             next == '\n')) {
+          flush();
+          inTargets = false;
+        } else {
+          token += c;
+        }
+        break;
+      default:
+        token += c;
+        break;
+    }
+  }
+  flush();
+}
+
+bool cmReadGccDepfile(std::string const& filePath,
+                      std::vector<std::string>& deps)
+{
+  cmsys::ifstream fin(filePath.c_str(), std::ios::in | std::ios::binary);
+  if (!fin) {
+    return false;
+  }
+  std::string content((std::istreambuf_iterator<char>(fin)),
+                      std::istreambuf_iterator<char>());
+  cmParseGccDepfile(content, deps);
+  return true;
+}
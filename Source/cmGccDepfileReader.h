@@ -0,0 +1,23 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmGccDepfileReader_h
+#define cmGccDepfileReader_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <string>
+#include <vector>
+
+/** Parse the content of a Makefile-syntax dependency file as written by
+    GCC-compatible compilers (e.g. "-MD -MF <depfile>").  The rule
+    targets are discarded and the prerequisites of all rules are appended
+    to deps in the order they appear.  */
+void cmParseGccDepfile(std::string const& content,
+                       std::vector<std::string>& deps);
+
+/** Read and parse a dependency file.  Returns false if the file cannot
+    be read.  */
+bool cmReadGccDepfile(std::string const& filePath,
+                      std::vector<std::string>& deps);
+
+#endif
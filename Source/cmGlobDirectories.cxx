@@ -0,0 +1,71 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmGlobDirectories.h"
+
+#include <chrono>
+
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#  include "cm_sys_stat.h"
+#else
+#  include "cmsys/Encoding.hxx"
+#  include <windows.h>
+#endif
+
+// Directory times closer than this to the time they were recorded may
+// still change without a visible difference.
+static const long long cmGlobDirectoriesRacyWindow = 2000000000LL;
+
+bool cmGlobDirectories::IsUpToDate() const
+{
+  for (Entry const& e : this->Entries) {
+    if (e.MTime != -1 &&
+        e.MTime >= this->RecordTime - cmGlobDirectoriesRacyWindow) {
+      return false;
+    }
+    if (GetMTime(e.Path) != e.MTime) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void cmGlobDirectories::AddEntry(std::string const& path, long long mtime)
+{
+  this->Entries.push_back(Entry{ path, mtime });
+}
+
+long long cmGlobDirectories::GetMTime(std::string const& path)
+{
+#if !defined(_WIN32) || defined(__CYGWIN__)
+  long long const bil = 1000000000;
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0) {
+    return -1;
+  }
+#  if CMake_STAT_HAS_ST_MTIM
+  return st.st_mtim.tv_sec * bil + st.st_mtim.tv_nsec;
+#  elif CMake_STAT_HAS_ST_MTIMESPEC
+  return st.st_mtimespec.tv_sec * bil + st.st_mtimespec.tv_nsec;
+#  else
+  return st.st_mtime * bil;
+#  endif
+#else
+  WIN32_FILE_ATTRIBUTE_DATA fdata;
+  if (!GetFileAttributesExW(cmsys::Encoding::ToWide(path).c_str(),
+                            GetFileExInfoStandard, &fdata)) {
+    return -1;
+  }
+  // Convert from 100ns intervals since 1601 to the Unix epoch.
+  LARGE_INTEGER t;
+  t.LowPart = fdata.ftLastWriteTime.dwLowDateTime;
+  t.HighPart = fdata.ftLastWriteTime.dwHighDateTime;
+  return (t.QuadPart - 116444736000000000LL) * 100;
+#endif
+}
+
+long long cmGlobDirectories::Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::system_clock::now().time_since_epoch())
+    .count();
+}
@@ -0,0 +1,57 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmGlobDirectories_h
+#define cmGlobDirectories_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <string>
+#include <vector>
+
+/** \class cmGlobDirectories
+ * \brief Directories whose listing determines the result of a glob.
+ *
+ * The result of a glob expression can only change when an entry is
+ * added to, removed from or renamed in one of the directories it
+ * lists, which changes the modification time of that directory.
+ * This records the modification time of each such directory so that
+ * the glob only needs to be evaluated again when one of them changed.
+ * The directories are recorded by cmGlobWalker before it lists them so
+ * that a change made while the glob is evaluated is never missed.
+ */
+class cmGlobDirectories
+{
+public:
+  /** Modification time of a directory in nanoseconds since the epoch,
+      or -1 if it does not exist.  */
+  struct Entry
+  {
+    std::string Path;
+    long long MTime;
+  };
+
+  /** Check whether all recorded directories still have the recorded
+      modification times.  A directory modified shortly before it was
+      recorded is never trusted because file systems update directory
+      times with a limited resolution.  */
+  bool IsUpToDate() const;
+
+  void AddEntry(std::string const& path, long long mtime);
+  std::vector<Entry> const& GetEntries() const { return this->Entries; }
+
+  /** Time at which the directories were recorded in nanoseconds.  */
+  long long GetRecordTime() const { return this->RecordTime; }
+  void SetRecordTime(long long t) { this->RecordTime = t; }
+
+  /** Get the modification time of a path as recorded in an entry.  */
+  static long long GetMTime(std::string const& path);
+
+  /** Get the current time in nanoseconds since the epoch.  */
+  static long long Now();
+
+private:
+  std::vector<Entry> Entries;
+  long long RecordTime = 0;
+};
+
+#endif
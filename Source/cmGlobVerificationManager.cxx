@@ -3,9 +3,14 @@
 #include "cmGlobVerificationManager.h"
 
 #include "cmsys/FStream.hxx"
+#include <algorithm>
+#include <errno.h>
+#include <iostream>
 #include <sstream>
+#include <stdlib.h>
 
 #include "cmGeneratedFileStream.h"
+#include "cmGlobWalker.h"
 #include "cmListFileCache.h"
 #include "cmSystemTools.h"
 #include "cmVersion.h"
@@ -19,9 +24,11 @@ bool cmGlobVerificationManager::SaveVerificationScript(const std::string& path)
   std::string scriptFile = path;
   scriptFile += "/CMakeFiles";
   std::string stampFile = scriptFile;
+  std::string cacheFile = scriptFile;
   cmSystemTools::MakeDirectory(scriptFile);
   scriptFile += "/VerifyGlobs.cmake";
   stampFile += "/cmake.verify_globs";
+  cacheFile += "/VerifyGlobs.txt";
   cmGeneratedFileStream verifyScriptFile(scriptFile);
   verifyScriptFile.SetCopyIfDifferent(true);
   if (!verifyScriptFile) {
@@ -69,6 +76,10 @@ bool cmGlobVerificationManager::SaveVerificationScript(const std::string& path)
   }
   verifyScriptFile.Close();
 
+  if (!WriteCacheFile(cacheFile, this->Cache)) {
+    return false;
+  }
+
   cmsys::ofstream verifyStampFile(stampFile.c_str());
   if (!verifyStampFile) {
     cmSystemTools::Error("Unable to open verification stamp file for write. ",
@@ -78,10 +89,158 @@ bool cmGlobVerificationManager::SaveVerificationScript(const std::string& path)
   verifyStampFile << "# This file is generated by CMake for checking of the "
                      "VerifyGlobs.cmake file\n";
   this->VerifyScript = scriptFile;
+  this->VerifyCache = cacheFile;
   this->VerifyStamp = stampFile;
   return true;
 }
 
+static bool cmGlobVerificationParseTime(std::string const& str,
+                                        long long& value)
+{
+  char* end = nullptr;
+  errno = 0;
+  value = strtoll(str.c_str(), &end, 10);
+  return errno == 0 && !str.empty() && *end == '\0';
+}
+
+bool cmGlobVerificationManager::WriteCacheFile(const std::string& cacheFile,
+                                               const CacheEntryMap& cache)
+{
+  cmGeneratedFileStream fout(cacheFile);
+  fout.SetCopyIfDifferent(true);
+  if (!fout) {
+    cmSystemTools::Error("Unable to open glob cache file for save. ",
+                         cacheFile.c_str());
+    cmSystemTools::ReportLastSystemError("");
+    return false;
+  }
+
+  // One "key value" pair per line.  Each glob starts with a "glob" line.
+  fout << "# CMAKE generated file: DO NOT EDIT!\n"
+       << "# Generated by CMake Version " << cmVersion::GetMajorVersion()
+       << "." << cmVersion::GetMinorVersion() << "\n";
+  for (auto const& i : cache) {
+    CacheEntryKey const& k = i.first;
+    CacheEntryValue const& v = i.second;
+    if (!v.Initialized) {
+      continue;
+    }
+    fout << "glob " << k.Recurse << k.ListDirectories << k.FollowSymlinks
+         << "\n";
+    fout << "relative " << k.Relative << "\n";
+    fout << "expression " << k.Expression << "\n";
+    fout << "recorded " << v.Directories.GetRecordTime() << "\n";
+    for (cmGlobDirectories::Entry const& e : v.Directories.GetEntries()) {
+      fout << "directory " << e.MTime << " " << e.Path << "\n";
+    }
+    for (std::string const& file : v.Files) {
+      fout << "file " << file << "\n";
+    }
+  }
+  return fout.Close();
+}
+
+bool cmGlobVerificationManager::ReadCacheFile(const std::string& cacheFile,
+                                              CacheEntryMap& cache)
+{
+  cmsys::ifstream fin(cacheFile.c_str());
+  if (!fin) {
+    return false;
+  }
+
+  std::string line;
+  std::string flags;
+  std::string relative;
+  CacheEntryValue* value = nullptr;
+  while (cmSystemTools::GetLineFromStream(fin, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::string::size_type const pos = line.find(' ');
+    std::string const key = line.substr(0, pos);
+    std::string const arg =
+      pos == std::string::npos ? std::string() : line.substr(pos + 1);
+    if (key == "glob") {
+      if (arg.size() != 3) {
+        return false;
+      }
+      flags = arg;
+      value = nullptr;
+    } else if (key == "relative") {
+      relative = arg;
+    } else if (key == "expression") {
+      if (flags.empty()) {
+        return false;
+      }
+      value = &cache[CacheEntryKey(flags[0] == '1', flags[1] == '1',
+                                   flags[2] == '1', relative, arg)];
+      value->Initialized = true;
+      flags.clear();
+      relative.clear();
+    } else if (value == nullptr) {
+      return false;
+    } else if (key == "recorded") {
+      long long t;
+      if (!cmGlobVerificationParseTime(arg, t)) {
+        return false;
+      }
+      value->Directories.SetRecordTime(t);
+    } else if (key == "directory") {
+      std::string::size_type const sep = arg.find(' ');
+      long long mtime;
+      if (sep == std::string::npos ||
+          !cmGlobVerificationParseTime(arg.substr(0, sep), mtime)) {
+        return false;
+      }
+      value->Directories.AddEntry(arg.substr(sep + 1), mtime);
+    } else if (key == "file") {
+      value->Files.push_back(arg);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool cmGlobVerificationManager::VerifyGlobs(const std::string& cacheFile)
+{
+  std::string const stampFile =
+    cmSystemTools::GetFilenamePath(cacheFile) + "/cmake.verify_globs";
+
+  CacheEntryMap cache;
+  if (!ReadCacheFile(cacheFile, cache)) {
+    // Without the recorded results the build system must be regenerated.
+    std::cout << "-- Unable to read glob cache file " << cacheFile
+              << std::endl;
+    cmSystemTools::Touch(stampFile, false);
+    return true;
+  }
+
+  bool updated = false;
+  for (auto& i : cache) {
+    CacheEntryKey const& k = i.first;
+    CacheEntryValue& v = i.second;
+    if (v.Directories.IsUpToDate()) {
+      continue;
+    }
+
+    cmGlobDirectories directories;
+    if (k.Glob(directories) != v.Files) {
+      std::cout << "-- GLOB mismatch!" << std::endl;
+      cmSystemTools::Touch(stampFile, false);
+      return true;
+    }
+    v.Directories = directories;
+    updated = true;
+  }
+
+  // Keep the new directory times so the next check is fast again.
+  if (updated) {
+    return WriteCacheFile(cacheFile, cache);
+  }
+  return true;
+}
+
 bool cmGlobVerificationManager::DoWriteVerifyTarget() const
 {
   return !this->VerifyScript.empty() && !this->VerifyStamp.empty();
@@ -138,17 +297,36 @@ void cmGlobVerificationManager::CacheEntryKey::PrintGlobCommand(
   out << "\"" << this->Expression << "\")";
 }
 
+std::vector<std::string> cmGlobVerificationManager::CacheEntryKey::Glob(
+  cmGlobDirectories& directories) const
+{
+  cmGlobWalker g;
+  g.SetRecurse(this->Recurse);
+  g.SetListDirs(this->ListDirectories);
+  g.SetRecurseListDirs(this->ListDirectories);
+  g.SetRecurseThroughSymlinks(this->FollowSymlinks);
+  g.SetRelative(this->Relative);
+  g.SetRecordDirectories(&directories);
+  g.FindFiles(this->Expression);
+
+  // Compare the results as recorded by file(GLOB).
+  std::vector<std::string>& files = g.GetFiles();
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+  return files;
+}
+
 void cmGlobVerificationManager::AddCacheEntry(
   const bool recurse, const bool listDirectories, const bool followSymlinks,
   const std::string& relative, const std::string& expression,
-  const std::vector<std::string>& files, const std::string& variable,
-  const cmListFileBacktrace& backtrace)
+  const std::vector<std::string>& files, const cmGlobDirectories& directories,
+  const std::string& variable, const cmListFileBacktrace& backtrace)
 {
   CacheEntryKey key = CacheEntryKey(recurse, listDirectories, followSymlinks,
                                     relative, expression);
   CacheEntryValue& value = this->Cache[key];
   if (!value.Initialized) {
     value.Files = files;
+    value.Directories = directories;
     value.Initialized = true;
     value.Backtraces.emplace_back(variable, backtrace);
   } else if (value.Initialized && value.Files != files) {
@@ -174,5 +352,6 @@ void cmGlobVerificationManager::Reset()
 {
   this->Cache.clear();
   this->VerifyScript.clear();
+  this->VerifyCache.clear();
   this->VerifyStamp.clear();
 }
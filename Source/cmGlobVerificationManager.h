@@ -5,6 +5,7 @@
 
 #include "cmConfigure.h" // IWYU pragma: keep
 
+#include "cmGlobDirectories.h"
 #include "cmListFileCache.h"
 
 #include <iosfwd>
@@ -17,10 +18,17 @@
  * \brief Class for expressing build-time dependencies on glob expressions.
  *
  * Generates a CMake script which verifies glob outputs during prebuild.
+ * The generated build systems use a native verifier instead which only
+ * evaluates a glob again when a directory it lists has been modified.
  *
  */
 class cmGlobVerificationManager
 {
+public:
+  ///! Verify the globs recorded in the given cache file and touch the
+  ///! verification stamp next to it if any of their results changed.
+  static bool VerifyGlobs(const std::string& cacheFile);
+
 protected:
   ///! Save verification script for given makefile.
   ///! Saves to output <path>/<CMakeFilesDirectory>/VerifyGlobs.cmake
@@ -31,6 +39,7 @@ protected:
                      const std::string& relative,
                      const std::string& expression,
                      const std::vector<std::string>& files,
+                     const cmGlobDirectories& directories,
                      const std::string& variable,
                      const cmListFileBacktrace& bt);
 
@@ -40,8 +49,9 @@ protected:
   ///! Check targets should be written in generated build system.
   bool DoWriteVerifyTarget() const;
 
-  ///! Get the paths to the generated script and stamp files
+  ///! Get the paths to the generated script, cache and stamp files
   std::string const& GetVerifyScript() const { return this->VerifyScript; }
+  std::string const& GetVerifyCache() const { return this->VerifyCache; }
   std::string const& GetVerifyStamp() const { return this->VerifyStamp; }
 
 private:
@@ -63,18 +73,27 @@ private:
     }
     bool operator<(const CacheEntryKey& r) const;
     void PrintGlobCommand(std::ostream& out, const std::string& cmdVar);
+    std::vector<std::string> Glob(cmGlobDirectories& directories) const;
   };
 
   struct CacheEntryValue
   {
     bool Initialized = false;
     std::vector<std::string> Files;
+    cmGlobDirectories Directories;
     std::vector<std::pair<std::string, cmListFileBacktrace>> Backtraces;
   };
 
   typedef std::map<CacheEntryKey, CacheEntryValue> CacheEntryMap;
+
+  static bool WriteCacheFile(const std::string& cacheFile,
+                             const CacheEntryMap& cache);
+  static bool ReadCacheFile(const std::string& cacheFile,
+                            CacheEntryMap& cache);
+
   CacheEntryMap Cache;
   std::string VerifyScript;
+  std::string VerifyCache;
   std::string VerifyStamp;
 
   // Only cmState should be able to add cache values.
@@ -0,0 +1,521 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmGlobWalker.h"
+
+#include "cmAlgorithms.h"
+#include "cmGlobDirectories.h"
+
+#include "cmsys/RegularExpression.hxx"
+#include "cmsys/SystemTools.hxx"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// The bootstrap build does not link to a thread library.
+#ifdef CMAKE_BUILD_WITH_CMAKE
+#  include <thread>
+#endif
+
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#  include "cm_sys_stat.h"
+#  include <dirent.h>
+#else
+#  include "cmsys/Directory.hxx"
+#endif
+
+// Match file names the same way cmsys::Glob does.
+#if defined(_WIN32) || defined(__APPLE__) || defined(__CYGWIN__)
+#  define cmGlobWalker_CASE_INDEPENDENT
+#endif
+
+namespace {
+
+// Number of pending directories after which more threads are started.
+const std::size_t cmGlobWalkerThreadThreshold = 8;
+
+/** One component of a glob expression.  Components with bracket
+    expressions are matched by the regular expression cmsys::Glob uses
+    for them.  All others only contain literal characters, '*' and '?'
+    and are matched directly.  */
+class cmGlobComponent
+{
+public:
+  explicit cmGlobComponent(std::string const& pattern)
+  {
+    if (pattern.find('[') != std::string::npos) {
+      this->UseRegex = true;
+      this->Regex.compile(cmsys::Glob::PatternToRegex(pattern));
+    } else {
+      this->Pattern = pattern;
+#if defined(cmGlobWalker_CASE_INDEPENDENT)
+      // Only letters are converted, like cmsys::Glob::PatternToRegex.
+      for (char& c : this->Pattern) {
+        if ('A' <= c && c <= 'Z') {
+          c = static_cast<char>(c - 'A' + 'a');
+        }
+      }
+#endif
+    }
+  }
+
+  // The regular expression keeps match state so each thread needs its
+  // own copy of a component.
+  bool Match(std::string const& name)
+  {
+    if (this->UseRegex) {
+      return this->Regex.find(name);
+    }
+    return MatchWildcards(this->Pattern, name);
+  }
+
+private:
+  static bool MatchWildcards(std::string const& p, std::string const& n)
+  {
+    std::string::size_type pi = 0;
+    std::string::size_type ni = 0;
+    std::string::size_type starP = std::string::npos;
+    std::string::size_type starN = 0;
+    while (ni < n.size()) {
+      if (pi < p.size() && p[pi] == '*') {
+        starP = pi++;
+        starN = ni;
+      } else if (pi < p.size() &&
+                 (p[pi] == n[ni] || (p[pi] == '?' && n[ni] != '/'))) {
+        ++pi;
+        ++ni;
+      } else if (starP != std::string::npos && n[starN] != '/') {
+        // Let the last '*' match one more character.
+        pi = starP + 1;
+        ni = ++starN;
+      } else {
+        return false;
+      }
+    }
+    while (pi < p.size() && p[pi] == '*') {
+      ++pi;
+    }
+    return pi == p.size();
+  }
+
+  bool UseRegex = false;
+  std::string Pattern;
+  cmsys::RegularExpression Regex;
+};
+
+/** An entry of a directory listing.  */
+struct cmGlobEntry
+{
+  std::string Name;
+  std::string Path;
+  bool IsDirectory;
+  bool IsSymlink;
+};
+
+bool cmGlobListDirectory(std::string const& dir,
+                         std::vector<cmGlobEntry>& entries)
+{
+  std::string const prefix = dir.back() == '/' ? dir : dir + "/";
+#if !defined(_WIN32) || defined(__CYGWIN__)
+  DIR* d = opendir(dir.c_str());
+  if (!d) {
+    return false;
+  }
+  while (struct dirent* ent = readdir(d)) {
+    cmGlobEntry e;
+    e.Name = ent->d_name;
+    if (e.Name == "." || e.Name == "..") {
+      continue;
+    }
+    e.Path = prefix + e.Name;
+    e.IsDirectory = false;
+    e.IsSymlink = false;
+    struct stat st;
+#  if defined(DT_DIR) && defined(DT_LNK) && defined(DT_UNKNOWN)
+    // Avoid a stat call for each entry when the type is already known.
+    if (ent->d_type == DT_DIR) {
+      e.IsDirectory = true;
+    } else if (ent->d_type == DT_LNK) {
+      e.IsSymlink = true;
+      e.IsDirectory = stat(e.Path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    } else if (ent->d_type == DT_UNKNOWN)
+#  endif
+    {
+      if (lstat(e.Path.c_str(), &st) == 0) {
+        if (S_ISLNK(st.st_mode)) {
+          e.IsSymlink = true;
+          e.IsDirectory =
+            stat(e.Path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+        } else {
+          e.IsDirectory = S_ISDIR(st.st_mode);
+        }
+      }
+    }
+    entries.push_back(std::move(e));
+  }
+  closedir(d);
+#else
+  cmsys::Directory d;
+  if (!d.Load(dir)) {
+    return false;
+  }
+  for (unsigned long i = 0; i < d.GetNumberOfFiles(); ++i) {
+    cmGlobEntry e;
+    e.Name = d.GetFile(i);
+    if (e.Name == "." || e.Name == "..") {
+      continue;
+    }
+    e.Path = prefix + e.Name;
+    e.IsDirectory = cmsys::SystemTools::FileIsDirectory(e.Path);
+    e.IsSymlink = cmsys::SystemTools::FileIsSymlink(e.Path);
+    entries.push_back(std::move(e));
+  }
+#endif
+  return true;
+}
+}
+
+class cmGlobWalker::Walk
+{
+public:
+  struct Item
+  {
+    std::string Dir;
+    std::vector<cmGlobComponent>::size_type Start;
+    std::vector<std::string> VisitedSymlinks;
+  };
+
+  Walk(cmGlobWalker& walker, std::vector<cmGlobComponent> const& components,
+       unsigned int threads)
+    : Walker(walker)
+    , Last(components.size() - 1)
+  {
+    for (unsigned int i = 0; i < threads; ++i) {
+      this->Workers.push_back(cm::make_unique<Worker>());
+      this->Workers.back()->Components = components;
+    }
+  }
+
+  void Run(Item root, cmsys::Glob::GlobMessages* messages);
+
+private:
+  struct Worker
+  {
+    std::mutex Mutex;
+    std::deque<Item> Queue;
+    std::vector<cmGlobComponent> Components;
+    std::vector<std::string> Files;
+    std::vector<cmGlobDirectories::Entry> Directories;
+    cmsys::Glob::GlobMessages Messages;
+  };
+
+  void Work(std::size_t index);
+  void Push(Worker& w, Item item);
+  bool Pop(std::size_t index, Item& item);
+  void Process(Worker& w, Item const& item);
+  void AddFile(Worker& w, std::string const& file);
+
+  cmGlobWalker& Walker;
+  std::vector<cmGlobComponent>::size_type const Last;
+  std::vector<std::unique_ptr<Worker>> Workers;
+#ifdef CMAKE_BUILD_WITH_CMAKE
+  std::vector<std::thread> Threads;
+#endif
+  std::atomic<std::size_t> Pending{ 0 };
+  std::atomic<unsigned int> FollowedSymlinks{ 0 };
+  std::atomic<bool> Failed{ false };
+};
+
+void cmGlobWalker::Walk::Run(Item root, cmsys::Glob::GlobMessages* messages)
+{
+  this->Push(*this->Workers[0], std::move(root));
+  this->Work(0);
+#ifdef CMAKE_BUILD_WITH_CMAKE
+  for (std::thread& t : this->Threads) {
+    t.join();
+  }
+#endif
+
+  // Merge the results of all threads in a deterministic order.
+  std::vector<std::string>& files = this->Walker.Files;
+  cmsys::Glob::GlobMessages allMessages;
+  std::vector<cmGlobDirectories::Entry> directories;
+  for (std::unique_ptr<Worker> const& w : this->Workers) {
+    files.insert(files.end(), w->Files.begin(), w->Files.end());
+    allMessages.insert(allMessages.end(), w->Messages.begin(),
+                       w->Messages.end());
+    directories.insert(directories.end(), w->Directories.begin(),
+                       w->Directories.end());
+  }
+  std::sort(files.begin(), files.end());
+  if (messages) {
+    std::sort(allMessages.begin(), allMessages.end(),
+              [](cmsys::Glob::Message const& l,
+                 cmsys::Glob::Message const& r) {
+                return l.content < r.content;
+              });
+    messages->insert(messages->end(), allMessages.begin(), allMessages.end());
+  }
+  if (cmGlobDirectories* dirs = this->Walker.RecordDirectories) {
+    std::sort(directories.begin(), directories.end(),
+              [](cmGlobDirectories::Entry const& l,
+                 cmGlobDirectories::Entry const& r) {
+                return l.Path < r.Path;
+              });
+    for (cmGlobDirectories::Entry const& e : directories) {
+      dirs->AddEntry(e.Path, e.MTime);
+    }
+  }
+  this->Walker.FollowedSymlinkCount += this->FollowedSymlinks;
+}
+
+void cmGlobWalker::Walk::Work(std::size_t index)
+{
+  Worker& w = *this->Workers[index];
+  Item item;
+  while (!this->Failed) {
+    if (!this->Pop(index, item)) {
+      if (this->Pending == 0) {
+        break;
+      }
+#ifdef CMAKE_BUILD_WITH_CMAKE
+      std::this_thread::yield();
+#endif
+      continue;
+    }
+    this->Process(w, item);
+    --this->Pending;
+
+#ifdef CMAKE_BUILD_WITH_CMAKE
+    // The first thread starts the others once there is enough work.
+    if (index == 0 && this->Threads.empty() && this->Workers.size() > 1) {
+      std::size_t queued;
+      {
+        std::lock_guard<std::mutex> lock(w.Mutex);
+        queued = w.Queue.size();
+      }
+      if (queued >= cmGlobWalkerThreadThreshold) {
+        for (std::size_t i = 1; i < this->Workers.size(); ++i) {
+          this->Threads.emplace_back(&Walk::Work, this, i);
+        }
+      }
+    }
+#endif
+  }
+}
+
+void cmGlobWalker::Walk::Push(Worker& w, Item item)
+{
+  ++this->Pending;
+  std::lock_guard<std::mutex> lock(w.Mutex);
+  w.Queue.push_back(std::move(item));
+}
+
+bool cmGlobWalker::Walk::Pop(std::size_t index, Item& item)
+{
+  // Continue with the most recent directory of this thread.
+  {
+    Worker& w = *this->Workers[index];
+    std::lock_guard<std::mutex> lock(w.Mutex);
+    if (!w.Queue.empty()) {
+      item = std::move(w.Queue.back());
+      w.Queue.pop_back();
+      return true;
+    }
+  }
+
+  // Steal the oldest directory of another thread.
+  for (std::size_t i = 1; i < this->Workers.size(); ++i) {
+    Worker& other = *this->Workers[(index + i) % this->Workers.size()];
+    std::lock_guard<std::mutex> lock(other.Mutex);
+    if (!other.Queue.empty()) {
+      item = std::move(other.Queue.front());
+      other.Queue.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void cmGlobWalker::Walk::AddFile(Worker& w, std::string const& file)
+{
+  if (!this->Walker.Relative.empty()) {
+    w.Files.push_back(
+      cmsys::SystemTools::RelativePath(this->Walker.Relative, file));
+  } else {
+    w.Files.push_back(file);
+  }
+}
+
+void cmGlobWalker::Walk::Process(Worker& w, Item const& item)
+{
+  if (this->Walker.RecordDirectories) {
+    w.Directories.push_back(cmGlobDirectories::Entry{
+      item.Dir, cmGlobDirectories::GetMTime(item.Dir) });
+  }
+
+  std::vector<cmGlobEntry> entries;
+  if (!cmGlobListDirectory(item.Dir, entries)) {
+    return;
+  }
+
+  bool const last = item.Start == this->Last;
+  cmGlobComponent& component = w.Components[item.Start];
+  bool const recurse = last && this->Walker.Recurse;
+  std::string canonicalPath;
+  for (cmGlobEntry& e : entries) {
+#if defined(cmGlobWalker_CASE_INDEPENDENT)
+    e.Name = cmsys::SystemTools::LowerCase(e.Name);
+#endif
+
+    if (!recurse) {
+      // Match one component of the expression, as
+      // cmsys::Glob::ProcessDirectory does.
+      if ((!last && !e.IsDirectory) ||
+          (last && e.IsDirectory && !this->Walker.ListDirs)) {
+        continue;
+      }
+      if (component.Match(e.Name)) {
+        if (last) {
+          this->AddFile(w, e.Path);
+        } else {
+          this->Push(w, Item{ e.Path, item.Start + 1, item.VisitedSymlinks });
+        }
+      }
+      continue;
+    }
+
+    // Match all files below the directory, as
+    // cmsys::Glob::RecurseDirectory does.
+    if (!e.IsDirectory ||
+        (e.IsSymlink && !this->Walker.RecurseThroughSymlinks)) {
+      if (component.Match(e.Name)) {
+        this->AddFile(w, e.Path);
+      }
+      continue;
+    }
+    if (!e.IsSymlink) {
+      if (this->Walker.RecurseListDirs) {
+        this->AddFile(w, e.Path);
+      }
+      this->Push(w, Item{ e.Path, item.Start, item.VisitedSymlinks });
+      continue;
+    }
+
+    ++this->FollowedSymlinks;
+    if (canonicalPath.empty()) {
+      std::string realPathErrorMessage;
+      canonicalPath =
+        cmsys::SystemTools::GetRealPath(item.Dir, &realPathErrorMessage);
+      if (!realPathErrorMessage.empty()) {
+        w.Messages.push_back(cmsys::Glob::Message(
+          cmsys::Glob::error,
+          "Canonical path generation from path '" + item.Dir +
+            "' failed! Reason: '" + realPathErrorMessage + "'"));
+        this->Failed = true;
+        return;
+      }
+    }
+    std::vector<std::string>::const_iterator visited =
+      std::find(item.VisitedSymlinks.begin(), item.VisitedSymlinks.end(),
+                canonicalPath);
+    if (visited == item.VisitedSymlinks.end()) {
+      if (this->Walker.RecurseListDirs) {
+        // symlinks are treated as directories
+        this->AddFile(w, e.Path);
+      }
+      Item sub{ e.Path, item.Start, item.VisitedSymlinks };
+      sub.VisitedSymlinks.push_back(canonicalPath);
+      this->Push(w, std::move(sub));
+    } else {
+      // We have already visited this symlink: prevent cyclic recursion.
+      std::string message;
+      for (; visited != item.VisitedSymlinks.end(); ++visited) {
+        message += *visited + "\n";
+      }
+      message += canonicalPath + "/" + e.Name;
+      w.Messages.push_back(
+        cmsys::Glob::Message(cmsys::Glob::cyclicRecursion, message));
+    }
+  }
+}
+
+bool cmGlobWalker::FindFiles(const std::string& inexpr,
+                             cmsys::Glob::GlobMessages* messages)
+{
+  this->Files.clear();
+  if (this->RecordDirectories &&
+      this->RecordDirectories->GetRecordTime() == 0) {
+    this->RecordDirectories->SetRecordTime(cmGlobDirectories::Now());
+  }
+
+  std::string expr = inexpr;
+  if (!cmsys::SystemTools::FileIsFullPath(expr)) {
+    expr = cmsys::SystemTools::GetCurrentWorkingDirectory();
+    expr += "/" + inexpr;
+  }
+
+  // Split the expression as cmsys::Glob::FindFiles does: the part before
+  // the last slash preceding the first wildcard is never listed.
+  std::string::size_type skip = 0;
+  for (std::string::size_type cc = 0; cc < expr.size(); ++cc) {
+    if (cc > 0 && expr[cc] == '/' && expr[cc - 1] != '\\') {
+      skip = cc;
+    }
+    if (cc > 0 && (expr[cc] == '[' || expr[cc] == '?' || expr[cc] == '*') &&
+        expr[cc - 1] != '\\') {
+      break;
+    }
+  }
+  if (skip == 0) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    if (expr.size() > 1 && expr[0] == '/' && expr[1] == '/') {
+      // Network path: the server and share are never listed.
+      int cnt = 0;
+      std::string::size_type cc;
+      for (cc = 2; cc < expr.size(); ++cc) {
+        if (expr[cc] == '/' && ++cnt == 2) {
+          break;
+        }
+      }
+      skip = cc + 1;
+    } else
+#endif
+      if (expr.size() > 1 && expr[1] == ':' && expr[0] != '/') {
+      skip = 2;
+    }
+  }
+
+  std::vector<cmGlobComponent> components;
+  std::string component;
+  for (std::string::size_type cc = skip; cc <= expr.size(); ++cc) {
+    if (cc == expr.size() || expr[cc] == '/') {
+      if (!component.empty()) {
+        components.emplace_back(component);
+      }
+      component.clear();
+    } else {
+      component += expr[cc];
+    }
+  }
+  if (components.empty()) {
+    return true;
+  }
+
+  unsigned int threads = 1;
+#ifdef CMAKE_BUILD_WITH_CMAKE
+  threads = this->Threads;
+  if (threads == 0) {
+    threads = std::min(std::max(std::thread::hardware_concurrency(), 1u), 8u);
+  }
+#endif
+
+  Walk walk(*this, components, threads);
+  walk.Run(
+    Walk::Item{ (skip > 0 ? expr.substr(0, skip) : std::string()) + "/", 0,
+                std::vector<std::string>() },
+    messages);
+  return true;
+}
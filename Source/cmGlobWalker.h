@@ -0,0 +1,91 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmGlobWalker_h
+#define cmGlobWalker_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include "cmsys/Glob.hxx"
+#include <string>
+#include <vector>
+
+class cmGlobDirectories;
+
+/** \class cmGlobWalker
+ * \brief Find files matching a glob expression using several threads.
+ *
+ * This finds the same files as cmsys::Glob with the same settings but
+ * lists the directories of large trees concurrently.  Each thread
+ * walks the directories it discovers depth first and idle threads
+ * steal the oldest pending directories of the others.  Entry types
+ * are taken from the directory listing where the platform provides
+ * them and expression components without bracket expressions are
+ * matched without regular expressions.  The resulting list of files
+ * is sorted so that it does not depend on the order of the walk.
+ */
+class cmGlobWalker
+{
+public:
+  //! Find all files that match the pattern.
+  bool FindFiles(const std::string& inexpr,
+                 cmsys::Glob::GlobMessages* messages = nullptr);
+
+  //! Return the sorted list of files that matched.
+  std::vector<std::string>& GetFiles() { return this->Files; }
+
+  //! Set recurse to true to match subdirectories.
+  void SetRecurse(bool i) { this->Recurse = i; }
+  bool GetRecurse() const { return this->Recurse; }
+
+  //! Set recurse through symlinks to true if recursion should traverse the
+  // linked-to directories
+  void RecurseThroughSymlinksOn() { this->SetRecurseThroughSymlinks(true); }
+  void RecurseThroughSymlinksOff() { this->SetRecurseThroughSymlinks(false); }
+  void SetRecurseThroughSymlinks(bool i) { this->RecurseThroughSymlinks = i; }
+  bool GetRecurseThroughSymlinks() const
+  {
+    return this->RecurseThroughSymlinks;
+  }
+
+  //! Get the number of symlinks followed through recursion
+  unsigned int GetFollowedSymlinkCount() const
+  {
+    return this->FollowedSymlinkCount;
+  }
+
+  //! Set the directory relative to which files are reported.
+  void SetRelative(const std::string& dir) { this->Relative = dir; }
+  std::string const& GetRelative() const { return this->Relative; }
+
+  //! Enable listing of directories in non-recursive and recursive mode.
+  void SetListDirs(bool list) { this->ListDirs = list; }
+  bool GetListDirs() const { return this->ListDirs; }
+  void SetRecurseListDirs(bool list) { this->RecurseListDirs = list; }
+  bool GetRecurseListDirs() const { return this->RecurseListDirs; }
+
+  /** Record every directory listed by FindFiles in the given object,
+      before it is listed.  */
+  void SetRecordDirectories(cmGlobDirectories* dirs)
+  {
+    this->RecordDirectories = dirs;
+  }
+
+  //! Set the number of threads used to walk directories.  By default
+  // this depends on the number of processors.
+  void SetThreads(unsigned int n) { this->Threads = n; }
+
+private:
+  class Walk;
+
+  bool Recurse = false;
+  bool RecurseThroughSymlinks = true;
+  bool ListDirs = true;
+  bool RecurseListDirs = false;
+  unsigned int FollowedSymlinkCount = 0;
+  unsigned int Threads = 0;
+  std::string Relative;
+  cmGlobDirectories* RecordDirectories = nullptr;
+  std::vector<std::string> Files;
+};
+
+#endif
@@ -1383,8 +1383,8 @@ void cmGlobalNinjaGenerator::WriteTargetRebuildManifest(std::ostream& os)
     std::ostringstream verify_cmd;
     verify_cmd << lg->ConvertToOutputFormat(cmSystemTools::GetCMakeCommand(),
                                             cmOutputConverter::SHELL)
-               << " -P "
-               << lg->ConvertToOutputFormat(cm->GetGlobVerifyScript(),
+               << " -E cmake_verify_globs "
+               << lg->ConvertToOutputFormat(cm->GetGlobVerifyCache(),
                                             cmOutputConverter::SHELL);
 
     WriteRule(*this->RulesFileStream, "VERIFY_GLOBS", verify_cmd.str(),
@@ -147,13 +147,14 @@ bool cmGlobalVisualStudio8Generator::AddCheckTarget()
                        lmf->GetListFiles().end());
     }
 
-    // Add a custom prebuild target to run the VerifyGlobs script.
+    // Add a custom prebuild target to verify the globs.
     cmake* cm = this->GetCMakeInstance();
     if (cm->DoWriteGlobVerifyTarget()) {
       cmCustomCommandLine verifyCommandLine;
       verifyCommandLine.push_back(cmSystemTools::GetCMakeCommand());
-      verifyCommandLine.push_back("-P");
-      verifyCommandLine.push_back(cm->GetGlobVerifyScript());
+      verifyCommandLine.push_back("-E");
+      verifyCommandLine.push_back("cmake_verify_globs");
+      verifyCommandLine.push_back(cm->GetGlobVerifyCache());
       cmCustomCommandLines verifyCommandLines;
       verifyCommandLines.push_back(verifyCommandLine);
       std::vector<std::string> byproducts;
@@ -0,0 +1,211 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmInstallHashManifest.h"
+
+#include "cmCryptoHash.h"
+#include "cmGeneratedFileStream.h"
+#include "cmSystemTools.h"
+
+#include "cmsys/FStream.hxx"
+#include <map>
+#include <memory>
+#include <sstream>
+#include <utility>
+
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#  include "cm_sys_stat.h"
+#else
+#  include "cmsys/Encoding.hxx"
+#  include <windows.h>
+#endif
+
+cmInstallHashManifest& cmInstallHashManifest::Get(std::string const& path)
+{
+  static std::map<std::string, std::unique_ptr<cmInstallHashManifest>>
+    manifests;
+  std::unique_ptr<cmInstallHashManifest>& manifest = manifests[path];
+  if (!manifest) {
+    manifest.reset(new cmInstallHashManifest(path));
+    manifest->Load();
+  }
+  return *manifest;
+}
+
+cmInstallHashManifest::cmInstallHashManifest(std::string path)
+  : Path(std::move(path))
+{
+  // The hash library is initialized on first use.  Do that here, before
+  // threads copying files compute entries.
+  cmCryptoHash init(cmCryptoHash::AlgoSHA256, cmCryptoHash::BackendPortable);
+  static_cast<void>(init);
+}
+
+void cmInstallHashManifest::Load()
+{
+  cmsys::ifstream fin(this->Path.c_str(), std::ios::in | std::ios::binary);
+  if (!fin) {
+    return;
+  }
+
+  // Each line has the installed size and time, the source size and hash,
+  // and the installed file.  Lines not in this form are ignored.
+  size_t lines = 0;
+  std::string line;
+  while (cmSystemTools::GetLineFromStream(fin, line)) {
+    ++lines;
+    std::istringstream ls(line);
+    Entry entry;
+    std::string installed;
+    if (ls >> entry.InstalledSize >> entry.InstalledTime >>
+          entry.SourceSize >> entry.SourceHash &&
+        ls.get() == ' ' && std::getline(ls, installed) &&
+        entry.SourceHash.size() == 64 && !installed.empty()) {
+      this->Entries[installed] = entry;
+    }
+  }
+  fin.close();
+
+  // Replace an old manifest that is mostly made of outdated entries.
+  if (lines > 2 * this->Entries.size() + 100) {
+    cmGeneratedFileStream fout(this->Path);
+    for (auto const& e : this->Entries) {
+      fout << e.second.InstalledSize << ' ' << e.second.InstalledTime << ' '
+           << e.second.SourceSize << ' ' << e.second.SourceHash << ' '
+           << e.first << '\n';
+    }
+  }
+}
+
+bool cmInstallHashManifest::IsUnchanged(std::string const& source,
+                                        std::string const& installed)
+{
+  Entry const* entry = this->Find(installed);
+  if (!entry) {
+    return false;
+  }
+  // Compare the sizes first to hash only likely matches.
+  unsigned long long size;
+  long long time;
+  if (!GetFileState(source, size, time) || size != entry->SourceSize) {
+    return false;
+  }
+  cmCryptoHash sha256(cmCryptoHash::AlgoSHA256);
+  return sha256.HashFile(source) == entry->SourceHash;
+}
+
+void cmInstallHashManifest::Refresh(std::string const& installed)
+{
+  auto i = this->Entries.find(installed);
+  if (i == this->Entries.end()) {
+    return;
+  }
+  Entry entry = i->second;
+  if (GetFileState(installed, entry.InstalledSize, entry.InstalledTime)) {
+    this->Add(installed, entry);
+  }
+}
+
+bool cmInstallHashManifest::ComputeEntry(std::string const& source,
+                                         std::string const& installed,
+                                         Entry& entry)
+{
+  long long sourceTime;
+  if (!GetFileState(source, entry.SourceSize, sourceTime) ||
+      !GetFileState(installed, entry.InstalledSize, entry.InstalledTime)) {
+    return false;
+  }
+  cmCryptoHash sha256(cmCryptoHash::AlgoSHA256);
+  entry.SourceHash = sha256.HashFile(source);
+  return !entry.SourceHash.empty();
+}
+
+void cmInstallHashManifest::Add(std::string const& installed,
+                                Entry const& entry)
+{
+  // Paths with line breaks cannot be stored.
+  if (installed.find_first_of("\r\n") != std::string::npos) {
+    return;
+  }
+  this->Entries[installed] = entry;
+
+  std::ostringstream line;
+  line << entry.InstalledSize << ' ' << entry.InstalledTime << ' '
+       << entry.SourceSize << ' ' << entry.SourceHash << ' ' << installed
+       << '\n';
+  this->Unsaved += line.str();
+}
+
+bool cmInstallHashManifest::Contains(std::string const& installed) const
+{
+  return this->Find(installed) != nullptr;
+}
+
+bool cmInstallHashManifest::Save()
+{
+  if (this->Unsaved.empty()) {
+    return true;
+  }
+  cmSystemTools::MakeDirectory(cmSystemTools::GetFilenamePath(this->Path));
+
+  // Append all lines in one write so that concurrent installations do
+  // not interleave them.
+  cmsys::ofstream fout(this->Path.c_str(),
+                       std::ios::out | std::ios::app | std::ios::binary);
+  fout.write(this->Unsaved.data(),
+             static_cast<std::streamsize>(this->Unsaved.size()));
+  fout.flush();
+  this->Unsaved.clear();
+  return static_cast<bool>(fout);
+}
+
+cmInstallHashManifest::Entry const* cmInstallHashManifest::Find(
+  std::string const& installed) const
+{
+  auto i = this->Entries.find(installed);
+  if (i == this->Entries.end()) {
+    return nullptr;
+  }
+  unsigned long long size;
+  long long time;
+  if (!GetFileState(installed, size, time) ||
+      size != i->second.InstalledSize || time != i->second.InstalledTime) {
+    return nullptr;
+  }
+  return &i->second;
+}
+
+bool cmInstallHashManifest::GetFileState(std::string const& path,
+                                         unsigned long long& size,
+                                         long long& time)
+{
+#if !defined(_WIN32) || defined(__CYGWIN__)
+  long long const bil = 1000000000;
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  size = static_cast<unsigned long long>(st.st_size);
+#  if CMake_STAT_HAS_ST_MTIM
+  time = st.st_mtim.tv_sec * bil + st.st_mtim.tv_nsec;
+#  elif CMake_STAT_HAS_ST_MTIMESPEC
+  time = st.st_mtimespec.tv_sec * bil + st.st_mtimespec.tv_nsec;
+#  else
+  time = st.st_mtime * bil;
+#  endif
+#else
+  WIN32_FILE_ATTRIBUTE_DATA fdata;
+  if (!GetFileAttributesExW(cmsys::Encoding::ToWide(path).c_str(),
+                            GetFileExInfoStandard, &fdata) ||
+      (fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+    return false;
+  }
+  size = (static_cast<unsigned long long>(fdata.nFileSizeHigh) << 32) |
+    fdata.nFileSizeLow;
+  // Times are in 100ns intervals.
+  LARGE_INTEGER t;
+  t.LowPart = fdata.ftLastWriteTime.dwLowDateTime;
+  t.HighPart = fdata.ftLastWriteTime.dwHighDateTime;
+  time = t.QuadPart * 100;
+#endif
+  return true;
+}
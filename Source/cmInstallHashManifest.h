@@ -0,0 +1,74 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmInstallHashManifest_h
+#define cmInstallHashManifest_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <string>
+#include <unordered_map>
+
+/** \class cmInstallHashManifest
+ * \brief Content hashes of installed files, kept across installations
+ *
+ * file(INSTALL) records the size and hash of each source file it copies,
+ * together with the size and time of the installed copy.  When a later
+ * installation finds a source with a new time but the same content, and
+ * the installed copy is still in the recorded state, the copy is kept.
+ * This includes changes made after copying that keep the file time, such
+ * as a new runtime path.
+ *
+ * The manifest file is only appended to, so several processes may
+ * install at the same time.  Later entries replace earlier ones.  An
+ * entry lost to a race only means that a file is copied again.
+ */
+class cmInstallHashManifest
+{
+public:
+  struct Entry
+  {
+    unsigned long long SourceSize = 0;
+    std::string SourceHash;
+    unsigned long long InstalledSize = 0;
+    long long InstalledTime = -1;
+  };
+
+  /** Get the manifest stored in the given file.  It is loaded on first
+      use and then kept for the rest of the process.  */
+  static cmInstallHashManifest& Get(std::string const& path);
+
+  /** Whether the installed file is still in the recorded state and its
+      source has the same content as the file it was copied from.  */
+  bool IsUnchanged(std::string const& source, std::string const& installed);
+
+  /** Record the new time of an installed file found unchanged.  */
+  void Refresh(std::string const& installed);
+
+  /** Compute the entry for an installed copy of the source.  This does
+      not use the manifest, so several threads may call it.  */
+  static bool ComputeEntry(std::string const& source,
+                           std::string const& installed, Entry& entry);
+
+  /** Record the entry for an installed file.  */
+  void Add(std::string const& installed, Entry const& entry);
+
+  /** Whether the installed file has an entry matching its state.  */
+  bool Contains(std::string const& installed) const;
+
+  /** Append the entries recorded since the last call to the file.  */
+  bool Save();
+
+private:
+  cmInstallHashManifest(std::string path);
+
+  void Load();
+  Entry const* Find(std::string const& installed) const;
+  static bool GetFileState(std::string const& path, unsigned long long& size,
+                           long long& time);
+
+  std::string Path;
+  std::unordered_map<std::string, Entry> Entries;
+  std::string Unsaved;
+};
+
+#endif
@@ -35,6 +35,8 @@
 // Include dependency scanners for supported languages.  Only the
 // C/C++ scanner is needed for bootstrapping CMake.
 #include "cmDependsC.h"
+#include "cmDependsCSharedCache.h"
+#include "cmDependsCompiler.h"
 #ifdef CMAKE_BUILD_WITH_CMAKE
 #  include "cmDependsFortran.h"
 #  include "cmDependsJava.h"
@@ -763,8 +765,8 @@ void cmLocalUnixMakefileGenerator3::WriteSpecialTargetsBottom(
     std::vector<std::string> commands;
     cmake* cm = this->GlobalGenerator->GetCMakeInstance();
     if (cm->DoWriteGlobVerifyTarget()) {
-      std::string rescanRule = "$(CMAKE_COMMAND) -P ";
-      rescanRule += this->ConvertToOutputFormat(cm->GetGlobVerifyScript(),
+      std::string rescanRule = "$(CMAKE_COMMAND) -E cmake_verify_globs ";
+      rescanRule += this->ConvertToOutputFormat(cm->GetGlobVerifyCache(),
                                                 cmOutputConverter::SHELL);
       commands.push_back(rescanRule);
     }
@@ -1308,6 +1310,26 @@ bool cmLocalUnixMakefileGenerator3::UpdateDependencies(
     }
   }
 
+  // If the compiler wrote new dependency files since depend.internal
+  // was written they must be consolidated into depend.make.
+  bool needRescanDepfiles = false;
+  {
+    std::vector<std::string> langs;
+    cmSystemTools::ExpandListArgument(
+      this->Makefile->GetSafeDefinition("CMAKE_DEPENDS_LANGUAGES"), langs);
+    for (std::string const& lang : langs) {
+      if (this->Makefile->IsOn("CMAKE_" + lang + "_DEPENDS_USE_COMPILER")) {
+        cmDependsCompiler depfiles(this, dir, internalDependFile, nullptr);
+        depfiles.SetVerbose(verbose);
+        depfiles.SetFileComparison(ftc);
+        if (depfiles.DepfilesChanged(lang)) {
+          needRescanDepfiles = true;
+          break;
+        }
+      }
+    }
+  }
+
   // Check the implicit dependencies to see if they are up to date.
   // The build.make file may have explicit dependencies for the object
   // files but these will not affect the scanning process so they need
@@ -1332,7 +1354,10 @@ bool cmLocalUnixMakefileGenerator3::UpdateDependencies(
       !checker.Check(dependFile, internalDependFile, validDependencies);
   }
 
-  if (needRescanDependInfo || needRescanDirInfo || needRescanDependencies) {
+  // The dependencies may already be up-to-date.
+  bool okay = true;
+  if (needRescanDependInfo || needRescanDirInfo || needRescanDependencies ||
+      needRescanDepfiles) {
     // The dependencies must be regenerated.
     std::string targetName = cmSystemTools::GetFilenameName(dir);
     targetName = targetName.substr(0, targetName.length() - 4);
@@ -1342,11 +1367,19 @@ bool cmLocalUnixMakefileGenerator3::UpdateDependencies(
                                        cmsysTerminal_Color_ForegroundBold,
                                      message.c_str(), true, color);
 
-    return this->ScanDependencies(dir, validDependencies);
+    okay = this->ScanDependencies(dir, validDependencies);
   }
 
-  // The dependencies are already up-to-date.
-  return true;
+  if (verbose) {
+    cmFileTimeComparison::Statistics const& stats = ftc->GetStatistics();
+    std::ostringstream msg;
+    msg << "Dependency check looked up " << stats.Lookups
+        << " file times with " << stats.StatCalls << " stat calls ("
+        << stats.PrefetchedStatCalls << " prefetched)." << std::endl;
+    cmSystemTools::Stdout(msg.str());
+  }
+
+  return okay;
 }
 
 bool cmLocalUnixMakefileGenerator3::ScanDependencies(
@@ -1418,14 +1451,31 @@ bool cmLocalUnixMakefileGenerator3::ScanDependencies(
     mf->GetSafeDefinition("CMAKE_DEPENDS_LANGUAGES");
   std::vector<std::string> langs;
   cmSystemTools::ExpandListArgument(langStr, langs);
+
+  // Include lines scanned by C-like scanners are shared by all targets
+  // in the build tree.
+  std::string sharedCacheFile = this->GetBinaryDirectory();
+  sharedCacheFile += "/CMakeFiles/IncludeScanCache.bin";
+  cmDependsCSharedCache sharedCache(sharedCacheFile);
+  bool sharedCacheLoaded = false;
+
   for (std::string const& lang : langs) {
     // construct the checker
     // Create the scanner for this language
     cmDepends* scanner = nullptr;
-    if (lang == "C" || lang == "CXX" || lang == "RC" || lang == "ASM" ||
-        lang == "CUDA") {
+    if (mf->IsOn("CMAKE_" + lang + "_DEPENDS_USE_COMPILER")) {
+      scanner = new cmDependsCompiler(this, targetDir,
+                                      internalRuleFileNameFull, &validDeps);
+    } else if (lang == "C" || lang == "CXX" || lang == "RC" ||
+               lang == "ASM" || lang == "CUDA") {
+      if (!sharedCacheLoaded) {
+        sharedCache.Load();
+        sharedCacheLoaded = true;
+      }
       // TODO: Handle RC (resource files) dependencies correctly.
-      scanner = new cmDependsC(this, targetDir, lang, &validDeps);
+      cmDependsC* scannerC = new cmDependsC(this, targetDir, lang, &validDeps);
+      scannerC->SetSharedCache(&sharedCache);
+      scanner = scannerC;
     }
 #ifdef CMAKE_BUILD_WITH_CMAKE
     else if (lang == "Fortran") {
@@ -1450,6 +1500,8 @@ bool cmLocalUnixMakefileGenerator3::ScanDependencies(
     }
   }
 
+  sharedCache.Save();
+
   return true;
 }
 
@@ -1665,8 +1717,8 @@ void cmLocalUnixMakefileGenerator3::WriteLocalAllRules(
     commands.clear();
     cmake* cm = this->GlobalGenerator->GetCMakeInstance();
     if (cm->DoWriteGlobVerifyTarget()) {
-      std::string rescanRule = "$(CMAKE_COMMAND) -P ";
-      rescanRule += this->ConvertToOutputFormat(cm->GetGlobVerifyScript(),
+      std::string rescanRule = "$(CMAKE_COMMAND) -E cmake_verify_globs ";
+      rescanRule += this->ConvertToOutputFormat(cm->GetGlobVerifyCache(),
                                                 cmOutputConverter::SHELL);
       commands.push_back(rescanRule);
     }
@@ -1798,6 +1850,12 @@ void cmLocalUnixMakefileGenerator3::WriteDependLanguageInfo(
     }
     cmakefileStream << "  )\n";
 
+    // Tell the dependency scanner to use the compiler's dependency files.
+    if (this->UseCompilerDepfiles(implicitLang.first)) {
+      cmakefileStream << "set(CMAKE_" << implicitLang.first
+                      << "_DEPENDS_USE_COMPILER 1)\n";
+    }
+
     // Tell the dependency scanner what compiler is used.
     std::string cidVar = "CMAKE_";
     cidVar += implicitLang.first;
@@ -2042,6 +2100,21 @@ cmLocalUnixMakefileGenerator3::GetImplicitDepends(const cmGeneratorTarget* tgt)
   return this->ImplicitDepends[tgt->GetName()];
 }
 
+bool cmLocalUnixMakefileGenerator3::UseCompilerDepfiles(
+  const std::string& lang) const
+{
+  // Only the dependency file format of GCC-compatible compilers is
+  // understood by cmDependsCompiler.  Other languages need CMake's own
+  // scanners, e.g. to order Fortran module dependencies.
+  if (lang != "C" && lang != "CXX" && lang != "ASM") {
+    return false;
+  }
+  return this->Makefile->IsOn("CMAKE_DEPENDS_USE_COMPILER") &&
+    this->Makefile->GetSafeDefinition("CMAKE_" + lang + "_DEPFILE_FORMAT") ==
+    "gcc" &&
+    !this->Makefile->GetSafeDefinition("CMAKE_DEPFILE_FLAGS_" + lang).empty();
+}
+
 void cmLocalUnixMakefileGenerator3::AddImplicitDepends(
   const cmGeneratorTarget* tgt, const std::string& lang,
   const std::string& obj, const std::string& src)
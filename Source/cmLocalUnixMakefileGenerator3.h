@@ -162,6 +162,11 @@ public:
                           const std::string& lang, const std::string& obj,
                           const std::string& src);
 
+  /** Whether dependencies of objects of the given language are taken
+      from dependency files written by the compiler instead of being
+      scanned by CMake.  */
+  bool UseCompilerDepfiles(const std::string& lang) const;
+
   // write the target rules for the local Makefile into the stream
   void WriteLocalAllRules(std::ostream& ruleFileStream);
 
@@ -11,6 +11,7 @@
 #include "cmComputeLinkInformation.h"
 #include "cmCustomCommand.h"
 #include "cmCustomCommandGenerator.h"
+#include "cmDependsCompiler.h"
 #include "cmGeneratedFileStream.h"
 #include "cmGeneratorExpression.h"
 #include "cmGeneratorTarget.h"
@@ -620,7 +621,27 @@ void cmMakefileTargetGenerator::WriteObjectBuildFile(
       this->LocalGenerator->GetCurrentBinaryDirectory(), objectFileDir),
     cmOutputConverter::SHELL);
   vars.ObjectFileDir = objectFileDir.c_str();
-  vars.Flags = flags.c_str();
+
+  // Ask the compiler to write the object's dependencies.  This is done
+  // only by the compile rule and not by the preprocess and assembly
+  // rules below.
+  std::string compileFlags = flags;
+  if (this->LocalGenerator->UseCompilerDepfiles(lang)) {
+    std::string depfileFlags =
+      this->Makefile->GetSafeDefinition("CMAKE_DEPFILE_FLAGS_" + lang);
+    std::string const depfile = cmDependsCompiler::GetDepfileName(obj);
+    cmSystemTools::ReplaceString(
+      depfileFlags, "<DEPFILE>",
+      this->LocalGenerator->ConvertToOutputFormat(depfile,
+                                                  cmOutputConverter::SHELL));
+    cmSystemTools::ReplaceString(depfileFlags, "<OBJECT>", shellObj);
+    cmSystemTools::ReplaceString(
+      depfileFlags, "<CMAKE_C_COMPILER>",
+      this->Makefile->GetSafeDefinition("CMAKE_C_COMPILER"));
+    this->LocalGenerator->AppendFlags(compileFlags, depfileFlags);
+    this->CleanFiles.push_back(depfile);
+  }
+  vars.Flags = compileFlags.c_str();
 
   std::string definesString = "$(";
   definesString += lang;
@@ -815,6 +836,7 @@ void cmMakefileTargetGenerator::WriteObjectBuildFile(
   bool do_assembly_rules =
     lang_has_assembly && this->LocalGenerator->GetCreateAssemblySourceRules();
   if (do_preprocess_rules || do_assembly_rules) {
+    vars.Flags = flags.c_str();
     std::vector<std::string> force_depends;
     force_depends.emplace_back("cmake_force");
     std::string::size_type dot_pos = relativeObj.rfind('.');
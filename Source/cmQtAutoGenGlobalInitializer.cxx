@@ -5,20 +5,25 @@
 #include "cmQtAutoGenInitializer.h"
 
 #include "cmAlgorithms.h"
+#include "cmCustomCommand.h"
 #include "cmCustomCommandLines.h"
 #include "cmDuration.h"
 #include "cmGeneratorTarget.h"
+#include "cmLinkItem.h"
 #include "cmLocalGenerator.h"
 #include "cmMakefile.h"
 #include "cmMessageType.h"
 #include "cmProcessOutput.h"
+#include "cmSourceFile.h"
 #include "cmState.h"
 #include "cmStateTypes.h"
 #include "cmSystemTools.h"
 #include "cmTarget.h"
 
 #include <memory>
+#include <set>
 #include <utility>
+#include <vector>
 
 cmQtAutoGenGlobalInitializer::cmQtAutoGenGlobalInitializer(
   std::vector<cmLocalGenerator*> const& localGenerators)
@@ -39,6 +44,11 @@ cmQtAutoGenGlobalInitializer::cmQtAutoGenGlobalInitializer(
         }
         GlobalAutoGenTargets_.emplace(localGen, std::move(targetName));
         globalAutoGenTarget = true;
+        // Detect whether the target runs all targets in one process
+        if (cmSystemTools::IsOn(makefile->GetSafeDefinition(
+              "CMAKE_GLOBAL_AUTOGEN_TARGET_BATCH"))) {
+          GlobalAutoGenBatchDirs_.insert(localGen);
+        }
       }
 
       // Detect global autorcc target name
@@ -161,15 +171,230 @@ void cmQtAutoGenGlobalInitializer::GetOrCreateGlobalTarget(
   }
 }
 
+/// @brief Collects the targets that the given target depends on, directly
+///        or not, through links, utilities and custom commands
+static void CollectTargetDepends(cmGeneratorTarget const* target,
+                                 std::set<cmGeneratorTarget const*>& reached)
+{
+  std::vector<cmGeneratorTarget const*> queue(1, target);
+  while (!queue.empty()) {
+    cmGeneratorTarget const* gt = queue.back();
+    queue.pop_back();
+    if ((gt == nullptr) || !reached.insert(gt).second) {
+      continue;
+    }
+    cmLocalGenerator* localGen = gt->GetLocalGenerator();
+    cmMakefile* makefile = gt->Makefile;
+    // Follow the custom commands like the dependency tracing of the
+    // generators does: through the targets they run or depend on and
+    // through the rules producing the files they depend on.
+    std::set<cmCustomCommand const*> commands;
+    std::vector<cmCustomCommand const*> commandQueue;
+    auto followOutput = [makefile, &commandQueue](std::string const& file) {
+      cmSourceFile* sf = makefile->GetSourceFileWithOutput(file);
+      if ((sf != nullptr) && (sf->GetCustomCommand() != nullptr)) {
+        commandQueue.push_back(sf->GetCustomCommand());
+      }
+    };
+    auto traceCommands = [localGen, &queue, &commands, &commandQueue,
+                          &followOutput]() {
+      while (!commandQueue.empty()) {
+        cmCustomCommand const* cc = commandQueue.back();
+        commandQueue.pop_back();
+        if (!commands.insert(cc).second) {
+          continue;
+        }
+        for (std::string const& dep : cc->GetDepends()) {
+          if (cmGeneratorTarget* depTarget =
+                localGen->FindGeneratorTargetToUse(dep)) {
+            queue.push_back(depTarget);
+          } else {
+            followOutput(dep);
+          }
+        }
+        for (cmCustomCommandLine const& line : cc->GetCommandLines()) {
+          if (!line.empty()) {
+            queue.push_back(localGen->FindGeneratorTargetToUse(line.front()));
+          }
+        }
+      }
+    };
+    auto followCommand = [&commandQueue,
+                          &traceCommands](cmCustomCommand const& cc) {
+      commandQueue.push_back(&cc);
+      traceCommands();
+    };
+
+    for (BT<std::string> const& depName : gt->Target->GetUtilities()) {
+      queue.push_back(localGen->FindGeneratorTargetToUse(depName.Value));
+    }
+    std::vector<std::string> configs;
+    makefile->GetConfigurations(configs);
+    if (configs.empty()) {
+      configs.emplace_back();
+    }
+    for (std::string const& config : configs) {
+      if (cmLinkImplementationLibraries const* libs =
+            gt->GetLinkImplementationLibraries(config)) {
+        for (cmLinkItem const& item : libs->Libraries) {
+          queue.push_back(item.Target);
+        }
+      }
+      if (cmLinkInterfaceLibraries const* libs =
+            gt->GetLinkInterfaceLibraries(config, gt, false)) {
+        for (cmLinkItem const& item : libs->Libraries) {
+          queue.push_back(item.Target);
+        }
+      }
+      if (!gt->IsImported() &&
+          gt->GetType() != cmStateEnums::INTERFACE_LIBRARY) {
+        std::vector<cmSourceFile*> sources;
+        gt->GetSourceFiles(sources, config);
+        for (cmSourceFile* sf : sources) {
+          if (cmCustomCommand const* cc = sf->GetCustomCommand()) {
+            followCommand(*cc);
+          } else if (sf->GetPropertyAsBool("GENERATED")) {
+            // The rule may still be attached to a separate rule file.
+            followOutput(sf->GetFullPath());
+            traceCommands();
+          }
+        }
+      }
+    }
+    for (cmCustomCommand const& cc : gt->GetPreBuildCommands()) {
+      followCommand(cc);
+    }
+    for (cmCustomCommand const& cc : gt->GetPreLinkCommands()) {
+      followCommand(cc);
+    }
+    for (cmCustomCommand const& cc : gt->GetPostBuildCommands()) {
+      followCommand(cc);
+    }
+  }
+}
+
+void cmQtAutoGenGlobalInitializer::GetOrCreateGlobalBatchTarget(
+  cmLocalGenerator* localGen, std::string const& name,
+  std::string const& comment)
+{
+  std::vector<AutoGenBatchTarget> batch;
+  std::swap(batch, GlobalAutoGenBatches_[name]);
+  cmMakefile* makefile = localGen->GetMakefile();
+
+  // The <ORIGIN>_autogen targets in the batch must wait for the batch
+  // target, or both may write the same files at once.  For targets that
+  // the batch target itself depends on, directly or not, this would be a
+  // dependency cycle.  Those are processed by their own autogen target,
+  // as without batching.
+  std::set<cmGeneratorTarget const*> reached;
+  for (AutoGenBatchTarget const& bt : batch) {
+    cmLocalGenerator* originGen = bt.Origin->GetLocalGenerator();
+    for (BT<std::string> const& depName : bt.Autogen->GetUtilities()) {
+      CollectTargetDepends(originGen->FindGeneratorTargetToUse(depName.Value),
+                           reached);
+    }
+  }
+  std::vector<AutoGenBatchTarget const*> members;
+  std::vector<std::string> separateTargets;
+  for (AutoGenBatchTarget const& bt : batch) {
+    cmGeneratorTarget const* autogenTarget =
+      bt.Origin->GetLocalGenerator()->FindGeneratorTargetToUse(
+        bt.Autogen->GetName());
+    if ((reached.count(bt.Origin) != 0) ||
+        (reached.count(autogenTarget) != 0)) {
+      separateTargets.push_back(bt.Autogen->GetName());
+    } else {
+      members.push_back(&bt);
+    }
+  }
+
+  // Depend on the autogen targets if a target of that name exists or
+  // there is nothing to process
+  if ((localGen->FindGeneratorTargetToUse(name) != nullptr) ||
+      members.empty()) {
+    GetOrCreateGlobalTarget(localGen, name, comment);
+    cmGeneratorTarget* target = localGen->FindGeneratorTargetToUse(name);
+    for (AutoGenBatchTarget const& bt : batch) {
+      target->Target->AddUtility(bt.Autogen->GetName(), makefile);
+    }
+    return;
+  }
+
+  // Process all targets in one call
+  cmCustomCommandLines commandLines;
+  std::set<std::string> dependFiles;
+  {
+    cmCustomCommandLine currentLine;
+    currentLine.push_back(cmSystemTools::GetCMakeCommand());
+    currentLine.push_back("-E");
+    currentLine.push_back("cmake_autogen");
+    currentLine.push_back(members.front()->InfoFile);
+    currentLine.push_back("$<CONFIGURATION>");
+    for (AutoGenBatchTarget const* bt : members) {
+      if (bt != members.front()) {
+        currentLine.push_back(bt->InfoFile);
+      }
+      dependFiles.insert(bt->DependFiles.begin(), bt->DependFiles.end());
+    }
+    commandLines.push_back(std::move(currentLine));
+  }
+
+  // Create utility target
+  cmTarget* target = makefile->AddUtilityCommand(
+    name, cmMakefile::TargetOrigin::Generator, true,
+    makefile->GetHomeOutputDirectory().c_str() /*work dir*/,
+    std::vector<std::string>() /*output*/,
+    std::vector<std::string>(dependFiles.begin(), dependFiles.end()),
+    commandLines, false, comment.c_str());
+  localGen->AddGeneratorTarget(new cmGeneratorTarget(target, localGen));
+
+  // Add the dependencies of all autogen targets in the batch and the
+  // autogen targets that are not
+  for (AutoGenBatchTarget const* bt : members) {
+    for (BT<std::string> const& depName : bt->Autogen->GetUtilities()) {
+      target->AddUtility(depName.Value, makefile);
+    }
+  }
+  for (std::string const& separateTarget : separateTargets) {
+    target->AddUtility(separateTarget, makefile);
+  }
+
+  // Run the autogen targets in the batch after the batch target, which
+  // writes the same files
+  for (AutoGenBatchTarget const* bt : members) {
+    bt->Autogen->AddUtility(name, makefile);
+  }
+
+  // Set FOLDER property in the target
+  {
+    char const* folder =
+      makefile->GetState()->GetGlobalProperty("AUTOGEN_TARGETS_FOLDER");
+    if (folder != nullptr) {
+      target->SetProperty("FOLDER", folder);
+    }
+  }
+}
+
 void cmQtAutoGenGlobalInitializer::AddToGlobalAutoGen(
-  cmLocalGenerator* localGen, std::string const& targetName)
+  cmLocalGenerator* localGen, cmGeneratorTarget const* originTarget,
+  cmTarget* autogenTarget, std::string const& infoFile,
+  std::set<std::string> const& dependFiles)
 {
   auto it = GlobalAutoGenTargets_.find(localGen);
-  if (it != GlobalAutoGenTargets_.end()) {
-    cmGeneratorTarget* target = localGen->FindGeneratorTargetToUse(it->second);
-    if (target != nullptr) {
-      target->Target->AddUtility(targetName, localGen->GetMakefile());
-    }
+  if (it == GlobalAutoGenTargets_.end()) {
+    return;
+  }
+  // Batch targets are created once all autogen targets are known
+  if (GlobalAutoGenBatchDirs_.count(localGen) != 0) {
+    GlobalAutoGenBatches_[it->second].push_back(
+      AutoGenBatchTarget{ originTarget, autogenTarget, infoFile,
+                          dependFiles });
+    return;
+  }
+  cmGeneratorTarget* target = localGen->FindGeneratorTargetToUse(it->second);
+  if (target != nullptr) {
+    target->Target->AddUtility(autogenTarget->GetName(),
+                               localGen->GetMakefile());
   }
 }
 
@@ -258,7 +483,9 @@ bool cmQtAutoGenGlobalInitializer::InitializeCustomTargets()
   {
     std::string const comment = "Global AUTOGEN target";
     for (auto const& pair : GlobalAutoGenTargets_) {
-      GetOrCreateGlobalTarget(pair.first, pair.second, comment);
+      if (GlobalAutoGenBatchDirs_.count(pair.first) == 0) {
+        GetOrCreateGlobalTarget(pair.first, pair.second, comment);
+      }
     }
   }
   // Initialize global autorcc targets
@@ -274,6 +501,15 @@ bool cmQtAutoGenGlobalInitializer::InitializeCustomTargets()
       return false;
     }
   }
+  // Initialize global autogen targets that process all targets at once
+  {
+    std::string const comment = "Global AUTOGEN target";
+    for (auto const& pair : GlobalAutoGenTargets_) {
+      if (GlobalAutoGenBatchDirs_.count(pair.first) != 0) {
+        GetOrCreateGlobalBatchTarget(pair.first, pair.second, comment);
+      }
+    }
+  }
   return true;
 }
 
@@ -7,12 +7,15 @@
 
 #include <map>
 #include <memory> // IWYU pragma: keep
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+class cmGeneratorTarget;
 class cmLocalGenerator;
 class cmQtAutoGenInitializer;
+class cmTarget;
 
 /// @brief Initializes the QtAutoGen generators
 class cmQtAutoGenGlobalInitializer
@@ -27,15 +30,29 @@ public:
 private:
   friend class cmQtAutoGenInitializer;
 
+  /// @brief A target processed by a global autogen target in one process
+  struct AutoGenBatchTarget
+  {
+    cmGeneratorTarget const* Origin;
+    cmTarget* Autogen;
+    std::string InfoFile;
+    std::set<std::string> DependFiles;
+  };
+
   bool InitializeCustomTargets();
   bool SetupCustomTargets();
 
   void GetOrCreateGlobalTarget(cmLocalGenerator* localGen,
                                std::string const& name,
                                std::string const& comment);
+  void GetOrCreateGlobalBatchTarget(cmLocalGenerator* localGen,
+                                    std::string const& name,
+                                    std::string const& comment);
 
   void AddToGlobalAutoGen(cmLocalGenerator* localGen,
-                          std::string const& targetName);
+                          cmGeneratorTarget const* originTarget,
+                          cmTarget* autogenTarget, std::string const& infoFile,
+                          std::set<std::string> const& dependFiles);
   void AddToGlobalAutoRcc(cmLocalGenerator* localGen,
                           std::string const& targetName);
 
@@ -46,6 +63,9 @@ private:
 private:
   std::vector<std::unique_ptr<cmQtAutoGenInitializer>> Initializers_;
   std::map<cmLocalGenerator*, std::string> GlobalAutoGenTargets_;
+  std::set<cmLocalGenerator*> GlobalAutoGenBatchDirs_;
+  std::map<std::string, std::vector<AutoGenBatchTarget>>
+    GlobalAutoGenBatches_;
   std::map<cmLocalGenerator*, std::string> GlobalAutoRccTargets_;
   std::unordered_map<std::string, std::string> ExecutableTestOutputs_;
 };
@@ -1097,8 +1097,9 @@ bool cmQtAutoGenInitializer::InitAutogenTarget()
 
     // Add autogen target to the global autogen target dependencies
     if (this->AutogenTarget.GlobalTarget) {
-      this->GlobalInitializer->AddToGlobalAutoGen(localGen,
-                                                  this->AutogenTarget.Name);
+      this->GlobalInitializer->AddToGlobalAutoGen(
+        localGen, this->Target, autogenTarget, this->AutogenTarget.InfoFile,
+        this->AutogenTarget.DependFiles);
     }
   }
 
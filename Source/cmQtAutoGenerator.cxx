@@ -19,6 +19,8 @@
 
 // -- Class methods
 
+std::mutex cmQtAutoGenerator::Logger::Mutex_;
+
 void cmQtAutoGenerator::Logger::RaiseVerbosity(std::string const& value)
 {
   unsigned long verbosity = 0;
@@ -153,6 +155,8 @@ void cmQtAutoGenerator::Logger::ErrorCommand(
   }
 }
 
+std::mutex cmQtAutoGenerator::FileSystem::Mutex_;
+
 std::string cmQtAutoGenerator::FileSystem::GetRealPath(
   std::string const& filename)
 {
@@ -678,6 +682,12 @@ cmQtAutoGenerator::~cmQtAutoGenerator()
 
 bool cmQtAutoGenerator::Run(std::string const& infoFile,
                             std::string const& config)
+{
+  return this->ReadInfoFile(infoFile, config) && this->Process();
+}
+
+bool cmQtAutoGenerator::ReadInfoFile(std::string const& infoFile,
+                                     std::string const& config)
 {
   // Info settings
   InfoFile_ = infoFile;
@@ -704,9 +714,6 @@ bool cmQtAutoGenerator::Run(std::string const& infoFile,
     gg.SetCurrentMakefile(makefile.get());
     success = this->Init(makefile.get());
   }
-  if (success) {
-    success = this->Process();
-  }
   return success;
 }
 
@@ -57,7 +57,8 @@ public:
     static std::string HeadLine(std::string const& title);
 
   private:
-    std::mutex Mutex_;
+    // Shared by the generators of a process to keep messages whole
+    static std::mutex Mutex_;
     unsigned int Verbosity_ = 0;
     bool ColorOutput_ = false;
   };
@@ -138,7 +139,9 @@ public:
     bool MakeParentDirectory(GeneratorT genType, std::string const& filename);
 
   private:
-    std::mutex Mutex_;
+    // Shared by the generators of a process since cmSystemTools is not
+    // thread safe
+    static std::mutex Mutex_;
     cmFilePathChecksum FilePathChecksum_;
     Logger* Log_;
   };
@@ -249,6 +252,8 @@ public:
 
   // -- Run
   bool Run(std::string const& infoFile, std::string const& config);
+  /// @brief Reads the info file, the first part of Run
+  bool ReadInfoFile(std::string const& infoFile, std::string const& config);
 
   // -- Accessors
   // Logging
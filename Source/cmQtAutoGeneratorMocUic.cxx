@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <functional>
 #include <list>
@@ -154,6 +155,85 @@ bool cmQtAutoGeneratorMocUic::UicSettingsT::skipped(
   return (!Enabled || (SkipList.find(fileName) != SkipList.end()));
 }
 
+void cmQtAutoGeneratorMocUic::SharedT::SetProcessSlots(unsigned int slots)
+{
+  std::lock_guard<std::mutex> lock(ProcessMutex_);
+  ProcessSlots_ = slots;
+}
+
+void cmQtAutoGeneratorMocUic::SharedT::AcquireProcessSlot()
+{
+  std::unique_lock<std::mutex> lock(ProcessMutex_);
+  while ((ProcessSlots_ != 0) && (ProcessesRunning_ >= ProcessSlots_)) {
+    ProcessCondition_.wait(lock);
+  }
+  ++ProcessesRunning_;
+}
+
+void cmQtAutoGeneratorMocUic::SharedT::ReleaseProcessSlot()
+{
+  {
+    std::lock_guard<std::mutex> lock(ProcessMutex_);
+    --ProcessesRunning_;
+  }
+  ProcessCondition_.notify_one();
+}
+
+bool cmQtAutoGeneratorMocUic::SharedT::ReadHeader(FileSystem& fileSys,
+                                                  std::string const& fileName,
+                                                  std::string& content,
+                                                  std::string& error)
+{
+  if (CacheHeaders_) {
+    std::lock_guard<std::mutex> lock(HeadersMutex_);
+    auto it = Headers_.find(fileName);
+    if (it != Headers_.end()) {
+      content = it->second.Content;
+      return true;
+    }
+  }
+  if (!fileSys.FileRead(content, fileName, &error)) {
+    return false;
+  }
+  if (CacheHeaders_) {
+    std::lock_guard<std::mutex> lock(HeadersMutex_);
+    auto ins = Headers_.emplace(fileName, HeaderT());
+    if (ins.second) {
+      ins.first->second.Content = content;
+    }
+  }
+  return true;
+}
+
+std::string cmQtAutoGeneratorMocUic::SharedT::FindHeaderMacro(
+  MocSettingsT const& moc, std::string const& fileName,
+  std::string const& content)
+{
+  if (!CacheHeaders_) {
+    return moc.FindMacro(content);
+  }
+  // The macro filters follow from the macro names
+  std::string names;
+  for (KeyExpT const& filter : moc.MacroFilters) {
+    names += filter.Key;
+    names += ';';
+  }
+  {
+    std::lock_guard<std::mutex> lock(HeadersMutex_);
+    HeaderT& header = Headers_[fileName];
+    auto it = header.Macros.find(names);
+    if (it != header.Macros.end()) {
+      return it->second;
+    }
+  }
+  std::string macro = moc.FindMacro(content);
+  {
+    std::lock_guard<std::mutex> lock(HeadersMutex_);
+    Headers_[fileName].Macros.emplace(std::move(names), macro);
+  }
+  return macro;
+}
+
 void cmQtAutoGeneratorMocUic::JobParseT::Process(WorkerT& wrk)
 {
   if (AutoMoc && Header) {
@@ -166,7 +246,11 @@ void cmQtAutoGeneratorMocUic::JobParseT::Process(WorkerT& wrk)
   if (AutoMoc || AutoUic) {
     std::string error;
     MetaT meta;
-    if (wrk.FileSys().FileRead(meta.Content, FileName, &error)) {
+    bool const read = Header
+      ? wrk.Gen().Shared().ReadHeader(wrk.FileSys(), FileName, meta.Content,
+                                      error)
+      : wrk.FileSys().FileRead(meta.Content, FileName, &error);
+    if (read) {
       if (!meta.Content.empty()) {
         meta.FileDir = wrk.FileSys().SubDirPrefix(FileName);
         meta.FileBase =
@@ -450,7 +534,8 @@ bool cmQtAutoGeneratorMocUic::JobParseT::ParseMocHeader(WorkerT& wrk,
                                                         MetaT const& meta)
 {
   bool success = true;
-  std::string const macroName = wrk.Moc().FindMacro(meta.Content);
+  std::string const macroName =
+    wrk.Gen().Shared().FindHeaderMacro(wrk.Moc(), FileName, meta.Content);
   if (!macroName.empty()) {
     JobHandleT jobHandle(
       new JobMocT(std::string(FileName), std::string(), std::string()));
@@ -1067,6 +1152,9 @@ bool cmQtAutoGeneratorMocUic::WorkerT::RunProcess(
     return false;
   }
 
+  // Wait for the other workers of the batch
+  Gen().Shared().AcquireProcessSlot();
+
   // Create process instance
   {
     std::lock_guard<std::mutex> lock(ProcessMutex_);
@@ -1092,6 +1180,7 @@ bool cmQtAutoGeneratorMocUic::WorkerT::RunProcess(
       ProcessCondition_.wait(ulock);
     }
   }
+  Gen().Shared().ReleaseProcessSlot();
   return !result.error();
 }
 
@@ -1130,10 +1219,16 @@ void cmQtAutoGeneratorMocUic::WorkerT::UVProcessFinished()
   ProcessCondition_.notify_one();
 }
 
-cmQtAutoGeneratorMocUic::cmQtAutoGeneratorMocUic()
-  : Base_(&FileSys())
+cmQtAutoGeneratorMocUic::cmQtAutoGeneratorMocUic(SharedT* shared)
+  : Shared_(shared)
+  , Base_(&FileSys())
   , Moc_(&FileSys())
 {
+  if (Shared_ == nullptr) {
+    OwnShared_ = cm::make_unique<SharedT>();
+    Shared_ = OwnShared_.get();
+  }
+
   // Precompile regular expressions
   Moc_.RegExpInclude.compile(
     "(^|\n)[ \t]*#[ \t]*include[ \t]+"
@@ -1147,6 +1242,54 @@ cmQtAutoGeneratorMocUic::cmQtAutoGeneratorMocUic()
 
 cmQtAutoGeneratorMocUic::~cmQtAutoGeneratorMocUic() = default;
 
+bool cmQtAutoGeneratorMocUic::RunBatch(
+  std::vector<std::string> const& infoFiles, std::string const& config)
+{
+  SharedT shared;
+  shared.SetCacheHeaders(infoFiles.size() > 1);
+
+  // Read the info files one after the other
+  std::vector<std::unique_ptr<cmQtAutoGeneratorMocUic>> gens;
+  unsigned int slots = 1;
+  for (std::string const& infoFile : infoFiles) {
+    gens.emplace_back(cm::make_unique<cmQtAutoGeneratorMocUic>(&shared));
+    if (!gens.back()->ReadInfoFile(infoFile, config)) {
+      return false;
+    }
+    slots = std::max(slots, gens.back()->Base().NumThreads);
+  }
+  // All targets together run as many processes as the most parallel one
+  shared.SetProcessSlots(slots);
+
+  // Process as many targets at once as processes may run, and share the
+  // worker threads among them so that the batch does not start more
+  // threads than the most parallel target would.
+  std::size_t const count = std::min<std::size_t>(slots, gens.size());
+  unsigned int const workers =
+    std::max(1u, slots / static_cast<unsigned int>(count));
+  for (auto& gen : gens) {
+    gen->Base_.NumThreads = workers;
+  }
+  std::atomic<std::size_t> next(0);
+  std::atomic<bool> success(true);
+  auto process = [&gens, &next, &success]() {
+    for (std::size_t i = next++; i < gens.size(); i = next++) {
+      if (!gens[i]->Process()) {
+        success = false;
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < count; ++i) {
+    threads.emplace_back(process);
+  }
+  process();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return success;
+}
+
 bool cmQtAutoGeneratorMocUic::Init(cmMakefile* makefile)
 {
   // -- Meta
@@ -20,6 +20,7 @@
 #include <set>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -29,16 +30,21 @@ class cmMakefile;
 class cmQtAutoGeneratorMocUic : public cmQtAutoGenerator
 {
 public:
-  cmQtAutoGeneratorMocUic();
+  // -- Types
+  class SharedT;
+  class WorkerT;
+
+  cmQtAutoGeneratorMocUic(SharedT* shared = nullptr);
   ~cmQtAutoGeneratorMocUic() override;
 
   cmQtAutoGeneratorMocUic(cmQtAutoGeneratorMocUic const&) = delete;
   cmQtAutoGeneratorMocUic& operator=(cmQtAutoGeneratorMocUic const&) = delete;
 
-public:
-  // -- Types
-  class WorkerT;
+  /// @brief Runs the generators of several targets at the same time
+  static bool RunBatch(std::vector<std::string> const& infoFiles,
+                       std::string const& config);
 
+public:
   /// @brief Search key plus regular expression pair
   ///
   struct KeyExpT
@@ -171,6 +177,51 @@ public:
     cmsys::RegularExpression RegExpInclude;
   };
 
+  /// @brief State shared by the generators of one process
+  ///
+  /// The generators of a batch limit the moc and uic processes they run
+  /// together, and read and scan the headers they have in common once.
+  class SharedT
+  {
+  public:
+    SharedT() = default;
+
+    SharedT(SharedT const&) = delete;
+    SharedT& operator=(SharedT const&) = delete;
+
+    // -- Processes
+    /// @brief Sets the number of processes to run at once, 0 for any
+    void SetProcessSlots(unsigned int slots);
+    void AcquireProcessSlot();
+    void ReleaseProcessSlot();
+
+    // -- Headers
+    void SetCacheHeaders(bool value) { CacheHeaders_ = value; }
+    bool ReadHeader(FileSystem& fileSys, std::string const& fileName,
+                    std::string& content, std::string& error);
+    std::string FindHeaderMacro(MocSettingsT const& moc,
+                                std::string const& fileName,
+                                std::string const& content);
+
+  private:
+    struct HeaderT
+    {
+      std::string Content;
+      // Found macro by the names of the searched macros
+      std::map<std::string, std::string> Macros;
+    };
+
+    // -- Processes
+    std::mutex ProcessMutex_;
+    std::condition_variable ProcessCondition_;
+    unsigned int ProcessSlots_ = 0;
+    unsigned int ProcessesRunning_ = 0;
+    // -- Headers
+    std::mutex HeadersMutex_;
+    bool CacheHeaders_ = false;
+    std::unordered_map<std::string, HeaderT> Headers_;
+  };
+
   /// @brief Abstract job class for threaded processing
   ///
   class JobT
@@ -381,6 +432,7 @@ public:
   const BaseSettingsT& Base() const { return this->Base_; }
   const MocSettingsT& Moc() const { return this->Moc_; }
   const UicSettingsT& Uic() const { return this->Uic_; }
+  SharedT& Shared() const { return *this->Shared_; }
 
   // -- Worker thread interface
   void WorkerSwapJob(JobHandleT& jobHandle);
@@ -413,6 +465,9 @@ private:
   void MocGenerateCompilation();
 
 private:
+  // -- Shared state
+  std::unique_ptr<SharedT> OwnShared_;
+  SharedT* Shared_;
   // -- Settings
   BaseSettingsT Base_;
   MocSettingsT Moc_;
@@ -0,0 +1,344 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmRegularExpressionSet.h"
+
+#include <algorithm>
+#include <deque>
+#include <string.h>
+
+namespace {
+
+typedef std::vector<std::string> cmLiteralSet;
+
+char cmRegularExpressionSetFold(char c)
+{
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Parse the syntax accepted by cmsys::RegularExpression to find the
+// literals one of which every match must contain.  The pattern is
+// known to compile.
+class cmLiteralParser
+{
+public:
+  explicit cmLiteralParser(std::string const& regex)
+    : Pos(regex.c_str())
+  {
+  }
+
+  // Parse alternatives up to a closing parenthesis or the end.
+  // Returns false if a match does not need to contain any literal.
+  bool ParseAlternatives(cmLiteralSet& literals)
+  {
+    bool filtered = true;
+    for (;;) {
+      cmLiteralSet branch;
+      if (this->ParseSequence(branch)) {
+        literals.insert(literals.end(), branch.begin(), branch.end());
+      } else {
+        filtered = false;
+      }
+      if (*this->Pos != '|') {
+        break;
+      }
+      ++this->Pos;
+    }
+    std::sort(literals.begin(), literals.end());
+    literals.erase(std::unique(literals.begin(), literals.end()),
+                   literals.end());
+    return filtered;
+  }
+
+private:
+  bool ParseSequence(cmLiteralSet& literals)
+  {
+    std::vector<cmLiteralSet> candidates;
+    std::string run;
+    while (*this->Pos != '\0' && *this->Pos != '|' && *this->Pos != ')') {
+      char c = *this->Pos++;
+      bool isLiteral = false;
+      char literal = 0;
+      bool groupFiltered = false;
+      cmLiteralSet group;
+      switch (c) {
+        case '^':
+        case '$':
+          // Anchors do not consume characters.
+          continue;
+        case '.':
+          break;
+        case '[':
+          isLiteral = this->ParseBracket(literal);
+          break;
+        case '(':
+          groupFiltered = this->ParseAlternatives(group);
+          if (*this->Pos == ')') {
+            ++this->Pos;
+          }
+          break;
+        case '\\':
+          if (*this->Pos != '\0') {
+            literal = *this->Pos++;
+            isLiteral = true;
+          }
+          break;
+        default:
+          literal = c;
+          isLiteral = true;
+          break;
+      }
+
+      char const op = *this->Pos;
+      bool const optional = op == '*' || op == '?';
+      if (optional || op == '+') {
+        ++this->Pos;
+      }
+      if (isLiteral && !optional) {
+        run += cmRegularExpressionSetFold(literal);
+        if (op != '+') {
+          continue;
+        }
+      }
+      if (!run.empty()) {
+        candidates.push_back(cmLiteralSet(1, run));
+        run.clear();
+      }
+      if (groupFiltered && !optional) {
+        candidates.push_back(std::move(group));
+      }
+    }
+    if (!run.empty()) {
+      candidates.push_back(cmLiteralSet(1, run));
+    }
+
+    // Prefer the candidate whose shortest literal is the longest.
+    size_t best = 0;
+    size_t bestLength = 0;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      size_t length = std::string::npos;
+      for (std::string const& l : candidates[i]) {
+        length = std::min(length, l.size());
+      }
+      if (length > bestLength ||
+          (length == bestLength &&
+           candidates[i].size() < candidates[best].size())) {
+        best = i;
+        bestLength = length;
+      }
+    }
+    if (bestLength == 0) {
+      return false;
+    }
+    literals = std::move(candidates[best]);
+    return true;
+  }
+
+  // Parse a bracket expression.  Returns true if it matches a single
+  // character ignoring case.
+  bool ParseBracket(char& literal)
+  {
+    bool const complement = *this->Pos == '^';
+    if (complement) {
+      ++this->Pos;
+    }
+    bool chars[256] = {};
+    unsigned char last = 0;
+    if (*this->Pos == ']' || *this->Pos == '-') {
+      last = static_cast<unsigned char>(*this->Pos++);
+      chars[last] = true;
+    }
+    while (*this->Pos != '\0' && *this->Pos != ']') {
+      if (*this->Pos == '-') {
+        ++this->Pos;
+        if (*this->Pos == ']' || *this->Pos == '\0') {
+          chars[static_cast<unsigned char>('-')] = true;
+        } else {
+          unsigned char end = static_cast<unsigned char>(*this->Pos++);
+          for (unsigned int r = last + 1u; r <= end; ++r) {
+            chars[r] = true;
+          }
+        }
+      } else {
+        last = static_cast<unsigned char>(*this->Pos++);
+        chars[last] = true;
+      }
+    }
+    if (*this->Pos == ']') {
+      ++this->Pos;
+    }
+    if (complement) {
+      return false;
+    }
+
+    int found = -1;
+    for (int i = 0; i < 256; ++i) {
+      if (chars[i]) {
+        int const folded = static_cast<unsigned char>(
+          cmRegularExpressionSetFold(static_cast<char>(i)));
+        if (found != -1 && found != folded) {
+          return false;
+        }
+        found = folded;
+      }
+    }
+    if (found == -1) {
+      return false;
+    }
+    literal = static_cast<char>(found);
+    return true;
+  }
+
+  char const* Pos;
+};
+}
+
+const size_t cmRegularExpressionSet::npos;
+
+std::vector<std::string> cmRegularExpressionSet::GetRequiredLiterals(
+  std::string const& regex)
+{
+  cmLiteralSet literals;
+  cmLiteralParser parser(regex);
+  if (!parser.ParseAlternatives(literals)) {
+    literals.clear();
+  }
+  return literals;
+}
+
+bool cmRegularExpressionSet::Add(std::string const& regex)
+{
+  Expression e;
+  if (!e.Regex.compile(regex)) {
+    return false;
+  }
+  e.Pattern = regex;
+  this->Literals.push_back(GetRequiredLiterals(regex));
+  e.Filtered = !this->Literals.back().empty();
+  this->Expressions.push_back(std::move(e));
+  this->Built = false;
+  return true;
+}
+
+void cmRegularExpressionSet::Clear()
+{
+  this->Expressions.clear();
+  this->Literals.clear();
+  this->Built = false;
+}
+
+void cmRegularExpressionSet::Build()
+{
+  this->Built = true;
+
+  // Give each byte used in a literal its own class.  Letters of both
+  // cases share one.
+  memset(this->ByteClass, 0, sizeof(this->ByteClass));
+  this->ClassCount = 1;
+  for (std::vector<std::string> const& literals : this->Literals) {
+    for (std::string const& l : literals) {
+      for (char c : l) {
+        unsigned char& cls = this->ByteClass[static_cast<unsigned char>(c)];
+        if (cls == 0) {
+          cls = static_cast<unsigned char>(this->ClassCount++);
+        }
+      }
+    }
+  }
+  for (int c = 'A'; c <= 'Z'; ++c) {
+    this->ByteClass[c] = this->ByteClass[c - 'A' + 'a'];
+  }
+
+  // Build the trie of all literals.
+  size_t const k = this->ClassCount;
+  this->Delta.assign(k, npos);
+  this->Outputs.assign(1, std::vector<size_t>());
+  for (size_t i = 0; i < this->Literals.size(); ++i) {
+    for (std::string const& l : this->Literals[i]) {
+      size_t state = 0;
+      for (char c : l) {
+        size_t const t =
+          state * k + this->ByteClass[static_cast<unsigned char>(c)];
+        if (this->Delta[t] == npos) {
+          this->Delta[t] = this->Outputs.size();
+          this->Outputs.emplace_back();
+          this->Delta.resize(this->Delta.size() + k, npos);
+        }
+        state = this->Delta[t];
+      }
+      this->Outputs[state].push_back(i);
+    }
+  }
+
+  // Complete the transitions along the failure links, breadth first.
+  std::vector<size_t> fail(this->Outputs.size(), 0);
+  std::deque<size_t> queue;
+  for (size_t c = 0; c < k; ++c) {
+    size_t& next = this->Delta[c];
+    if (next == npos) {
+      next = 0;
+    } else {
+      queue.push_back(next);
+    }
+  }
+  while (!queue.empty()) {
+    size_t const state = queue.front();
+    queue.pop_front();
+    std::vector<size_t> const& inherited = this->Outputs[fail[state]];
+    this->Outputs[state].insert(this->Outputs[state].end(), inherited.begin(),
+                                inherited.end());
+    for (size_t c = 0; c < k; ++c) {
+      size_t const next = this->Delta[state * k + c];
+      size_t const fallback = this->Delta[fail[state] * k + c];
+      if (next == npos) {
+        this->Delta[state * k + c] = fallback;
+      } else {
+        fail[next] = fallback;
+        queue.push_back(next);
+      }
+    }
+  }
+}
+
+void cmRegularExpressionSet::Scan(char const* text)
+{
+  if (!this->Built) {
+    this->Build();
+  }
+  this->Candidate.assign(this->Expressions.size(), 0);
+  if (this->Outputs.size() <= 1) {
+    return;
+  }
+  size_t const k = this->ClassCount;
+  size_t state = 0;
+  for (unsigned char const* p = reinterpret_cast<unsigned char const*>(text);
+       *p; ++p) {
+    state = this->Delta[state * k + this->ByteClass[*p]];
+    for (size_t i : this->Outputs[state]) {
+      this->Candidate[i] = 1;
+    }
+  }
+}
+
+size_t cmRegularExpressionSet::Find(char const* text)
+{
+  this->Scan(text);
+  for (size_t i = 0; i < this->Expressions.size(); ++i) {
+    if (this->MayMatch(i) && this->Expressions[i].Regex.find(text)) {
+      return i;
+    }
+  }
+  return npos;
+}
+
+void cmRegularExpressionSet::FindAll(char const* text,
+                                     std::vector<bool>& matched)
+{
+  this->Scan(text);
+  matched.resize(this->Expressions.size(), false);
+  for (size_t i = 0; i < this->Expressions.size(); ++i) {
+    if (!matched[i] && this->MayMatch(i) &&
+        this->Expressions[i].Regex.find(text)) {
+      matched[i] = true;
+    }
+  }
+}
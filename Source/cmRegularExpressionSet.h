@@ -0,0 +1,94 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmRegularExpressionSet_h
+#define cmRegularExpressionSet_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include "cmsys/RegularExpression.hxx"
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/** \class cmRegularExpressionSet
+ * \brief Match a list of regular expressions against the same text.
+ *
+ * Each expression is analyzed for literal strings one of which must
+ * appear in any text it matches.  The literals of all expressions are
+ * searched for in a single pass over the text, ignoring case, and only
+ * the expressions whose literals were found are then evaluated.
+ * Expressions without such literals are always evaluated.
+ */
+class cmRegularExpressionSet
+{
+public:
+  static const size_t npos = static_cast<size_t>(-1);
+
+  //! Add an expression.  Returns false if it does not compile.
+  bool Add(std::string const& regex);
+
+  //! Remove all expressions.
+  void Clear();
+
+  size_t Size() const { return this->Expressions.size(); }
+  bool Empty() const { return this->Expressions.empty(); }
+
+  //! Get an expression, e.g. to access the groups it matched.
+  cmsys::RegularExpression& Get(size_t i)
+  {
+    return this->Expressions[i].Regex;
+  }
+
+  //! Return the pattern an expression was compiled from.
+  std::string const& GetPattern(size_t i) const
+  {
+    return this->Expressions[i].Pattern;
+  }
+
+  /** Return the index of the first expression, in the order they were
+      added, that matches the text, or npos.  */
+  size_t Find(char const* text);
+  size_t Find(std::string const& text) { return this->Find(text.c_str()); }
+
+  /** Set the entry of each expression that matches the text to true.
+      Expressions whose entry is already true are not evaluated.  */
+  void FindAll(char const* text, std::vector<bool>& matched);
+  void FindAll(std::string const& text, std::vector<bool>& matched)
+  {
+    this->FindAll(text.c_str(), matched);
+  }
+
+  //! Return the literals one of which the given pattern requires.
+  static std::vector<std::string> GetRequiredLiterals(
+    std::string const& regex);
+
+private:
+  struct Expression
+  {
+    std::string Pattern;
+    cmsys::RegularExpression Regex;
+    bool Filtered;
+  };
+
+  void Build();
+  void Scan(char const* text);
+  bool MayMatch(size_t i) const
+  {
+    return !this->Expressions[i].Filtered || this->Candidate[i];
+  }
+
+  std::vector<Expression> Expressions;
+  std::vector<std::vector<std::string>> Literals;
+  bool Built = false;
+
+  // Automaton over the literals of all expressions.  Bytes not used
+  // by any literal share one class.
+  unsigned char ByteClass[256];
+  size_t ClassCount = 0;
+  std::vector<size_t> Delta;
+  std::vector<std::vector<size_t>> Outputs;
+
+  std::vector<char> Candidate;
+};
+
+#endif
@@ -222,6 +222,11 @@ std::string const& cmState::GetGlobVerifyScript() const
   return this->GlobVerificationManager->GetVerifyScript();
 }
 
+std::string const& cmState::GetGlobVerifyCache() const
+{
+  return this->GlobVerificationManager->GetVerifyCache();
+}
+
 std::string const& cmState::GetGlobVerifyStamp() const
 {
   return this->GlobVerificationManager->GetVerifyStamp();
@@ -237,12 +242,13 @@ void cmState::AddGlobCacheEntry(bool recurse, bool listDirectories,
                                 const std::string& relative,
                                 const std::string& expression,
                                 const std::vector<std::string>& files,
+                                const cmGlobDirectories& directories,
                                 const std::string& variable,
                                 cmListFileBacktrace const& backtrace)
 {
   this->GlobVerificationManager->AddCacheEntry(
     recurse, listDirectories, followSymlinks, relative, expression, files,
-    variable, backtrace);
+    directories, variable, backtrace);
 }
 
 void cmState::RemoveCacheEntry(std::string const& key)
@@ -22,6 +22,7 @@
 
 class cmCacheManager;
 class cmCommand;
+class cmGlobDirectories;
 class cmGlobVerificationManager;
 class cmPropertyDefinition;
 class cmStateSnapshot;
@@ -194,12 +195,14 @@ private:
 
   bool DoWriteGlobVerifyTarget() const;
   std::string const& GetGlobVerifyScript() const;
+  std::string const& GetGlobVerifyCache() const;
   std::string const& GetGlobVerifyStamp() const;
   bool SaveVerificationScript(const std::string& path);
   void AddGlobCacheEntry(bool recurse, bool listDirectories,
                          bool followSymlinks, const std::string& relative,
                          const std::string& expression,
                          const std::vector<std::string>& files,
+                         const cmGlobDirectories& directories,
                          const std::string& variable,
                          cmListFileBacktrace const& bt);
 
@@ -18,6 +18,11 @@
 #  ifndef __LA_SSIZE_T
 #    define __LA_SSIZE_T la_ssize_t
 #  endif
+#  include <condition_variable>
+#  include <deque>
+#  include <mutex>
+#  include <set>
+#  include <thread>
 #endif
 
 #if defined(CMAKE_BUILD_WITH_CMAKE)
@@ -43,6 +48,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
@@ -76,6 +82,14 @@
 #  include <malloc.h> /* for malloc/free on QNX */
 #endif
 
+#if defined(__linux)
+#  include <fcntl.h>
+#  include <linux/fs.h>
+#  include <sys/ioctl.h>
+#  include <sys/sendfile.h>
+#  include <sys/syscall.h>
+#endif
+
 namespace {
 
 cmSystemTools::InterruptCallback s_InterruptCallback;
@@ -941,6 +955,96 @@ bool cmSystemTools::cmCopyFile(const std::string& source,
   return Superclass::CopyFileAlways(source, destination);
 }
 
+bool cmSystemTools::CopyAFile(const std::string& source,
+                              const std::string& destination, bool always)
+{
+  std::string realDestination = destination;
+  if (cmSystemTools::FileIsDirectory(destination)) {
+    cmSystemTools::ConvertToUnixSlashes(realDestination);
+    realDestination += '/';
+    realDestination += cmSystemTools::GetFilenameName(source);
+  }
+  if (!always && !cmSystemTools::FilesDiffer(source, realDestination)) {
+    return true;
+  }
+  // KWSys handles directories and copies of a file onto itself.
+  if (cmSystemTools::FileIsDirectory(source) ||
+      cmSystemTools::SameFile(source, realDestination)) {
+    return Superclass::CopyFileAlways(source, destination);
+  }
+
+  mode_t perm = 0;
+  bool const perms = cmSystemTools::GetPermissions(source, perm);
+  cmSystemTools::MakeDirectory(
+    cmSystemTools::GetFilenamePath(realDestination));
+  if (!cmSystemTools::CloneOrCopyFileContent(source, realDestination)) {
+    return Superclass::CopyFileAlways(source, destination);
+  }
+  return !perms || cmSystemTools::SetPermissions(realDestination, perm);
+}
+
+bool cmSystemTools::CloneOrCopyFileContent(const std::string& source,
+                                           const std::string& destination)
+{
+#if defined(__linux)
+  int in = open(source.c_str(), O_RDONLY);
+  if (in < 0) {
+    return false;
+  }
+  // Files reporting no size, like those in /proc, are copied blockwise.
+  struct stat st;
+  if (fstat(in, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+    close(in);
+    return false;
+  }
+
+  cmSystemTools::RemoveFile(destination);
+  int out =
+    open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  if (out < 0) {
+    close(in);
+    return false;
+  }
+
+  bool copied = false;
+#  if defined(FICLONE)
+  copied = ioctl(out, FICLONE, in) == 0;
+#  endif
+  // Let the kernel copy the data if the file system cannot share it.
+  off_t remaining = copied ? 0 : st.st_size;
+#  if defined(__NR_copy_file_range)
+  while (remaining > 0) {
+    size_t const chunk =
+      static_cast<size_t>(std::min<off_t>(remaining, 0x40000000));
+    long n = syscall(__NR_copy_file_range, in, nullptr, out, nullptr, chunk,
+                     0u);
+    if (n <= 0) {
+      break;
+    }
+    remaining -= static_cast<off_t>(n);
+  }
+#  endif
+  // Older kernels cannot use copy_file_range between file systems.
+  // Continue from the current file offsets with sendfile.
+  while (remaining > 0) {
+    size_t const chunk =
+      static_cast<size_t>(std::min<off_t>(remaining, 0x40000000));
+    ssize_t n = sendfile(out, in, nullptr, chunk);
+    if (n <= 0) {
+      break;
+    }
+    remaining -= static_cast<off_t>(n);
+  }
+  close(in);
+  close(out);
+  return remaining == 0;
+#else
+  static_cast<void>(source);
+  static_cast<void>(destination);
+  return false;
+#endif
+}
+
 #ifdef _WIN32
 cmSystemTools::WindowsFileRetry cmSystemTools::GetWindowsFileRetry()
 {
@@ -1637,7 +1741,9 @@ bool cmSystemTools::CreateTar(const char* outFileName,
                               const std::vector<std::string>& files,
                               cmTarCompression compressType, bool verbose,
                               std::string const& mtime,
-                              std::string const& format)
+                              std::string const& format,
+                              int compressionLevel, int numThreads,
+                              bool reproducible)
 {
 #if defined(CMAKE_BUILD_WITH_CMAKE)
   std::string cwd = cmSystemTools::GetCurrentWorkingDirectory();
@@ -1666,7 +1772,8 @@ bool cmSystemTools::CreateTar(const char* outFileName,
       break;
   }
 
-  cmArchiveWrite a(fout, compress, format.empty() ? "paxr" : format);
+  cmArchiveWrite a(fout, compress, format.empty() ? "paxr" : format,
+                   compressionLevel, numThreads, reproducible);
 
   a.SetMTime(mtime);
   a.SetVerbose(verbose);
@@ -1688,6 +1795,9 @@ bool cmSystemTools::CreateTar(const char* outFileName,
   (void)outFileName;
   (void)files;
   (void)verbose;
+  (void)compressionLevel;
+  (void)numThreads;
+  (void)reproducible;
   return false;
 #endif
 }
@@ -1853,7 +1963,213 @@ bool copy_data(struct archive* ar, struct archive* aw)
 #  endif
 }
 
-bool extract_tar(const char* outFileName, bool verbose, bool extract)
+// Regular files up to this size are read into memory and written by the
+// threads of a ParallelDiskWriter.  Larger files are written directly.
+size_t const ParallelExtractMaxFileSize = 8 * 1024 * 1024;
+
+// The data read but not yet written is limited to about this size.
+size_t const ParallelExtractMaxBytesInFlight = 64 * 1024 * 1024;
+
+// Writes the regular files of an archive on a pool of threads, while the
+// calling thread reads and decompresses the archive.  Each thread has its
+// own disk writer.  Entries that may depend on files already queued, like
+// links, must wait until those are written.
+class ParallelDiskWriter
+{
+public:
+  ParallelDiskWriter(int flags, unsigned int threads)
+  {
+    // Create all disk writers here, because creating one changes the
+    // process umask for a moment.
+    for (unsigned int i = 0; i < threads; ++i) {
+      struct archive* ext = archive_write_disk_new();
+      archive_write_disk_set_options(ext, flags);
+      this->Disks.push_back(ext);
+    }
+    for (struct archive* ext : this->Disks) {
+      this->Threads.emplace_back(&ParallelDiskWriter::Work, this, ext);
+    }
+  }
+
+  ~ParallelDiskWriter() { this->Finish(); }
+
+  ParallelDiskWriter(ParallelDiskWriter const&) = delete;
+  ParallelDiskWriter& operator=(ParallelDiskWriter const&) = delete;
+
+  // Queue a regular file with its data.  Returns false if a file written
+  // earlier failed.
+  bool Write(struct archive_entry* entry, std::vector<char> data)
+  {
+    size_t const size = data.size();
+    {
+      std::unique_lock<std::mutex> lock(this->Mutex);
+      this->SpaceReady.wait(lock, [this, size]() {
+        return !this->Error.empty() || this->BytesInFlight == 0 ||
+          this->BytesInFlight + size <= ParallelExtractMaxBytesInFlight;
+      });
+      if (!this->Error.empty()) {
+        return false;
+      }
+      this->BytesInFlight += size;
+      this->Jobs.emplace_back(archive_entry_clone(entry), std::move(data));
+    }
+    this->WorkReady.notify_one();
+    this->Pending.insert(cm_archive_entry_pathname(entry));
+    return true;
+  }
+
+  // Whether the path was queued since the last wait.
+  bool IsPending(std::string const& path) const
+  {
+    return this->Pending.count(path) != 0;
+  }
+
+  // Wait until all queued files are written.  Returns false on failure.
+  bool Wait()
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->SpaceReady.wait(
+      lock, [this]() { return this->Jobs.empty() && this->Active == 0; });
+    this->Pending.clear();
+    return this->Error.empty();
+  }
+
+  // Write the remaining files and stop the threads.
+  bool Finish()
+  {
+    bool const okay = this->Wait();
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Stopping = true;
+    }
+    this->WorkReady.notify_all();
+    for (std::thread& t : this->Threads) {
+      t.join();
+    }
+    this->Threads.clear();
+    for (struct archive* ext : this->Disks) {
+      archive_write_free(ext);
+    }
+    this->Disks.clear();
+    return okay;
+  }
+
+  std::string const& GetError() const { return this->Error; }
+  std::string const& GetErrorFile() const { return this->ErrorFile; }
+
+private:
+  struct Job
+  {
+    Job(struct archive_entry* entry, std::vector<char> data)
+      : Entry(entry)
+      , Data(std::move(data))
+    {
+    }
+    struct archive_entry* Entry;
+    std::vector<char> Data;
+  };
+
+  void Work(struct archive* ext)
+  {
+    for (;;) {
+      std::unique_ptr<Job> job;
+      {
+        std::unique_lock<std::mutex> lock(this->Mutex);
+        this->WorkReady.wait(lock, [this]() {
+          return this->Stopping || !this->Jobs.empty();
+        });
+        if (this->Jobs.empty()) {
+          return;
+        }
+        job = cm::make_unique<Job>(std::move(this->Jobs.front()));
+        this->Jobs.pop_front();
+        ++this->Active;
+      }
+
+      // The whole file is written at once, so the file system can
+      // allocate it in one piece.
+      std::string error;
+      std::string file;
+      if (archive_write_header(ext, job->Entry) != ARCHIVE_OK) {
+        error = "Problem with archive_write_header(): ";
+      } else if (!job->Data.empty() &&
+                 archive_write_data(ext, &job->Data[0], job->Data.size()) !=
+                   static_cast<__LA_SSIZE_T>(job->Data.size())) {
+        error = "Problem with archive_write_data(): ";
+      } else if (archive_write_finish_entry(ext) != ARCHIVE_OK) {
+        error = "Problem with archive_write_finish_entry(): ";
+      }
+      if (!error.empty()) {
+        const char* err = archive_error_string(ext);
+        error += err ? err : "unknown error";
+        file = cm_archive_entry_pathname(job->Entry);
+      }
+      archive_entry_free(job->Entry);
+
+      {
+        std::lock_guard<std::mutex> lock(this->Mutex);
+        this->BytesInFlight -= job->Data.size();
+        --this->Active;
+        if (this->Error.empty()) {
+          this->Error = error;
+          this->ErrorFile = file;
+        }
+      }
+      this->SpaceReady.notify_all();
+    }
+  }
+
+  std::mutex Mutex;
+  std::condition_variable WorkReady;
+  std::condition_variable SpaceReady;
+  std::deque<Job> Jobs;
+  size_t BytesInFlight = 0;
+  size_t Active = 0;
+  bool Stopping = false;
+  std::string Error;
+  std::string ErrorFile;
+  std::vector<struct archive*> Disks;
+  std::vector<std::thread> Threads;
+  // Only used by the reading thread.
+  std::set<std::string> Pending;
+};
+
+// Whether a ParallelDiskWriter may write the current entry.
+bool is_parallel_extractable(struct archive_entry* entry)
+{
+  return archive_entry_filetype(entry) == AE_IFREG &&
+    !archive_entry_hardlink(entry) && archive_entry_size_is_set(entry) &&
+    archive_entry_size(entry) >= 0 &&
+    static_cast<size_t>(archive_entry_size(entry)) <=
+    ParallelExtractMaxFileSize &&
+    archive_entry_sparse_count(entry) == 0;
+}
+
+// Read the data of the current entry into memory.
+bool read_data(struct archive* ar, std::vector<char>& data)
+{
+  size_t offset = 0;
+  while (offset < data.size()) {
+    __LA_SSIZE_T const r =
+      archive_read_data(ar, &data[offset], data.size() - offset);
+    if (r < 0 && !la_diagnostic(ar, r)) {
+      return false;
+    }
+    if (r <= 0) {
+      break;
+    }
+    offset += static_cast<size_t>(r);
+  }
+  if (offset != data.size()) {
+    cmSystemTools::Error("Problem with archive_read_data(): ",
+                         "truncated entry data");
+    return false;
+  }
+  return true;
+}
+
+bool extract_tar(const char* outFileName, bool verbose, bool extract,
+                 int numThreads)
 {
   cmLocaleRAII localeRAII;
   static_cast<void>(localeRAII);
@@ -1870,6 +2186,14 @@ bool extract_tar(const char* outFileName, bool verbose, bool extract)
     archive_read_close(a);
     return false;
   }
+  // Write files on several threads while this one reads the archive.
+  unsigned int threads = numThreads > 0
+    ? static_cast<unsigned int>(numThreads)
+    : std::max(std::thread::hardware_concurrency(), 1u);
+  std::unique_ptr<ParallelDiskWriter> pool;
+  if (extract && threads > 1) {
+    pool = cm::make_unique<ParallelDiskWriter>(ARCHIVE_EXTRACT_TIME, threads);
+  }
   for (;;) {
     r = archive_read_next_header(a, &entry);
     if (r == ARCHIVE_EOF) {
@@ -1900,6 +2224,30 @@ bool extract_tar(const char* outFileName, bool verbose, bool extract)
         break;
       }
 
+      if (pool) {
+        // Links may refer to files still being written, and a path given
+        // twice must be written in order.  Directories do not wait.
+        bool const parallel = is_parallel_extractable(entry);
+        if (pool->IsPending(cm_archive_entry_pathname(entry)) ||
+            (archive_entry_filetype(entry) != AE_IFDIR &&
+             (archive_entry_filetype(entry) != AE_IFREG ||
+              archive_entry_hardlink(entry)))) {
+          if (!pool->Wait()) {
+            r = ARCHIVE_FATAL;
+            break;
+          }
+        }
+        if (parallel) {
+          std::vector<char> data(
+            static_cast<size_t>(archive_entry_size(entry)));
+          if (!read_data(a, data) || !pool->Write(entry, std::move(data))) {
+            r = ARCHIVE_FATAL;
+            break;
+          }
+          continue;
+        }
+      }
+
       r = archive_write_header(ext, entry);
       if (r == ARCHIVE_OK) {
         if (!copy_data(a, ext)) {
@@ -1928,6 +2276,14 @@ bool extract_tar(const char* outFileName, bool verbose, bool extract)
       }
     }
   }
+  // Directory times are set when the writer is freed, after all files.
+  if (pool && !pool->Finish()) {
+    if (!pool->GetError().empty()) {
+      cmSystemTools::Error(pool->GetError());
+      cmSystemTools::Error("Current file: ", pool->GetErrorFile().c_str());
+    }
+    r = ARCHIVE_FATAL;
+  }
   archive_write_free(ext);
   archive_read_close(a);
   archive_read_free(a);
@@ -1936,13 +2292,15 @@ bool extract_tar(const char* outFileName, bool verbose, bool extract)
 }
 #endif
 
-bool cmSystemTools::ExtractTar(const char* outFileName, bool verbose)
+bool cmSystemTools::ExtractTar(const char* outFileName, bool verbose,
+                               int numThreads)
 {
 #if defined(CMAKE_BUILD_WITH_CMAKE)
-  return extract_tar(outFileName, verbose, true);
+  return extract_tar(outFileName, verbose, true, numThreads);
 #else
   (void)outFileName;
   (void)verbose;
+  (void)numThreads;
   return false;
 #endif
 }
@@ -1950,7 +2308,7 @@ bool cmSystemTools::ExtractTar(const char* outFileName, bool verbose)
 bool cmSystemTools::ListTar(const char* outFileName, bool verbose)
 {
 #if defined(CMAKE_BUILD_WITH_CMAKE)
-  return extract_tar(outFileName, verbose, false);
+  return extract_tar(outFileName, verbose, false, 1);
 #else
   (void)outFileName;
   (void)verbose;
@@ -2517,6 +2875,143 @@ struct cmSystemToolsRPathInfo
   std::string Name;
   std::string Value;
 };
+
+// Bytes to be written over the file at a known offset.
+struct cmSystemToolsFileEdit
+{
+  unsigned long Position;
+  std::string Bytes;
+  std::string Name;
+};
+
+// Compute the edits that remove the RPATH and RUNPATH entries from an
+// already parsed binary.  Leaves the edits empty if there are none.
+static bool cmSystemToolsRemoveRPathEdits(
+  cmELF& elf, std::vector<cmSystemToolsFileEdit>& edits, std::string* emsg)
+{
+  // Get the RPATH and RUNPATH entries from it.
+  int se_count = 0;
+  cmELF::StringEntry const* se[2] = { nullptr, nullptr };
+  const char* se_name[2] = { nullptr, nullptr };
+  if (cmELF::StringEntry const* se_rpath = elf.GetRPath()) {
+    se[se_count] = se_rpath;
+    se_name[se_count] = "RPATH";
+    ++se_count;
+  }
+  if (cmELF::StringEntry const* se_runpath = elf.GetRunPath()) {
+    se[se_count] = se_runpath;
+    se_name[se_count] = "RUNPATH";
+    ++se_count;
+  }
+  if (se_count == 0) {
+    // There is no RPATH or RUNPATH anyway.
+    return true;
+  }
+
+  // Obtain a copy of the dynamic entries
+  cmELF::DynamicEntryList dentries = elf.GetDynamicEntries();
+  if (dentries.empty()) {
+    // This should happen only for invalid ELF files where a DT_NULL
+    // appears before the end of the table.
+    if (emsg) {
+      *emsg = "DYNAMIC section contains a DT_NULL before the end.";
+    }
+    return false;
+  }
+
+  // Get size of one DYNAMIC entry
+  unsigned long const sizeof_dentry =
+    elf.GetDynamicEntryPosition(1) - elf.GetDynamicEntryPosition(0);
+
+  // Adjust the entry list as necessary to remove the run path
+  unsigned long entriesErased = 0;
+  for (cmELF::DynamicEntryList::iterator it = dentries.begin();
+       it != dentries.end();) {
+    if (it->first == cmELF::TagRPath || it->first == cmELF::TagRunPath) {
+      it = dentries.erase(it);
+      entriesErased++;
+      continue;
+    }
+    if (cmELF::TagMipsRldMapRel != 0 &&
+        it->first == cmELF::TagMipsRldMapRel) {
+      // Background: debuggers need to know the "linker map" which contains
+      // the addresses each dynamic object is loaded at. Most arches use
+      // the DT_DEBUG tag which the dynamic linker writes to (directly) and
+      // contain the location of the linker map, however on MIPS the
+      // .dynamic section is always read-only so this is not possible. MIPS
+      // objects instead contain a DT_MIPS_RLD_MAP tag which contains the
+      // address where the dynamic linker will write to (an indirect
+      // version of DT_DEBUG). Since this doesn't work when using PIE, a
+      // relative equivalent was created - DT_MIPS_RLD_MAP_REL. Since this
+      // version contains a relative offset, moving it changes the
+      // calculated address. This may cause the dynamic linker to write
+      // into memory it should not be changing.
+      //
+      // To fix this, we adjust the value of DT_MIPS_RLD_MAP_REL here. If
+      // we move it up by n bytes, we add n bytes to the value of this tag.
+      it->second += entriesErased * sizeof_dentry;
+    }
+
+    it++;
+  }
+
+  // Encode new entries list
+  std::vector<char> const bytes = elf.EncodeDynamicEntries(dentries);
+  cmSystemToolsFileEdit header;
+  header.Position = elf.GetDynamicEntryPosition(0);
+  header.Bytes.assign(bytes.begin(), bytes.end());
+  header.Name = "DYNAMIC table header";
+  edits.push_back(std::move(header));
+
+  // Fill the RPATH and RUNPATH strings with zero bytes.
+  for (int i = 0; i < se_count; ++i) {
+    cmSystemToolsFileEdit zero;
+    zero.Position = se[i]->Position;
+    zero.Bytes.assign(se[i]->Size, '\0');
+    zero.Name = se_name[i];
+    edits.push_back(std::move(zero));
+  }
+  return true;
+}
+
+// Write all edits with one open of the file.  The edits are small, so
+// this is cheaper than mapping the whole binary into memory.
+static bool cmSystemToolsWriteFileEdits(
+  std::string const& file, std::vector<cmSystemToolsFileEdit> const& edits,
+  std::string* emsg)
+{
+  // Open the file for update.
+  cmsys::ofstream f(file.c_str(),
+                    std::ios::in | std::ios::out | std::ios::binary);
+  if (!f) {
+    if (emsg) {
+      *emsg = "Error opening file for update.";
+    }
+    return false;
+  }
+
+  for (cmSystemToolsFileEdit const& edit : edits) {
+    if (!f.seekp(edit.Position)) {
+      if (emsg) {
+        *emsg = "Error seeking to ";
+        *emsg += edit.Name;
+        *emsg += " position.";
+      }
+      return false;
+    }
+    if (!f.write(edit.Bytes.data(),
+                 static_cast<std::streamsize>(edit.Bytes.size())) ||
+        !f.flush()) {
+      if (emsg) {
+        *emsg = "Error writing the new ";
+        *emsg += edit.Name;
+        *emsg += " to the file.";
+      }
+      return false;
+    }
+  }
+  return true;
+}
 #endif
 
 #if defined(CMAKE_USE_ELF_PARSER)
@@ -2531,6 +3026,7 @@ bool cmSystemTools::ChangeRPath(std::string const& file,
   int rp_count = 0;
   bool remove_rpath = true;
   cmSystemToolsRPathInfo rp[2];
+  std::vector<cmSystemToolsFileEdit> edits;
   {
     // Parse the ELF binary.
     cmELF elf(file.c_str());
@@ -2631,60 +3127,37 @@ bool cmSystemTools::ChangeRPath(std::string const& file,
       // This entry is ready for update.
       ++rp_count;
     }
-  }
-
-  // If no runtime path needs to be changed, we are done.
-  if (rp_count == 0) {
-    return true;
-  }
 
-  // If the resulting rpath is empty, just remove the entire entry instead.
-  if (remove_rpath) {
-    return cmSystemTools::RemoveRPath(file, emsg, changed);
-  }
-
-  {
-    // Open the file for update.
-    cmsys::ofstream f(file.c_str(),
-                      std::ios::in | std::ios::out | std::ios::binary);
-    if (!f) {
-      if (emsg) {
-        *emsg = "Error opening file for update.";
-      }
-      return false;
+    // If no runtime path needs to be changed, we are done.
+    if (rp_count == 0) {
+      return true;
     }
 
-    // Store the new RPATH and RUNPATH strings.
-    for (int i = 0; i < rp_count; ++i) {
-      // Seek to the RPATH position.
-      if (!f.seekp(rp[i].Position)) {
-        if (emsg) {
-          *emsg = "Error seeking to ";
-          *emsg += rp[i].Name;
-          *emsg += " position.";
-        }
+    if (remove_rpath) {
+      // If the resulting rpath is empty, just remove the entire entry
+      // instead.  Use the entries already parsed above.
+      if (!cmSystemToolsRemoveRPathEdits(elf, edits, emsg)) {
         return false;
       }
-
+    } else {
       // Write the new rpath.  Follow it with enough null terminators to
       // fill the string table entry.
-      f << rp[i].Value;
-      for (unsigned long j = rp[i].Value.length(); j < rp[i].Size; ++j) {
-        f << '\0';
-      }
-
-      // Make sure it wrote correctly.
-      if (!f) {
-        if (emsg) {
-          *emsg = "Error writing the new ";
-          *emsg += rp[i].Name;
-          *emsg += " string to the file.";
-        }
-        return false;
+      for (int i = 0; i < rp_count; ++i) {
+        cmSystemToolsFileEdit edit;
+        edit.Position = rp[i].Position;
+        edit.Bytes = rp[i].Value;
+        edit.Bytes.resize(rp[i].Size, '\0');
+        edit.Name = rp[i].Name + " string";
+        edits.push_back(std::move(edit));
       }
     }
   }
 
+  // Store the new DYNAMIC table, RPATH and RUNPATH strings.
+  if (!cmSystemToolsWriteFileEdits(file, edits, emsg)) {
+    return false;
+  }
+
   // Everything was updated successfully.
   if (changed) {
     *changed = true;
@@ -2840,135 +3313,22 @@ bool cmSystemTools::RemoveRPath(std::string const& file, std::string* emsg,
   if (removed) {
     *removed = false;
   }
-  int zeroCount = 0;
-  unsigned long zeroPosition[2] = { 0, 0 };
-  unsigned long zeroSize[2] = { 0, 0 };
-  unsigned long bytesBegin = 0;
-  std::vector<char> bytes;
+  std::vector<cmSystemToolsFileEdit> edits;
   {
     // Parse the ELF binary.
     cmELF elf(file.c_str());
-
-    // Get the RPATH and RUNPATH entries from it and sort them by index
-    // in the dynamic section header.
-    int se_count = 0;
-    cmELF::StringEntry const* se[2] = { nullptr, nullptr };
-    if (cmELF::StringEntry const* se_rpath = elf.GetRPath()) {
-      se[se_count++] = se_rpath;
-    }
-    if (cmELF::StringEntry const* se_runpath = elf.GetRunPath()) {
-      se[se_count++] = se_runpath;
-    }
-    if (se_count == 0) {
-      // There is no RPATH or RUNPATH anyway.
-      return true;
-    }
-    if (se_count == 2 && se[1]->IndexInSection < se[0]->IndexInSection) {
-      std::swap(se[0], se[1]);
-    }
-
-    // Obtain a copy of the dynamic entries
-    cmELF::DynamicEntryList dentries = elf.GetDynamicEntries();
-    if (dentries.empty()) {
-      // This should happen only for invalid ELF files where a DT_NULL
-      // appears before the end of the table.
-      if (emsg) {
-        *emsg = "DYNAMIC section contains a DT_NULL before the end.";
-      }
+    if (!cmSystemToolsRemoveRPathEdits(elf, edits, emsg)) {
       return false;
     }
-
-    // Save information about the string entries to be zeroed.
-    zeroCount = se_count;
-    for (int i = 0; i < se_count; ++i) {
-      zeroPosition[i] = se[i]->Position;
-      zeroSize[i] = se[i]->Size;
-    }
-
-    // Get size of one DYNAMIC entry
-    unsigned long const sizeof_dentry =
-      elf.GetDynamicEntryPosition(1) - elf.GetDynamicEntryPosition(0);
-
-    // Adjust the entry list as necessary to remove the run path
-    unsigned long entriesErased = 0;
-    for (cmELF::DynamicEntryList::iterator it = dentries.begin();
-         it != dentries.end();) {
-      if (it->first == cmELF::TagRPath || it->first == cmELF::TagRunPath) {
-        it = dentries.erase(it);
-        entriesErased++;
-        continue;
-      }
-      if (cmELF::TagMipsRldMapRel != 0 &&
-          it->first == cmELF::TagMipsRldMapRel) {
-        // Background: debuggers need to know the "linker map" which contains
-        // the addresses each dynamic object is loaded at. Most arches use
-        // the DT_DEBUG tag which the dynamic linker writes to (directly) and
-        // contain the location of the linker map, however on MIPS the
-        // .dynamic section is always read-only so this is not possible. MIPS
-        // objects instead contain a DT_MIPS_RLD_MAP tag which contains the
-        // address where the dynamic linker will write to (an indirect
-        // version of DT_DEBUG). Since this doesn't work when using PIE, a
-        // relative equivalent was created - DT_MIPS_RLD_MAP_REL. Since this
-        // version contains a relative offset, moving it changes the
-        // calculated address. This may cause the dynamic linker to write
-        // into memory it should not be changing.
-        //
-        // To fix this, we adjust the value of DT_MIPS_RLD_MAP_REL here. If
-        // we move it up by n bytes, we add n bytes to the value of this tag.
-        it->second += entriesErased * sizeof_dentry;
-      }
-
-      it++;
-    }
-
-    // Encode new entries list
-    bytes = elf.EncodeDynamicEntries(dentries);
-    bytesBegin = elf.GetDynamicEntryPosition(0);
-  }
-
-  // Open the file for update.
-  cmsys::ofstream f(file.c_str(),
-                    std::ios::in | std::ios::out | std::ios::binary);
-  if (!f) {
-    if (emsg) {
-      *emsg = "Error opening file for update.";
-    }
-    return false;
   }
-
-  // Write the new DYNAMIC table header.
-  if (!f.seekp(bytesBegin)) {
-    if (emsg) {
-      *emsg = "Error seeking to DYNAMIC table header for RPATH.";
-    }
-    return false;
+  if (edits.empty()) {
+    // There is no RPATH or RUNPATH anyway.
+    return true;
   }
-  if (!f.write(&bytes[0], bytes.size())) {
-    if (emsg) {
-      *emsg = "Error replacing DYNAMIC table header.";
-    }
+  if (!cmSystemToolsWriteFileEdits(file, edits, emsg)) {
     return false;
   }
 
-  // Fill the RPATH and RUNPATH strings with zero bytes.
-  for (int i = 0; i < zeroCount; ++i) {
-    if (!f.seekp(zeroPosition[i])) {
-      if (emsg) {
-        *emsg = "Error seeking to RPATH position.";
-      }
-      return false;
-    }
-    for (unsigned long j = 0; j < zeroSize[i]; ++j) {
-      f << '\0';
-    }
-    if (!f) {
-      if (emsg) {
-        *emsg = "Error writing the empty rpath string to the file.";
-      }
-      return false;
-    }
-  }
-
   // Everything was updated successfully.
   if (removed) {
     *removed = true;
@@ -180,6 +180,21 @@ public:
   static bool cmCopyFile(const std::string& source,
                          const std::string& destination);
 
+  /** Copy a file like KWSys does, but let the kernel clone or copy the
+      content of regular files where it can.  Unless always is true, a
+      destination with the same content is left alone.  */
+  static bool CopyAFile(const std::string& source,
+                        const std::string& destination, bool always = true);
+
+  /** Copy the content of a regular file to the given file without
+      passing it through user space.  The file system shares the blocks
+      if it can, or else the kernel copies them.  Returns false if this
+      is not possible here, and the caller then copies the file itself.
+      The destination is replaced and does not get the permissions of
+      the source.  */
+  static bool CloneOrCopyFileContent(const std::string& source,
+                                     const std::string& destination);
+
   /** Rename a file or directory within a single disk volume (atomic
       if possible).  */
   static bool RenameFile(const std::string& oldname,
@@ -436,8 +451,11 @@ public:
                         const std::vector<std::string>& files,
                         cmTarCompression compressType, bool verbose,
                         std::string const& mtime = std::string(),
-                        std::string const& format = std::string());
-  static bool ExtractTar(const char* inFileName, bool verbose);
+                        std::string const& format = std::string(),
+                        int compressionLevel = 0, int numThreads = 1,
+                        bool reproducible = false);
+  static bool ExtractTar(const char* inFileName, bool verbose,
+                         int numThreads = 1);
   // This should be called first thing in main
   // it will keep child processes from inheriting the
   // stdin and stdout of this process.  This is important
@@ -482,7 +500,9 @@ public:
   static bool GuessLibraryInstallName(std::string const& fullPath,
                                       std::string& soname);
 
-  /** Try to set the RPATH in an ELF binary.  */
+  /** Try to set the RPATH in an ELF binary.  The binary is parsed once
+      and only the changed bytes are written, also when the RPATH is
+      removed because the new one is empty.  */
   static bool ChangeRPath(std::string const& file, std::string const& oldRPath,
                           std::string const& newRPath,
                           std::string* emsg = nullptr,
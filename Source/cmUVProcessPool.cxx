@@ -0,0 +1,164 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmUVProcessPool.h"
+
+#include "cmAlgorithms.h"
+
+#include <signal.h>
+#include <utility>
+
+cmUVProcessPool::cmUVProcessPool(size_t slots, FinishFunction finish)
+  : Finish(std::move(finish))
+{
+  uv_loop_init(&this->Loop);
+  for (size_t i = 0; i < slots; ++i) {
+    this->Slots.push_back(cm::make_unique<Slot>());
+    Slot& slot = *this->Slots.back();
+    slot.Pool = this;
+    slot.Index = i;
+    slot.Out.Owner = &slot;
+    slot.Err.Owner = &slot;
+  }
+}
+
+cmUVProcessPool::~cmUVProcessPool()
+{
+  // Close the handles of the processes still running, if any.
+  for (auto const& slot : this->Slots) {
+    if (slot->Process.get() != nullptr) {
+      uv_process_kill(slot->Process, SIGKILL);
+    }
+  }
+  this->Slots.clear();
+  uv_run(&this->Loop, UV_RUN_DEFAULT);
+  uv_loop_close(&this->Loop);
+}
+
+bool cmUVProcessPool::IsBusy(size_t slot) const
+{
+  return this->Slots[slot]->Current != nullptr;
+}
+
+bool cmUVProcessPool::Start(size_t index, Job& job)
+{
+  Slot& slot = *this->Slots[index];
+
+  std::vector<const char*> args;
+  for (std::string const& arg : job.Command) {
+    args.push_back(arg.c_str());
+  }
+  args.push_back(nullptr);
+
+  std::vector<const char*> env;
+  for (std::string const& var : job.Environment) {
+    env.push_back(var.c_str());
+  }
+  env.push_back(nullptr);
+
+  slot.Out.Target = &job.Output;
+  slot.Err.Target = &job.Errors;
+  slot.Out.Handle.init(this->Loop, 0, &slot.Out);
+  slot.Err.Handle.init(this->Loop, 0, &slot.Err);
+
+  uv_stdio_container_t stdio[3];
+  stdio[0].flags = UV_IGNORE;
+  stdio[0].data.stream = nullptr;
+  stdio[1].flags =
+    static_cast<uv_stdio_flags>(UV_CREATE_PIPE | UV_WRITABLE_PIPE);
+  stdio[1].data.stream = slot.Out.Handle;
+  stdio[2].flags =
+    static_cast<uv_stdio_flags>(UV_CREATE_PIPE | UV_WRITABLE_PIPE);
+  stdio[2].data.stream = slot.Err.Handle;
+
+  uv_process_options_t options = uv_process_options_t();
+  options.file = args[0];
+  options.args = const_cast<char**>(args.data());
+  if (!job.WorkingDirectory.empty()) {
+    options.cwd = job.WorkingDirectory.c_str();
+  }
+  if (!job.Environment.empty()) {
+    options.env = const_cast<char**>(env.data());
+  }
+  options.flags = UV_PROCESS_WINDOWS_HIDE;
+  options.stdio_count = 3;
+  options.stdio = stdio;
+  options.exit_cb = &cmUVProcessPool::OnExit;
+
+  int status = args[0] ? slot.Process.spawn(this->Loop, options, &slot)
+                       : UV_EINVAL;
+  if (status == 0) {
+    status = uv_read_start(slot.Out.Handle, &cmUVProcessPool::OnAllocate,
+                           &cmUVProcessPool::OnRead);
+  }
+  if (status == 0) {
+    status = uv_read_start(slot.Err.Handle, &cmUVProcessPool::OnAllocate,
+                           &cmUVProcessPool::OnRead);
+  }
+  if (status != 0) {
+    job.Errors += uv_strerror(status);
+    slot.Out.Handle.reset();
+    slot.Err.Handle.reset();
+    if (slot.Process.get() != nullptr) {
+      // Do not leave the process behind without anyone reading its output.
+      uv_process_kill(slot.Process, SIGKILL);
+      slot.Process.reset();
+    }
+    return false;
+  }
+
+  slot.Current = &job;
+  return true;
+}
+
+void cmUVProcessPool::Run()
+{
+  uv_run(&this->Loop, UV_RUN_DEFAULT);
+}
+
+void cmUVProcessPool::OnAllocate(uv_handle_t* handle, size_t suggestedSize,
+                                 uv_buf_t* buf)
+{
+  Pipe& pipe = *static_cast<Pipe*>(handle->data);
+  pipe.Buffer.resize(suggestedSize);
+  *buf = uv_buf_init(pipe.Buffer.data(),
+                     static_cast<unsigned int>(pipe.Buffer.size()));
+}
+
+void cmUVProcessPool::OnRead(uv_stream_t* stream, ssize_t nread,
+                             const uv_buf_t* buf)
+{
+  Pipe& pipe = *static_cast<Pipe*>(stream->data);
+  if (nread > 0) {
+    pipe.Target->append(buf->base, static_cast<size_t>(nread));
+  } else if (nread < 0) {
+    pipe.Handle.reset();
+    pipe.Owner->Pool->TryFinish(*pipe.Owner);
+  }
+}
+
+void cmUVProcessPool::OnExit(uv_process_t* process, int64_t exitStatus,
+                             int termSignal)
+{
+  Slot& slot = *static_cast<Slot*>(process->data);
+  Job& job = *slot.Current;
+  if (termSignal == 0) {
+    job.Exited = true;
+    job.ExitValue = static_cast<int>(exitStatus);
+  } else {
+    job.Errors += "Process terminated by signal ";
+    job.Errors += std::to_string(termSignal);
+  }
+  slot.Process.reset();
+  slot.Pool->TryFinish(slot);
+}
+
+void cmUVProcessPool::TryFinish(Slot& slot)
+{
+  // Output may still arrive after the process has exited.
+  if (slot.Process.get() != nullptr || slot.Out.Handle.get() != nullptr ||
+      slot.Err.Handle.get() != nullptr) {
+    return;
+  }
+  slot.Current = nullptr;
+  this->Finish(slot.Index);
+}
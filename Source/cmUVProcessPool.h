@@ -0,0 +1,99 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#ifndef cmUVProcessPool_h
+#define cmUVProcessPool_h
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include "cmUVHandlePtr.h"
+#include "cm_uv.h"
+
+#include <functional>
+#include <memory>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/** \class cmUVProcessPool
+ * \brief Run several child processes at once on a libuv loop
+ *
+ * Each process runs in one of a fixed number of slots and has its
+ * standard output and error captured.  Once a process exited and all
+ * of its output was read, its slot is free again and the finish
+ * function is called with it on the thread calling Run.  The finish
+ * function may start the next process.
+ */
+class cmUVProcessPool
+{
+public:
+  struct Job
+  {
+    std::vector<std::string> Command;
+    // The working directory of the process, or empty for the current one
+    std::string WorkingDirectory;
+    // The complete environment of the process, or empty to inherit it
+    std::vector<std::string> Environment;
+    // Whether the process ran and exited
+    bool Exited = false;
+    int ExitValue = 0;
+    std::string Output;
+    std::string Errors;
+  };
+
+  //! Handle the job that finished in the given slot.
+  typedef std::function<void(size_t)> FinishFunction;
+
+  cmUVProcessPool(size_t slots, FinishFunction finish);
+  ~cmUVProcessPool();
+
+  cmUVProcessPool(cmUVProcessPool const&) = delete;
+  cmUVProcessPool& operator=(cmUVProcessPool const&) = delete;
+
+  size_t GetSlotCount() const { return this->Slots.size(); }
+  bool IsBusy(size_t slot) const;
+
+  /** Start the job in the given free slot.  The job must stay valid
+      until its slot finished.  If the process cannot start, the error
+      is added to the Errors of the job, false is returned and the
+      finish function is not called.  */
+  bool Start(size_t slot, Job& job);
+
+  //! Run the loop until all processes and other requests are done.
+  void Run();
+
+  //! The loop, e.g. to queue work on the libuv thread pool
+  uv_loop_t& GetLoop() { return this->Loop; }
+
+private:
+  struct Slot;
+  struct Pipe
+  {
+    Slot* Owner = nullptr;
+    std::string* Target = nullptr;
+    std::vector<char> Buffer;
+    cm::uv_pipe_ptr Handle;
+  };
+  struct Slot
+  {
+    cmUVProcessPool* Pool = nullptr;
+    size_t Index = 0;
+    Job* Current = nullptr;
+    cm::uv_process_ptr Process;
+    Pipe Out;
+    Pipe Err;
+  };
+
+  void TryFinish(Slot& slot);
+
+  static void OnAllocate(uv_handle_t* handle, size_t suggestedSize,
+                         uv_buf_t* buf);
+  static void OnRead(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
+  static void OnExit(uv_process_t* process, int64_t exitStatus,
+                     int termSignal);
+
+  FinishFunction Finish;
+  uv_loop_t Loop;
+  std::vector<std::unique_ptr<Slot>> Slots;
+};
+
+#endif
@@ -11,6 +11,7 @@
 #include "cmExternalMakefileProjectGenerator.h"
 #include "cmFileTimeComparison.h"
 #include "cmGeneratorTarget.h"
+#include "cmGlobVerificationManager.h"
 #include "cmGlobalGenerator.h"
 #include "cmGlobalGeneratorFactory.h"
 #include "cmLinkLineComputer.h"
@@ -1861,6 +1862,11 @@ std::string const& cmake::GetGlobVerifyScript() const
   return this->State->GetGlobVerifyScript();
 }
 
+std::string const& cmake::GetGlobVerifyCache() const
+{
+  return this->State->GetGlobVerifyCache();
+}
+
 std::string const& cmake::GetGlobVerifyStamp() const
 {
   return this->State->GetGlobVerifyStamp();
@@ -1870,12 +1876,13 @@ void cmake::AddGlobCacheEntry(bool recurse, bool listDirectories,
                               bool followSymlinks, const std::string& relative,
                               const std::string& expression,
                               const std::vector<std::string>& files,
+                              const cmGlobDirectories& directories,
                               const std::string& variable,
                               cmListFileBacktrace const& backtrace)
 {
   this->State->AddGlobCacheEntry(recurse, listDirectories, followSymlinks,
-                                 relative, expression, files, variable,
-                                 backtrace);
+                                 relative, expression, files, directories,
+                                 variable, backtrace);
 }
 
 std::string cmake::StripExtension(const std::string& file) const
@@ -2228,6 +2235,10 @@ int cmake::CheckBuildSystem()
     return 1;
   }
 
+  // Lookup the times of all files at once.
+  this->FileComparison->Prefetch(depends);
+  this->FileComparison->Prefetch(outputs);
+
   // Find the newest dependency.
   std::vector<std::string>::iterator dep = depends.begin();
   std::string dep_newest = *dep++;
@@ -2697,14 +2708,13 @@ int cmake::Build(int jobs, const std::string& dir, const std::string& target,
   if (cmSystemTools::FileExists(stampList)) {
 
     // Check if running for Visual Studio 9 - we need to explicitly run
-    // the glob verification script before starting the build
+    // the glob verification before starting the build
     this->AddScriptingCommands();
     if (this->GlobalGenerator->MatchesGeneratorName("Visual Studio 9 2008")) {
-      std::string const globVerifyScript =
-        cachePath + "/" + "CMakeFiles/" + "VerifyGlobs.cmake";
-      if (cmSystemTools::FileExists(globVerifyScript)) {
-        std::vector<std::string> args;
-        this->ReadListFile(args, globVerifyScript);
+      std::string const globVerifyCache =
+        cachePath + "/" + "CMakeFiles/" + "VerifyGlobs.txt";
+      if (cmSystemTools::FileExists(globVerifyCache)) {
+        cmGlobVerificationManager::VerifyGlobs(globVerifyCache);
       }
     }
 
@@ -27,6 +27,7 @@
 class cmExternalMakefileProjectGeneratorFactory;
 class cmFileAPI;
 class cmFileTimeComparison;
+class cmGlobDirectories;
 class cmGlobalGenerator;
 class cmGlobalGeneratorFactory;
 class cmMakefile;
@@ -272,11 +273,13 @@ int Execute(const std::vector<std::string>& commandLineArgs);
 
   bool DoWriteGlobVerifyTarget() const;
   std::string const& GetGlobVerifyScript() const;
+  std::string const& GetGlobVerifyCache() const;
   std::string const& GetGlobVerifyStamp() const;
   void AddGlobCacheEntry(bool recurse, bool listDirectories,
                          bool followSymlinks, const std::string& relative,
                          const std::string& expression,
                          const std::vector<std::string>& files,
+                         const cmGlobDirectories& directories,
                          const std::string& variable,
                          cmListFileBacktrace const& bt);
 
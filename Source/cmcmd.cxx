@@ -4,6 +4,7 @@
 
 #include "cmAlgorithms.h"
 #include "cmDuration.h"
+#include "cmGlobVerificationManager.h"
 #include "cmGlobalGenerator.h"
 #include "cmLocalGenerator.h"
 #include "cmMakefile.h"
@@ -37,6 +38,7 @@
 #include "cmsys/Process.h"
 #include "cmsys/Terminal.h"
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <iterator>
 #include <memory> // IWYU pragma: keep
@@ -47,6 +49,11 @@
 #include <time.h>
 #include <utility>
 
+// The bootstrap build does not link to a thread library.
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+#  include <thread>
+#endif
+
 class cmConnection;
 
 int cmcmd_cmake_ninja_depends(std::vector<std::string>::const_iterator argBeg,
@@ -80,12 +87,15 @@ void CMakeCommandUsage(const char* program)
     << "  chdir dir cmd [args...]   - run command in a given directory\n"
     << "  compare_files [--ignore-eol] file1 file2\n"
     << "                              - check if file1 is same as file2\n"
-    << "  copy <file>... destination  - copy files to destination "
+    << "  copy [-j <N>] <file>... destination  - copy files to destination "
        "(either file or directory)\n"
-    << "  copy_directory <dir>... destination   - copy content of <dir>... "
-       "directories to 'destination' directory\n"
-    << "  copy_if_different <file>... destination  - copy files if it has "
-       "changed\n"
+    << "  copy_directory [-j <N>] <dir>... destination   - copy content of "
+       "<dir>... directories to 'destination' directory\n"
+    << "  copy_directory_if_different [-j <N>] <dir>... destination\n"
+    << "                            - copy content of <dir>... directories "
+       "if it has changed\n"
+    << "  copy_if_different [-j <N>] <file>... destination  - copy files if "
+       "it has changed\n"
     << "  echo [<string>...]        - displays arguments as text\n"
     << "  echo_append [<string>...] - displays arguments as text but no new "
        "line\n"
@@ -127,6 +137,102 @@ void CMakeCommandUsage(const char* program)
   cmSystemTools::Error(errorStream.str());
 }
 
+// A file to be copied by one of the copy commands.
+struct cmcmdCopyJob
+{
+  std::string Source;
+  std::string Destination;
+  std::string::size_type Argument;
+  bool Failed;
+};
+
+// Parse the "-j <N>" or "-j<N>" option given before the files to copy.
+// Returns the index of the first file, or 0 if the option is invalid.
+static std::string::size_type cmcmdParseCopyJobs(
+  std::vector<std::string> const& args, unsigned long& jobs)
+{
+  jobs = 1;
+  std::string const& arg = args[2];
+  if (!cmHasLiteralPrefix(arg, "-j")) {
+    return 2;
+  }
+  std::string::size_type first = 3;
+  std::string value = arg.substr(2);
+  if (value.empty() && args.size() > 3) {
+    value = args[3];
+    first = 4;
+  }
+  if (!cmSystemTools::StringToULong(value.c_str(), &jobs) || jobs < 1) {
+    std::cerr << "Error: Invalid number of parallel jobs \"" << value
+              << "\" given to " << args[1] << ".\n";
+    return 0;
+  }
+  if (args.size() < first + 2) {
+    std::cerr << "Error: No files given to " << args[1] << ".\n";
+    return 0;
+  }
+  return first;
+}
+
+// Create the directories of a tree under the destination, in order, and
+// queue its files.  Returns false if a directory cannot be read or created.
+static bool cmcmdQueueDirectoryCopy(std::string const& source,
+                                    std::string const& destination,
+                                    std::string::size_type argument,
+                                    std::vector<cmcmdCopyJob>& jobs)
+{
+  cmsys::Directory dir;
+  if (!dir.Load(source) || !cmSystemTools::MakeDirectory(destination)) {
+    return false;
+  }
+  for (unsigned long i = 0; i < dir.GetNumberOfFiles(); ++i) {
+    std::string const name = dir.GetFile(i);
+    if (name == "." || name == "..") {
+      continue;
+    }
+    std::string const path = source + "/" + name;
+    if (cmSystemTools::FileIsDirectory(path)) {
+      if (!cmcmdQueueDirectoryCopy(path, destination + "/" + name, argument,
+                                   jobs)) {
+        return false;
+      }
+    } else {
+      jobs.push_back(cmcmdCopyJob{ path, destination, argument, false });
+    }
+  }
+  return true;
+}
+
+// Copy the queued files on up to the given number of threads.  With
+// onlyIfDifferent, files whose destination has the same content are
+// left alone.  Each job records whether it failed.
+static void cmcmdRunCopyJobs(std::vector<cmcmdCopyJob>& jobs,
+                             unsigned long threads, bool onlyIfDifferent)
+{
+  std::atomic<size_t> next(0);
+  auto worker = [&jobs, &next, onlyIfDifferent]() {
+    for (size_t i = next++; i < jobs.size(); i = next++) {
+      cmcmdCopyJob& job = jobs[i];
+      job.Failed = !cmSystemTools::CopyAFile(job.Source, job.Destination,
+                                             !onlyIfDifferent);
+    }
+  };
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  size_t const threadCount = std::min<size_t>(threads, jobs.size());
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < threadCount; ++t) {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& t : pool) {
+    t.join();
+  }
+#else
+  static_cast<void>(threads);
+  worker();
+#endif
+}
+
 static bool cmTarFilesFrom(std::string const& file,
                            std::vector<std::string>& files)
 {
@@ -470,43 +576,35 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
   // IF YOU ADD A NEW COMMAND, DOCUMENT IT ABOVE and in cmakemain.cxx
   if (args.size() > 1) {
     // Copy file
-    if (args[1] == "copy" && args.size() > 3) {
-      // If multiple source files specified,
-      // then destination must be directory
-      if ((args.size() > 4) &&
-          (!cmSystemTools::FileIsDirectory(args.back()))) {
-        std::cerr << "Error: Target (for copy command) \"" << args.back()
-                  << "\" is not a directory.\n";
+    if ((args[1] == "copy" || args[1] == "copy_if_different") &&
+        args.size() > 3) {
+      bool const onlyIfDifferent = args[1] == "copy_if_different";
+      unsigned long threads;
+      std::string::size_type const first = cmcmdParseCopyJobs(args, threads);
+      if (first == 0) {
         return 1;
       }
-      // If error occurs we want to continue copying next files.
-      bool return_value = false;
-      for (std::string::size_type cc = 2; cc < args.size() - 1; cc++) {
-        if (!cmSystemTools::cmCopyFile(args[cc], args.back())) {
-          std::cerr << "Error copying file \"" << args[cc] << "\" to \""
-                    << args.back() << "\".\n";
-          return_value = true;
-        }
-      }
-      return return_value;
-    }
-
-    // Copy file if different.
-    if (args[1] == "copy_if_different" && args.size() > 3) {
       // If multiple source files specified,
       // then destination must be directory
-      if ((args.size() > 4) &&
+      if ((args.size() > first + 2) &&
           (!cmSystemTools::FileIsDirectory(args.back()))) {
-        std::cerr << "Error: Target (for copy_if_different command) \""
+        std::cerr << "Error: Target (for " << args[1] << " command) \""
                   << args.back() << "\" is not a directory.\n";
         return 1;
       }
       // If error occurs we want to continue copying next files.
+      std::vector<cmcmdCopyJob> jobs;
+      for (std::string::size_type cc = first; cc < args.size() - 1; cc++) {
+        jobs.push_back(cmcmdCopyJob{ args[cc], args.back(), cc, false });
+      }
+      cmcmdRunCopyJobs(jobs, threads, onlyIfDifferent);
       bool return_value = false;
-      for (std::string::size_type cc = 2; cc < args.size() - 1; cc++) {
-        if (!cmSystemTools::CopyFileIfDifferent(args[cc], args.back())) {
-          std::cerr << "Error copying file (if different) from \"" << args[cc]
-                    << "\" to \"" << args.back() << "\".\n";
+      for (cmcmdCopyJob const& job : jobs) {
+        if (job.Failed) {
+          std::cerr << (onlyIfDifferent ? "Error copying file (if different)"
+                                          " from \""
+                                        : "Error copying file \"")
+                    << job.Source << "\" to \"" << args.back() << "\".\n";
           return_value = true;
         }
       }
@@ -514,11 +612,32 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
     }
 
     // Copy directory content
-    if (args[1] == "copy_directory" && args.size() > 3) {
-      // If error occurs we want to continue copying next files.
+    if ((args[1] == "copy_directory" ||
+         args[1] == "copy_directory_if_different") &&
+        args.size() > 3) {
+      bool const onlyIfDifferent = args[1] == "copy_directory_if_different";
+      unsigned long threads;
+      std::string::size_type const first = cmcmdParseCopyJobs(args, threads);
+      if (first == 0) {
+        return 1;
+      }
+      // Create all directories first, then copy the files of all trees
+      // together.  If error occurs we want to continue copying next files.
+      std::vector<bool> failed(args.size(), false);
+      std::vector<cmcmdCopyJob> jobs;
+      for (std::string::size_type cc = first; cc < args.size() - 1; cc++) {
+        failed[cc] =
+          !cmcmdQueueDirectoryCopy(args[cc], args.back(), cc, jobs);
+      }
+      cmcmdRunCopyJobs(jobs, threads, onlyIfDifferent);
+      for (cmcmdCopyJob const& job : jobs) {
+        if (job.Failed) {
+          failed[job.Argument] = true;
+        }
+      }
       bool return_value = false;
-      for (std::string::size_type cc = 2; cc < args.size() - 1; cc++) {
-        if (!cmSystemTools::CopyADirectory(args[cc], args.back())) {
+      for (std::string::size_type cc = first; cc < args.size() - 1; cc++) {
+        if (failed[cc]) {
           std::cerr << "Error copying directory from \"" << args[cc]
                     << "\" to \"" << args.back() << "\".\n";
           return_value = true;
@@ -978,6 +1097,11 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
       return 1;
     }
 
+    // Internal CMake glob verification support.
+    if (args[1] == "cmake_verify_globs" && args.size() == 3) {
+      return cmGlobVerificationManager::VerifyGlobs(args[2]) ? 0 : 1;
+    }
+
     // Internal CMake link script support.
     if (args[1] == "cmake_link_script" && args.size() >= 3) {
       return cmcmd::ExecuteLinkScript(args);
@@ -1020,9 +1144,15 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
 
 #ifdef CMAKE_BUILD_WITH_CMAKE
     if ((args[1] == "cmake_autogen") && (args.size() >= 4)) {
-      cmQtAutoGeneratorMocUic autoGen;
       std::string const& infoDir = args[2];
       std::string const& config = args[3];
+      if (args.size() > 4) {
+        // The info files of further targets follow the configuration
+        std::vector<std::string> infoFiles(1, infoDir);
+        infoFiles.insert(infoFiles.end(), args.begin() + 4, args.end());
+        return cmQtAutoGeneratorMocUic::RunBatch(infoFiles, config) ? 0 : 1;
+      }
+      cmQtAutoGeneratorMocUic autoGen;
       return autoGen.Run(infoDir, config) ? 0 : 1;
     }
     if ((args[1] == "cmake_autorcc") && (args.size() >= 3)) {
@@ -1045,6 +1175,9 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
       std::vector<std::string> files;
       std::string mtime;
       std::string format;
+      unsigned long compressionLevel = 0;
+      unsigned long numThreads = 1;
+      bool reproducible = false;
       bool doing_options = true;
       for (std::string::size_type cc = 4; cc < args.size(); cc++) {
         std::string const& arg = args[cc];
@@ -1053,6 +1186,8 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
             doing_options = false;
           } else if (cmHasLiteralPrefix(arg, "--mtime=")) {
             mtime = arg.substr(8);
+          } else if (arg == "--reproducible") {
+            reproducible = true;
           } else if (cmHasLiteralPrefix(arg, "--files-from=")) {
             std::string const& files_from = arg.substr(13);
             if (!cmTarFilesFrom(files_from, files)) {
@@ -1069,6 +1204,24 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
                                    format.c_str());
               return 1;
             }
+          } else if (cmHasLiteralPrefix(arg, "--compression-level=")) {
+            std::string const& level = arg.substr(20);
+            if (!cmSystemTools::StringToULong(level.c_str(),
+                                              &compressionLevel) ||
+                compressionLevel < 1 || compressionLevel > 9) {
+              cmSystemTools::Error(
+                "Invalid -E tar --compression-level= argument: ",
+                level.c_str());
+              return 1;
+            }
+          } else if (cmHasLiteralPrefix(arg, "--threads=")) {
+            std::string const& threads = arg.substr(10);
+            if (!cmSystemTools::StringToULong(threads.c_str(), &numThreads) ||
+                numThreads > 1024) {
+              cmSystemTools::Error("Invalid -E tar --threads= argument: ",
+                                   threads.c_str());
+              return 1;
+            }
           } else {
             cmSystemTools::Error("Unknown option to -E tar: ", arg.c_str());
             return 1;
@@ -1114,12 +1267,16 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string>& args)
         }
       } else if (flags.find_first_of('c') != std::string::npos) {
         if (!cmSystemTools::CreateTar(outFile.c_str(), files, compress,
-                                      verbose, mtime, format)) {
+                                      verbose, mtime, format,
+                                      static_cast<int>(compressionLevel),
+                                      static_cast<int>(numThreads),
+                                      reproducible)) {
           cmSystemTools::Error("Problem creating tar: ", outFile.c_str());
           return 1;
         }
       } else if (flags.find_first_of('x') != std::string::npos) {
-        if (!cmSystemTools::ExtractTar(outFile.c_str(), verbose)) {
+        if (!cmSystemTools::ExtractTar(outFile.c_str(), verbose,
+                                       static_cast<int>(numThreads))) {
           cmSystemTools::Error("Problem extracting tar: ", outFile.c_str());
           return 1;
         }
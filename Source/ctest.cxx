@@ -3,6 +3,7 @@
 
 #include "CTest/cmCTestLaunch.h"
 #include "CTest/cmCTestScriptHandler.h"
+#include "CTest/cmCTestWorker.h"
 #include "cmCTest.h"
 #include "cmDocumentation.h"
 #include "cmSystemTools.h"
@@ -95,6 +96,8 @@ static const char* cmDocumentationOptions[][2] = {
     "Run a specific number of tests by number." },
   { "-U, --union", "Take the Union of -I and -R" },
   { "--rerun-failed", "Run only the tests that failed previously" },
+  { "--cache-results",
+    "Skip tests whose inputs did not change since they last passed" },
   { "--repeat-until-fail <n>",
     "Require each test to run <n> "
     "times without failing in order to pass" },
@@ -123,12 +126,25 @@ static const char* cmDocumentationOptions[][2] = {
   { "--test-command", "The test to run with the --build-and-test option." },
   { "--test-timeout", "The time limit in seconds, internal use only." },
   { "--test-load", "CPU load threshold for starting new parallel tests." },
+  { "--test-pressure <percent>",
+    "CPU and memory pressure threshold for starting new parallel tests." },
+  { "--workers <n>",
+    "Run the tests in <n> worker processes that capture and check their "
+    "output." },
+  { "--shard-index <i>",
+    "Run only the tests of shard <i> of those given by --shard-count." },
+  { "--shard-count <n>",
+    "Split the tests into <n> shards of about the same expected cost." },
+  { "--shard-cost-file <file>",
+    "Balance the shards by the test costs in <file>, common to all shards." },
   { "--tomorrow-tag", "Nightly or experimental starts with next day tag." },
   { "--overwrite", "Overwrite CTest configuration option." },
   { "--extra-submit <file>[;<file>]", "Submit extra files to the dashboard." },
   { "--force-new-ctest-process",
     "Run child CTest instances as new processes" },
   { "--schedule-random", "Use a random order for scheduling tests" },
+  { "--schedule-critical-path",
+    "Start tests on the longest chains of dependencies first" },
   { "--submit-index",
     "Submit individual dashboard tests with specific index" },
   { "--timeout <seconds>", "Set the default test timeout." },
@@ -165,6 +181,11 @@ int main(int argc, char const* const* argv)
     return cmCTestLaunch::Main(argc, argv);
   }
 
+  // Dispatch 'ctest --worker' mode directly.
+  if (argc >= 2 && strcmp(argv[1], "--worker") == 0) {
+    return cmCTestWorker::Main(argc, argv);
+  }
+
   cmCTest inst;
 
   if (cmSystemTools::GetCurrentWorkingDirectory().empty()) {
@@ -0,0 +1,108 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmSystemTools.h"
+#include "cmWorkingDirectory.h"
+
+#include "cm_libarchive.h"
+
+#include "cmsys/FStream.hxx"
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#define ASSERT_TRUE(x)                                                        \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      std::cout << "ASSERT_TRUE(" #x ") failed on line " << __LINE__ << "\n"; \
+      return false;                                                           \
+    }                                                                         \
+  } while (false)
+
+static const std::string testDir = "testArchiveExtract.dir";
+
+static std::string testData(size_t size, unsigned int seed)
+{
+  std::string data(size, '\0');
+  unsigned int x = seed;
+  for (char& c : data) {
+    x = x * 1103515245 + 12345;
+    c = static_cast<char>(x >> 16);
+  }
+  return data;
+}
+
+static std::string readFile(std::string const& file)
+{
+  cmsys::ifstream fin(file.c_str(), std::ios::in | std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(fin),
+                     std::istreambuf_iterator<char>());
+}
+
+// Add a regular file, or a hard link to an earlier entry, to the archive.
+static bool addEntry(struct archive* a, std::string const& name,
+                     std::string const& data,
+                     std::string const& hardlink = std::string())
+{
+  struct archive_entry* entry = archive_entry_new();
+  archive_entry_set_pathname(entry, name.c_str());
+  archive_entry_set_filetype(entry, AE_IFREG);
+  archive_entry_set_perm(entry, 0644);
+  archive_entry_set_size(entry, static_cast<__LA_INT64_T>(data.size()));
+  if (!hardlink.empty()) {
+    archive_entry_set_hardlink(entry, hardlink.c_str());
+  }
+  bool ok = archive_write_header(a, entry) == ARCHIVE_OK &&
+    (data.empty() ||
+     archive_write_data(a, data.data(), data.size()) ==
+       static_cast<__LA_SSIZE_T>(data.size()));
+  archive_entry_free(entry);
+  return ok;
+}
+
+static bool testExtract(int threads)
+{
+  std::cout << "testExtract(" << threads << ")\n";
+
+  // Small files are queued for the writer threads.  The other entries
+  // are written by the reading thread once the files they may depend on
+  // are written.
+  std::string const small = testData(1000, 1);
+  std::string const large = testData(8 * 1024 * 1024 + 1, 2);
+  std::string const first = testData(2000, 3);
+  std::string const second = testData(3000, 4);
+  std::string const archive = testDir + "/test.tar";
+  {
+    struct archive* a = archive_write_new();
+    archive_write_set_format_pax_restricted(a);
+    ASSERT_TRUE(archive_write_open_filename(a, archive.c_str()) ==
+                ARCHIVE_OK);
+    bool const ok = addEntry(a, "small", small) &&
+      addEntry(a, "twice", first) && addEntry(a, "large", large) &&
+      addEntry(a, "link", std::string(), "small") &&
+      addEntry(a, "twice", second);
+    archive_write_free(a);
+    ASSERT_TRUE(ok);
+  }
+
+  std::string const outDir = testDir + "/out" + std::to_string(threads);
+  cmSystemTools::MakeDirectory(outDir);
+  {
+    cmWorkingDirectory workdir(outDir);
+    ASSERT_TRUE(!workdir.Failed());
+    ASSERT_TRUE(cmSystemTools::ExtractTar("../test.tar", false, threads));
+  }
+  ASSERT_TRUE(readFile(outDir + "/small") == small);
+  ASSERT_TRUE(readFile(outDir + "/large") == large);
+  ASSERT_TRUE(readFile(outDir + "/link") == small);
+  ASSERT_TRUE(readFile(outDir + "/twice") == second);
+  return true;
+}
+
+int testArchiveExtract(int /*unused*/, char* /*unused*/ [])
+{
+  cmSystemTools::RemoveADirectory(testDir);
+  cmSystemTools::MakeDirectory(testDir);
+  bool ok = testExtract(1) && testExtract(4);
+  cmSystemTools::RemoveADirectory(testDir);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCryptoHash.h"
+#include "cmCryptoHashAccel.h"
+#include "cmSystemTools.h"
+
+#include "cmsys/FStream.hxx"
+#include <chrono>
+#include <iostream>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define ASSERT_TRUE(x)                                                        \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      std::cout << "ASSERT_TRUE(" #x ") failed on line " << __LINE__ << "\n"; \
+      return false;                                                           \
+    }                                                                         \
+  } while (false)
+
+static const std::string testDir = "testCryptoHash.dir";
+
+static std::string testData(size_t size)
+{
+  std::string data(size, '\0');
+  unsigned int x = 12345;
+  for (char& c : data) {
+    x = x * 1103515245 + 12345;
+    c = static_cast<char>(x >> 16);
+  }
+  return data;
+}
+
+static bool testKnownValues()
+{
+  std::cout << "testKnownValues()\n";
+
+  cmCryptoHash sha1(cmCryptoHash::AlgoSHA1);
+  ASSERT_TRUE(sha1.HashString("") ==
+              "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+  ASSERT_TRUE(sha1.HashString("abc") ==
+              "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+  cmCryptoHash sha256(cmCryptoHash::AlgoSHA256);
+  ASSERT_TRUE(
+    sha256.HashString("") ==
+    "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  ASSERT_TRUE(
+    sha256.HashString(
+      "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+    "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+  return true;
+}
+
+static bool testBackends(cmCryptoHash::Algo algo)
+{
+  std::cout << "testBackends(" << algo << ")\n";
+
+  // The default backend may use processor extensions.  It must agree
+  // with the portable one for every length of the last block, and no
+  // matter how the input is split.
+  cmCryptoHash fast(algo);
+  cmCryptoHash portable(algo, cmCryptoHash::BackendPortable);
+  std::string const data = testData(300);
+  for (size_t size = 0; size <= data.size(); ++size) {
+    std::string const input = data.substr(0, size);
+    std::string const expected = portable.HashString(input);
+    ASSERT_TRUE(fast.HashString(input) == expected);
+
+    for (size_t chunk : { 1, 13, 64, 100 }) {
+      fast.Initialize();
+      for (size_t i = 0; i < size; i += chunk) {
+        fast.Append(input.substr(i, chunk));
+      }
+      ASSERT_TRUE(fast.FinalizeHex() == expected);
+    }
+  }
+  return true;
+}
+
+static bool testFiles()
+{
+  std::cout << "testFiles()\n";
+
+  // Small files are read and large files may be mapped into memory.
+  cmCryptoHash portable(cmCryptoHash::AlgoSHA256,
+                        cmCryptoHash::BackendPortable);
+  for (size_t size : { 0, 1000, 4 * 1024 * 1024 + 3 }) {
+    std::string const data = testData(size);
+    std::string const file = testDir + "/file" + std::to_string(size);
+    {
+      cmsys::ofstream fout(file.c_str(), std::ios::out | std::ios::binary);
+      fout.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    std::string const expected = portable.HashString(data);
+    for (auto algo : { cmCryptoHash::AlgoSHA256, cmCryptoHash::AlgoMD5 }) {
+      for (bool map : { false, true }) {
+        cmCryptoHash hash(algo);
+        hash.SetMapFiles(map);
+        ASSERT_TRUE(hash.HashFile(file) == hash.HashString(data));
+      }
+    }
+    ASSERT_TRUE(portable.HashFile(file) == expected);
+  }
+
+  cmCryptoHash hash(cmCryptoHash::AlgoSHA256);
+  ASSERT_TRUE(hash.HashFile(testDir + "/missing").empty());
+  ASSERT_TRUE(hash.HashFile(testDir).empty());
+  return true;
+}
+
+static void benchmark()
+{
+  // Compare the backends on the same data in memory.
+  std::string const data = testData(64 * 1024 * 1024);
+  std::cout << "SHA extensions: "
+            << (cmCryptoHashAccel::IsSupported() ? "yes" : "no") << "\n";
+  for (auto algo : { cmCryptoHash::AlgoSHA1, cmCryptoHash::AlgoSHA256 }) {
+    for (auto backend :
+         { cmCryptoHash::BackendPortable, cmCryptoHash::BackendDefault }) {
+      cmCryptoHash hash(algo, backend);
+      auto const start = std::chrono::steady_clock::now();
+      hash.HashString(data);
+      std::chrono::duration<double> const elapsed =
+        std::chrono::steady_clock::now() - start;
+      std::cout << (algo == cmCryptoHash::AlgoSHA1 ? "SHA1" : "SHA256")
+                << (backend == cmCryptoHash::BackendPortable ? " portable: "
+                                                             : " default: ")
+                << static_cast<int>(data.size() / 1e6 / elapsed.count())
+                << " MB/s\n";
+    }
+  }
+}
+
+int testCryptoHash(int argc, char* argv[])
+{
+  if (argc > 1 && strcmp(argv[1], "benchmark") == 0) {
+    benchmark();
+    return 0;
+  }
+
+  cmSystemTools::RemoveADirectory(testDir);
+  cmSystemTools::MakeDirectory(testDir);
+  bool ok = testKnownValues() && testBackends(cmCryptoHash::AlgoSHA1) &&
+    testBackends(cmCryptoHash::AlgoSHA256) && testFiles();
+  cmSystemTools::RemoveADirectory(testDir);
+  return ok ? 0 : 1;
+}
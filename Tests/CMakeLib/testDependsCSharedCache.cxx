@@ -0,0 +1,129 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmDependsCSharedCache.h"
+#include "cmSystemTools.h"
+
+#include "cmsys/FStream.hxx"
+#include <iostream>
+#include <string>
+
+#define ASSERT_TRUE(x)                                                        \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      std::cout << "ASSERT_TRUE(" #x ") failed on line " << __LINE__ << "\n"; \
+      return false;                                                           \
+    }                                                                         \
+  } while (false)
+
+static const std::string cacheFile = "testDependsCSharedCache.bin";
+
+static cmDependsCSharedCache::IncludeEntries makeIncludes()
+{
+  cmDependsCSharedCache::IncludeEntries includes;
+  cmDependsCSharedCache::IncludeEntry a;
+  a.FileName = "a.h";
+  a.QuotedLocation = "/src/a.h";
+  includes.push_back(a);
+  cmDependsCSharedCache::IncludeEntry b;
+  b.FileName = "sys/b.h";
+  includes.push_back(b);
+  return includes;
+}
+
+static bool testRoundTrip()
+{
+  std::cout << "testRoundTrip()\n";
+  cmDependsCSharedCache::FileStamp stamp;
+  stamp.MTime = 1234567890123456789LL;
+  stamp.Size = 42;
+  {
+    cmDependsCSharedCache cache(cacheFile);
+    ASSERT_TRUE(!cache.Load());
+    cache.Store("settings", "/src/x.h", stamp, makeIncludes());
+    ASSERT_TRUE(cache.Save());
+  }
+
+  cmDependsCSharedCache cache(cacheFile);
+  ASSERT_TRUE(cache.Load());
+  cmDependsCSharedCache::IncludeEntries const* includes =
+    cache.Find("settings", "/src/x.h", stamp);
+  ASSERT_TRUE(includes);
+  ASSERT_TRUE(includes->size() == 2);
+  ASSERT_TRUE((*includes)[0].FileName == "a.h");
+  ASSERT_TRUE((*includes)[0].QuotedLocation == "/src/a.h");
+  ASSERT_TRUE((*includes)[1].FileName == "sys/b.h");
+  ASSERT_TRUE((*includes)[1].QuotedLocation.empty());
+
+  // Other settings or another version of the file do not match.
+  ASSERT_TRUE(!cache.Find("other", "/src/x.h", stamp));
+  cmDependsCSharedCache::FileStamp changed = stamp;
+  changed.Size = 43;
+  ASSERT_TRUE(!cache.Find("settings", "/src/x.h", changed));
+  changed = stamp;
+  changed.MTime += 1;
+  ASSERT_TRUE(!cache.Find("settings", "/src/x.h", changed));
+  return true;
+}
+
+static bool testMerge()
+{
+  std::cout << "testMerge()\n";
+  cmDependsCSharedCache::FileStamp stamp;
+  stamp.MTime = 1;
+  stamp.Size = 2;
+
+  // Two caches loaded from the same file store different entries.
+  cmDependsCSharedCache first(cacheFile);
+  cmDependsCSharedCache second(cacheFile);
+  first.Load();
+  second.Load();
+  first.Store("settings", "/src/first.h", stamp, makeIncludes());
+  second.Store("settings", "/src/second.h", stamp, makeIncludes());
+  ASSERT_TRUE(first.Save());
+  ASSERT_TRUE(second.Save());
+
+  cmDependsCSharedCache cache(cacheFile);
+  ASSERT_TRUE(cache.Load());
+  ASSERT_TRUE(cache.Find("settings", "/src/first.h", stamp));
+  ASSERT_TRUE(cache.Find("settings", "/src/second.h", stamp));
+  return true;
+}
+
+static bool testCorrupt()
+{
+  std::cout << "testCorrupt()\n";
+  {
+    cmsys::ofstream fout(cacheFile.c_str(), std::ios::out | std::ios::binary);
+    fout << "CMakeIncludeScanCache1\n\xff\xff\xff\xff";
+  }
+  cmDependsCSharedCache cache(cacheFile);
+  ASSERT_TRUE(!cache.Load());
+  cmDependsCSharedCache::FileStamp stamp;
+  ASSERT_TRUE(!cache.Find("settings", "/src/x.h", stamp));
+  return true;
+}
+
+static bool testFileStamp()
+{
+  std::cout << "testFileStamp()\n";
+  std::string const file = "testDependsCSharedCache.h";
+  {
+    cmsys::ofstream fout(file.c_str());
+    fout << "#include \"a.h\"\n";
+  }
+  cmDependsCSharedCache::FileStamp stamp;
+  ASSERT_TRUE(cmDependsCSharedCache::GetFileStamp(file, stamp));
+  ASSERT_TRUE(stamp.Size == 15);
+  cmSystemTools::RemoveFile(file);
+  ASSERT_TRUE(!cmDependsCSharedCache::GetFileStamp(file, stamp));
+  return true;
+}
+
+int testDependsCSharedCache(int /*unused*/, char* /*unused*/ [])
+{
+  cmSystemTools::RemoveFile(cacheFile);
+  bool ok = testRoundTrip() && testMerge() && testCorrupt() &&
+    testFileStamp();
+  cmSystemTools::RemoveFile(cacheFile);
+  return ok ? 0 : 1;
+}
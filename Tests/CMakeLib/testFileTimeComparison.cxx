@@ -0,0 +1,73 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmFileTimeComparison.h"
+#include "cmSystemTools.h"
+
+#include "cmsys/FStream.hxx"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define ASSERT_TRUE(x)                                                        \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      std::cout << "ASSERT_TRUE(" #x ") failed on line " << __LINE__ << "\n"; \
+      return false;                                                           \
+    }                                                                         \
+  } while (false)
+
+static const std::string testDir = "testFileTimeComparison.dir";
+
+static bool testPrefetch()
+{
+  std::cout << "testPrefetch()\n";
+
+  // Enough files to use several prefetch threads.
+  std::vector<std::string> files;
+  for (int i = 0; i < 1100; ++i) {
+    std::ostringstream name;
+    name << testDir << "/file" << i;
+    files.push_back(name.str());
+    cmsys::ofstream fout(files.back().c_str());
+    fout << i;
+  }
+  std::string const missing = testDir + "/missing";
+  files.push_back(missing);
+
+  cmFileTimeComparison ftc;
+  ftc.Prefetch(files);
+  cmFileTimeComparison::Statistics stats = ftc.GetStatistics();
+  ASSERT_TRUE(stats.StatCalls == files.size());
+  ASSERT_TRUE(stats.PrefetchedStatCalls == files.size());
+
+  // Prefetched files are answered without further stat calls.
+  int result;
+  ASSERT_TRUE(ftc.FileTimeCompare(files[0], files[1099], &result));
+  ASSERT_TRUE(ftc.FileExists(files[500]));
+  stats = ftc.GetStatistics();
+  ASSERT_TRUE(stats.Lookups == 3);
+  ASSERT_TRUE(stats.StatCalls == files.size());
+
+  // Missing files are looked up again.
+  ASSERT_TRUE(!ftc.FileExists(missing));
+  ASSERT_TRUE(ftc.GetStatistics().StatCalls == files.size() + 1);
+  {
+    cmsys::ofstream fout(missing.c_str());
+  }
+  ASSERT_TRUE(ftc.FileExists(missing));
+
+  // Files already known are not prefetched again.
+  ftc.Prefetch(files);
+  ASSERT_TRUE(ftc.GetStatistics().PrefetchedStatCalls == files.size());
+  return true;
+}
+
+int testFileTimeComparison(int /*unused*/, char* /*unused*/ [])
+{
+  cmSystemTools::RemoveADirectory(testDir);
+  cmSystemTools::MakeDirectory(testDir);
+  bool ok = testPrefetch();
+  cmSystemTools::RemoveADirectory(testDir);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmGccDepfileReader.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define ASSERT_TRUE(x)                                                        \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      std::cout << "ASSERT_TRUE(" #x ") failed on line " << __LINE__ << "\n"; \
+      return false;                                                           \
+    }                                                                         \
+  } while (false)
+
+static bool checkDeps(std::string const& content,
+                      std::vector<std::string> const& expected)
+{
+  std::vector<std::string> deps;
+  cmParseGccDepfile(content, deps);
+  if (deps != expected) {
+    std::cout << "Parsing\n" << content << "\ngave:\n";
+    for (std::string const& d : deps) {
+      std::cout << "  '" << d << "'\n";
+    }
+    return false;
+  }
+  return true;
+}
+
+static bool testSimple()
+{
+  std::cout << "testSimple()\n";
+  ASSERT_TRUE(checkDeps("CMakeFiles/a.dir/a.c.o: /src/a.c /src/a.h\n",
+                        { "/src/a.c", "/src/a.h" }));
+  ASSERT_TRUE(checkDeps("a.o : a.c", { "a.c" }));
+  ASSERT_TRUE(checkDeps("", {}));
+  return true;
+}
+
+static bool testContinuation()
+{
+  std::cout << "testContinuation()\n";
+  ASSERT_TRUE(checkDeps("a.o: a.c \\\n a.h \\\n  b.h\n",
+                        { "a.c", "a.h", "b.h" }));
+  ASSERT_TRUE(checkDeps("a.o: a.c \\\r\n a.h\r\n", { "a.c", "a.h" }));
+  return true;
+}
+
+static bool testEscapes()
+{
+  std::cout << "testEscapes()\n";
+  ASSERT_TRUE(checkDeps("a.o: dir\\ with\\ space/a.h odd\\#.h cost$$.h\n",
+                        { "dir with space/a.h", "odd#.h", "cost$.h" }));
+  return true;
+}
+
+static bool testWindowsPaths()
+{
+  std::cout << "testWindowsPaths()\n";
+  ASSERT_TRUE(checkDeps("C:/b/a.o: C:/src/a.c c:\\inc\\a.h\n",
+                        { "C:/src/a.c", "c:\\inc\\a.h" }));
+  return true;
+}
+
+static bool testMultipleRules()
+{
+  std::cout << "testMultipleRules()\n";
+  // With -MP the compiler adds a phony rule for each header.
+  ASSERT_TRUE(checkDeps("a.o: a.c a.h\n\na.h:\n", { "a.c", "a.h" }));
+  ASSERT_TRUE(checkDeps("a.o b.o: a.c\nc.o: c.c\n", { "a.c", "c.c" }));
+  return true;
+}
+
+int testGccDepfileReader(int /*unused*/, char* /*unused*/ [])
+{
+  if (!testSimple()) {
+    return 1;
+  }
+  if (!testContinuation()) {
+    return 1;
+  }
+  if (!testEscapes()) {
+    return 1;
+  }
+  if (!testWindowsPaths()) {
+    return 1;
+  }
+  if (!testMultipleRules()) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmGlobDirectories.h"
+#include "cmGlobWalker.h"
+#include "cmSystemTools.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define ASSERT_TRUE(x)                                                        \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      std::cout << "ASSERT_TRUE(" #x ") failed on line " << __LINE__ << "\n"; \
+      return false;                                                           \
+    }                                                                         \
+  } while (false)
+
+static std::string testDir;
+
+static bool hasEntry(cmGlobDirectories const& dirs, std::string const& path)
+{
+  std::vector<cmGlobDirectories::Entry> const& entries = dirs.GetEntries();
+  return std::find_if(entries.begin(), entries.end(),
+                      [&path](cmGlobDirectories::Entry const& e) {
+                        return e.Path == path;
+                      }) != entries.end();
+}
+
+static void collect(cmGlobDirectories& dirs, std::string const& expr,
+                    bool recurse)
+{
+  cmGlobWalker g;
+  g.SetRecurse(recurse);
+  g.SetRecordDirectories(&dirs);
+  g.FindFiles(expr);
+}
+
+static bool testCollect()
+{
+  std::cout << "testCollect()\n";
+
+  // Only directories matching the intermediate components are listed.
+  cmGlobDirectories dirs;
+  collect(dirs, testDir + "/a*/inc/*.h", false);
+  ASSERT_TRUE(dirs.GetEntries().size() == 4);
+  ASSERT_TRUE(hasEntry(dirs, testDir + "/"));
+  ASSERT_TRUE(hasEntry(dirs, testDir + "/a1"));
+  ASSERT_TRUE(hasEntry(dirs, testDir + "/a1/inc"));
+  ASSERT_TRUE(hasEntry(dirs, testDir + "/a2"));
+  ASSERT_TRUE(!hasEntry(dirs, testDir + "/b"));
+
+  // A recursive glob lists every directory below its base.
+  cmGlobDirectories rdirs;
+  collect(rdirs, testDir + "/a1/*.h", true);
+  ASSERT_TRUE(rdirs.GetEntries().size() == 3);
+  ASSERT_TRUE(hasEntry(rdirs, testDir + "/a1/inc/sub"));
+  return true;
+}
+
+static bool testUpToDate()
+{
+  std::cout << "testUpToDate()\n";
+
+  // Directories modified shortly before they were recorded are not
+  // trusted.
+  cmGlobDirectories dirs;
+  collect(dirs, testDir + "/*/inc/*.h", true);
+  ASSERT_TRUE(!dirs.IsUpToDate());
+
+  // Pretend the directories were recorded later.
+  dirs.SetRecordTime(cmGlobDirectories::Now() + 10000000000LL);
+  ASSERT_TRUE(dirs.IsUpToDate());
+
+  // Removing a nested directory is noticed.
+  cmSystemTools::RemoveADirectory(testDir + "/a1/inc/sub");
+  ASSERT_TRUE(!dirs.IsUpToDate());
+  return true;
+}
+
+int testGlobDirectories(int /*unused*/, char* /*unused*/ [])
+{
+  testDir = cmSystemTools::GetCurrentWorkingDirectory();
+  testDir += "/testGlobDirectories.dir";
+  cmSystemTools::RemoveADirectory(testDir);
+  cmSystemTools::MakeDirectory(testDir + "/a1/inc/sub");
+  cmSystemTools::MakeDirectory(testDir + "/a2");
+  cmSystemTools::MakeDirectory(testDir + "/b/inc");
+  bool ok = testCollect() && testUpToDate();
+  cmSystemTools::RemoveADirectory(testDir);
+  return ok ? 0 : 1;
+}
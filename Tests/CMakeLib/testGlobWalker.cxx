@@ -0,0 +1,122 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmGlobWalker.h"
+#include "cmSystemTools.h"
+
+#include "cmsys/FStream.hxx"
+#include "cmsys/Glob.hxx"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define ASSERT_TRUE(x)                                                        \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      std::cout << "ASSERT_TRUE(" #x ") failed on line " << __LINE__ << "\n"; \
+      return false;                                                           \
+    }                                                                         \
+  } while (false)
+
+static std::string testDir;
+
+static void touch(std::string const& path)
+{
+  cmsys::ofstream fout(path.c_str());
+}
+
+// Compare the results of cmGlobWalker and cmsys::Glob for one expression.
+static bool compareGlob(std::string const& expr, bool recurse, bool listDirs,
+                        bool follow, unsigned int threads)
+{
+  cmsys::Glob g;
+  g.SetRecurse(recurse);
+  g.SetListDirs(listDirs);
+  g.SetRecurseListDirs(listDirs);
+  g.SetRecurseThroughSymlinks(follow);
+  g.FindFiles(testDir + "/" + expr);
+  std::vector<std::string> expected = g.GetFiles();
+  std::sort(expected.begin(), expected.end());
+
+  cmGlobWalker w;
+  w.SetRecurse(recurse);
+  w.SetListDirs(listDirs);
+  w.SetRecurseListDirs(listDirs);
+  w.SetRecurseThroughSymlinks(follow);
+  w.SetThreads(threads);
+  w.FindFiles(testDir + "/" + expr);
+
+  if (w.GetFiles() != expected ||
+      w.GetFollowedSymlinkCount() != g.GetFollowedSymlinkCount()) {
+    std::cout << "Globbing '" << expr << "' recurse=" << recurse
+              << " listDirs=" << listDirs << " follow=" << follow
+              << " threads=" << threads << " found " << w.GetFiles().size()
+              << " instead of " << expected.size() << " files\n";
+    return false;
+  }
+  return true;
+}
+
+static bool testMatchesGlob()
+{
+  std::cout << "testMatchesGlob()\n";
+
+  char const* exprs[] = { "*",          "*.c",      "d1*/*.h",
+                          "d?/sub*/*",  "*/[ab]*.c", "*/*x*y*",
+                          "d1/sub2/a.c", "missing/*" };
+  for (char const* expr : exprs) {
+    for (int mode = 0; mode < 8; ++mode) {
+      bool const recurse = (mode & 1) != 0;
+      bool const listDirs = (mode & 2) != 0;
+      bool const follow = (mode & 4) != 0;
+      ASSERT_TRUE(compareGlob(expr, recurse, listDirs, follow, 1));
+      ASSERT_TRUE(compareGlob(expr, recurse, listDirs, follow, 4));
+    }
+  }
+  return true;
+}
+
+static bool testRelative()
+{
+  std::cout << "testRelative()\n";
+
+  cmGlobWalker w;
+  w.SetRecurse(true);
+  w.SetRelative(testDir + "/d1");
+  w.FindFiles(testDir + "/d1/sub1/*.c");
+  std::vector<std::string> const& files = w.GetFiles();
+  ASSERT_TRUE(!files.empty());
+  ASSERT_TRUE(files[0] == "sub1/a.c");
+  ASSERT_TRUE(std::is_sorted(files.begin(), files.end()));
+  return true;
+}
+
+int testGlobWalker(int /*unused*/, char* /*unused*/ [])
+{
+  testDir = cmSystemTools::GetCurrentWorkingDirectory();
+  testDir += "/testGlobWalker.dir";
+  cmSystemTools::RemoveADirectory(testDir);
+
+  // Enough directories for several threads to take part.
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 8; ++j) {
+      std::ostringstream dir;
+      dir << testDir << "/d" << i << "/sub" << j;
+      cmSystemTools::MakeDirectory(dir.str() + "/deep");
+      touch(dir.str() + "/a.c");
+      touch(dir.str() + "/b.h");
+      touch(dir.str() + "/xay.txt");
+      touch(dir.str() + "/deep/c.c");
+    }
+  }
+  touch(testDir + "/top.c");
+#ifndef _WIN32
+  cmSystemTools::CreateSymlink(testDir + "/d1", testDir + "/d2/link");
+  cmSystemTools::CreateSymlink(testDir + "/d3", testDir + "/d3/sub0/loop");
+#endif
+
+  bool ok = testMatchesGlob() && testRelative();
+  cmSystemTools::RemoveADirectory(testDir);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmRegularExpressionSet.h"
+
+#include "cmsys/RegularExpression.hxx"
+#include <chrono>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define ASSERT_TRUE(x)                                                        \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      std::cout << "ASSERT_TRUE(" #x ") failed on line " << __LINE__ << "\n"; \
+      return false;                                                           \
+    }                                                                         \
+  } while (false)
+
+static bool testRequiredLiterals()
+{
+  std::cout << "testRequiredLiterals()\n";
+
+  typedef std::vector<std::string> Literals;
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals("^Fatal") ==
+              Literals{ "fatal" });
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals(
+                "^[Bb]us [Ee]rror") == Literals{ "bus error" });
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals(
+                "make\\[.*\\]: \\*\\*\\*.*Error") == Literals{ "]: ***" });
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals(
+                "([^ :]+) : (error|fatal error)") ==
+              (Literals{ "error", "fatal error" }));
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals(
+                "(^|[ :])[Ww][Aa][Rr][Nn][Ii][Nn][Gg]") ==
+              Literals{ "warning" });
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals("ab+c") ==
+              Literals{ "ab" });
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals("xy?z") ==
+              Literals{ "x" });
+
+  // Patterns that can match without any literal are not filtered.
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals("a|.*").empty());
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals("(abc)?").empty());
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals("[a-z]+").empty());
+  ASSERT_TRUE(cmRegularExpressionSet::GetRequiredLiterals("^$").empty());
+  return true;
+}
+
+static bool testMatchesEachExpression()
+{
+  std::cout << "testMatchesEachExpression()\n";
+
+  char const* patterns[] = {
+    "^[Bb]us [Ee]rror",
+    ":.*[Pp]ermission [Dd]enied",
+    "([^ :]+):([0-9]+): ([^ \\t])",
+    "^Error ([0-9]+):",
+    "^\"[^\"]+\", line [0-9]+: [^Ww]",
+    "^ld([^:])*:([ \\t])*ERROR([^:])*:",
+    "([^ :]+) : (error|fatal error|catastrophic error)",
+    "([^:]+)\\(([^\\)]+)\\) ?: (error|fatal error|catastrophic error)",
+    ": \\*\\*\\* No rule to make target [`'].*\\'.  Stop",
+    "make\\[.*\\]: \\*\\*\\*.*Error",
+    "nternal error:",
+    "([^ :]+):([0-9]+): Warning",
+    "(^|[ :])[Nn][Oo][Tt][Ee]",
+    "[-]+",
+    "a|b*",
+  };
+  char const* lines[] = {
+    "",
+    "Bus error",
+    "bus Error (core dumped)",
+    "foo.c:12: undefined reference",
+    "foo.c:12: Warning: unused",
+    "Error 2: failed",
+    "\"x.c\", line 3: bad",
+    "ld: ERROR: missing",
+    "LD: error",
+    "x.cxx : fatal error C1083",
+    "x.cxx(10) : error C2065",
+    "x.cxx(10): catastrophic error",
+    "make: *** No rule to make target `all'.  Stop",
+    "make[2]: *** [all] Error 2",
+    "INTERNAL ERROR: nothing",
+    "compiler internal error: oops",
+    "note: here",
+    "a NOTE",
+    "denote",
+    "----",
+    "plain text without anything",
+  };
+
+  cmRegularExpressionSet set;
+  std::vector<cmsys::RegularExpression> regexes;
+  for (char const* p : patterns) {
+    ASSERT_TRUE(set.Add(p));
+    regexes.emplace_back(p);
+  }
+  ASSERT_TRUE(set.Size() == regexes.size());
+
+  for (char const* line : lines) {
+    size_t first = cmRegularExpressionSet::npos;
+    std::vector<bool> expected;
+    for (size_t i = 0; i < regexes.size(); ++i) {
+      bool const found = regexes[i].find(line);
+      expected.push_back(found);
+      if (found && first == cmRegularExpressionSet::npos) {
+        first = i;
+      }
+    }
+    std::vector<bool> matched;
+    set.FindAll(line, matched);
+    if (set.Find(line) != first || matched != expected) {
+      std::cout << "Matching '" << line
+                << "' differs from the individual expressions\n";
+      return false;
+    }
+    if (first != cmRegularExpressionSet::npos) {
+      // The groups of the first match are available.
+      ASSERT_TRUE(set.Get(first).match(0) == regexes[first].match(0));
+    }
+  }
+  return true;
+}
+
+static bool testAddAndClear()
+{
+  std::cout << "testAddAndClear()\n";
+
+  cmRegularExpressionSet set;
+  ASSERT_TRUE(set.Empty());
+  ASSERT_TRUE(set.Find("anything") == cmRegularExpressionSet::npos);
+  ASSERT_TRUE(!set.Add("(unbalanced"));
+  ASSERT_TRUE(set.Empty());
+
+  ASSERT_TRUE(set.Add("world"));
+  ASSERT_TRUE(set.Find("hello world") == 0);
+  // Adding an expression after matching rebuilds the automaton.
+  ASSERT_TRUE(set.Add("hello"));
+  ASSERT_TRUE(set.Find("hello") == 1);
+  ASSERT_TRUE(set.GetPattern(1) == "hello");
+
+  // Entries already set are kept.
+  std::vector<bool> matched(2, false);
+  matched[1] = true;
+  set.FindAll("world", matched);
+  ASSERT_TRUE(matched[0] && matched[1]);
+
+  set.Clear();
+  ASSERT_TRUE(set.Empty());
+  ASSERT_TRUE(set.Find("hello world") == cmRegularExpressionSet::npos);
+  return true;
+}
+
+static void benchmark(size_t megabytes)
+{
+  // A subset of the default build handler expressions.
+  char const* patterns[] = {
+    "^CMake Error.*:",
+    ":[ \\t]cannot find",
+    ": \\*\\*\\* No rule to make target [`'].*\\'.  Stop",
+    "ld: fatal: ",
+    "make: \\*\\*\\*.*Error",
+    "make\\[.*\\]: \\*\\*\\*.*Error",
+    "nternal error:",
+    ": No such file or directory",
+    "^\\[ERROR\\]",
+    "([^ :]+):([0-9]+): ([^ \\t])",
+    "([^:]+): error[ \\t]*[0-9]+[ \\t]*:",
+    "^[Bb]us [Ee]rror",
+    "^[Ss]egmentation [Vv]iolation",
+    "([^ :]+) : (error|fatal error|catastrophic error)",
+    "([^:]+)\\(([^\\)]+)\\) ?: (error|fatal error|catastrophic error)",
+    "([^ :]+):([0-9]+): warning:",
+    "^ld([^:])*:([ \\t])*WARNING([^:])*:",
+    "^(Warning|Warnung) ([0-9]+):",
+    "([^ :]+) : warning",
+    "([^:]+): warning",
+    "\\([0-9]*\\): remark #[0-9]*",
+  };
+  char const* lines[] = {
+    "[ 42%] Building CXX object Source/CMakeFiles/CMakeLib.dir/cmFoo.cxx.o",
+    "/usr/bin/c++ -DCMAKE_BUILD_WITH_CMAKE -I/src/Source -O2 -g "
+    "-o CMakeFiles/CMakeLib.dir/cmFoo.cxx.o -c /src/Source/cmFoo.cxx",
+    "/src/Source/cmFoo.cxx:123:45: warning: unused variable 'x' "
+    "[-Wunused-variable]",
+    "   int x = 0;",
+    "       ^",
+    "[ 43%] Linking CXX static library libCMakeLib.a",
+  };
+
+  std::string log;
+  for (size_t i = 0; log.size() < megabytes * 1024 * 1024; ++i) {
+    log += lines[i % (sizeof(lines) / sizeof(lines[0]))];
+    log += '\n';
+  }
+  std::vector<std::string> logLines;
+  for (size_t pos = 0, end; (end = log.find('\n', pos)) != std::string::npos;
+       pos = end + 1) {
+    logLines.push_back(log.substr(pos, end - pos));
+  }
+
+  cmRegularExpressionSet set;
+  std::vector<cmsys::RegularExpression> regexes;
+  for (char const* p : patterns) {
+    set.Add(p);
+    regexes.emplace_back(p);
+  }
+
+  // Match each line like the build handler, first with each expression
+  // on its own and then with the set.
+  size_t loopMatches = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (std::string const& line : logLines) {
+    for (cmsys::RegularExpression& r : regexes) {
+      if (r.find(line)) {
+        ++loopMatches;
+        break;
+      }
+    }
+  }
+  std::chrono::duration<double> const loopTime =
+    std::chrono::steady_clock::now() - start;
+
+  size_t setMatches = 0;
+  start = std::chrono::steady_clock::now();
+  for (std::string const& line : logLines) {
+    if (set.Find(line) != cmRegularExpressionSet::npos) {
+      ++setMatches;
+    }
+  }
+  std::chrono::duration<double> const setTime =
+    std::chrono::steady_clock::now() - start;
+
+  double const mb = static_cast<double>(log.size()) / 1e6;
+  std::cout << logLines.size() << " lines, " << mb << " MB, "
+            << regexes.size() << " expressions\n"
+            << "loop: " << loopTime.count() << " s, " << mb / loopTime.count()
+            << " MB/s, " << loopMatches << " matches\n"
+            << "set: " << setTime.count() << " s, " << mb / setTime.count()
+            << " MB/s, " << setMatches << " matches\n";
+}
+
+int testRegularExpressionSet(int argc, char* argv[])
+{
+  // Run as 'testRegularExpressionSet benchmark [<megabytes>]'.
+  if (argc > 1 && strcmp(argv[1], "benchmark") == 0) {
+    benchmark(argc > 2 ? static_cast<size_t>(atoi(argv[2])) : 4);
+    return 0;
+  }
+
+  if (!testRequiredLiterals()) {
+    return 1;
+  }
+  if (!testMatchesEachExpression()) {
+    return 1;
+  }
+  if (!testAddAndClear()) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,9 @@
+/* The include scanner of CMake cannot follow this include, but the
+   compiler records it in its dependency file.  */
+#define HEADER "MakeDependsCompiler.h"
+#include HEADER
+
+int main(void)
+{
+  return MakeDependsCompiler();
+}
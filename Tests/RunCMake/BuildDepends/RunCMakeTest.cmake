@@ -49,6 +49,9 @@ if(RunCMake_GENERATOR MATCHES "Make")
   if(NOT "${RunCMake_BINARY_DIR}" STREQUAL "${RunCMake_SOURCE_DIR}")
     run_BuildDepends(MakeInProjectOnly)
   endif()
+  if(CMAKE_C_COMPILER_ID MATCHES "^(GNU|Clang|AppleClang)$")
+    run_BuildDepends(MakeDependsCompiler)
+  endif()
 endif()
 
 function(run_ReGeneration)
@@ -0,0 +1,24 @@
+if(PACKAGING_TYPE STREQUAL "COMPONENT")
+  set(EXPECTED_FILES_COUNT "3")
+  set(EXPECTED_FILES_NAME_GENERATOR_SPECIFIC_FORMAT TRUE)
+  foreach(i 1 2 3)
+    set(EXPECTED_FILE_${i}_COMPONENT "pkg_${i}")
+    set(EXPECTED_FILE_CONTENT_${i}_LIST
+      "/pkg_${i}"
+      "/pkg_${i}/a.txt"
+      "/pkg_${i}/sub"
+      "/pkg_${i}/sub/b.txt"
+      "/pkg_${i}/sub/c.txt")
+  endforeach()
+else()
+  set(EXPECTED_FILES_COUNT "1")
+  set(EXPECTED_FILE_CONTENT_1_LIST)
+  foreach(i 1 2 3)
+    list(APPEND EXPECTED_FILE_CONTENT_1_LIST
+      "/pkg_${i}"
+      "/pkg_${i}/a.txt"
+      "/pkg_${i}/sub"
+      "/pkg_${i}/sub/b.txt"
+      "/pkg_${i}/sub/c.txt")
+  endforeach()
+endif()
@@ -0,0 +1,10 @@
+set(CPACK_INSTALL_PARALLEL_LEVEL 3)
+
+foreach(comp IN ITEMS pkg_1 pkg_2 pkg_3)
+  install(FILES CMakeLists.txt DESTINATION ${comp} RENAME a.txt
+    COMPONENT ${comp})
+  install(FILES CMakeLists.txt DESTINATION ${comp}/sub RENAME b.txt
+    COMPONENT ${comp})
+  install(FILES CMakeLists.txt DESTINATION ${comp}/sub RENAME c.txt
+    COMPONENT ${comp})
+endforeach()
@@ -0,0 +1,11 @@
+file(READ "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/LastTest.log" log)
+foreach(i RANGE 1 40)
+  if(NOT log MATCHES "-- line ${i}\n")
+    set(RunCMake_TEST_FAILED "LastTest.log does not contain line ${i}:\n${log}")
+    break()
+  endif()
+endforeach()
+file(GLOB spill "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/TestOutput-*")
+if(spill)
+  set(RunCMake_TEST_FAILED "Temporary output file not removed:\n ${spill}")
+endif()
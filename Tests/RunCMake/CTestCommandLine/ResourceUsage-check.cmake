@@ -0,0 +1,22 @@
+file(GLOB test_xml_file "${RunCMake_TEST_BINARY_DIR}/Testing/*/Test.xml")
+if(test_xml_file)
+  file(READ "${test_xml_file}" test_xml)
+  foreach(name "User Time" "System Time" "Max Resident Set Size"
+      "Block Input Operations" "Block Output Operations")
+    if(NOT test_xml MATCHES "<NamedMeasurement type=\"numeric/double\" name=\"${name}\">[ \t\r\n]*<Value>[0-9.e+-]+</Value>")
+      set(RunCMake_TEST_FAILED "Test.xml does not contain the ${name}:\n ${test_xml}")
+    endif()
+  endforeach()
+else()
+  set(RunCMake_TEST_FAILED "Test.xml not found")
+endif()
+
+set(usage_file "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestResourceUsage.txt")
+if(EXISTS "${usage_file}")
+  file(READ "${usage_file}" usage)
+  if(NOT usage MATCHES "^ResourceUsage 1 [0-9.e+-]+ [0-9.e+-]+ [0-9.e+-]+ [1-9][0-9]* [0-9]+ [0-9]+ [1-9][0-9]*\n$")
+    string(APPEND RunCMake_TEST_FAILED "CTestResourceUsage.txt has unexpected content:\n ${usage}")
+  endif()
+else()
+  string(APPEND RunCMake_TEST_FAILED "CTestResourceUsage.txt not found")
+endif()
@@ -124,6 +124,204 @@ run_TestLoad(test-load-pass 10)
 
 unset(ENV{__CTEST_FAKE_LOAD_AVERAGE_FOR_TESTING})
 
+function(run_TestPressure name pressure)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestPressure)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(TestPressure1 \"${CMAKE_COMMAND}\" -E echo \"test of --test-pressure\")
+  add_test(TestPressure2 \"${CMAKE_COMMAND}\" -E echo \"test of --test-pressure\")
+")
+  run_cmake_command(${name} ${CMAKE_CTEST_COMMAND} -j2 --test-pressure ${pressure})
+endfunction()
+
+# Tests for the --test-pressure feature of ctest
+#
+# Spoof a CPU pressure value to make these tests more reliable.
+set(ENV{__CTEST_FAKE_PRESSURE_FOR_TESTING} 50)
+
+# Verify that new tests are not started when the pressure exceeds
+# our threshold and that they then run once the pressure drops.
+run_TestPressure(test-pressure-wait 20)
+
+# Verify that warning message is displayed but tests still start when
+# an invalid argument is given.
+run_TestPressure(test-pressure-invalid 'two')
+
+# Verify that new tests are started when the pressure is below our
+# threshold.
+run_TestPressure(test-pressure-pass 80)
+
+unset(ENV{__CTEST_FAKE_PRESSURE_FOR_TESTING})
+
+function(run_TestPressureMemory)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestPressureMemory)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(Memory1 \"${CMAKE_COMMAND}\" -E echo \"Memory1\")
+  add_test(Memory2 \"${CMAKE_COMMAND}\" -E echo \"Memory2\")
+")
+  # Claim that each test needed 1 TiB of memory before.
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestResourceUsage.txt"
+    "Memory1 1 1 0 0 1073741824 0 0 1073741824\n"
+    "Memory2 1 1 0 0 1073741824 0 0 1073741824\n")
+  run_cmake_command(test-pressure-memory ${CMAKE_CTEST_COMMAND} -j2 --test-pressure 100 -V)
+endfunction()
+# The available memory is known only on Linux.
+if(EXISTS /proc/meminfo)
+  run_TestPressureMemory()
+endif()
+
+function(run_CriticalPath)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/CriticalPath)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+add_test(Setup \"${CMAKE_COMMAND}\" -E echo \"Setup\")
+add_test(Chain \"${CMAKE_COMMAND}\" -E echo \"Chain\")
+add_test(Long \"${CMAKE_COMMAND}\" -E echo \"Long\")
+set_tests_properties(Setup PROPERTIES COST 1)
+set_tests_properties(Chain PROPERTIES COST 1 DEPENDS Setup)
+set_tests_properties(Long PROPERTIES COST 10)
+")
+  run_cmake_command(CriticalPath ${CMAKE_CTEST_COMMAND} -j2
+    --schedule-critical-path)
+endfunction()
+run_CriticalPath()
+
+function(run_CriticalPathProcessors)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/CriticalPathProcessors)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+add_test(Serial \"${CMAKE_COMMAND}\" -E echo \"Serial\")
+add_test(Wide \"${CMAKE_COMMAND}\" -E echo \"Wide\")
+set_tests_properties(Serial PROPERTIES COST 3)
+set_tests_properties(Wide PROPERTIES COST 3 PROCESSORS 2)
+")
+  run_cmake_command(CriticalPathProcessors ${CMAKE_CTEST_COMMAND} -j2
+    --schedule-critical-path)
+endfunction()
+run_CriticalPathProcessors()
+
+function(run_CacheResults)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/CacheResults)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/input.txt" "1")
+  set(tests "
+add_test(User \"${CMAKE_COMMAND}\" -E echo \"User\")
+add_test(Input \"${CMAKE_COMMAND}\" -E echo \"Input\")
+set_tests_properties(User PROPERTIES DEPENDS Setup)
+set_tests_properties(Input PROPERTIES RESULT_CACHE_INPUTS input.txt)
+")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+add_test(Setup \"${CMAKE_COMMAND}\" -E echo \"Setup\")
+${tests}")
+  run_cmake_command(CacheResults-first ${CMAKE_CTEST_COMMAND} --cache-results)
+  run_cmake_command(CacheResults-cached ${CMAKE_CTEST_COMMAND} --cache-results)
+  # Tests run again when their input files change.
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/input.txt" "2")
+  run_cmake_command(CacheResults-input ${CMAKE_CTEST_COMMAND} --cache-results)
+  # Tests run again when a test they depend on runs.
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+add_test(Setup \"${CMAKE_COMMAND}\" -E echo \"Changed\")
+${tests}")
+  run_cmake_command(CacheResults-depends ${CMAKE_CTEST_COMMAND} --cache-results)
+  # Without the option all tests run.
+  run_cmake_command(CacheResults-off ${CMAKE_CTEST_COMMAND})
+endfunction()
+run_CacheResults()
+
+function(run_Shard)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  set(cost_file "${RunCMake_BINARY_DIR}/ShardCostData.txt")
+  file(WRITE "${cost_file}"
+    "a 1 5\nb 1 1\nc 1 4\nd 1 2\ne 1 2\nf 1 3\nsetup 1 1\n---\n")
+  # Each machine has cost data of its own that must not change the plan.
+  set(costs_1 "a 1 1\nb 1 1\nc 1 1\nd 1 1\ne 1 1\nf 1 1\nsetup 1 1\n---\n")
+  set(costs_2 "a 1 1\nb 1 9\nc 1 2\nd 1 7\ne 1 3\nf 1 8\nsetup 1 1\n---\n")
+  macro(run_Shard_case case costs)
+    set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/${case})
+    file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+    file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+    file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+foreach(t a b c d e f setup)
+  add_test(\${t} \"${CMAKE_COMMAND}\" -E echo \${t})
+endforeach()
+set_tests_properties(b PROPERTIES DEPENDS a)
+set_tests_properties(setup PROPERTIES FIXTURES_SETUP fx)
+set_tests_properties(d e PROPERTIES FIXTURES_REQUIRED fx)
+")
+    file(WRITE "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt"
+      "${costs}")
+    run_cmake_command(${case} ${CMAKE_CTEST_COMMAND} ${ARGN})
+  endmacro()
+  run_Shard_case(Shard "${costs_1}"
+    --shard-count 3 --shard-index 2 --shard-cost-file "${cost_file}")
+  run_Shard_case(Shard-other "${costs_2}"
+    --shard-count 3 --shard-index 0 --shard-cost-file "${cost_file}")
+  run_Shard_case(Shard-hash-0 "${costs_1}" --shard-count 2 --shard-index 0)
+  run_Shard_case(Shard-hash-1 "${costs_2}" --shard-count 2 --shard-index 1)
+  run_Shard_case(Shard-bad-index "${costs_1}" --shard-count 3 --shard-index 3)
+  run_Shard_case(Shard-bad-cost-file "${costs_1}"
+    --shard-count 3 --shard-index 0 --shard-cost-file missing.txt)
+endfunction()
+run_Shard()
+
+function(run_OutputCapture)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/OutputCapture)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestCustom.cmake" "
+set(CTEST_CUSTOM_TEST_OUTPUT_CAPTURE_SIZE 100)
+set(CTEST_CUSTOM_MAXIMUM_PASSED_TEST_OUTPUT_SIZE 10)
+set(CTEST_CUSTOM_MAXIMUM_FAILED_TEST_OUTPUT_SIZE 10)
+")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/lines.cmake" "
+foreach(i RANGE 1 40)
+  message(STATUS \"line \${i}\")
+endforeach()
+")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+add_test(OutputCapture \"${CMAKE_COMMAND}\" -P lines.cmake)
+set_tests_properties(OutputCapture PROPERTIES
+  FAIL_REGULAR_EXPRESSION \"-- line 20\\n\")
+")
+  run_cmake_command(OutputCapture ${CMAKE_CTEST_COMMAND} --output-on-failure)
+endfunction()
+run_OutputCapture()
+
+function(run_Workers)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/Workers)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestCustom.cmake" "
+set(CTEST_CUSTOM_TEST_OUTPUT_CAPTURE_SIZE 100)
+")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/lines.cmake" "
+foreach(i RANGE 1 40)
+  message(STATUS \"line \${i}\")
+endforeach()
+")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+add_test(WorkersPass \"${CMAKE_COMMAND}\" -E echo WorkersPass)
+add_test(WorkersFail \"${CMAKE_COMMAND}\" -P lines.cmake)
+set_tests_properties(WorkersFail PROPERTIES
+  FAIL_REGULAR_EXPRESSION \"-- line 20\\n\")
+")
+  run_cmake_command(Workers ${CMAKE_CTEST_COMMAND} --workers 2 -j2)
+endfunction()
+run_Workers()
+
 function(run_TestOutputSize)
   set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestOutputSize)
   set(RunCMake_TEST_NO_CLEAN 1)
@@ -142,6 +340,20 @@ function(run_TestOutputSize)
 endfunction()
 run_TestOutputSize()
 
+function(run_ResourceUsage)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/ResourceUsage)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(ResourceUsage \"${CMAKE_COMMAND}\" -E echo ResourceUsage)
+")
+  run_cmake_command(ResourceUsage ${CMAKE_CTEST_COMMAND} -M Experimental -T Test)
+endfunction()
+if(TEST_RESOURCE_USAGE)
+  run_ResourceUsage()
+endif()
+
 function(run_TestAffinity)
   set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestAffinity)
   set(RunCMake_TEST_NO_CLEAN 1)
@@ -0,0 +1,13 @@
+file(READ "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestShardPlan.txt" plan)
+set(expect "# <shard> <cost> <test>
+0 5 a
+0 1 b
+1 2 d
+1 2 e
+1 1 setup
+2 4 c
+2 3 f
+")
+if(NOT plan STREQUAL expect)
+  set(RunCMake_TEST_FAILED "Unexpected CTestShardPlan.txt:\n${plan}")
+endif()
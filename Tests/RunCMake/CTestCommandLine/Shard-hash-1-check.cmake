@@ -0,0 +1,13 @@
+file(READ "${RunCMake_BINARY_DIR}/Shard-hash-0/Testing/Temporary/CTestShardPlan.txt" expect)
+file(READ "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestShardPlan.txt" plan)
+if(NOT plan STREQUAL expect)
+  set(RunCMake_TEST_FAILED "CTestShardPlan.txt differs between shards:\n${plan}\nexpected:\n${expect}")
+  return()
+endif()
+
+# The shard runs the tests its plan assigns to it.
+string(REGEX MATCHALL "(^|\n)1 [0-9.]+ [a-z]+" assigned "${plan}")
+list(LENGTH assigned count)
+if(NOT actual_stdout MATCHES "tests passed, 0 tests failed out of ${count}\n")
+  set(RunCMake_TEST_FAILED "Shard did not run the ${count} tests of its plan:\n${actual_stdout}")
+endif()
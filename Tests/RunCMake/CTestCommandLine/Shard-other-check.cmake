@@ -0,0 +1,5 @@
+file(READ "${RunCMake_BINARY_DIR}/Shard/Testing/Temporary/CTestShardPlan.txt" expect)
+file(READ "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestShardPlan.txt" plan)
+if(NOT plan STREQUAL expect)
+  set(RunCMake_TEST_FAILED "CTestShardPlan.txt differs between shards:\n${plan}\nexpected:\n${expect}")
+endif()
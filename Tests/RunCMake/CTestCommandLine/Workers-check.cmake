@@ -0,0 +1,18 @@
+# The tests finish in any order, so check the passing one separately.
+if(NOT actual_stdout MATCHES "Test #1: WorkersPass \\.+   Passed +[0-9.]+ sec")
+  set(RunCMake_TEST_FAILED "Passing test result not reported:\n${actual_stdout}")
+endif()
+file(READ "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/LastTest.log" log)
+if(NOT log MATCHES "WorkersPass\n")
+  set(RunCMake_TEST_FAILED "LastTest.log does not contain passing test output:\n${log}")
+endif()
+foreach(i RANGE 1 40)
+  if(NOT log MATCHES "-- line ${i}\n")
+    set(RunCMake_TEST_FAILED "LastTest.log does not contain line ${i}:\n${log}")
+    break()
+  endif()
+endforeach()
+file(GLOB spill "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/TestOutput-*")
+if(spill)
+  set(RunCMake_TEST_FAILED "Temporary output file not removed:\n ${spill}")
+endif()
@@ -10,7 +10,7 @@ def check_version(v):
     assert is_int(v["major"])
     assert is_int(v["minor"])
     assert v["major"] == 1
-    assert v["minor"] == 0
+    assert v["minor"] == 1
 
 def check_backtracegraph(b):
     assert is_dict(b)
@@ -212,6 +212,10 @@ run_cmake_command(E_copy_if_different-three-source-files-target-is-directory
   ${CMAKE_COMMAND} -E copy_if_different ${in}/f1.txt ${in}/f2.txt ${in}/f3.txt ${out})
 run_cmake_command(E_copy_if_different-three-source-files-target-is-file
   ${CMAKE_COMMAND} -E copy_if_different ${in}/f1.txt ${in}/f2.txt ${in}/f3.txt ${out}/f1.txt)
+run_cmake_command(E_copy-parallel-three-source-files-target-is-directory
+  ${CMAKE_COMMAND} -E copy -j 2 ${in}/f1.txt ${in}/f2.txt ${in}/f3.txt ${out})
+run_cmake_command(E_copy_if_different-parallel-two-good-and-one-bad-source-files
+  ${CMAKE_COMMAND} -E copy_if_different -j3 ${in}/f1.txt ${in}/not_existing_file.bad ${in}/f3.txt ${out})
 unset(in)
 unset(out)
 
@@ -227,6 +231,14 @@ run_cmake_command(E_copy_directory-three-source-files-target-is-file
   ${CMAKE_COMMAND} -E copy_directory ${in}/d1 ${in}/d2 ${in}/d3 ${outfile})
 run_cmake_command(E_copy_directory-three-source-files-target-is-not-exist
   ${CMAKE_COMMAND} -E copy_directory ${in}/d1 ${in}/d2 ${in}/d3 ${out}/not_existing_directory)
+run_cmake_command(E_copy_directory-parallel
+  ${CMAKE_COMMAND} -E copy_directory -j 3 ${in} ${out}/parallel)
+run_cmake_command(E_copy_directory-parallel-check
+  ${CMAKE_COMMAND} -E compare_files ${in}/d3/d3.txt ${out}/parallel/d3/d3.txt)
+run_cmake_command(E_copy_directory_if_different-parallel
+  ${CMAKE_COMMAND} -E copy_directory_if_different -j2 ${in} ${out}/parallel)
+run_cmake_command(E_copy_directory-bad-jobs
+  ${CMAKE_COMMAND} -E copy_directory -j 0 ${in} ${out}/parallel)
 unset(in)
 unset(out)
 unset(outfile)
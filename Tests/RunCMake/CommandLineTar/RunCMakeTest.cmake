@@ -17,6 +17,8 @@ external_command_test(mtime      tar cvf bad.tar "--mtime=1970-01-01 00:00:00 UT
 external_command_test(bad-format tar cvf bad.tar "--format=bad-format")
 external_command_test(zip-bz2    tar cvjf bad.tar "--format=zip")
 external_command_test(7zip-gz    tar cvzf bad.tar "--format=7zip")
+external_command_test(bad-threads tar cvzf bad.tar --threads=bad .)
+external_command_test(bad-level  tar cvzf bad.tar --compression-level=10 .)
 
 run_cmake(7zip)
 run_cmake(gnutar)
@@ -25,4 +27,9 @@ run_cmake(pax)
 run_cmake(pax-xz)
 run_cmake(paxr)
 run_cmake(paxr-bz2)
+run_cmake(reproducible)
+run_cmake(threads-gz)
+run_cmake(threads-xz)
+run_cmake(threads-large-gz)
+run_cmake(threads-large-xz)
 run_cmake(zip)
@@ -0,0 +1,35 @@
+function(run_tar WORKING_DIRECTORY)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E tar ${ARGN}
+    WORKING_DIRECTORY ${WORKING_DIRECTORY}
+    RESULT_VARIABLE result
+  )
+
+  if(NOT result STREQUAL "0")
+    message(FATAL_ERROR "tar failed with arguments [${ARGN}] result [${result}]")
+  endif()
+endfunction()
+
+# Create the same files twice, in a different order and at different
+# times, and archive each copy.
+set(FILES "f1.txt" "d1/f1.txt" "d1/f2.txt" "d 2/f1.txt" "d_3/f1.txt")
+set(hashes)
+foreach(copy 1 2)
+  set(dir ${CMAKE_CURRENT_BINARY_DIR}/copy${copy})
+  file(REMOVE_RECURSE ${dir})
+  foreach(file ${FILES})
+    file(WRITE ${dir}/compress_dir/${file} "${file}\n")
+  endforeach()
+  if(UNIX)
+    execute_process(COMMAND ln -sf f1.txt ${dir}/compress_dir/d1/f3.txt)
+  endif()
+  list(REVERSE FILES)
+  run_tar(${dir} czf test.tar.gz --format=pax --reproducible compress_dir)
+  file(SHA256 ${dir}/test.tar.gz hash)
+  list(APPEND hashes ${hash})
+endforeach()
+
+list(GET hashes 0 hash1)
+list(GET hashes 1 hash2)
+if(NOT hash1 STREQUAL hash2)
+  message(FATAL_ERROR "The archives of the two copies differ")
+endif()
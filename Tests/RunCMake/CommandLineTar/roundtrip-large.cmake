@@ -0,0 +1,58 @@
+foreach(parameter OUTPUT_EXT COMPRESSION_FLAGS DECOMPRESSION_FLAGS DATA_SIZE)
+  if(NOT DEFINED ${parameter})
+    message(FATAL_ERROR "missing required parameter ${parameter}")
+  endif()
+endforeach()
+
+# Generate DATA_SIZE bytes that span several compression blocks and end
+# in a partial one.
+string(RANDOM LENGTH 1000 RANDOM_SEED 1 data)
+while(1)
+  string(LENGTH "${data}" length)
+  if(length GREATER DATA_SIZE)
+    break()
+  endif()
+  string(APPEND data "${data}")
+endwhile()
+string(SUBSTRING "${data}" 0 ${DATA_SIZE} data)
+set(COMPRESS_DIR ${CMAKE_CURRENT_BINARY_DIR}/compress_dir)
+file(REMOVE_RECURSE ${COMPRESS_DIR})
+file(WRITE ${COMPRESS_DIR}/large.txt "${data}")
+set(data "")
+file(SHA256 ${COMPRESS_DIR}/large.txt input_hash)
+
+function(run_tar WORKING_DIRECTORY)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E tar ${ARGN}
+    WORKING_DIRECTORY ${WORKING_DIRECTORY}
+    RESULT_VARIABLE result
+  )
+  if(NOT result STREQUAL "0")
+    message(FATAL_ERROR "tar failed with arguments [${ARGN}] result [${result}]")
+  endif()
+endfunction()
+
+# The output depends on the block size only, not on the thread count.
+set(first_hash "")
+foreach(threads 2 3 8)
+  set(archive ${CMAKE_CURRENT_BINARY_DIR}/test-${threads}.${OUTPUT_EXT})
+  set(decompress_dir ${CMAKE_CURRENT_BINARY_DIR}/decompress-${threads})
+  file(REMOVE ${archive})
+  file(REMOVE_RECURSE ${decompress_dir})
+  file(MAKE_DIRECTORY ${decompress_dir})
+
+  run_tar(${COMPRESS_DIR} ${COMPRESSION_FLAGS} ${archive}
+    --threads=${threads} --mtime=2019-01-01 large.txt)
+  run_tar(${decompress_dir} ${DECOMPRESSION_FLAGS} ${archive})
+
+  file(SHA256 ${decompress_dir}/large.txt output_hash)
+  if(NOT output_hash STREQUAL input_hash)
+    message(SEND_ERROR "Extracting ${archive} changed the data")
+  endif()
+
+  file(SHA256 ${archive} archive_hash)
+  if(NOT first_hash)
+    set(first_hash ${archive_hash})
+  elseif(NOT archive_hash STREQUAL first_hash)
+    message(SEND_ERROR "The archive written with ${threads} threads differs")
+  endif()
+endforeach()
@@ -0,0 +1,8 @@
+set(OUTPUT_EXT "tar.gz")
+set(COMPRESSION_FLAGS czf)
+set(DECOMPRESSION_FLAGS xzf)
+
+# gzip blocks are 1 MiB.
+set(DATA_SIZE 3146000)
+
+include(${CMAKE_CURRENT_LIST_DIR}/roundtrip-large.cmake)
@@ -0,0 +1,8 @@
+set(OUTPUT_EXT "tar.xz")
+set(COMPRESSION_FLAGS cJf)
+set(DECOMPRESSION_FLAGS xJf)
+
+# xz blocks are 24 MiB.
+set(DATA_SIZE 25166000)
+
+include(${CMAKE_CURRENT_LIST_DIR}/roundtrip-large.cmake)
@@ -0,0 +1,31 @@
+set(ENV{CMAKE_INSTALL_HASH_MANIFEST} ${CMAKE_CURRENT_BINARY_DIR}/hashes.txt)
+set(src ${CMAKE_CURRENT_BINARY_DIR}/src)
+set(dst ${CMAKE_CURRENT_BINARY_DIR}/dst)
+file(REMOVE_RECURSE ${src} ${dst} $ENV{CMAKE_INSTALL_HASH_MANIFEST})
+foreach(f a b c)
+  file(WRITE ${src}/${f}.txt "${f}\n")
+endforeach()
+set(files ${src}/a.txt ${src}/b.txt ${src}/c.txt)
+file(INSTALL ${files} DESTINATION ${dst})
+
+# Modify the installed c.txt, then give the sources new times.  Only
+# b.txt gets new content.
+file(WRITE ${dst}/c.txt "modified\n")
+execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 1.1)
+foreach(f a b c)
+  file(WRITE ${src}/${f}.txt "${f}\n")
+endforeach()
+file(WRITE ${src}/b.txt "b2\n")
+file(INSTALL ${files} DESTINATION ${dst})
+
+# The kept file has the new time.
+file(INSTALL ${files} DESTINATION ${dst})
+
+foreach(f a b c)
+  file(READ ${src}/${f}.txt expect)
+  file(READ ${dst}/${f}.txt content)
+  if(NOT content STREQUAL expect)
+    message(SEND_ERROR "${f}.txt has unexpected content:\n${content}")
+  endif()
+endforeach()
+file(REMOVE_RECURSE ${src} ${dst} $ENV{CMAKE_INSTALL_HASH_MANIFEST})
@@ -0,0 +1,23 @@
+set(ENV{CMAKE_INSTALL_PARALLEL_LEVEL} 4)
+set(src ${CMAKE_CURRENT_BINARY_DIR}/src)
+set(dst ${CMAKE_CURRENT_BINARY_DIR}/dst)
+file(REMOVE_RECURSE ${src} ${dst})
+foreach(f a b c)
+  file(WRITE ${src}/${f}.txt "${f}\n")
+endforeach()
+set(files ${src}/a.txt ${src}/b.txt ${src}/c.txt)
+file(INSTALL ${files} DESTINATION ${dst} PERMISSIONS OWNER_READ)
+file(INSTALL ${files} ${src}/a.txt DESTINATION ${dst} PERMISSIONS OWNER_READ)
+foreach(f a b c)
+  file(READ ${dst}/${f}.txt content)
+  if(NOT content STREQUAL "${f}\n")
+    message(SEND_ERROR "${f}.txt has unexpected content:\n${content}")
+  endif()
+  if(UNIX)
+    execute_process(COMMAND ls -l ${dst}/${f}.txt OUTPUT_VARIABLE mode)
+    if(NOT mode MATCHES "^-r--------")
+      message(SEND_ERROR "${f}.txt has unexpected permissions:\n${mode}")
+    endif()
+  endif()
+endforeach()
+file(REMOVE_RECURSE ${src} ${dst})
@@ -20,6 +20,8 @@ run_cmake(INSTALL-DIRECTORY)
 run_cmake(INSTALL-FILES_FROM_DIR)
 run_cmake(INSTALL-FILES_FROM_DIR-bad)
 run_cmake(INSTALL-MESSAGE-bad)
+run_cmake(INSTALL-PARALLEL)
+run_cmake(INSTALL-HASH-MANIFEST)
 run_cmake(FileOpenFailRead)
 run_cmake(LOCK)
 run_cmake(LOCK-error-file-create-fail)